@@ -456,6 +456,18 @@ namespace ncpp
 			return error_guard_cond<int> (ret, ret < 0);
 		}
 
+		int putnstr (size_t s, const char *gclustarr) const NOEXCEPT_MAYBE
+		{
+			int ret = ncplane_putnstr (plane, s, gclustarr);
+			return error_guard_cond<int> (ret, ret < 0);
+		}
+
+		int putnstr (int y, int x, size_t s, const char *gclustarr) const NOEXCEPT_MAYBE
+		{
+			int ret = ncplane_putnstr_yx (plane, y, x, s, gclustarr);
+			return error_guard_cond<int> (ret, ret < 0);
+		}
+
 		int putstr (int y, NCAlign atype, const char *s) const NOEXCEPT_MAYBE
 		{
 			return error_guard<int> (ncplane_putstr_aligned (plane, y, static_cast<ncalign_e>(atype), s), -1);
@@ -626,11 +638,21 @@ namespace ncpp
 			return ncplane_rgba (plane, begy, begx, leny, lenx);
 		}
 
+		bool rgba(int begy, int begx, int leny, int lenx, uint32_t* buf) const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncplane_rgba_buf (plane, begy, begx, leny, lenx, buf), -1);
+		}
+
 		char* content(int begy, int begx, int leny, int lenx) const noexcept
 		{
 			return ncplane_contents (plane, begy, begx, leny, lenx);
 		}
 
+		int content(int begy, int begx, int leny, int lenx, char* buf, size_t buflen) const NOEXCEPT_MAYBE
+		{
+			return error_guard<int> (ncplane_contents_buf (plane, begy, begx, leny, lenx, buf, buflen), -1);
+		}
+
 		uint64_t get_channels () const noexcept
 		{
 			return ncplane_channels (plane);
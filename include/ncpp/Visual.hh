@@ -24,6 +24,38 @@ namespace ncpp
 				throw init_error ("Notcurses failed to create a new visual");
 		}
 
+		explicit Visual (const char *file, nc_err_e *ncerr, int rows, int cols)
+     : Root(NotCurses::get_instance())
+		{
+			visual = ncvisual_from_file_sized (file, ncerr, rows, cols);
+			if (visual == nullptr)
+				throw init_error ("Notcurses failed to create a new visual");
+		}
+
+		explicit Visual (ncprefetch *pf, int idx, nc_err_e *ncerr)
+     : Root(NotCurses::get_instance())
+		{
+			visual = ncprefetch_take (pf, idx, ncerr);
+			if (visual == nullptr)
+				throw init_error ("Notcurses failed to create a new visual");
+		}
+
+		explicit Visual (const void *data, size_t len, nc_err_e *ncerr)
+     : Root(NotCurses::get_instance())
+		{
+			visual = ncvisual_from_memory (data, len, ncerr);
+			if (visual == nullptr)
+				throw init_error ("Notcurses failed to create a new visual");
+		}
+
+		explicit Visual (int fd, nc_err_e *ncerr)
+     : Root(NotCurses::get_instance())
+		{
+			visual = ncvisual_from_fd (fd, ncerr);
+			if (visual == nullptr)
+				throw init_error ("Notcurses failed to create a new visual");
+		}
+
     explicit Visual (const uint32_t* rgba, int rows, int rowstride, int cols)
      : Root(NotCurses::get_instance())
     {
@@ -61,6 +93,11 @@ namespace ncpp
 			return ncvisual_decode (visual);
 		}
 
+		nc_err_e seek (uint64_t ns) const noexcept
+		{
+			return ncvisual_seek (visual, ns);
+		}
+
 		ncplane* render (const ncvisual_options* vopts) const NOEXCEPT_MAYBE
 		{
 			return ncvisual_render (get_notcurses (), visual, vopts); // FIXME error_guard
@@ -71,6 +108,16 @@ namespace ncpp
 			return error_guard<int> (ncvisual_stream (get_notcurses (), visual, ncerr, timescale, streamer, vopts, curry), -1);
 		}
 
+		int tier () const noexcept
+		{
+			return ncvisual_tier (visual);
+		}
+
+		bool record (size_t maxbytes) const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncvisual_record (visual, maxbytes), -1);
+		}
+
 		char* subtitle () const noexcept
 		{
 			return ncvisual_subtitle (visual);
@@ -40,6 +40,7 @@ struct ncselector;// widget supporting selecting 1 from a list of options
 struct ncmultiselector; // widget supporting selecting 0..n from n options
 struct ncreader;  // widget supporting free string input ala readline
 struct ncfadectx; // context for a palette fade operation
+struct ncsnapshot;// saved contents of an ncplane, see ncplane_snapshot()
 
 // Initialize a direct-mode notcurses context on the connected terminal at 'fp'.
 // 'fp' must be a tty. You'll usually want stdout. Direct mode supportes a
@@ -766,6 +767,15 @@ typedef enum {
 // doing something weird (setting a locale not based on LANG).
 #define NCOPTION_INHIBIT_SETLOCALE 0x0001
 
+// Sixel support can't be reliably detected, and is assumed only for a few
+// terminal types known to always support it. Set this bit to use Sixel
+// graphics (NCBLIT_SIXEL) regardless of the terminal type.
+#define NCOPTION_SIXEL             0x0002
+
+// Likewise, the kitty graphics protocol is assumed only for kitty itself. Set
+// this bit to use it (NCBLIT_KITTY) regardless of the terminal type.
+#define NCOPTION_KITTY             0x0004
+
 // Configuration for notcurses_init().
 typedef struct notcurses_options {
   // The name of the terminfo database entry describing this terminal. If NULL,
@@ -823,6 +833,23 @@ typedef enum {
 // Lex a visual scaling mode (one of "none", "stretch", or "scale").
 API int notcurses_lex_scalemode(const char* op, ncscale_e* scalemode);
 
+// The filter used when a visual is scaled. NCSCALEQ_DEFAULT leaves it to the
+// multimedia engine (Lanczos with FFmpeg). NCSCALEQ_BOX is a built-in integer
+// box filter, fastest for the large reductions typical of rendering to cells;
+// it's the only filter available without a multimedia engine.
+typedef enum {
+  NCSCALEQ_DEFAULT,
+  NCSCALEQ_FAST,     // fast bilinear
+  NCSCALEQ_AREA,     // area averaging
+  NCSCALEQ_BICUBIC,
+  NCSCALEQ_LANCZOS,
+  NCSCALEQ_BOX,      // built-in box filter
+} ncscalequality_e;
+
+// Lex a scaling quality (one of "default", "fast", "area", "bicubic",
+// "lanczos", or "box").
+API int notcurses_lex_scalequality(const char* op, ncscalequality_e* quality);
+
 // Initialize a notcurses context on the connected terminal at 'fp'. 'fp' must
 // be a tty. You'll usually want stdout. NULL can be supplied for 'fp', in
 // which case /dev/tty will be opened. Returns NULL on error, including any
@@ -1004,9 +1031,27 @@ API struct ncplane* ncplane_reparent(struct ncplane* n, struct ncplane* newparen
 
 // Duplicate an existing ncplane. The new plane will have the same geometry,
 // will duplicate all content, and will start with the same rendering state.
-// The new plane will be immediately above the old one on the z axis.
+// The new plane will be immediately above the old one on the z axis. The
+// content is shared copy-on-write, so duplication is cheap; writes to either
+// plane copy only the affected region of the framebuffer.
 API struct ncplane* ncplane_dup(const struct ncplane* n, void* opaque);
 
+// Capture the contents of 'n' (its cells, geometry, cursor, styling, and base
+// cell) into an opaque ncsnapshot. Like ncplane_dup(), the content is shared
+// copy-on-write, making snapshots cheap to take and to hold. The plane's
+// position, z-axis location, and bindings are not part of the snapshot.
+API struct ncsnapshot* ncplane_snapshot(const struct ncplane* n);
+
+// Return 'n' to the contents captured in 's', which must have been taken from
+// a plane of the same notcurses context. 's' remains valid, and can be
+// restored again. The standard plane can only be restored from a snapshot of
+// its current geometry. Returns 0 on success, -1 on error.
+API int ncplane_restore(struct ncplane* n, const struct ncsnapshot* s);
+
+// Destroy a snapshot. Planes restored from it are unaffected. Snapshots are
+// not freed by notcurses_stop(), and must be destroyed before it is called.
+API void ncsnapshot_destroy(struct ncsnapshot* s);
+
 // provided a coordinate relative to the origin of 'src', map it to the same
 // absolute coordinate relative to thte origin of 'dst'. either or both of 'y'
 // and 'x' may be NULL. if 'dst' is NULL, it is taken to be the standard plane.
@@ -1052,9 +1097,12 @@ API bool notcurses_canopen_videos(const struct notcurses* nc);
 // Is our encoding UTF-8? Requires LANG being set to a UTF8 locale.
 API bool notcurses_canutf8(const struct notcurses* nc);
 
-// Can we blit to Sixel? This requires being built against libsixel.
+// Can we blit to Sixel? See NCOPTION_SIXEL.
 API bool notcurses_cansixel(const struct notcurses* nc);
 
+// Can we blit using the kitty graphics protocol? See NCOPTION_KITTY.
+API bool notcurses_cankitty(const struct notcurses* nc);
+
 typedef struct ncstats {
   // purely increasing stats
   uint64_t renders;          // number of successful notcurses_render() runs
@@ -1077,6 +1125,18 @@ typedef struct ncstats {
   // current state -- these can decrease
   uint64_t fbbytes;          // total bytes devoted to all active framebuffers
   unsigned planes;           // number of planes currently in existence
+
+  // purely increasing stats of streamed visuals
+  uint64_t frames_decoded;   // frames decoded by ncvisual_stream()
+  uint64_t frames_dropped;   // decoded frames skipped to keep up
+  uint64_t frames_late;      // frames displayed after their scheduled time
+  uint64_t decode_ns;        // ns spent decoding streamed frames
+  uint64_t scale_ns;         // ns spent scaling streamed frames
+  uint64_t blit_ns;          // ns spent blitting streamed frames
+  uint64_t scalebuf_hits;    // scaled frame buffers reused
+  uint64_t scalebuf_misses;  // scaled frame buffers allocated
+  uint64_t swsctx_hits;      // scaling contexts reused
+  uint64_t swsctx_misses;    // scaling contexts built
 } ncstats;
 
 // Acquire an atomic snapshot of the notcurses object's stats.
@@ -1220,6 +1280,14 @@ ncplane_at_yx_cell(struct ncplane* n, int y, int x, cell* c){
 API uint32_t* ncplane_rgba(const struct ncplane* nc, int begy, int begx,
                            int leny, int lenx);
 
+// As ncplane_rgba(), but write the pixels into the caller-supplied 'rgba',
+// which must have room for 2 * 'leny' * 'lenx' pixels (after resolving any
+// -1 lengths against the plane). No memory is allocated. Returns 0 on
+// success, or -1 on an invalid region or an undecomposable glyph (in which
+// case 'rgba' might have been partially written).
+API int ncplane_rgba_buf(const struct ncplane* nc, int begy, int begx,
+                         int leny, int lenx, uint32_t* rgba);
+
 // Create a flat string from the EGCs of the selected region of the ncplane
 // 'nc'. Start at the plane's 'begy'x'begx' coordinate (which must lie on the
 // plane), continuing for 'leny'x'lenx' cells. Either or both of 'leny' and
@@ -1227,6 +1295,15 @@ API uint32_t* ncplane_rgba(const struct ncplane* nc, int begy, int begx,
 API char* ncplane_contents(const struct ncplane* nc, int begy, int begx,
                            int leny, int lenx);
 
+// As ncplane_contents(), but write into the caller-supplied 'buf' of 'buflen'
+// bytes. Only whole EGCs are written, and the result is always NUL-terminated
+// if 'buflen' is positive. Returns the number of bytes necessary to hold the
+// entire region (not including the NUL terminator), or -1 on an invalid
+// region. Like snprintf(3), a return value greater than or equal to 'buflen'
+// indicates truncation.
+API int ncplane_contents_buf(const struct ncplane* nc, int begy, int begx,
+                             int leny, int lenx, char* buf, size_t buflen);
+
 // Manipulate the opaque user pointer associated with this plane.
 // ncplane_set_userptr() returns the previous userptr after replacing
 // it with 'opaque'. the others simply return the userptr.
@@ -1356,6 +1433,16 @@ ncplane_putwegc_yx(struct ncplane* n, int y, int x, const wchar_t* gclust,
 // of the plane will not be changed.
 API int ncplane_putwegc_stainable(struct ncplane* n, const wchar_t* gclust, int* sbytes);
 
+// As ncplane_putstr_yx(), but writing no more than 's' bytes of 'gclusters',
+// which needn't be NUL-terminated (e.g. a chunk read from a file descriptor).
+// On a scrolling plane, output which would scroll away before the write is
+// complete is never drawn, and the plane is scrolled in a single step. If
+// 's' ends partway through a multibyte character, output stops before it;
+// the bytes consumed are returned, and the remainder ought be resubmitted
+// ahead of the following input.
+API int ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s,
+                           const char* gclusters);
+
 // Write a series of EGCs to the current location, using the current style.
 // They will be interpreted as a series of columns (according to the definition
 // of ncplane_putc()). Advances the cursor by some positive number of cells
@@ -1364,25 +1451,7 @@ API int ncplane_putwegc_stainable(struct ncplane* n, const wchar_t* gclust, int*
 // which were written before the error.
 static inline int
 ncplane_putstr_yx(struct ncplane* n, int y, int x, const char* gclusters){
-  int ret = 0;
-  // FIXME speed up this blissfully naive solution
-  while(*gclusters){
-    int wcs;
-    int cols = ncplane_putegc_yx(n, y, x, gclusters, &wcs);
-    if(cols < 0){
-      return -ret;
-    }
-    if(wcs == 0){
-      break;
-    }
-    // after the first iteration, just let the cursor code control where we
-    // print, so that scrolling is taken into account
-    y = -1;
-    x = -1;
-    gclusters += wcs;
-    ret += wcs;
-  }
-  return ret;
+  return ncplane_putnstr_yx(n, y, x, strlen(gclusters), gclusters);
 }
 
 static inline int
@@ -1390,6 +1459,11 @@ ncplane_putstr(struct ncplane* n, const char* gclustarr){
   return ncplane_putstr_yx(n, -1, -1, gclustarr);
 }
 
+static inline int
+ncplane_putnstr(struct ncplane* n, size_t s, const char* gclustarr){
+  return ncplane_putnstr_yx(n, -1, -1, s, gclustarr);
+}
+
 API int ncplane_putstr_aligned(struct ncplane* n, int y, ncalign_e align,
                                const char* s);
 
@@ -2105,6 +2179,92 @@ ncplane_double_box_sized(struct ncplane* n, uint32_t attr, uint64_t channels,
 // image to memory.
 API struct ncvisual* ncvisual_from_file(const char* file, nc_err_e* ncerr);
 
+// As ncvisual_from_file(), but the visual will be rendered at no more than
+// 'rows'x'cols' pixels (either may be 0 if unconstrained). Where the decoder
+// supports it (e.g. JPEG's DCT scaling, or an image's MIP levels), the file
+// is decoded at the smallest reduced resolution which still covers that
+// geometry, which is much faster for large images and small targets. The
+// visual's geometry is that of the reduced image.
+API struct ncvisual* ncvisual_from_file_sized(const char* file, nc_err_e* ncerr,
+                                              int rows, int cols);
+
+// As ncvisual_from_file(), but decoding the 'len' encoded bytes at 'data'
+// (e.g. a PNG or JPEG received over IPC). 'data' is not copied, and must
+// remain valid until the ncvisual is destroyed.
+API struct ncvisual* ncvisual_from_memory(const void* data, size_t len,
+                                          nc_err_e* ncerr);
+
+// As ncvisual_from_file(), but reading from the open file descriptor 'fd',
+// which might be a pipe. Input is read as it's decoded, so 'fd' must remain
+// open until the ncvisual is destroyed; it is not closed.
+API struct ncvisual* ncvisual_from_fd(int fd, nc_err_e* ncerr);
+
+// Cache up to 'bytes' of decoded still images across calls to
+// ncvisual_from_file(), along with the scaled renderings made of them by
+// ncvisual_render(). Images are keyed on their path, modification time, and
+// size, and are evicted least-recently-used first. A cached ncvisual has no
+// further frames to decode. The cache is shared by the whole process, and is
+// disabled (0) by default; disabling it empties it.
+API void ncvisual_cache_limit(size_t bytes);
+
+typedef struct ncvisual_cachestats {
+  uint64_t hits, misses;          // ncvisual_from_file() lookups
+  uint64_t scaled_hits;           // renders which skipped scaling
+  uint64_t scaled_misses;         // renders which had to scale
+  uint64_t evictions;             // images dropped to stay under the limit
+  uint64_t bytes;                 // currently cached, scaled renderings included
+  uint64_t limit;                 // as set by ncvisual_cache_limit()
+  unsigned entries;               // images currently cached
+} ncvisual_cachestats;
+
+// Acquire the cache's counters. They are never reset.
+API void ncvisual_cache_stats(ncvisual_cachestats* stats);
+
+// An ncprefetch opens a list of files ahead of their being shown, e.g. by an
+// image browser, on threads of its own. Each is opened with
+// ncvisual_from_file_sized(), and still images are prescaled to the geometry
+// at which they'll be rendered, so that showing the next file is immediate.
+typedef struct ncprefetch_options {
+  int threads;          // decoding threads; 0 for one
+  int depth;            // files opened ahead of the last taken; 0 for two
+  size_t maxbytes;      // bound on pixels held ready; 0 for no bound
+  // the geometry in pixels at which the visuals will be rendered, i.e. the
+  // plane's geometry times the blitter's ratios (see ncvisual_geom()). 0 to
+  // open them at their own geometry.
+  int rows, cols;
+  // the scaling with which they'll be rendered. still images are prescaled
+  // to 'rows' x 'cols' with NCSCALE_STRETCH, and to the largest geometry
+  // within it having their aspect ratio with NCSCALE_SCALE. NCSCALE_NONE
+  // (the default) prescales nothing.
+  ncscale_e scaling;
+  // the filter with which they'll be rendered, and so prescaled
+  ncscalequality_e quality;
+} ncprefetch_options;
+
+struct ncprefetch;
+
+// Begin prefetching the first files of 'files', an array of 'count' paths,
+// which are copied. 'opts' may be NULL for the defaults.
+API struct ncprefetch* ncprefetch_create(const char* const* files, int count,
+                                         const ncprefetch_options* opts);
+
+// Take ownership of the visual for the file at 'idx', waiting for it to be
+// opened if necessary (or opening it on the calling thread, if it wasn't
+// being prefetched). The files following 'idx' are then prefetched in its
+// place; prefetched files outside that window (e.g. when skipping ahead)
+// are discarded. A file being opened can't be interrupted, but its visual is
+// discarded once it has been. Returns NULL on failure, setting 'ncerr'.
+API struct ncvisual* ncprefetch_take(struct ncprefetch* pf, int idx,
+                                     nc_err_e* ncerr);
+
+// The target geometry has changed (e.g. the terminal was resized, or the
+// blitter changed). Discard everything prefetched, and start anew.
+API void ncprefetch_retarget(struct ncprefetch* pf, int rows, int cols);
+
+// Stop prefetching, waiting for files being opened, and free any visuals
+// not taken.
+API void ncprefetch_destroy(struct ncprefetch* pf);
+
 // Prepare an ncvisual, and its underlying plane, based off RGBA content in
 // memory at 'rgba'. 'rgba' must be a flat array of 32-bit 8bpc RGBA pixels.
 // These must be arranged in 'rowstride' lines, where the first 'cols' * 4b
@@ -2139,13 +2299,14 @@ typedef enum {
   NCBLIT_4x1,     // four vert/horz levels     █▆▄▂ / ▎▌▊█
   NCBLIT_BRAILLE, // 4 rows, 2 cols (braille)  ⡀⡄⡆⡇⢀⣀⣄⣆⣇⢠⣠⣤⣦⣧⢰⣰⣴⣶⣷⢸⣸⣼⣾⣿
   NCBLIT_8x1,     // eight vert/horz levels    █▇▆▅▄▃▂▁ / ▏▎▍▌▋▊▉█
-  NCBLIT_SIXEL,   // 6 rows, 1 col (RGB), spotty support among terminals
+  NCBLIT_SIXEL,   // pixels (RGB), spotty support among terminals
+  NCBLIT_KITTY,   // pixels (RGBA), kitty graphics protocol
 } ncblitter_e;
 
 // Get the size and ratio of ncvisual pixels to output cells along the y
 // ('toy') and x ('tox') axes. A ncvisual of '*y'X'*x' pixels will require
 // ('*y' * '*toy')X('x' * 'tox') cells for full output. Returns non-zero
-// for an invalid 'blitter'.
+// for an invalid 'blitter'. If 'n' is NULL, only the ratios are returned.
 API int ncvisual_geom(const struct notcurses* nc, const struct ncvisual* n,
                       ncblitter_e blitter, int* y, int* x, int* toy, int* tox);
 
@@ -2157,8 +2318,17 @@ API void ncvisual_destroy(struct ncvisual* ncv);
 // and NCERR_SUCCESS on success, otherwise some other NCERR.
 API nc_err_e ncvisual_decode(struct ncvisual* nc);
 
-// Rotate the visual 'rads' radians. Only M_PI/2 and -M_PI/2 are
-// supported at the moment, but this will change FIXME.
+// Make the frame shown 'ns' nanoseconds into the media the current frame, as
+// if ncvisual_decode() had reached it. Frames are decoded forward from the
+// latest keyframe preceding 'ns' (keyframes are remembered as they're read),
+// or from the current frame, if that's closer. Returns NCERR_EOF if the media
+// ends before 'ns', and NCERR_DECODE if it can't be sought (e.g. backwards
+// through a pipe). May be called from a streamer, in which case the stream
+// carries on from the frame sought once the streamer returns.
+API nc_err_e ncvisual_seek(struct ncvisual* nc, uint64_t ns);
+
+// Rotate the visual 'rads' radians. Multiples of M_PI/2 move each pixel
+// exactly; other angles take the nearest source pixel.
 API nc_err_e ncvisual_rotate(struct ncvisual* n, double rads);
 
 // Resize the visual so that it is 'rows' X 'columns'. This is a lossy
@@ -2167,6 +2337,9 @@ API nc_err_e ncvisual_resize(struct ncvisual* n, int rows, int cols);
 
 #define NCVISUAL_OPTION_MAYDEGRADE 0x0001 // blitter can be worse than requested
 #define NCVISUAL_OPTION_BLEND      0x0002 // use CELL_ALPHA_BLEND with visual
+#define NCVISUAL_OPTION_PARALLEL   0x0004 // scale and blit in bands on threads
+#define NCVISUAL_OPTION_DELTA      0x0008 // only redraw cells which changed
+#define NCVISUAL_OPTION_ADAPTIVE   0x0010 // degrade streams to keep up
 
 struct ncvisual_options {
   // if no ncplane is provided, one will be created using the exact size
@@ -2191,6 +2364,12 @@ struct ncvisual_options {
   // UTF8) or NCBLIT_1x1 (in an ASCII environment)
   ncblitter_e blitter; // glyph set to use (maps input to output cells)
   uint64_t flags; // bitmask over NCVISUAL_OPTION_*
+  // with NCVISUAL_OPTION_DELTA, changes no larger than this in every channel
+  // of a cell's pixels don't cause it to be redrawn.
+  unsigned delta_threshold;
+  // the filter used if the source is scaled. cheaper filters are often
+  // indistinguishable once the output is reduced to cells.
+  ncscalequality_e quality;
 };
 
 // Render the decoded frame to the specified ncplane (if one is not provided,
@@ -2227,11 +2406,32 @@ API int ncvisual_simple_streamer(struct ncvisual* ncv, struct ncvisual_options*
 // streamer(). 'timescale' allows the frame duration time to be scaled. For a
 // visual naturally running at 30FPS, a 'timescale' of 0.1 will result in
 // 300FPS, and a 'timescale' of 10 will result in 3FPS. It is an error to
-// supply 'timescale' less than or equal to 0.
+// supply 'timescale' less than or equal to 0. Frames are decoded and scaled
+// ahead on other threads; a frame is skipped if its successor is already due.
+// streamer() must not call ncvisual_decode(), but may call ncvisual_seek().
+// Frames decoded ahead but not displayed are discarded.
 API int ncvisual_stream(struct notcurses* nc, struct ncvisual* ncv,
                         nc_err_e* ncerr, float timescale, streamcb streamer,
                         const struct ncvisual_options* vopts, void* curry);
 
+// The tier at which ncvisual_stream() rendered the current frame of 'ncv' with
+// NCVISUAL_OPTION_ADAPTIVE: 0 for the options as provided, each greater tier
+// being cheaper (fewer pixels per cell, and finally coarse redraws). The
+// streamer is passed the options of the current tier. Always 0 otherwise.
+API int ncvisual_tier(const struct ncvisual* ncv);
+
+// Record the cells drawn by each frame of 'ncv' when it is next streamed, in
+// up to 'maxbytes', so that it can be played again without decoding, scaling,
+// or blitting (e.g. looping animations and sprites). While recording, each
+// ncvisual_stream() starts from the first frame. Once a stream has run to its
+// end, later streams with the same options (and an unresized plane) replay the
+// recording, keeping the stream's timing. A recording which would exceed
+// 'maxbytes' is abandoned, and those options are decoded as usual. 'vopts->n'
+// must be provided. Only the first frame is kept whole; following frames
+// store only the cells which they change. A 'maxbytes' of 0 stops recording,
+// and frees any recording.
+API int ncvisual_record(struct ncvisual* ncv, size_t maxbytes);
+
 // Blit a flat array 'data' of BGRx 32-bit values to the ncplane 'nc', offset
 // from the upper left by 'placey' and 'placex'. Each row ought occupy
 // 'linesize' bytes (this might be greater than lenx * 4 due to padding). A
@@ -2246,6 +2446,24 @@ API int ncblit_bgrx(struct ncplane* nc, int placey, int placex, int linesize,
 API int ncblit_rgba(struct ncplane* nc, int placey, int placex, int linesize,
                     const void* data, int begy, int begx, int leny, int lenx);
 
+// As ncblit_rgba(), but for 8-bit planar YUV 4:2:0, as decoded from most
+// video and JPEGs, without first converting the image to RGBA. 'planes' are Y,
+// U, and V, each with rows of 'linesizes' bytes; U and V have half the rows
+// and columns of Y. Colors are converted with BT.601, once per cell for the
+// pixels sharing chroma. If 'fullrange', samples span 0..255 (JPEG);
+// otherwise luma spans 16..235 (video).
+API int ncblit_yuv420p(struct ncplane* nc, int placey, int placex,
+                       const int linesizes[3], const void* const planes[3],
+                       int begy, int begx, int leny, int lenx, bool fullrange);
+
+// As ncblit_rgba(), but for packed 24-bit BGR.
+API int ncblit_bgr24(struct ncplane* nc, int placey, int placex, int linesize,
+                     const void* data, int begy, int begx, int leny, int lenx);
+
+// As ncblit_rgba(), but for 8-bit greyscale.
+API int ncblit_gray8(struct ncplane* nc, int placey, int placex, int linesize,
+                     const void* data, int begy, int begx, int leny, int lenx);
+
 // An ncreel is a notcurses region devoted to displaying zero or more
 // line-oriented, contained panels between which the user may navigate. If at
 // least one panel exists, there is an active panel. As much of the active
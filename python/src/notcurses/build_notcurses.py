@@ -126,6 +126,7 @@ bool notcurses_canopen_images(const struct notcurses* nc);
 bool notcurses_canopen_videos(const struct notcurses* nc);
 bool notcurses_canutf8(const struct notcurses* nc);
 bool notcurses_cansixel(const struct notcurses* nc);
+bool notcurses_cankitty(const struct notcurses* nc);
 int notcurses_mouse_enable(struct notcurses* n);
 int notcurses_mouse_disable(struct notcurses* n);
 int ncplane_destroy(struct ncplane* ncp);
@@ -148,7 +149,9 @@ int ncplane_at_cursor_cell(struct ncplane* n, cell* c);
 char* ncplane_at_yx(const struct ncplane* n, int y, int x, uint32_t* attrword, uint64_t* channels);
 int ncplane_at_yx_cell(struct ncplane* n, int y, int x, cell* c);
 uint32_t* ncplane_rgba(const struct ncplane* nc, int begy, int begx, int leny, int lenx);
+int ncplane_rgba_buf(const struct ncplane* nc, int begy, int begx, int leny, int lenx, uint32_t* rgba);
 char* ncplane_contents(const struct ncplane* nc, int begy, int begx, int leny, int lenx);
+int ncplane_contents_buf(const struct ncplane* nc, int begy, int begx, int leny, int lenx, char* buf, size_t buflen);
 void* ncplane_set_userptr(struct ncplane* n, void* opaque);
 void* ncplane_userptr(struct ncplane* n);
 int ncplane_resize(struct ncplane* n, int keepy, int keepx, int keepleny,
@@ -197,6 +200,16 @@ typedef struct ncstats {
   uint64_t bgemissions;      // RGB bg emissions
   uint64_t defaultelisions;  // default color was emitted
   uint64_t defaultemissions; // default color was elided
+  uint64_t frames_decoded;   // frames decoded by ncvisual_stream()
+  uint64_t frames_dropped;   // decoded frames skipped to keep up
+  uint64_t frames_late;      // frames displayed after their scheduled time
+  uint64_t decode_ns;        // ns spent decoding streamed frames
+  uint64_t scale_ns;         // ns spent scaling streamed frames
+  uint64_t blit_ns;          // ns spent blitting streamed frames
+  uint64_t scalebuf_hits;    // scaled frame buffers reused
+  uint64_t scalebuf_misses;  // scaled frame buffers allocated
+  uint64_t swsctx_hits;      // scaling contexts reused
+  uint64_t swsctx_misses;    // scaling contexts built
 } ncstats;
 void notcurses_stats(struct notcurses* nc, ncstats* stats);
 void notcurses_reset_stats(struct notcurses* nc, ncstats* stats);
@@ -211,7 +224,11 @@ int ncplane_putwc_yx(struct ncplane* n, int y, int x, wchar_t w);
 int ncplane_putwc(struct ncplane* n, wchar_t w);
 int ncplane_putegc_yx(struct ncplane* n, int y, int x, const char* gclust, int* sbytes);
 int ncplane_putstr_aligned(struct ncplane* n, int y, ncalign_e align, const char* s);
+int ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s, const char* gclusters);
 struct ncplane* ncplane_dup(const struct ncplane* n, void* opaque);
+struct ncsnapshot* ncplane_snapshot(const struct ncplane* n);
+int ncplane_restore(struct ncplane* n, const struct ncsnapshot* s);
+void ncsnapshot_destroy(struct ncsnapshot* s);
 void cell_init(cell* c);
 int cell_load(struct ncplane* n, cell* c, const char* gcluster);
 int cell_prime(struct ncplane* n, cell* c, const char* gcluster, uint32_t attr, uint64_t channels);
@@ -292,6 +309,14 @@ typedef enum {
   NCSCALE_SCALE,
   NCSCALE_STRETCH,
 } ncscale_e;
+typedef enum {
+  NCSCALEQ_DEFAULT,
+  NCSCALEQ_FAST,
+  NCSCALEQ_AREA,
+  NCSCALEQ_BICUBIC,
+  NCSCALEQ_LANCZOS,
+  NCSCALEQ_BOX,
+} ncscalequality_e;
 typedef enum {
   NCBLIT_1x1,     // full block                █
   NCBLIT_2x1,     // full/(upper|left) blocks  ▄█
@@ -300,20 +325,50 @@ typedef enum {
   NCBLIT_4x1,     // four vert/horz levels     █▆▄▂ / ▎▌▊█
   NCBLIT_BRAILLE, // 4 rows, 2 cols (braille)  ⡀⡄⡆⡇⢀⣀⣄⣆⣇⢠⣠⣤⣦⣧⢰⣰⣴⣶⣷⢸⣸⣼⣾⣿
   NCBLIT_8x1,     // eight vert/horz levels    █▇▆▅▄▃▂▁ / ▏▎▍▌▋▊▉█
-  NCBLIT_SIXEL,   // 6 rows, 1 col (RGB)
+  NCBLIT_SIXEL,   // pixels (RGB)
+  NCBLIT_KITTY,   // pixels (RGBA)
 } ncblitter_e;
 struct ncvisual* ncvisual_from_file(const char* file, nc_err_e* ncerr);
+struct ncvisual* ncvisual_from_file_sized(const char* file, nc_err_e* ncerr, int rows, int cols);
+struct ncvisual* ncvisual_from_memory(const void* data, size_t len, nc_err_e* ncerr);
+struct ncvisual* ncvisual_from_fd(int fd, nc_err_e* ncerr);
+void ncvisual_cache_limit(size_t bytes);
+typedef struct ncvisual_cachestats {
+  uint64_t hits, misses;
+  uint64_t scaled_hits;
+  uint64_t scaled_misses;
+  uint64_t evictions;
+  uint64_t bytes;
+  uint64_t limit;
+  unsigned entries;
+} ncvisual_cachestats;
+void ncvisual_cache_stats(ncvisual_cachestats* stats);
+typedef struct ncprefetch_options {
+  int threads;
+  int depth;
+  size_t maxbytes;
+  int rows, cols;
+  ncscale_e scaling;
+  ncscalequality_e quality;
+} ncprefetch_options;
+struct ncprefetch* ncprefetch_create(const char* const* files, int count, const ncprefetch_options* opts);
+struct ncvisual* ncprefetch_take(struct ncprefetch* pf, int idx, nc_err_e* ncerr);
+void ncprefetch_retarget(struct ncprefetch* pf, int rows, int cols);
+void ncprefetch_destroy(struct ncprefetch* pf);
 struct ncvisual* ncvisual_from_rgba(const void* rgba, int rows, int rowstride, int cols);
 struct ncvisual* ncvisual_from_bgra(const void* rgba, int rows, int rowstride, int cols);
 struct ncvisual* ncvisual_from_plane(const struct ncplane* n, int begy, int begx, int leny, int lenx);
 int ncvisual_geom(const struct notcurses* nc, const struct ncvisual* n, ncblitter_e blitter, int* y, int* x, int* toy, int* tox);
 void ncvisual_destroy(struct ncvisual* ncv);
 nc_err_e ncvisual_decode(struct ncvisual* nc);
+nc_err_e ncvisual_seek(struct ncvisual* nc, uint64_t ns);
 int ncvisual_rotate(struct ncvisual* n, double rads);
 struct ncplane* ncvisual_render(struct notcurses* nc, struct ncvisual* ncv, const struct ncvisual_options* vopts);
 char* ncvisual_subtitle(const struct ncvisual* ncv);
 typedef int (*streamcb)(struct ncplane*, struct ncvisual*, const struct timespec*, void*);
 int ncvisual_stream(struct notcurses* nc, struct ncvisual* ncv, nc_err_e* ncerr, float timescale, streamcb streamer, const struct ncvisual_options* vopts, void* curry);
+int ncvisual_tier(const struct ncvisual* ncv);
+int ncvisual_record(struct ncvisual* ncv, size_t maxbytes);
 struct ncvisual_options {
   struct ncplane* n;
   ncscale_e scaling;
@@ -322,9 +377,14 @@ struct ncvisual_options {
   int leny, lenx;
   ncblitter_e blitter;
   uint64_t flags;
+  unsigned delta_threshold;
+  ncscalequality_e quality;
 };
 int ncblit_bgrx(struct ncplane* nc, int placey, int placex, int linesize, const unsigned char* data, int begy, int begx, int leny, int lenx);
 int ncblit_rgba(struct ncplane* nc, int placey, int placex, int linesize, const unsigned char* data, int begy, int begx, int leny, int lenx);
+int ncblit_yuv420p(struct ncplane* nc, int placey, int placex, const int linesizes[3], const void* const planes[3], int begy, int begx, int leny, int lenx, bool fullrange);
+int ncblit_bgr24(struct ncplane* nc, int placey, int placex, int linesize, const void* data, int begy, int begx, int leny, int lenx);
+int ncblit_gray8(struct ncplane* nc, int placey, int placex, int linesize, const void* data, int begy, int begx, int leny, int lenx);
 struct ncselector_item {
   char* option;
   char* desc;
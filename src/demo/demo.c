@@ -458,6 +458,8 @@ int main(int argc, char** argv){
   if((nc = notcurses_init(&nopts, NULL)) == NULL){
     return EXIT_FAILURE;
   }
+  // demos named more than once in the spec reopen the same images
+  ncvisual_cache_limit(64 * 1024 * 1024);
   if(notcurses_mouse_enable(nc)){
     goto err;
   }
@@ -0,0 +1,152 @@
+#include <limits.h>
+#include "internal.h"
+#include "blitset.h"
+
+// Tiers of an adaptive stream (see NCVISUAL_OPTION_ADAPTIVE). Tier 0 is the
+// options as provided; each following tier uses a blitter with fewer pixels
+// per cell, and the last additionally scales cheaply, and only redraws cells
+// which have changed appreciably (cutting the bytes written to the terminal).
+// For each tier we keep moving averages of the time taken to blit a frame,
+// and of the bytes its render emitted. The rate at which the terminal drains
+// our output is averaged across all tiers, so the cost of a tier (its blit,
+// plus the time to drain its bytes) can be predicted without visiting it.
+
+#define ADAPT_TIERS_MAX 5
+#define ADAPT_LATE_FRAMES 3    // consecutive late frames before stepping down
+#define ADAPT_IDLE_FRAMES 30   // consecutive comfortable frames before stepping up
+#define ADAPT_HEADROOM 0.6     // share of the interval a tier must fit to step up
+#define ADAPT_COARSE_THRESHOLD 24
+
+typedef struct adapttier {
+  ncblitter_e blitter;
+  ncscalequality_e quality;
+  uint64_t flags;
+  unsigned delta_threshold;
+  double blitns;               // moving averages, 0 until measured
+  double bytes;
+} adapttier;
+
+struct ncadapt {
+  adapttier tiers[ADAPT_TIERS_MAX];
+  int count;
+  int cur;
+  double drain;                // bytes per ns, 0 until measured
+  double intervalns;           // between frames, as scheduled
+  int late;                    // consecutive frames over budget
+  int idle;                    // consecutive frames within the headroom
+};
+
+static inline double
+adapt_average(double avg, double sample){
+  return avg ? avg + (sample - avg) / 8 : sample;
+}
+
+static int
+adapt_pixels(const notcurses* nc, const struct blitset* bset){
+  if(bset->geom == NCBLIT_SIXEL || bset->geom == NCBLIT_KITTY){
+    const int pixels = nc->cellpixy * nc->cellpixx;
+    return pixels > 0 ? pixels : INT_MAX;
+  }
+  return bset->width * bset->height;
+}
+
+ncadapt* ncadapt_create(const notcurses* nc, const struct ncvisual_options* vopts){
+  const struct blitset* bset = rgba_blitter(nc, vopts);
+  if(bset == NULL){
+    return NULL;
+  }
+  ncadapt* a = malloc(sizeof(*a));
+  if(a == NULL){
+    return NULL;
+  }
+  memset(a, 0, sizeof(*a));
+  adapttier* t = &a->tiers[a->count++];
+  t->blitter = vopts->blitter;
+  t->quality = vopts->quality;
+  t->flags = vopts->flags;
+  t->delta_threshold = vopts->delta_threshold;
+  int pixels = adapt_pixels(nc, bset);
+  static const ncblitter_e steps[] = { NCBLIT_2x2, NCBLIT_2x1, NCBLIT_1x1, };
+  for(size_t i = 0 ; i < sizeof(steps) / sizeof(*steps) ; ++i){
+    const struct blitset* b = lookup_blitset(nc, steps[i], false);
+    if(b == NULL || b->blit == NULL || adapt_pixels(nc, b) >= pixels){
+      continue;
+    }
+    pixels = adapt_pixels(nc, b);
+    a->tiers[a->count] = a->tiers[a->count - 1];
+    t = &a->tiers[a->count++];
+    t->blitter = steps[i];
+  }
+  a->tiers[a->count] = a->tiers[a->count - 1];
+  t = &a->tiers[a->count++];
+  if(t->quality != NCSCALEQ_BOX){
+    t->quality = NCSCALEQ_FAST;
+  }
+  t->flags |= NCVISUAL_OPTION_DELTA;
+  if(t->delta_threshold < ADAPT_COARSE_THRESHOLD){
+    t->delta_threshold = ADAPT_COARSE_THRESHOLD;
+  }
+  return a;
+}
+
+void ncadapt_destroy(ncadapt* a){
+  free(a);
+}
+
+// the predicted cost of a frame at tier 't'. a tier not yet visited is
+// guessed at twice the cost of the one below it.
+static double
+adapt_cost(const ncadapt* a, int t){
+  const adapttier* at = &a->tiers[t];
+  if(at->blitns == 0){
+    return t + 1 < a->count ? 2 * adapt_cost(a, t + 1) : 0;
+  }
+  return at->blitns + (a->drain ? at->bytes / a->drain : 0);
+}
+
+int ncadapt_frame(ncadapt* a, uint64_t blitns, uint64_t bytes,
+                  uint64_t renderns, uint64_t intervalns, bool late){
+  adapttier* t = &a->tiers[a->cur];
+  t->blitns = adapt_average(t->blitns, blitns);
+  if(renderns){ // the streamer needn't render
+    t->bytes = adapt_average(t->bytes, bytes);
+    if(bytes){
+      a->drain = adapt_average(a->drain, (double)bytes / renderns);
+    }
+  }
+  if(intervalns){
+    a->intervalns = adapt_average(a->intervalns, intervalns);
+  }
+  if(a->intervalns == 0){
+    return a->cur;
+  }
+  // a frame can be late through slow decoding, which cheaper rendering won't
+  // help, so lateness only counts if rendering takes a fair share of the time
+  const double cost = adapt_cost(a, a->cur);
+  if(cost > a->intervalns || (late && cost > a->intervalns * ADAPT_HEADROOM)){
+    a->idle = 0;
+    if(++a->late >= ADAPT_LATE_FRAMES && a->cur + 1 < a->count){
+      ++a->cur;
+      a->late = 0;
+    }
+  }else{
+    a->late = 0;
+    if(a->cur && adapt_cost(a, a->cur - 1) < a->intervalns * ADAPT_HEADROOM){
+      if(++a->idle >= ADAPT_IDLE_FRAMES){
+        --a->cur;
+        a->idle = 0;
+      }
+    }else{
+      a->idle = 0;
+    }
+  }
+  return a->cur;
+}
+
+void ncadapt_apply(const ncadapt* a, struct ncvisual_options* vopts){
+  const adapttier* t = &a->tiers[a->cur];
+  vopts->blitter = t->blitter;
+  vopts->quality = t->quality;
+  vopts->flags = t->flags;
+  vopts->delta_threshold = t->delta_threshold;
+}
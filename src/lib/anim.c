@@ -0,0 +1,319 @@
+#include "internal.h"
+
+// A recording of the cells written by each frame of a streamed ncvisual (see
+// ncvisual_record()), so that later loops needn't decode, scale, or blit. The
+// first frame is kept whole; each following frame only as the cells which it
+// changed. EGCs are interned in a single arena, so that a cell costs the same
+// whatever its glyph. While recording, the region as last recorded is kept
+// for comparison, and discarded once the recording is complete.
+
+typedef struct animcell {
+  uint32_t idx;               // offset of the cell within the region
+  uint32_t egc;               // offset of its EGC within the arena
+  uint32_t attrword;
+  uint64_t channels;
+} animcell;
+
+typedef struct animframe {
+  uint64_t offsetns;          // from the beginning of the stream, unscaled
+  size_t first, count;        // cells of this frame
+} animframe;
+
+struct ncanim {
+  size_t maxbytes;
+  size_t bytes;               // of the recording, not counting 'prev'
+  ncanim_e state;
+  // the options recorded, and the geometry of their plane at the time
+  struct ncvisual_options vopts;
+  int planey, planex;
+  int y, x, rows, cols;       // region recorded
+  animframe* frames;
+  size_t framecount, framesize;
+  animcell* cells;
+  size_t cellcount, cellsize;
+  char* egcs;
+  size_t egclen, egcsize;
+  uint32_t* slots;            // hash of 'egcs': offsets plus one, 0 if empty
+  size_t slotcount, slotsused;
+  animcell* prev;             // rows x cols, while recording
+};
+
+ncanim* ncanim_create(size_t maxbytes){
+  ncanim* ret = malloc(sizeof(*ret));
+  if(ret){
+    memset(ret, 0, sizeof(*ret));
+    ret->maxbytes = maxbytes;
+  }
+  return ret;
+}
+
+// free the recording, if any, and enter 'state'
+static void
+ncanim_clear(ncanim* a, ncanim_e state){
+  free(a->frames);
+  free(a->cells);
+  free(a->egcs);
+  free(a->slots);
+  free(a->prev);
+  a->frames = NULL;
+  a->cells = NULL;
+  a->egcs = NULL;
+  a->slots = NULL;
+  a->prev = NULL;
+  a->framecount = a->framesize = 0;
+  a->cellcount = a->cellsize = 0;
+  a->egclen = a->egcsize = 0;
+  a->slotcount = a->slotsused = 0;
+  a->bytes = 0;
+  a->state = state;
+}
+
+void ncanim_destroy(ncanim* a){
+  if(a){
+    ncanim_clear(a, NCANIM_EMPTY);
+    free(a);
+  }
+}
+
+void ncanim_limit(ncanim* a, size_t maxbytes){
+  a->maxbytes = maxbytes;
+  if(a->bytes > maxbytes){
+    ncanim_clear(a, NCANIM_ABANDONED);
+  }
+}
+
+ncanim_e ncanim_lookup(const ncanim* a, const struct ncvisual_options* vopts){
+  if(a->state == NCANIM_EMPTY){
+    return NCANIM_EMPTY;
+  }
+  const struct ncvisual_options* v = &a->vopts;
+  int dimy, dimx;
+  ncplane_dim_yx(vopts->n, &dimy, &dimx);
+  if(v->n != vopts->n || a->planey != dimy || a->planex != dimx ||
+     v->scaling != vopts->scaling || v->quality != vopts->quality ||
+     v->y != vopts->y || v->x != vopts->x ||
+     v->begy != vopts->begy || v->begx != vopts->begx ||
+     v->leny != vopts->leny || v->lenx != vopts->lenx ||
+     v->blitter != vopts->blitter || v->flags != vopts->flags ||
+     v->delta_threshold != vopts->delta_threshold){
+    return NCANIM_EMPTY;
+  }
+  return a->state;
+}
+
+void ncanim_begin(ncanim* a, const struct ncvisual_options* vopts){
+  ncanim_clear(a, NCANIM_RECORDING);
+  memcpy(&a->vopts, vopts, sizeof(*vopts));
+  ncplane_dim_yx(vopts->n, &a->planey, &a->planex);
+}
+
+void ncanim_cancel(ncanim* a){
+  if(a->state == NCANIM_RECORDING){
+    ncanim_clear(a, NCANIM_EMPTY);
+  }
+}
+
+void ncanim_finish(ncanim* a){
+  if(a->state == NCANIM_RECORDING){
+    if(a->framecount == 0){
+      ncanim_clear(a, NCANIM_EMPTY);
+      return;
+    }
+    free(a->prev);
+    a->prev = NULL;
+    free(a->slots); // only needed to intern new EGCs
+    a->slots = NULL;
+    a->slotcount = a->slotsused = 0;
+    a->state = NCANIM_COMPLETE;
+  }
+}
+
+// grow the array 'p' of 'size' elements of 'esize' bytes to hold at least
+// 'need', accounting for any new space in the recording's bytes.
+static int
+anim_reserve(ncanim* a, void** p, size_t* size, size_t need, size_t esize){
+  if(need <= *size){
+    return 0;
+  }
+  size_t nsize = *size ? *size * 2 : 64;
+  while(nsize < need){
+    nsize *= 2;
+  }
+  void* tmp = realloc(*p, nsize * esize);
+  if(tmp == NULL){
+    return -1;
+  }
+  a->bytes += (nsize - *size) * esize;
+  *p = tmp;
+  *size = nsize;
+  return 0;
+}
+
+static inline uint32_t
+anim_hash(const char* s){
+  uint32_t h = 2166136261u; // FNV-1a
+  while(*s){
+    h = (h ^ (unsigned char)*s++) * 16777619u;
+  }
+  return h;
+}
+
+static int
+anim_rehash(ncanim* a){
+  const size_t count = a->slotcount ? a->slotcount * 2 : 64;
+  uint32_t* slots = calloc(count, sizeof(*slots));
+  if(slots == NULL){
+    return -1;
+  }
+  for(size_t i = 0 ; i < a->slotcount ; ++i){
+    if(a->slots[i]){
+      size_t s = anim_hash(a->egcs + a->slots[i] - 1) & (count - 1);
+      while(slots[s]){
+        s = (s + 1) & (count - 1);
+      }
+      slots[s] = a->slots[i];
+    }
+  }
+  a->bytes += (count - a->slotcount) * sizeof(*slots);
+  free(a->slots);
+  a->slots = slots;
+  a->slotcount = count;
+  return 0;
+}
+
+// the offset of 'egc' within the arena, adding it if necessary
+static int64_t
+anim_intern(ncanim* a, const char* egc){
+  if((a->slotsused + 1) * 2 > a->slotcount){
+    if(anim_rehash(a)){
+      return -1;
+    }
+  }
+  size_t s = anim_hash(egc) & (a->slotcount - 1);
+  while(a->slots[s]){
+    if(strcmp(a->egcs + a->slots[s] - 1, egc) == 0){
+      return a->slots[s] - 1;
+    }
+    s = (s + 1) & (a->slotcount - 1);
+  }
+  const size_t len = strlen(egc) + 1;
+  if(anim_reserve(a, (void**)&a->egcs, &a->egcsize, a->egclen + len, 1)){
+    return -1;
+  }
+  const size_t off = a->egclen;
+  memcpy(a->egcs + off, egc, len);
+  a->egclen += len;
+  a->slots[s] = off + 1;
+  ++a->slotsused;
+  return off;
+}
+
+// abandon the recording if it's grown past the limit
+static int
+anim_check(ncanim* a){
+  if(a->bytes > a->maxbytes){
+    ncanim_clear(a, NCANIM_ABANDONED);
+    return -1;
+  }
+  return 0;
+}
+
+int ncanim_record(ncanim* a, const ncplane* n, int y, int x, int rows,
+                  int cols, uint64_t offsetns){
+  if(a->state != NCANIM_RECORDING){
+    return -1;
+  }
+  // only the part of the region on the plane was drawn
+  if(y < 0){
+    rows += y;
+    y = 0;
+  }
+  if(x < 0){
+    cols += x;
+    x = 0;
+  }
+  if(rows > n->leny - y){
+    rows = n->leny - y;
+  }
+  if(cols > n->lenx - x){
+    cols = n->lenx - x;
+  }
+  if(rows <= 0 || cols <= 0){
+    rows = cols = 0;
+  }
+  if(a->framecount == 0){
+    a->y = y;
+    a->x = x;
+    a->rows = rows;
+    a->cols = cols;
+    if((a->prev = malloc(sizeof(*a->prev) * ((size_t)rows * cols + 1))) == NULL){
+      ncanim_clear(a, NCANIM_EMPTY);
+      return -1;
+    }
+  }else if(a->y != y || a->x != x || a->rows != rows || a->cols != cols){
+    ncanim_clear(a, NCANIM_ABANDONED); // frames of varying geometry
+    return -1;
+  }
+  if(anim_reserve(a, (void**)&a->frames, &a->framesize, a->framecount + 1,
+                  sizeof(*a->frames))){
+    ncanim_clear(a, NCANIM_EMPTY);
+    return -1;
+  }
+  animframe* f = &a->frames[a->framecount];
+  f->offsetns = offsetns;
+  f->first = a->cellcount;
+  f->count = 0;
+  for(int yy = 0 ; yy < rows ; ++yy){
+    for(int xx = 0 ; xx < cols ; ++xx){
+      const cell* c = ncplane_cell_const(n, y + yy, x + xx);
+      char simple[2] = { (char)c->gcluster, '\0' };
+      const int64_t egc = anim_intern(a, cell_simple_p(c) ? simple : extended_gcluster(n, c));
+      if(egc < 0){
+        ncanim_clear(a, NCANIM_EMPTY);
+        return -1;
+      }
+      const uint32_t idx = yy * cols + xx;
+      animcell* p = &a->prev[idx];
+      if(a->framecount && p->egc == egc && p->attrword == c->attrword &&
+         p->channels == c->channels){
+        continue;
+      }
+      p->idx = idx;
+      p->egc = egc;
+      p->attrword = c->attrword;
+      p->channels = c->channels;
+      if(anim_reserve(a, (void**)&a->cells, &a->cellsize, a->cellcount + 1,
+                      sizeof(*a->cells))){
+        ncanim_clear(a, NCANIM_EMPTY);
+        return -1;
+      }
+      a->cells[a->cellcount++] = *p;
+      ++f->count;
+    }
+  }
+  ++a->framecount;
+  return anim_check(a);
+}
+
+size_t ncanim_frames(const ncanim* a){
+  return a->framecount;
+}
+
+uint64_t ncanim_offset(const ncanim* a, size_t frame){
+  return a->frames[frame].offsetns;
+}
+
+int ncanim_apply(const ncanim* a, ncplane* n, size_t frame){
+  const animframe* f = &a->frames[frame];
+  for(size_t i = f->first ; i < f->first + f->count ; ++i){
+    const animcell* ac = &a->cells[i];
+    cell* c = ncplane_cell_ref_yx(n, a->y + ac->idx / a->cols,
+                                  a->x + ac->idx % a->cols);
+    if(c == NULL || cell_load(n, c, a->egcs + ac->egc) < 0){
+      return -1;
+    }
+    c->attrword = ac->attrword;
+    c->channels = ac->channels;
+  }
+  return 0;
+}
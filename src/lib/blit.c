@@ -2,84 +2,183 @@
 
 static const unsigned char zeroes[] = "\x00\x00\x00\x00";
 
-// linearly interpolate a 24-bit RGB value along each 8-bit channel
-static inline uint32_t
-lerp(uint32_t c0, uint32_t c1){
-  uint32_t ret = 0;
-  unsigned r0, g0, b0, r1, g1, b1;
-  channel_rgb(c0, &r0, &g0, &b0);
-  channel_rgb(c1, &r1, &g1, &b1);
-  channel_set_rgb(&ret, (r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2);
-  return ret;
+// the blitters are written as kernels taking 'bgr' and 'blendcolors', which
+// are always inlined into a specialization for each combination (see
+// BLIT_SPECIALIZE), so that tests of either fold away within the per-cell
+// loops. kernels write directly into the framebuffer, one row at a time.
+#define BLIT_KERNEL __attribute__ ((always_inline)) static inline int
+
+#define BLIT_SPECIALIZE(blitter, kernel) \
+static int \
+blitter(ncplane* nc, int placey, int placex, int linesize, const void* data, \
+        int begy, int begx, int leny, int lenx, bool bgr, bool blendcolors){ \
+  if(bgr){ \
+    return blendcolors ? \
+      kernel(nc, placey, placex, linesize, data, begy, begx, leny, lenx, true, true) : \
+      kernel(nc, placey, placex, linesize, data, begy, begx, leny, lenx, true, false); \
+  } \
+  return blendcolors ? \
+    kernel(nc, placey, placex, linesize, data, begy, begx, leny, lenx, false, true) : \
+    kernel(nc, placey, placex, linesize, data, begy, begx, leny, lenx, false, false); \
 }
 
-// linearly interpolate a 24-bit RGB value along each 8-bit channel
+// a channel having the given alpha, which is not the default color
+#define BLIT_ALPHA(alpha) ((uint32_t)CELL_BGDEFAULT_MASK | ((alpha) << CELL_ALPHA_SHIFT))
+
+// a channel having the RGB of the pixel 'px', which is not the default color.
+// the alpha bits are clear, to be ORed in.
 static inline uint32_t
-trilerp(uint32_t c0, uint32_t c1, uint32_t c2){
-  uint32_t ret = 0;
-  unsigned r0, g0, b0, r1, g1, b1, r2, g2, b2;
-  channel_rgb(c0, &r0, &g0, &b0);
-  channel_rgb(c1, &r1, &g1, &b1);
-  channel_rgb(c2, &r2, &g2, &b2);
-  channel_set_rgb(&ret, (r0 + r1 + r2 + 2) / 3,
-                        (g0 + g1 + g2 + 2) / 3,
-                        (b0 + b1 + b2 + 2) / 3);
-  return ret;
+blit_rgb(const unsigned char* px, bool bgr){
+  return (uint32_t)CELL_BGDEFAULT_MASK |
+         (px[bgr ? 2 : 0] << 16u) | (px[1] << 8u) | px[bgr ? 0 : 2];
 }
 
-// alpha comes to us 0--255, but we have only 3 alpha values to map them to.
-// settled on experimentally.
+// a cell whose EGC a band couldn't write without modifying the egcpool. it
+// is written by blitbands_finish(), once all bands are done.
+typedef struct egcdeferral {
+  cell* c;
+  char egc[5];           // NUL-terminated, as blit_egc() expects
+  unsigned char len;
+} egcdeferral;
+
+// the state of one band of a banded blit (see blitbands_init())
+typedef struct blitband {
+  egcdeferral* deferrals;
+  int deferred, deferralsize;
+  int total;             // cells written
+  int lasty, lastx;      // the last row started, for the cursor
+} blitband;
+
+// the band being blitted by this thread, if any. it's read for every cell,
+// so insist on the cheapest TLS access.
+static _Thread_local blitband* blit_banding __attribute__ ((tls_model ("initial-exec")));
+
+static int
+blit_egc_defer(blitband* band, cell* c, const char* egc, size_t len){
+  if(band->deferred == band->deferralsize){
+    const int size = band->deferralsize ? band->deferralsize * 2 : 256;
+    egcdeferral* tmp = realloc(band->deferrals, sizeof(*tmp) * size);
+    if(tmp == NULL){
+      return -1;
+    }
+    band->deferrals = tmp;
+    band->deferralsize = size;
+  }
+  egcdeferral* d = &band->deferrals[band->deferred++];
+  d->c = c;
+  memcpy(d->egc, egc, len);
+  d->egc[len] = '\0';
+  d->len = len;
+  return len;
+}
+
+// is the EGC stashed for 'c' exactly the 'len' bytes of 'egc'? the stashed
+// EGC might be shorter than 'len', so compare no further than its NUL.
 static inline bool
-ffmpeg_trans_p(bool bgr, unsigned char alpha){
-  if(!bgr && alpha < 192){
-//fprintf(stderr, "TRANSPARENT!\n");
-    return true;
+blit_egc_stashed_p(const ncplane* nc, const cell* c, const char* egc, size_t len){
+  const char* stashed = egcpool_extended_gcluster(&nc->pool, c);
+  return strncmp(stashed, egc, len) == 0 && stashed[len] == '\0';
+}
+
+// load the constant EGC 'egc' of 'len' bytes, which occupies a single column,
+// into the framebuffer cell 'c' without cell_load()'s decoding. the caller
+// sets c->channels afterwards. an identical EGC already in 'c' is kept. while
+// banding, the egcpool is only read; anything else is deferred.
+static inline int
+blit_egc(ncplane* nc, cell* c, const char* egc, size_t len){
+  blitband* band = blit_banding;
+  if(band){
+    if(cell_simple_p(c)){
+      if(len == 1){
+        c->gcluster = *egc;
+        return 1;
+      }
+    }else if(blit_egc_stashed_p(nc, c, egc, len)){
+      return len;
+    }
+    return blit_egc_defer(band, c, egc, len);
   }
-  return false;
+  if(len == 1){
+    pool_release(&nc->pool, c);
+    c->gcluster = *egc;
+    return 1;
+  }
+  if(!cell_simple_p(c)){
+    if(blit_egc_stashed_p(nc, c, egc, len)){
+      return len;
+    }
+    pool_release(&nc->pool, c);
+  }
+  int eoffset = egcpool_stash(&nc->pool, egc, len);
+  if(eoffset < 0){
+    return -1;
+  }
+  c->gcluster = eoffset + 0x80;
+  return len;
+}
+
+// get the writable framebuffer row for logical row 'y', having first moved
+// the cursor to 'y'/'x' as the blitters always have. NULL on error. while
+// banding, the rows were claimed beforehand, and the cursor is moved after.
+static inline cell*
+blit_row(ncplane* nc, int y, int x){
+  blitband* band = blit_banding;
+  if(band){
+    if(y < 0 || y >= nc->leny || x < 0 || x >= nc->lenx){
+      return NULL;
+    }
+    const int vrow = logical_to_virtual(nc, y);
+    const fbtile* t = nc->tiles[vrow / NCTILE_ROWS];
+    if(t == NULL || t->refcount > 1){
+      return NULL;
+    }
+    band->lasty = y;
+    band->lastx = x;
+    return ncplane_fbrow(nc, vrow);
+  }
+  if(ncplane_cursor_move_yx(nc, y, x)){
+    return NULL;
+  }
+  return ncplane_fbrow(nc, logical_to_virtual(nc, y));
 }
 
 // Retarded RGBA/BGRx blitter (ASCII only).
 // For incoming BGRx (no transparency), bgr == true.
-static inline int
-tria_blit_ascii(ncplane* nc, int placey, int placex, int linesize,
-                const void* data, int begy, int begx,
-                int leny, int lenx, bool bgr, bool blendcolors){
+BLIT_KERNEL
+tria_kernel_ascii(ncplane* nc, int placey, int placex, int linesize,
+                  const void* data, int begy, int begx,
+                  int leny, int lenx, bool bgr, bool blendcolors){
 //fprintf(stderr, "ASCII %d X %d @ %d X %d (%p) place: %d X %d\n", leny, lenx, begy, begx, data, placey, placex);
   const int bpp = 32;
-  const int rpos = bgr ? 2 : 0;
-  const int bpos = bgr ? 0 : 2;
   int dimy, dimx, x, y;
   int total = 0; // number of cells written
   ncplane_dim_yx(nc, &dimy, &dimx);
+  // use the default for the background, as that's the only way it's
+  // effective in that case anyway
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint64_t transparent = ((uint64_t)BLIT_ALPHA(CELL_ALPHA_TRANSPARENT) << 32u) |
+                               BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
   // FIXME not going to necessarily be safe on all architectures hrmmm
   const unsigned char* dat = data;
   int visy = begy;
   for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, ++visy){
-    if(ncplane_cursor_move_yx(nc, y, placex)){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
       return -1;
     }
+    const unsigned char* rgbbase = dat + (linesize * visy) + (begx * bpp / CHAR_BIT);
     int visx = begx;
-    for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, ++visx){
-      const unsigned char* rgbbase_up = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
-//fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
-      cell* c = ncplane_cell_ref_yx(nc, y, x);
-      // use the default for the background, as that's the only way it's
-      // effective in that case anyway
-      c->channels = 0;
+    for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, ++visx, rgbbase += bpp / CHAR_BIT){
+      cell* c = &row[x];
       c->attrword = 0;
-      if(blendcolors){
-        cell_set_bg_alpha(c, CELL_ALPHA_BLEND);
-        cell_set_fg_alpha(c, CELL_ALPHA_BLEND);
-      }
-      if(ffmpeg_trans_p(bgr, rgbbase_up[3])){
-        cell_set_bg_alpha(c, CELL_ALPHA_TRANSPARENT);
-        cell_set_fg_alpha(c, CELL_ALPHA_TRANSPARENT);
+      if(ffmpeg_trans_p(bgr, rgbbase[3])){
+        c->channels = transparent;
       }else{
-        cell_set_fg_rgb(c, rgbbase_up[rpos], rgbbase_up[1], rgbbase_up[bpos]);
-        cell_set_bg_rgb(c, rgbbase_up[rpos], rgbbase_up[1], rgbbase_up[bpos]);
-        if(cell_load(nc, c, " ") <= 0){
+        if(blit_egc(nc, c, " ", 1) <= 0){
           return -1;
         }
+        const uint32_t chan = alpha | blit_rgb(rgbbase, bgr);
+        c->channels = ((uint64_t)chan << 32u) | chan;
       }
       ++total;
     }
@@ -87,339 +186,477 @@ tria_blit_ascii(ncplane* nc, int placey, int placex, int linesize,
   return total;
 }
 
+BLIT_SPECIALIZE(tria_blit_ascii, tria_kernel_ascii)
+
 // RGBA/BGRx half-block blitter. Best for most images/videos. Full fidelity
 // combined with 1:1 pixel aspect ratio.
 // For incoming BGRx (no transparency), bgr == true.
-static inline int
-tria_blit(ncplane* nc, int placey, int placex, int linesize,
-          const void* data, int begy, int begx,
-          int leny, int lenx, bool bgr, bool blendcolors){
+BLIT_KERNEL
+tria_kernel(ncplane* nc, int placey, int placex, int linesize,
+            const void* data, int begy, int begx,
+            int leny, int lenx, bool bgr, bool blendcolors){
 //fprintf(stderr, "HALF %d X %d @ %d X %d (%p) place: %d X %d\n", leny, lenx, begy, begx, data, placey, placex);
   const int bpp = 32;
-  const int rpos = bgr ? 2 : 0;
-  const int bpos = bgr ? 0 : 2;
   int dimy, dimx, x, y;
   int total = 0; // number of cells written
   ncplane_dim_yx(nc, &dimy, &dimx);
+  // use the default for the background, as that's the only way it's
+  // effective in that case anyway
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint32_t transparent = BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
   // FIXME not going to necessarily be safe on all architectures hrmmm
   const unsigned char* dat = data;
   int visy = begy;
   for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, visy += 2){
-    if(ncplane_cursor_move_yx(nc, y, placex)){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
       return -1;
     }
+    const unsigned char* rgbbase_up = dat + (linesize * visy) + (begx * bpp / CHAR_BIT);
+    // the lower pixel is taken from 'zeroes' past the bottom of the image
+    const bool haslower = visy < begy + leny - 1;
+    const unsigned char* rgbbase_down = haslower ? rgbbase_up + linesize : zeroes;
     int visx = begx;
     for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, ++visx){
-      const unsigned char* rgbbase_up = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
-      const unsigned char* rgbbase_down = zeroes;
-      if(visy < begy + leny - 1){
-        rgbbase_down = dat + (linesize * (visy + 1)) + (visx * bpp / CHAR_BIT);
-      }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
-      cell* c = ncplane_cell_ref_yx(nc, y, x);
-      // use the default for the background, as that's the only way it's
-      // effective in that case anyway
-      c->channels = 0;
+      cell* c = &row[x];
       c->attrword = 0;
-      if(blendcolors){
-        cell_set_bg_alpha(c, CELL_ALPHA_BLEND);
-        cell_set_fg_alpha(c, CELL_ALPHA_BLEND);
-      }
-      if(ffmpeg_trans_p(bgr, rgbbase_up[3]) || ffmpeg_trans_p(bgr, rgbbase_down[3])){
-        cell_set_bg_alpha(c, CELL_ALPHA_TRANSPARENT);
-        if(ffmpeg_trans_p(bgr, rgbbase_up[3]) && ffmpeg_trans_p(bgr, rgbbase_down[3])){
-          cell_set_fg_alpha(c, CELL_ALPHA_TRANSPARENT);
-        }else if(ffmpeg_trans_p(bgr, rgbbase_up[3])){ // down has the color
-          if(cell_load(nc, c, "\u2584") <= 0){ // lower half block
+      const bool transup = ffmpeg_trans_p(bgr, rgbbase_up[3]);
+      const bool transdown = ffmpeg_trans_p(bgr, rgbbase_down[3]);
+      uint32_t fchan, bchan;
+      if(transup || transdown){
+        bchan = transparent;
+        if(transup && transdown){
+          fchan = transparent;
+        }else if(transup){ // down has the color
+          if(blit_egc(nc, c, "\u2584", 3) <= 0){ // lower half block
             return -1;
           }
-          cell_set_fg_rgb(c, rgbbase_down[rpos], rgbbase_down[1], rgbbase_down[bpos]);
+          fchan = alpha | blit_rgb(rgbbase_down, bgr);
         }else{ // up has the color
-          if(cell_load(nc, c, "\u2580") <= 0){ // upper half block
+          if(blit_egc(nc, c, "\u2580", 3) <= 0){ // upper half block
             return -1;
           }
-          cell_set_fg_rgb(c, rgbbase_up[rpos], rgbbase_up[1], rgbbase_up[bpos]);
+          fchan = alpha | blit_rgb(rgbbase_up, bgr);
         }
       }else{
+        bchan = alpha | blit_rgb(rgbbase_down, bgr);
         if(memcmp(rgbbase_up, rgbbase_down, 3) == 0){
-          cell_set_fg_rgb(c, rgbbase_down[rpos], rgbbase_down[1], rgbbase_down[bpos]);
-          cell_set_bg_rgb(c, rgbbase_down[rpos], rgbbase_down[1], rgbbase_down[bpos]);
-          if(cell_load(nc, c, " ") <= 0){ // only need the background
+          fchan = bchan;
+          if(blit_egc(nc, c, " ", 1) <= 0){ // only need the background
             return -1;
           }
         }else{
-          cell_set_fg_rgb(c, rgbbase_up[rpos], rgbbase_up[1], rgbbase_up[bpos]);
-          cell_set_bg_rgb(c, rgbbase_down[rpos], rgbbase_down[1], rgbbase_down[bpos]);
-          if(cell_load(nc, c, "\u2580") <= 0){ // upper half block
+          fchan = alpha | blit_rgb(rgbbase_up, bgr);
+          if(blit_egc(nc, c, "\u2580", 3) <= 0){ // upper half block
             return -1;
           }
         }
       }
+      c->channels = ((uint64_t)fchan << 32u) | bchan;
+      rgbbase_up += bpp / CHAR_BIT;
+      if(haslower){
+        rgbbase_down += bpp / CHAR_BIT;
+      }
       ++total;
     }
   }
   return total;
 }
 
-// get a non-negative "distance" between two rgb values
-static inline uint32_t
-rgb_diff(unsigned r1, unsigned g1, unsigned b1, unsigned r2, unsigned g2, unsigned b2){
-  uint32_t distance = 0;
-  distance += r1 > r2 ? r1 - r2 : r2 - r1;
-  distance += g1 > g2 ? g1 - g2 : g2 - g1;
-  distance += b1 > b2 ? b1 - b2 : b2 - b1;
-  return distance;
-}
-
-// once we find the closest pair of colors, we need look at the other two
-// colors, and determine whether
-static const struct qdriver {
-  int pair[2];      // indices of contributing pair
-  int others[2];    // indices of excluded pair
-  const char* egc;  // EGC corresponding to contributing pair
-  const char* oth0egc; // EGC upon absorbing others[0]
-  const char* oth1egc; // EGC upon absorbing others[1]
-} quadrant_drivers[6] = {
-  { .pair = { 0, 1 }, .others = { 2, 3 }, .egc = "▀", .oth0egc = "▛", .oth1egc = "▜", },
-  { .pair = { 0, 2 }, .others = { 1, 3 }, .egc = "▋", .oth0egc = "▛", .oth1egc = "▙", },
-  { .pair = { 0, 3 }, .others = { 1, 2 }, .egc = "▚", .oth0egc = "▜", .oth1egc = "▙", },
-  { .pair = { 1, 2 }, .others = { 0, 3 }, .egc = "▞", .oth0egc = "▛", .oth1egc = "▟", },
-  { .pair = { 1, 3 }, .others = { 0, 2 }, .egc = "▐", .oth0egc = "▜", .oth1egc = "▟", },
-  { .pair = { 2, 3 }, .others = { 0, 1 }, .egc = "▄", .oth0egc = "▙", .oth1egc = "▟", },
+BLIT_SPECIALIZE(tria_blit, tria_kernel)
+
+// the quadrant glyphs, indexed by the mask of quadrants drawn in the
+// foreground: 1 is the top left, 2 top right, 4 bottom left, 8 bottom right.
+static const char quadrant_egcs[16][4] = {
+  " ", "▘", "▝", "▀", "▖", "▌", "▞", "▛",
+  "▗", "▚", "▐", "▜", "▄", "▙", "▟", "█",
 };
 
-// get the six distances between four colors. diffs must be an array of
-// at least 6 uint32_t values.
-static void
-rgb_4diff(uint32_t* diffs, uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br){
-  struct rgb {
-    unsigned r, g, b;
-  } colors[4];
-  channel_rgb(tl, &colors[0].r, &colors[0].g, &colors[0].b);
-  channel_rgb(tr, &colors[1].r, &colors[1].g, &colors[1].b);
-  channel_rgb(bl, &colors[2].r, &colors[2].g, &colors[2].b);
-  channel_rgb(br, &colors[3].r, &colors[3].g, &colors[3].b);
-  for(size_t idx = 0 ; idx < sizeof(quadrant_drivers) / sizeof(*quadrant_drivers) ; ++idx){
-    const struct qdriver* qd = quadrant_drivers + idx;
-    const struct rgb* rgb0 = colors + qd->pair[0];
-    const struct rgb* rgb1 = colors + qd->pair[1];
-    diffs[idx] = rgb_diff(rgb0->r, rgb0->g, rgb0->b,
-                          rgb1->r, rgb1->g, rgb1->b);
-  }
-}
-
-// solve for the EGC and two colors to best represent four colors at top
-// left, top right, bot left, bot right
-static inline const char*
-quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
+// the rounded means of the one to three pixels selected by 'mask', and of
+// the rest. dividing by 3 is done as a multiply by its fixed-point
+// reciprocal, which is exact for sums of up to three 8-bit values.
+static inline void
+quadrant_means(const int r[4], const int g[4], const int b[4],
+               unsigned mask, int fc[3], int bc[3]){
+  static const int recip[4] = { 0, 65536, 32768, 21846, };
+  const int nf = __builtin_popcount(mask);
+  const int nb = 4 - nf;
+  int sr = 0, sg = 0, sb = 0, tr = 0, tg = 0, tb = 0;
+  for(int i = 0 ; i < 4 ; ++i){
+    const int in = -(int)((mask >> i) & 1u);
+    sr += in & r[i];
+    sg += in & g[i];
+    sb += in & b[i];
+    tr += r[i];
+    tg += g[i];
+    tb += b[i];
+  }
+  fc[0] = ((sr + nf / 2) * recip[nf]) >> 16;
+  fc[1] = ((sg + nf / 2) * recip[nf]) >> 16;
+  fc[2] = ((sb + nf / 2) * recip[nf]) >> 16;
+  bc[0] = ((tr - sr + nb / 2) * recip[nb]) >> 16;
+  bc[1] = ((tg - sg + nb / 2) * recip[nb]) >> 16;
+  bc[2] = ((tb - sb + nb / 2) * recip[nb]) >> 16;
+}
+
+// squared euclidean distance between pixels 'i' and 'j'
+#define QDIST(i, j) \
+  ((r[i] - r[j]) * (r[i] - r[j]) + (g[i] - g[j]) * (g[i] - g[j]) + \
+   (b[i] - b[j]) * (b[i] - b[j]))
+
+// solve for the quadrant mask and two colors best representing the pixels
+// at top left, top right, bottom left, and bottom right. this is one round
+// of 2-means: seed with the two most distant pixels, assign each pixel to the
+// nearer seed, and take the mean of each cluster. further rounds reduce the
+// squared error by less than 0.1%, and are not worth their cost. a uniform
+// block yields a mask of 0 with both colors equal.
+static inline unsigned
+quadrant_solver(const unsigned char* px[4], bool bgr,
                 uint32_t* fore, uint32_t* back){
-  const uint32_t colors[4] = { tl, tr, bl, br };
-  uint32_t diffs[sizeof(quadrant_drivers) / sizeof(*quadrant_drivers)];
-  rgb_4diff(diffs, tl, tr, bl, br);
-  // compiler can't verify that we'll always be less than 769 somewhere,
-  // so fuck it, just go ahead and initialize to 0 / diffs[0]
-  size_t mindiffidx = 0;
-  unsigned mindiff = diffs[0]; // 3 * 256 + 1; // max distance is 256 * 3
-  for(size_t idx = 1 ; idx < sizeof(diffs) / sizeof(*diffs) ; ++idx){
-    if(diffs[idx] < mindiff){
-      mindiffidx = idx;
-      mindiff = diffs[idx];
-    }
-  }
-  // at this point, 0 <= mindiffidx <= 5. foreground color will be the
-  // lerp of this nearest pair. we then check the other two. if they are
-  // closer to one another than either is to our lerp, lerp between them.
-  // otherwise, bring the closer one into our lerped fold.
-  const struct qdriver* qd = &quadrant_drivers[mindiffidx];
-  // the diff of the excluded pair is conveniently located at the inverse
-  // location within diffs[] viz mindiffidx.
-  // const uint32_t otherdiff = diffs[5 - mindiffidx];
-  *fore = lerp(colors[qd->pair[0]], colors[qd->pair[1]]);
-  *back = lerp(colors[qd->others[0]], colors[qd->others[1]]);
-  const char* egc = qd->egc;
-  // break down the excluded pair and lerp
-  unsigned r0, r1, g0, g1, b0, b1;
-  unsigned roth, goth, both, rlerp, glerp, blerp;
-  channel_rgb(qd->others[0], &r0, &g0, &b0);
-  channel_rgb(qd->others[1], &r1, &g1, &b1);
-  channel_rgb(*fore, &rlerp, &glerp, &blerp);
-  channel_rgb(*back, &roth, &goth, &both);
-  diffs[0] = rgb_diff(r0, g0, b0, rlerp, glerp, blerp);
-  diffs[1] = rgb_diff(r0, g0, b0, roth, goth, both);
-  diffs[2] = rgb_diff(r1, g1, b1, rlerp, glerp, blerp);
-  diffs[3] = rgb_diff(r1, g1, b1, roth, goth, both);
-  if(diffs[0] < diffs[1] && diffs[0] < diffs[2]){
-    egc = qd->oth0egc;
-    *back = colors[qd->others[1]];
-    *fore = trilerp(colors[qd->pair[0]], colors[qd->pair[1]], colors[qd->others[0]]);
-  }else if(diffs[2] < diffs[3]){
-    egc = qd->oth1egc;
-    *back = colors[qd->others[0]];
-    *fore = trilerp(colors[qd->pair[0]], colors[qd->pair[1]], colors[qd->others[1]]);
-  }
-  return egc;
+  int r[4], g[4], b[4];
+  for(int i = 0 ; i < 4 ; ++i){
+    r[i] = px[i][bgr ? 2 : 0];
+    g[i] = px[i][1];
+    b[i] = px[i][bgr ? 0 : 2];
+  }
+  // all pairwise distances, from which the seeds and their distances to
+  // each pixel are drawn. the farthest pair is found without branching by
+  // taking the maximum of each distance tagged with its pair's index.
+  static const unsigned char pairs[6][2] = {
+    { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 }, { 2, 3 },
+  };
+  int d[4][4];
+  d[0][0] = d[1][1] = d[2][2] = d[3][3] = 0;
+  unsigned far = 0;
+  for(unsigned p = 0 ; p < 6 ; ++p){
+    const int i = pairs[p][0], j = pairs[p][1];
+    d[i][j] = d[j][i] = QDIST(i, j);
+    const unsigned tagged = ((unsigned)d[i][j] << 3u) | p;
+    far = tagged > far ? tagged : far;
+  }
+  const int s0 = pairs[far & 7u][0], s1 = pairs[far & 7u][1];
+  // a uniform block has no distance between its seeds, and assigns no pixel
+  // to the foreground. otherwise both seeds are distinct, and both clusters
+  // are nonempty.
+  unsigned mask = 0;
+  for(int i = 0 ; i < 4 ; ++i){
+    mask |= (unsigned)(d[i][s0] < d[i][s1]) << i;
+  }
+  int fc[3], bc[3];
+  if(mask == 0){
+    *fore = *back = (uint32_t)CELL_BGDEFAULT_MASK | (r[0] << 16u) | (g[0] << 8u) | b[0];
+    return 0;
+  }
+  quadrant_means(r, g, b, mask, fc, bc);
+  *fore = (uint32_t)CELL_BGDEFAULT_MASK | (fc[0] << 16u) | (fc[1] << 8u) | fc[2];
+  *back = (uint32_t)CELL_BGDEFAULT_MASK | (bc[0] << 16u) | (bc[1] << 8u) | bc[2];
+  return mask;
 }
 
+#undef QDIST
+
 // quadrant blitter. maps 2x2 to each cell. since we only have two colors at
 // our disposal (foreground and background), we lose some fidelity.
-static inline int
-quadrant_blit(ncplane* nc, int placey, int placex, int linesize,
-              const void* data, int begy, int begx,
-              int leny, int lenx, bool bgr, bool blendcolors){
+BLIT_KERNEL
+quadrant_kernel(ncplane* nc, int placey, int placex, int linesize,
+                const void* data, int begy, int begx,
+                int leny, int lenx, bool bgr, bool blendcolors){
   const int bpp = 32;
-  const int rpos = bgr ? 2 : 0;
-  const int bpos = bgr ? 0 : 2;
   int dimy, dimx, x, y;
   int total = 0; // number of cells written
   ncplane_dim_yx(nc, &dimy, &dimx);
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint64_t transparent = ((uint64_t)BLIT_ALPHA(CELL_ALPHA_TRANSPARENT) << 32u) |
+                               BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
   // FIXME not going to necessarily be safe on all architectures hrmmm
   const unsigned char* dat = data;
   int visy = begy;
   for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, visy += 2){
-    if(ncplane_cursor_move_yx(nc, y, placex)){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
       return -1;
     }
+    const unsigned char* rowtop = dat + (linesize * visy);
+    const unsigned char* rowbot = visy < begy + leny - 1 ? rowtop + linesize : NULL;
     int visx = begx;
     for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, visx += 2){
-      const unsigned char* rgbbase_tl = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
+      const unsigned char* rgbbase_tl = rowtop + (visx * bpp / CHAR_BIT);
       const unsigned char* rgbbase_tr = zeroes;
       const unsigned char* rgbbase_bl = zeroes;
       const unsigned char* rgbbase_br = zeroes;
-      if(visx < begx + lenx - 1){
-        rgbbase_tr = dat + (linesize * visy) + ((visx + 1) * bpp / CHAR_BIT);
-        if(visy < begy + leny - 1){
-          rgbbase_br = dat + (linesize * (visy + 1)) + ((visx + 1) * bpp / CHAR_BIT);
-        }
+      const bool hasright = visx < begx + lenx - 1;
+      if(hasright){
+        rgbbase_tr = rgbbase_tl + bpp / CHAR_BIT;
       }
-      if(visy < begy + leny - 1){
-        rgbbase_bl = dat + (linesize * (visy + 1)) + (visx * bpp / CHAR_BIT);
+      if(rowbot){
+        rgbbase_bl = rowbot + (visx * bpp / CHAR_BIT);
+        if(hasright){
+          rgbbase_br = rgbbase_bl + bpp / CHAR_BIT;
+        }
       }
 //fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
-      cell* c = ncplane_cell_ref_yx(nc, y, x);
-      c->channels = 0;
+      cell* c = &row[x];
       c->attrword = 0;
       // FIXME for now, we're only transparent if all four are transparent. we ought
       // match transparent like anything else...
       const char* egc = NULL;
+      size_t egclen = 1;
+      uint64_t channels;
       if(ffmpeg_trans_p(bgr, rgbbase_tl[3]) && ffmpeg_trans_p(bgr, rgbbase_tr[3])
           && ffmpeg_trans_p(bgr, rgbbase_bl[3]) && ffmpeg_trans_p(bgr, rgbbase_br[3])){
-          cell_set_bg_alpha(c, CELL_ALPHA_TRANSPARENT);
-          cell_set_fg_alpha(c, CELL_ALPHA_TRANSPARENT);
+          channels = transparent;
           egc = " ";
           // FIXME else look for pairs of transparency!
       }else{
-        uint32_t tl = 0, tr = 0, bl = 0, br = 0;
-        channel_set_rgb(&tl, rgbbase_tl[rpos], rgbbase_tl[1], rgbbase_tl[bpos]);
-        channel_set_rgb(&tr, rgbbase_tr[rpos], rgbbase_tr[1], rgbbase_tr[bpos]);
-        channel_set_rgb(&bl, rgbbase_bl[rpos], rgbbase_bl[1], rgbbase_bl[bpos]);
-        channel_set_rgb(&br, rgbbase_br[rpos], rgbbase_br[1], rgbbase_br[bpos]);
+        const unsigned char* px[4] = {
+          rgbbase_tl, rgbbase_tr, rgbbase_bl, rgbbase_br,
+        };
         uint32_t bg, fg;
-        egc = quadrant_solver(tl, tr, bl, br, &fg, &bg);
-        cell_set_fchannel(c, fg);
-        cell_set_bchannel(c, bg);
-        if(blendcolors){
-          cell_set_bg_alpha(c, CELL_ALPHA_BLEND);
-          cell_set_fg_alpha(c, CELL_ALPHA_BLEND);
-        }
+        const unsigned mask = quadrant_solver(px, bgr, &fg, &bg);
+        egc = quadrant_egcs[mask];
+        egclen = mask ? 3 : 1;
+        channels = ((uint64_t)(alpha | fg) << 32u) | (alpha | bg);
       }
       assert(egc);
-      if(cell_load(nc, c, egc) <= 0){
+      if(blit_egc(nc, c, egc, egclen) <= 0){
         return -1;
       }
+      c->channels = channels;
       ++total;
     }
   }
   return total;
 }
 
+BLIT_SPECIALIZE(quadrant_blit, quadrant_kernel)
+
+// the braille dot (as a bit of the offset from U+2800) for each pixel of a
+// 4 row by 2 column block. the bottom row was a later addition to braille, and
+// thus gets the high bits.
+static const unsigned char braille_dots[4][2] = {
+  { 0x01, 0x08, },
+  { 0x02, 0x10, },
+  { 0x04, 0x20, },
+  { 0x40, 0x80, },
+};
+
+// integer approximation of BT.601 luma, 0..255
+static inline unsigned
+blit_luma(const unsigned char* px, bool bgr){
+  return (px[bgr ? 2 : 0] * 77u + px[1] * 150u + px[bgr ? 0 : 2] * 29u) >> 8u;
+}
+
 // Braille blitter. maps 4x2 to each cell. since we only have one color at
 // our disposal (foreground), we lose some fidelity. this is optimal for
 // visuals with only two colors in a given area, as it packs lots of
-// resolution. always transparent background.
-static inline int
-braille_blit(ncplane* nc, int placey, int placex, int linesize,
-             const void* data, int begy, int begx,
-             int leny, int lenx, bool bgr, bool blendcolors){
+// resolution. always transparent background. each opaque pixel at least as
+// bright as the mean of its block's opaque pixels gets a dot, and the
+// foreground is the average of those pixels. transparent pixels, and those
+// beyond the edge of the image, never get a dot.
+BLIT_KERNEL
+braille_kernel(ncplane* nc, int placey, int placex, int linesize,
+               const void* data, int begy, int begx,
+               int leny, int lenx, bool bgr, bool blendcolors){
   const int bpp = 32;
-  const int rpos = bgr ? 2 : 0;
-  const int bpos = bgr ? 0 : 2;
   int dimy, dimx, x, y;
   int total = 0; // number of cells written
   ncplane_dim_yx(nc, &dimy, &dimx);
+  // use the default for the background, as that's the only way it's
+  // effective in that case anyway
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint32_t transparent = BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
   // FIXME not going to necessarily be safe on all architectures hrmmm
   const unsigned char* dat = data;
   int visy = begy;
   for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, visy += 4){
-    if(ncplane_cursor_move_yx(nc, y, placex)){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
       return -1;
     }
+    // the four pixel rows of this cell row; those past the end are NULL
+    const unsigned char* rows[4];
+    for(int r = 0 ; r < 4 ; ++r){
+      rows[r] = visy + r < begy + leny ? dat + (linesize * (visy + r)) : NULL;
+    }
     int visx = begx;
     for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, visx += 2){
-      const unsigned char* rgbbase_l0 = dat + (linesize * visy) + (visx * bpp / CHAR_BIT);
-      const unsigned char* rgbbase_r0 = zeroes;
-      const unsigned char* rgbbase_l1 = zeroes;
-      const unsigned char* rgbbase_r1 = zeroes;
-      const unsigned char* rgbbase_l2 = zeroes;
-      const unsigned char* rgbbase_r2 = zeroes;
-      const unsigned char* rgbbase_l3 = zeroes;
-      const unsigned char* rgbbase_r3 = zeroes;
-      if(visx < begx + lenx - 1){
-        rgbbase_r0 = dat + (linesize * visy) + ((visx + 1) * bpp / CHAR_BIT);
-        if(visy < begy + leny - 1){
-          rgbbase_r1 = dat + (linesize * (visy + 1)) + ((visx + 1) * bpp / CHAR_BIT);
-          if(visy < begy + leny - 2){
-            rgbbase_r2 = dat + (linesize * (visy + 2)) + ((visx + 1) * bpp / CHAR_BIT);
-            if(visy < begy + leny - 3){
-              rgbbase_r3 = dat + (linesize * (visy + 3)) + ((visx + 1) * bpp / CHAR_BIT);
+      const int cols = visx < begx + lenx - 1 ? 2 : 1;
+      const unsigned char* px[8];
+      unsigned luma[8];
+      unsigned opaque = 0; // bitmask over px[]
+      unsigned lumasum = 0;
+      unsigned count = 0;
+      for(int r = 0 ; r < 4 ; ++r){
+        for(int col = 0 ; col < 2 ; ++col){
+          const int idx = r * 2 + col;
+          if(rows[r] && col < cols){
+            px[idx] = rows[r] + ((visx + col) * bpp / CHAR_BIT);
+            if(!ffmpeg_trans_p(bgr, px[idx][3])){
+              luma[idx] = blit_luma(px[idx], bgr);
+              lumasum += luma[idx];
+              opaque |= 1u << idx;
+              ++count;
             }
           }
         }
       }
-      if(visy < begy + leny - 1){
-        rgbbase_l1 = dat + (linesize * (visy + 1)) + (visx * bpp / CHAR_BIT);
-        if(visy < begy + leny - 2){
-          rgbbase_l2 = dat + (linesize * (visy + 2)) + (visx * bpp / CHAR_BIT);
-          if(visy < begy + leny - 3){
-            rgbbase_l3 = dat + (linesize * (visy + 3)) + (visx * bpp / CHAR_BIT);
+      cell* c = &row[x];
+      c->attrword = 0;
+      uint32_t fchan;
+      if(count == 0){
+        fchan = transparent;
+        if(blit_egc(nc, c, " ", 1) <= 0){
+          return -1;
+        }
+      }else{
+        // compare luma * count against the sum, avoiding division
+        unsigned dots = 0;
+        unsigned rsum = 0, gsum = 0, bsum = 0, on = 0;
+        for(int idx = 0 ; idx < 8 ; ++idx){
+          if((opaque & (1u << idx)) && luma[idx] * count >= lumasum){
+            dots |= braille_dots[idx / 2][idx % 2];
+            rsum += px[idx][bgr ? 2 : 0];
+            gsum += px[idx][1];
+            bsum += px[idx][bgr ? 0 : 2];
+            ++on;
+          }
+        }
+        const unsigned char avg[3] = {
+          (rsum + on / 2) / on, (gsum + on / 2) / on, (bsum + on / 2) / on,
+        };
+        fchan = alpha | blit_rgb(avg, false);
+        // U+2800 + dots, UTF-8 encoded
+        const char egc[4] = {
+          '\xe2', (char)(0xa0 | (dots >> 6u)), (char)(0x80 | (dots & 0x3fu)), '\0',
+        };
+        if(blit_egc(nc, c, egc, 3) <= 0){
+          return -1;
+        }
+      }
+      c->channels = ((uint64_t)fchan << 32u) | transparent;
+      ++total;
+    }
+  }
+  return total;
+}
+
+BLIT_SPECIALIZE(braille_blit, braille_kernel)
+
+// Pixel blitters (Sixel and kitty). the graphic is drawn at the terminal's
+// own pixel geometry, and attached to the plane as its sprixel. each cell it
+// covers gets the mean of its opaque pixels as a background, shown when the
+// graphic can't be drawn.
+static inline int
+pixel_blit(ncplane* nc, int placey, int placex, int linesize,
+           const void* data, int begy, int begx,
+           int leny, int lenx, bool bgr, bool blendcolors, bool kitty){
+  const int cellpixy = nc->nc->cellpixy;
+  const int cellpixx = nc->nc->cellpixx;
+  int dimy, dimx;
+  ncplane_dim_yx(nc, &dimy, &dimx);
+  if(placey < 0 || placex < 0 || placey >= dimy || placex >= dimx){
+    return -1;
+  }
+  // clip the graphic to the plane
+  int rows = (leny + cellpixy - 1) / cellpixy;
+  if(rows > dimy - placey){
+    rows = dimy - placey;
+    leny = rows * cellpixy;
+  }
+  int cols = (lenx + cellpixx - 1) / cellpixx;
+  if(cols > dimx - placex){
+    cols = dimx - placex;
+    lenx = cols * cellpixx;
+  }
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint64_t transparent = ((uint64_t)BLIT_ALPHA(CELL_ALPHA_TRANSPARENT) << 32u) |
+                               BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
+  const unsigned char* dat = data;
+  bool opaque = false;
+  int total = 0;
+  for(int y = 0 ; y < rows ; ++y){
+    cell* row = blit_row(nc, placey + y, placex);
+    if(row == NULL){
+      return -1;
+    }
+    const int visy = begy + y * cellpixy;
+    const int endy = visy + cellpixy < begy + leny ? visy + cellpixy : begy + leny;
+    for(int x = 0 ; x < cols ; ++x){
+      const int visx = begx + x * cellpixx;
+      const int endx = visx + cellpixx < begx + lenx ? visx + cellpixx : begx + lenx;
+      unsigned r = 0, g = 0, b = 0, count = 0;
+      for(int py = visy ; py < endy ; ++py){
+        const unsigned char* px = dat + linesize * py + visx * 4;
+        for(int pxx = visx ; pxx < endx ; ++pxx, px += 4){
+          if(!ffmpeg_trans_p(bgr, px[3])){
+            r += px[bgr ? 2 : 0];
+            g += px[1];
+            b += px[bgr ? 0 : 2];
+            ++count;
           }
         }
       }
-//fprintf(stderr, "[%04d/%04d] bpp: %d lsize: %d %02x %02x %02x %02x\n", y, x, bpp, linesize, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2], rgbbase_up[3]);
-      cell* c = ncplane_cell_ref_yx(nc, y, x);
-      // use the default for the background, as that's the only way it's
-      // effective in that case anyway
-      c->channels = 0;
+      cell* c = &row[placex + x];
       c->attrword = 0;
-      if(blendcolors){
-        cell_set_fg_alpha(c, CELL_ALPHA_BLEND);
+      if(blit_egc(nc, c, " ", 1) <= 0){
+        return -1;
       }
-      // FIXME for now, we just sample, color-wise, and always draw crap.
-      // more complicated to do optimally than quadrants, for sure. ideally,
-      // we only get one color in an area.
-      cell_set_bg_alpha(c, CELL_ALPHA_TRANSPARENT);
-      const char* egc = NULL;
-      if(ffmpeg_trans_p(bgr, rgbbase_l0[3]) && ffmpeg_trans_p(bgr, rgbbase_r0[3])
-          && ffmpeg_trans_p(bgr, rgbbase_l1[3]) && ffmpeg_trans_p(bgr, rgbbase_r1[3])
-          && ffmpeg_trans_p(bgr, rgbbase_l2[3]) && ffmpeg_trans_p(bgr, rgbbase_r2[3])
-          && ffmpeg_trans_p(bgr, rgbbase_l3[3]) && ffmpeg_trans_p(bgr, rgbbase_r3[3])){
-          cell_set_fg_alpha(c, CELL_ALPHA_TRANSPARENT);
-          egc = " ";
-          // FIXME else look for pairs of transparency!
+      if(count){
+        const unsigned char avg[3] = {
+          (r + count / 2) / count, (g + count / 2) / count, (b + count / 2) / count,
+        };
+        const uint32_t chan = alpha | blit_rgb(avg, false);
+        c->channels = ((uint64_t)chan << 32u) | chan;
+        opaque = true;
       }else{
-        // FIXME interpolate into 1
-        cell_set_fg_rgb(c, rgbbase_l0[rpos], rgbbase_l0[1], rgbbase_l0[bpos]);
-        egc = "⡜";
-      }
-      assert(egc);
-      if(cell_load(nc, c, egc) <= 0){
-        return -1;
+        c->channels = transparent;
       }
       ++total;
     }
   }
+  if(!opaque){
+    sprixel_detach(nc);
+    return total;
+  }
+  if(kitty){
+    kittyimg* k = kitty_encode(nc->nc, data, linesize, begy, begx, leny, lenx, bgr);
+    if(k == NULL){
+      return -1;
+    }
+    // the sprixel takes its own reference
+    const int r = sprixel_attach_kitty(nc, k, placey, placex, rows, cols);
+    kittyimg_release(nc->nc, k);
+    return r ? -1 : total;
+  }
+  size_t glyphlen;
+  char* glyph = sixel_encode(data, linesize, begy, begx, leny, lenx, bgr, &glyphlen);
+  if(glyph == NULL){
+    return -1;
+  }
+  if(sprixel_attach(nc, glyph, glyphlen, placey, placex, rows, cols)){
+    free(glyph);
+    return -1;
+  }
   return total;
 }
 
+static int
+sixel_blit(ncplane* nc, int placey, int placex, int linesize,
+           const void* data, int begy, int begx,
+           int leny, int lenx, bool bgr, bool blendcolors){
+  return pixel_blit(nc, placey, placex, linesize, data, begy, begx,
+                    leny, lenx, bgr, blendcolors, false);
+}
+
+static int
+kitty_blit(ncplane* nc, int placey, int placex, int linesize,
+           const void* data, int begy, int begx,
+           int leny, int lenx, bool bgr, bool blendcolors){
+  return pixel_blit(nc, placey, placex, linesize, data, begy, begx,
+                    leny, lenx, bgr, blendcolors, true);
+}
+
 // NCBLIT_DEFAULT is not included, as it has no defined properties. It ought
 // be replaced with some real blitter implementation by the calling widget.
 const struct blitset notcurses_blitters[] = {
@@ -437,8 +674,10 @@ const struct blitset notcurses_blitters[] = {
      .blit = tria_blit,      .fill = false, }, // FIXME
    { .geom = NCBLIT_BRAILLE, .width = 2, .height = 4, .egcs = L"⠀⡀⡄⡆⡇⢀⣀⣄⣆⣇⢠⣠⣤⣦⣧⢰⣰⣴⣶⣷⢸⣸⣼⣾⣿",
      .blit = braille_blit,   .fill = true,  },
-   { .geom = NCBLIT_SIXEL,   .width = 1, .height = 6, .egcs = L"",
-     .blit = tria_blit,      .fill = true,  }, // FIXME
+   { .geom = NCBLIT_SIXEL,   .width = NCSIXEL_CELLPIXX, .height = NCSIXEL_CELLPIXY, .egcs = L"",
+     .blit = sixel_blit,     .fill = true,  },
+   { .geom = NCBLIT_KITTY,   .width = NCSIXEL_CELLPIXX, .height = NCSIXEL_CELLPIXY, .egcs = L"",
+     .blit = kitty_blit,     .fill = true,  },
    { .geom = 0,              .width = 0, .height = 0, .egcs = NULL,
      .blit = NULL,           .fill = false,  },
 };
@@ -475,3 +714,564 @@ int rgba_blit_dispatch(ncplane* nc, const struct blitset* bset, int placey,
   return bset->blit(nc, placey, placex, linesize, data, begy, begx,
                     leny, lenx, false, blendcolors);
 }
+
+// pixel rows consumed by each plane row. this isn't always the blitset's
+// height (see the FIXMEs in notcurses_blitters[]).
+static int
+blitset_pixrows(const struct blitset* bset){
+  if(bset->blit == tria_blit){
+    return 2;
+  }else if(bset->blit == tria_blit_ascii){
+    return 1;
+  }
+  return bset->height;
+}
+
+bool blitset_bandable(const struct blitset* bset){
+  // a pixel blitter's graphic is attached to the plane as a whole
+  return bset->geom != NCBLIT_SIXEL && bset->geom != NCBLIT_KITTY;
+}
+
+int blitbands_init(blitbands* bb, ncplane* n, const struct blitset* bset,
+                   int placey, int placex, int begy, int begx, int leny,
+                   int lenx, bool blendcolors, int count){
+  bb->n = n;
+  bb->bset = bset;
+  bb->placey = placey;
+  bb->placex = placex;
+  bb->begy = begy;
+  bb->begx = begx;
+  bb->leny = leny;
+  bb->lenx = lenx;
+  bb->blendcolors = blendcolors;
+  bb->pixrows = blitset_pixrows(bset);
+  bb->bands = NULL;
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  if(placey < 0 || placey >= dimy || placex < 0 || placex >= dimx || count <= 0){
+    return -1;
+  }
+  int rows = (leny + bb->pixrows - 1) / bb->pixrows;
+  if(rows > dimy - placey){
+    rows = dimy - placey;
+  }
+  if(count > rows){
+    count = rows;
+  }
+  bb->rowsper = (rows + count - 1) / count;
+  bb->count = (rows + bb->rowsper - 1) / bb->rowsper;
+  if((bb->bands = calloc(bb->count, sizeof(*bb->bands))) == NULL){
+    return -1;
+  }
+  // claim all rows now, so that no band need allocate or unshare tiles
+  for(int y = placey ; y < placey + rows ; ++y){
+    if(ncplane_fbrow(n, logical_to_virtual(n, y)) == NULL){
+      free(bb->bands);
+      bb->bands = NULL;
+      return -1;
+    }
+  }
+  for(int b = 0 ; b < bb->count ; ++b){
+    bb->bands[b].lasty = -1;
+  }
+  return 0;
+}
+
+void blitbands_extent(const blitbands* bb, int band, int* begy, int* leny){
+  const int off = band * bb->rowsper * bb->pixrows;
+  *begy = bb->begy + off;
+  *leny = bb->rowsper * bb->pixrows;
+  if(*leny > bb->leny - off){
+    *leny = bb->leny - off;
+  }
+}
+
+int blitbands_blit(blitbands* bb, int band, int linesize, const void* data){
+  blitband* b = &bb->bands[band];
+  int begy, leny;
+  blitbands_extent(bb, band, &begy, &leny);
+  blit_banding = b;
+  const int r = bb->bset->blit(bb->n, bb->placey + band * bb->rowsper, bb->placex,
+                               linesize, data, begy, bb->begx, leny, bb->lenx,
+                               false, bb->blendcolors);
+  blit_banding = NULL;
+  if(r < 0){
+    return -1;
+  }
+  b->total = r;
+  return 0;
+}
+
+int blitbands_finish(blitbands* bb, bool failed){
+  int total = 0;
+  int cursory = -1, cursorx = -1;
+  for(int i = 0 ; i < bb->count ; ++i){
+    blitband* b = &bb->bands[i];
+    for(int d = 0 ; !failed && d < b->deferred ; ++d){
+      const egcdeferral* def = &b->deferrals[d];
+      if(blit_egc(bb->n, def->c, def->egc, def->len) <= 0){
+        failed = true;
+      }
+    }
+    free(b->deferrals);
+    total += b->total;
+    if(b->lasty >= 0){
+      cursory = b->lasty;
+      cursorx = b->lastx;
+    }
+  }
+  free(bb->bands);
+  bb->bands = NULL;
+  if(failed){
+    return -1;
+  }
+  if(cursory >= 0){
+    ncplane_cursor_move_yx(bb->n, cursory, cursorx);
+  }
+  return total;
+}
+
+typedef struct bandjob {
+  blitbands* bb;
+  int linesize;
+  const void* data;
+} bandjob;
+
+static int
+blitbands_job(void* vjob, int band){
+  bandjob* job = vjob;
+  return blitbands_blit(job->bb, band, job->linesize, job->data);
+}
+
+int rgba_blit_parallel(ncplane* nc, const struct blitset* bset, int placey,
+                       int placex, int linesize, const void* data, int begy,
+                       int begx, int leny, int lenx, bool blendcolors){
+  if(!blitset_bandable(bset)){
+    return rgba_blit_dispatch(nc, bset, placey, placex, linesize, data,
+                              begy, begx, leny, lenx, blendcolors);
+  }
+  // a few bands per thread, so that one slow band doesn't idle the rest. with
+  // only the one thread, they're all blitted by the caller.
+  blitbands bb;
+  if(blitbands_init(&bb, nc, bset, placey, placex, begy, begx, leny, lenx,
+                    blendcolors, workerpool_threads(nc->nc) * 4)){
+    return -1;
+  }
+  bandjob job = { .bb = &bb, .linesize = linesize, .data = data, };
+  const bool failed = workerpool_run(nc->nc, bb.count, blitbands_job, &job);
+  return blitbands_finish(&bb, failed);
+}
+
+void blitdelta_destroy(blitdelta* bd){
+  if(bd){
+    free(bd->pixels);
+    free(bd);
+  }
+}
+
+// has any pixel of the block at 'y'x'x' ('leny' x 'lenx' pixels of the blit)
+// changed by more than 'threshold' in some channel since it was last drawn?
+static bool
+blitdelta_changed(const blitdelta* bd, int linesize, const void* data,
+                  int begy, int begx, int y, int x, int leny, int lenx){
+  for(int py = y ; py < y + leny ; ++py){
+    const unsigned char* cur = (const unsigned char*)data +
+                               (size_t)(begy + py) * linesize + (begx + x) * 4;
+    const unsigned char* old = (const unsigned char*)(bd->pixels + (size_t)py * bd->lenx + x);
+    if(bd->threshold == 0){
+      if(memcmp(cur, old, lenx * 4)){
+        return true;
+      }
+      continue;
+    }
+    for(int i = 0 ; i < lenx * 4 ; ++i){
+      if((unsigned)abs(cur[i] - old[i]) > bd->threshold){
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// remember the block at 'y'x'x' as drawn
+static void
+blitdelta_store(blitdelta* bd, int linesize, const void* data, int begy,
+                int begx, int y, int x, int leny, int lenx){
+  for(int py = y ; py < y + leny ; ++py){
+    memcpy(bd->pixels + (size_t)py * bd->lenx + x,
+           (const unsigned char*)data + (size_t)(begy + py) * linesize + (begx + x) * 4,
+           lenx * 4);
+  }
+}
+
+// Blit only those cells whose source pixels changed since the last blit with
+// 'bd', which must have been of the same geometry to the same place. Runs of
+// changed cells within a plane row are blitted together.
+static int
+rgba_blit_changed(blitdelta* bd, ncplane* nc, const struct blitset* bset,
+                  int placey, int placex, int linesize, const void* data,
+                  int begy, int begx, int leny, int lenx, bool blendcolors){
+  const int pixrows = blitset_pixrows(bset);
+  const int pixcols = bset->width;
+  int ret = 0;
+  for(int cy = 0 ; cy * pixrows < leny ; ++cy){
+    const int y = cy * pixrows;
+    const int celly = leny - y < pixrows ? leny - y : pixrows;
+    int run = -1; // first cell of the current run of changed cells
+    for(int cx = 0 ; cx * pixcols <= lenx ; ++cx){
+      const int x = cx * pixcols;
+      if(x < lenx){
+        const int cellx = lenx - x < pixcols ? lenx - x : pixcols;
+        if(blitdelta_changed(bd, linesize, data, begy, begx, y, x, celly, cellx)){
+          if(run < 0){
+            run = cx;
+          }
+          continue;
+        }
+      }
+      if(run >= 0){
+        const int runx = run * pixcols;
+        const int runlen = (x < lenx ? x : lenx) - runx;
+        const int r = rgba_blit_dispatch(nc, bset, placey + cy, placex + run,
+                                         linesize, data, begy + y, begx + runx,
+                                         celly, runlen, blendcolors);
+        if(r < 0){
+          return -1;
+        }
+        blitdelta_store(bd, linesize, data, begy, begx, y, runx, celly, runlen);
+        ret += r;
+        run = -1;
+      }
+    }
+  }
+  return ret;
+}
+
+int rgba_blit_visual(ncplane* nc, const struct blitset* bset, int placey,
+                     int placex, int linesize, const void* data, int begy,
+                     int begx, int leny, int lenx, bool blendcolors,
+                     bool parallel, blitdelta* delta){
+  if(delta && blitset_bandable(bset)){
+    if(delta->pixels && delta->n == nc && delta->bset == bset &&
+       delta->placey == placey && delta->placex == placex &&
+       delta->leny == leny && delta->lenx == lenx &&
+       delta->epoch == nc->epoch &&
+       delta->blendcolors == blendcolors){
+      const int r = rgba_blit_changed(delta, nc, bset, placey, placex, linesize,
+                                      data, begy, begx, leny, lenx, blendcolors);
+      if(r < 0){
+        delta->n = NULL; // whatever was drawn, we don't know it
+      }
+      return r;
+    }
+    // a different blit; draw it all, and remember it for the next one
+    uint32_t* tmp = realloc(delta->pixels, sizeof(*tmp) * leny * lenx);
+    if(tmp == NULL){
+      return -1;
+    }
+    delta->pixels = tmp;
+    delta->n = nc;
+    delta->bset = bset;
+    delta->placey = placey;
+    delta->placex = placex;
+    delta->leny = leny;
+    delta->lenx = lenx;
+    delta->epoch = nc->epoch;
+    delta->blendcolors = blendcolors;
+    blitdelta_store(delta, linesize, data, begy, begx, 0, 0, leny, lenx);
+  }else if(delta){
+    delta->n = NULL; // pixel blitters are always drawn whole
+  }
+  const int r = parallel ?
+    rgba_blit_parallel(nc, bset, placey, placex, linesize, data, begy, begx,
+                       leny, lenx, blendcolors) :
+    rgba_blit_dispatch(nc, bset, placey, placex, linesize, data, begy, begx,
+                       leny, lenx, blendcolors);
+  if(r <= 0){
+    if(delta){
+      delta->n = NULL; // whatever was drawn, we don't know it
+    }
+    return -1;
+  }
+  return r;
+}
+
+// the RGB of pixel ('y', 'x') of 'src', which is of 'fmt'. BGRx is read by
+// the RGBA blitters themselves.
+__attribute__ ((always_inline)) static inline void
+native_rgb(const blitsource* src, blitfmt_e fmt, int y, int x, unsigned char* rgb){
+  const unsigned char* p = src->planes[0] + (size_t)y * src->linesizes[0];
+  switch(fmt){
+    case BLITFMT_YUV420P: case BLITFMT_YUVJ420P: {
+      const bool full = fmt == BLITFMT_YUVJ420P;
+      int cr, cg, cb;
+      yuv_chroma(src->planes[1][(size_t)(y >> 1) * src->linesizes[1] + (x >> 1)],
+                 src->planes[2][(size_t)(y >> 1) * src->linesizes[2] + (x >> 1)],
+                 full, &cr, &cg, &cb);
+      yuv_rgb(p[x], full, cr, cg, cb, rgb);
+      break;
+    }case BLITFMT_RGB24:
+      p += x * 3;
+      rgb[0] = p[0]; rgb[1] = p[1]; rgb[2] = p[2];
+      break;
+    case BLITFMT_BGR24:
+      p += x * 3;
+      rgb[0] = p[2]; rgb[1] = p[1]; rgb[2] = p[0];
+      break;
+    case BLITFMT_GRAY8:
+      rgb[0] = rgb[1] = rgb[2] = p[x];
+      break;
+    case BLITFMT_BGRX:
+      break;
+  }
+}
+
+// the RGB of pixels ('y', 'x') and ('y' + 1, 'x') of 'src'. in YUV 4:2:0, the
+// two share their chroma when 'y' is even, and it's converted once.
+__attribute__ ((always_inline)) static inline void
+native_pair(const blitsource* src, blitfmt_e fmt, int y, int x,
+            unsigned char* up, unsigned char* down){
+  if((fmt == BLITFMT_YUV420P || fmt == BLITFMT_YUVJ420P) && y % 2 == 0){
+    const bool full = fmt == BLITFMT_YUVJ420P;
+    int cr, cg, cb;
+    yuv_chroma(src->planes[1][(size_t)(y >> 1) * src->linesizes[1] + (x >> 1)],
+               src->planes[2][(size_t)(y >> 1) * src->linesizes[2] + (x >> 1)],
+               full, &cr, &cg, &cb);
+    const unsigned char* luma = src->planes[0] + (size_t)y * src->linesizes[0] + x;
+    yuv_rgb(luma[0], full, cr, cg, cb, up);
+    yuv_rgb(luma[src->linesizes[0]], full, cr, cg, cb, down);
+    return;
+  }
+  native_rgb(src, fmt, y, x, up);
+  native_rgb(src, fmt, y + 1, x, down);
+}
+
+// As tria_kernel_ascii(), reading 'src' of 'fmt'. These are all opaque.
+BLIT_KERNEL
+tria_native_kernel_ascii(ncplane* nc, int placey, int placex,
+                         const blitsource* src, blitfmt_e fmt, int begy,
+                         int begx, int leny, int lenx, bool blendcolors){
+  int dimy, dimx, x, y;
+  int total = 0; // number of cells written
+  ncplane_dim_yx(nc, &dimy, &dimx);
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  int visy = begy;
+  for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, ++visy){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
+      return -1;
+    }
+    int visx = begx;
+    for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, ++visx){
+      cell* c = &row[x];
+      c->attrword = 0;
+      unsigned char rgb[3];
+      native_rgb(src, fmt, visy, visx, rgb);
+      if(blit_egc(nc, c, " ", 1) <= 0){
+        return -1;
+      }
+      const uint32_t chan = alpha | blit_rgb(rgb, false);
+      c->channels = ((uint64_t)chan << 32u) | chan;
+      ++total;
+    }
+  }
+  return total;
+}
+
+// As tria_kernel(), reading 'src' of 'fmt'. These are all opaque, save the
+// nonexistent pixel below an odd final row.
+BLIT_KERNEL
+tria_native_kernel(ncplane* nc, int placey, int placex, const blitsource* src,
+                   blitfmt_e fmt, int begy, int begx, int leny, int lenx,
+                   bool blendcolors){
+  int dimy, dimx, x, y;
+  int total = 0; // number of cells written
+  ncplane_dim_yx(nc, &dimy, &dimx);
+  const uint32_t alpha = blendcolors ? BLIT_ALPHA(CELL_ALPHA_BLEND) : 0;
+  const uint32_t transparent = BLIT_ALPHA(CELL_ALPHA_TRANSPARENT);
+  int visy = begy;
+  for(y = placey ; visy < (begy + leny) && y < dimy ; ++y, visy += 2){
+    cell* row = blit_row(nc, y, placex);
+    if(row == NULL){
+      return -1;
+    }
+    const bool haslower = visy < begy + leny - 1;
+    int visx = begx;
+    for(x = placex ; visx < (begx + lenx) && x < dimx ; ++x, ++visx){
+      cell* c = &row[x];
+      c->attrword = 0;
+      unsigned char up[3], down[3];
+      uint32_t fchan, bchan;
+      if(!haslower){
+        native_rgb(src, fmt, visy, visx, up);
+        if(blit_egc(nc, c, "\u2580", 3) <= 0){ // upper half block
+          return -1;
+        }
+        fchan = alpha | blit_rgb(up, false);
+        bchan = transparent;
+      }else{
+        native_pair(src, fmt, visy, visx, up, down);
+        bchan = alpha | blit_rgb(down, false);
+        if(memcmp(up, down, 3) == 0){
+          fchan = bchan;
+          if(blit_egc(nc, c, " ", 1) <= 0){ // only need the background
+            return -1;
+          }
+        }else{
+          fchan = alpha | blit_rgb(up, false);
+          if(blit_egc(nc, c, "\u2580", 3) <= 0){ // upper half block
+            return -1;
+          }
+        }
+      }
+      c->channels = ((uint64_t)fchan << 32u) | bchan;
+      ++total;
+    }
+  }
+  return total;
+}
+
+// specialize a native kernel for each format it reads
+#define NATIVE_SPECIALIZE(blitter, kernel) \
+static int \
+blitter(ncplane* nc, int placey, int placex, const blitsource* src, \
+        int begy, int begx, int leny, int lenx, bool blendcolors){ \
+  switch(src->fmt){ \
+    case BLITFMT_YUV420P: \
+      return kernel(nc, placey, placex, src, BLITFMT_YUV420P, begy, begx, leny, lenx, blendcolors); \
+    case BLITFMT_YUVJ420P: \
+      return kernel(nc, placey, placex, src, BLITFMT_YUVJ420P, begy, begx, leny, lenx, blendcolors); \
+    case BLITFMT_RGB24: \
+      return kernel(nc, placey, placex, src, BLITFMT_RGB24, begy, begx, leny, lenx, blendcolors); \
+    case BLITFMT_BGR24: \
+      return kernel(nc, placey, placex, src, BLITFMT_BGR24, begy, begx, leny, lenx, blendcolors); \
+    case BLITFMT_GRAY8: \
+      return kernel(nc, placey, placex, src, BLITFMT_GRAY8, begy, begx, leny, lenx, blendcolors); \
+    case BLITFMT_BGRX: \
+      break; \
+  } \
+  return -1; \
+}
+
+NATIVE_SPECIALIZE(tria_native_blit_ascii, tria_native_kernel_ascii)
+NATIVE_SPECIALIZE(tria_native_blit, tria_native_kernel)
+
+// convert row 'y' of 'src' to 'lenx' RGBA pixels from 'begx'
+static void
+native_row(const blitsource* src, int y, int begx, int lenx, unsigned char* out){
+  switch(src->fmt){
+#define NATIVE_ROW(fmt) \
+    case fmt: \
+      for(int x = 0 ; x < lenx ; ++x, out += 4){ \
+        native_rgb(src, fmt, y, begx + x, out); \
+        out[3] = 0xff; \
+      } \
+      break;
+    NATIVE_ROW(BLITFMT_YUV420P)
+    NATIVE_ROW(BLITFMT_YUVJ420P)
+    NATIVE_ROW(BLITFMT_RGB24)
+    NATIVE_ROW(BLITFMT_BGR24)
+    NATIVE_ROW(BLITFMT_GRAY8)
+#undef NATIVE_ROW
+    case BLITFMT_BGRX:
+      break;
+  }
+}
+
+// the blitters lacking native kernels are handed this many cell rows at a
+// time, converted to RGBA
+#define NATIVE_STRIP_CELLROWS 8
+
+static int
+native_blit_strips(ncplane* nc, const struct blitset* bset, int placey,
+                   int placex, const blitsource* src, int begy, int begx,
+                   int leny, int lenx, bool blendcolors){
+  const int pixrows = blitset_pixrows(bset);
+  const int striprows = pixrows * NATIVE_STRIP_CELLROWS;
+  unsigned char* strip = malloc((size_t)striprows * lenx * 4);
+  if(strip == NULL){
+    return -1;
+  }
+  int total = 0;
+  for(int y = 0 ; y < leny && placey + y / pixrows < ncplane_dim_y(nc) ; y += striprows){
+    const int h = leny - y < striprows ? leny - y : striprows;
+    for(int sy = 0 ; sy < h ; ++sy){
+      native_row(src, begy + y + sy, begx, lenx, strip + (size_t)sy * lenx * 4);
+    }
+    const int r = bset->blit(nc, placey + y / pixrows, placex, lenx * 4, strip,
+                             0, 0, h, lenx, false, blendcolors);
+    if(r < 0){
+      free(strip);
+      return -1;
+    }
+    total += r;
+  }
+  free(strip);
+  return total;
+}
+
+int native_blit(ncplane* nc, const struct blitset* bset, int placey,
+                int placex, const blitsource* src, int begy, int begx,
+                int leny, int lenx, bool blendcolors){
+  if(!blitset_bandable(bset)){
+    return -1;
+  }
+  if(src->fmt == BLITFMT_BGRX){ // the RGBA blitters are specialized for it
+    return bset->blit(nc, placey, placex, src->linesizes[0], src->planes[0],
+                      begy, begx, leny, lenx, true, blendcolors);
+  }
+  if(bset->blit == tria_blit){
+    return tria_native_blit(nc, placey, placex, src, begy, begx, leny, lenx,
+                            blendcolors);
+  }else if(bset->blit == tria_blit_ascii){
+    return tria_native_blit_ascii(nc, placey, placex, src, begy, begx, leny,
+                                  lenx, blendcolors);
+  }
+  return native_blit_strips(nc, bset, placey, placex, src, begy, begx, leny,
+                            lenx, blendcolors);
+}
+
+// as ncblit_rgba(), for the packed and planar formats
+static int
+ncblit_native(ncplane* nc, int placey, int placex, const blitsource* src,
+              int begy, int begx, int leny, int lenx){
+  if(!nc->nc->utf8){
+    return tria_native_blit_ascii(nc, placey, placex, src, begy, begx, leny,
+                                  lenx, false);
+  }
+  return tria_native_blit(nc, placey, placex, src, begy, begx, leny, lenx,
+                          false);
+}
+
+int ncblit_yuv420p(ncplane* nc, int placey, int placex,
+                   const int linesizes[3], const void* const planes[3],
+                   int begy, int begx, int leny, int lenx, bool fullrange){
+  blitsource src = {
+    .fmt = fullrange ? BLITFMT_YUVJ420P : BLITFMT_YUV420P,
+  };
+  for(int i = 0 ; i < 3 ; ++i){
+    src.planes[i] = planes[i];
+    src.linesizes[i] = linesizes[i];
+  }
+  return ncblit_native(nc, placey, placex, &src, begy, begx, leny, lenx);
+}
+
+int ncblit_bgr24(ncplane* nc, int placey, int placex, int linesize,
+                 const void* data, int begy, int begx, int leny, int lenx){
+  const blitsource src = {
+    .fmt = BLITFMT_BGR24,
+    .planes = { data, },
+    .linesizes = { linesize, },
+  };
+  return ncblit_native(nc, placey, placex, &src, begy, begx, leny, lenx);
+}
+
+int ncblit_gray8(ncplane* nc, int placey, int placex, int linesize,
+                 const void* data, int begy, int begx, int leny, int lenx){
+  const blitsource src = {
+    .fmt = BLITFMT_GRAY8,
+    .planes = { data, },
+    .linesizes = { linesize, },
+  };
+  return ncblit_native(nc, placey, placex, &src, begy, begx, leny, lenx);
+}
@@ -13,6 +13,22 @@ lookup_blitset(const struct notcurses* nc, ncblitter_e setid, bool may_degrade)
       return NULL;
     }
   }
+  // NCBLIT_KITTY degrades to NCBLIT_SIXEL, which degrades to the densest of
+  // the multicolor text blitters
+  if(setid == NCBLIT_KITTY && !notcurses_cankitty(nc)){
+    if(may_degrade){
+      setid = NCBLIT_SIXEL;
+    }else{
+      return NULL;
+    }
+  }
+  if(setid == NCBLIT_SIXEL && !notcurses_cansixel(nc)){
+    if(may_degrade){
+      setid = NCBLIT_2x2;
+    }else{
+      return NULL;
+    }
+  }
   const struct blitset* bset = notcurses_blitters;
   while(bset->egcs){
     if(bset->geom == setid){
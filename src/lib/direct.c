@@ -53,7 +53,7 @@ int ncdirect_clear(ncdirect* nc){
 
 int ncdirect_dim_x(const ncdirect* nc){
   int x;
-  if(update_term_dimensions(fileno(nc->ttyfp), NULL, &x) == 0){
+  if(update_term_dimensions(fileno(nc->ttyfp), NULL, &x, NULL, NULL) == 0){
     return x;
   }
   return -1;
@@ -61,7 +61,7 @@ int ncdirect_dim_x(const ncdirect* nc){
 
 int ncdirect_dim_y(const ncdirect* nc){
   int y;
-  if(update_term_dimensions(fileno(nc->ttyfp), &y, NULL) == 0){
+  if(update_term_dimensions(fileno(nc->ttyfp), &y, NULL, NULL, NULL) == 0){
     return y;
   }
   return -1;
@@ -5,6 +5,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,12 +20,17 @@ extern "C" {
 // more than that, it's spilled into the egcpool, and the cell is given an
 // offset. when a cell is released, the memory it owned is zeroed out, and
 // recognizable as use for another cell.
+//
+// the storage can be shared copy-on-write among several egcpools (see
+// egcpool_share()), in which case 'sharers' points to a count of the egcpools
+// referencing it. any modification first takes a private copy.
 
 typedef struct egcpool {
   char* pool;         // ringbuffer of attached extension storage
   int poolsize;       // total number of bytes in pool
   int poolused;       // bytes actively used, grow when this gets too large
   int poolwrite;      // next place to *look for* a place to write
+  unsigned* sharers;  // non-NULL iff 'pool' is shared with other egcpools
 } egcpool;
 
 #define POOL_MINIMUM_ALLOC BUFSIZ
@@ -35,6 +41,30 @@ egcpool_init(egcpool* p){
   memset(p, 0, sizeof(*p));
 }
 
+// take a private copy of shared storage, if it is indeed shared. returns -1
+// if the copy couldn't be allocated, in which case the pool is unchanged.
+static inline int
+egcpool_unshare(egcpool* pool){
+  if(pool->sharers == NULL){
+    return 0;
+  }
+  if(*pool->sharers > 1){
+    char* tmp = NULL;
+    if(pool->poolsize){
+      if((tmp = (char*)malloc(pool->poolsize)) == NULL){
+        return -1;
+      }
+      memcpy(tmp, pool->pool, pool->poolsize);
+    }
+    --*pool->sharers;
+    pool->pool = tmp;
+  }else{ // we were the last holder; the storage is already ours
+    free(pool->sharers);
+  }
+  pool->sharers = NULL;
+  return 0;
+}
+
 static inline int
 egcpool_grow(egcpool* pool, size_t len){
   size_t newsize = pool->poolsize * 2;
@@ -64,9 +94,12 @@ egcpool_grow(egcpool* pool, size_t len){
 // the number of columns occupied to '*colcount'. Returns the number of bytes
 // consumed, not including any NUL terminator. Note that neither the number
 // of bytes nor columns is necessarily equivalent to the number of decoded code
-// points. Such are the ways of Unicode.
+// points. Such are the ways of Unicode. No more than 'len' bytes of
+// 'gcluster' are examined; an EGC running up against that limit ends there.
+// A multibyte character cut off by that limit is not consumed: the EGC ends
+// before it, and 0 is returned if it would have begun the EGC.
 static inline int
-utf8_egc_len(const char* gcluster, int* colcount){
+utf8_egc_nlen(const char* gcluster, size_t len, int* colcount){
   size_t ret = 0;
   *colcount = 0;
   wchar_t wc;
@@ -74,8 +107,13 @@ utf8_egc_len(const char* gcluster, int* colcount){
   mbstate_t mbt;
   memset(&mbt, 0, sizeof(mbt));
   do{
-    r = mbrtowc(&wc, gcluster, MB_CUR_MAX, &mbt);
-    if(r < 0){
+    if(len == 0){
+      break;
+    }
+    r = mbrtowc(&wc, gcluster, len < MB_CUR_MAX ? len : MB_CUR_MAX, &mbt);
+    if(r == -2){ // incomplete, so cut off by 'len'
+      break;
+    }else if(r < 0){
       return -1;
     }else if(r){
       int cols = wcwidth(wc);
@@ -87,11 +125,18 @@ utf8_egc_len(const char* gcluster, int* colcount){
       }
       ret += r;
       gcluster += r;
+      len -= r;
     }
   }while(r);
   return ret;
 }
 
+// As utf8_egc_nlen(), for a NUL-terminated 'gcluster'.
+static inline int
+utf8_egc_len(const char* gcluster, int* colcount){
+  return utf8_egc_nlen(gcluster, SIZE_MAX, colcount);
+}
+
 // if we're inserting a EGC of |len| bytes, ought we proactively realloc?
 static inline bool
 egcpool_alloc_justified(const egcpool* pool, int len){
@@ -116,6 +161,10 @@ egcpool_stash(egcpool* pool, const char* egc, size_t ulen){
   if(len <= 2){ // should never be empty, nor a single byte + NUL
     return -1;
   }
+  // if 'egc' lives in shared storage, it remains valid following the copy
+  if(egcpool_unshare(pool)){
+    return -1;
+  }
   // the first time through, we don't force a grow unless we expect ourselves
   // to have too little space. once we've done a search, we do force the grow.
   // we should thus never have more than two iterations of this loop.
@@ -219,6 +268,11 @@ static inline void
 egcpool_release(egcpool* pool, int offset){
   size_t freed = 1; // account for free(d) NUL terminator
   assert(egcpool_check_validity(pool, offset));
+  // if we can't get a private copy, leave the EGC in place. it's wasted space
+  // until the next erase, but it's not incorrect.
+  if(egcpool_unshare(pool)){
+    return;
+  }
   while(pool->pool[offset]){
     pool->pool[offset] = '\0';
     ++freed;
@@ -231,7 +285,15 @@ egcpool_release(egcpool* pool, int offset){
 
 static inline void
 egcpool_dump(egcpool* pool){
-  free(pool->pool);
+  if(pool->sharers){
+    if(--*pool->sharers == 0){
+      free(pool->sharers);
+      free(pool->pool);
+    }
+    pool->sharers = NULL;
+  }else{
+    free(pool->pool);
+  }
   pool->pool = NULL;
   pool->poolsize = 0;
   pool->poolwrite = 0;
@@ -249,6 +311,9 @@ egcpool_extended_gcluster(const egcpool* pool, const cell* c) {
 static inline int
 egcpool_dup(egcpool* dst, const egcpool* src){
   char* tmp;
+  if(egcpool_unshare(dst)){
+    return -1;
+  }
   if((tmp = (char*)realloc(dst->pool, src->poolsize)) == NULL){
     return -1;
   }
@@ -260,6 +325,29 @@ egcpool_dup(egcpool* dst, const egcpool* src){
   return 0;
 }
 
+// Share the storage of EGCpool 'src' with 'dst', copy-on-write, wiping out any
+// prior contents in 'dst'. This is O(1). Both pools remain fully usable; the
+// first to be modified takes its own copy. 'src' is modified only to track
+// the sharing.
+static inline int
+egcpool_share(egcpool* dst, egcpool* src){
+  if(dst->pool == src->pool && dst->sharers && dst->sharers == src->sharers){
+    return 0; // already sharing
+  }
+  egcpool_dump(dst);
+  if(src->pool){
+    if(src->sharers == NULL){
+      if((src->sharers = (unsigned*)malloc(sizeof(*src->sharers))) == NULL){
+        return -1;
+      }
+      *src->sharers = 1;
+    }
+    ++*src->sharers;
+  }
+  *dst = *src;
+  return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
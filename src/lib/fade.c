@@ -9,6 +9,12 @@ typedef struct ncfadectx {
   uint64_t nanosecs_step;       // nanoseconds per iteration
   uint64_t startns;             // time fade started
   uint64_t* channels;           // all channels from the framebuffer
+  // fading through the palette (see fade_palette_setup())
+  bool palette;
+  int level;                    // last applied, out of maxsteps
+  bool ours[NCPALETTESIZE];     // entries holding the plane's colors
+  unsigned rgb[NCPALETTESIZE];  // color held by each of our entries
+  uint32_t saved[NCPALETTESIZE];// prior channel of each of our entries
 } ncfadectx;
 
 int ncfadectx_iterations(const ncfadectx* nctx){
@@ -28,12 +34,14 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   }
   pp->maxr = pp->maxg = pp->maxb = 0;
   pp->maxbr = pp->maxbg = pp->maxbb = 0;
+  pp->palette = false;
+  pp->level = 0;
   unsigned r, g, b, br, bg, bb;
   uint64_t channels;
   int y, x;
   for(y = 0 ; y < pp->rows ; ++y){
     for(x = 0 ; x < pp->cols ; ++x){
-      channels = n->fb[nfbcellidx(n, y, x)].channels;
+      channels = ncplane_cell_const(n, y, x)->channels;
       pp->channels[y * pp->cols + x] = channels;
       channels_fg_rgb(channels, &r, &g, &b);
       if(r > pp->maxr){
@@ -104,9 +112,229 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   return 0;
 }
 
+// When the terminal can redefine its palette, and the plane's colors fit
+// within palette entries which nothing on the screen is using, each color is
+// moved onto its own entry. A step of the fade then need only reprogram those
+// entries (emitting a handful of initc sequences), rather than rewriting every
+// cell of the plane, and emitting each anew. Once the fade is done, the cells
+// get their RGB colors back (at the fade's final level), and the entries are
+// returned to their prior values (see fade_palette_settle()). Blending can't
+// be done with palette-indexed colors, so the plane must be opaque; the
+// terminal must otherwise draw in RGB, lest it draw others' colors through
+// the entries we've taken.
+static int
+rgb_compare(const void* va, const void* vb){
+  const unsigned a = *(const unsigned*)va;
+  const unsigned b = *(const unsigned*)vb;
+  return a < b ? -1 : a > b;
+}
+
+// the palette index holding 'rgb', one of the 'count' sorted 'colors'
+static int
+fade_palette_index(const unsigned* colors, const int* idx, int count, unsigned rgb){
+  const unsigned* found = bsearch(&rgb, colors, count, sizeof(*colors), rgb_compare);
+  return idx[found - colors];
+}
+
+static void
+fade_palette_cell(const unsigned* colors, const int* idx, int count, cell* c){
+  if(!cell_fg_default_p(c)){
+    cell_set_fg_palindex(c, fade_palette_index(colors, idx, count, cell_fg(c)));
+  }
+  if(!cell_bg_default_p(c)){
+    cell_set_bg_palindex(c, fade_palette_index(colors, idx, count, cell_bg(c)));
+  }
+}
+
+// move the plane onto palette entries, if possible. on failure, the plane is
+// untouched, and we fade through the cells' RGB channels.
+static inline void
+fade_palette_mark(const cell* c, bool* used){
+  if(cell_fg_palindex_p(c)){
+    used[cell_fg_palindex(c)] = true;
+  }
+  if(cell_bg_palindex_p(c)){
+    used[cell_bg_palindex(c)] = true;
+  }
+}
+
+static int
+fade_palette_setup(ncplane* n, ncfadectx* pp){
+  notcurses* nc = n->nc;
+  pp->palette = false;
+  if(!nc->tcache.RGBflag || !notcurses_canchangecolor(nc)){
+    return -1;
+  }
+  const int total = pp->rows * pp->cols + 1;
+  unsigned* colors = malloc(sizeof(*colors) * total * 2);
+  if(colors == NULL){
+    return -1;
+  }
+  int count = 0;
+  for(int i = 0 ; i < total ; ++i){
+    const uint32_t chans[] = {
+      channels_fchannel(pp->channels[i]), channels_bchannel(pp->channels[i]),
+    };
+    for(size_t c = 0 ; c < sizeof(chans) / sizeof(*chans) ; ++c){
+      if(channel_default_p(chans[c])){
+        continue;
+      }
+      if(channel_palindex_p(chans[c]) || channel_alpha(chans[c]) != CELL_ALPHA_OPAQUE){
+        free(colors);
+        return -1;
+      }
+      colors[count++] = chans[c] & CELL_BG_MASK;
+    }
+  }
+  qsort(colors, count, sizeof(*colors), rgb_compare);
+  int distinct = 0;
+  for(int i = 0 ; i < count ; ++i){
+    if(distinct == 0 || colors[distinct - 1] != colors[i]){
+      colors[distinct++] = colors[i];
+    }
+  }
+  // take entries from the top of the palette, avoiding any on the screen,
+  // and any in the planes (which might not yet have been rendered, or might
+  // be hidden beneath others for now)
+  bool used[NCPALETTESIZE] = { false };
+  for(int i = 0 ; nc->lastframe && i < nc->lfdimy * nc->lfdimx ; ++i){
+    fade_palette_mark(&nc->lastframe[i], used);
+  }
+  for(const ncplane* p = nc->top ; p ; p = p->below){
+    for(int y = 0 ; y < p->leny ; ++y){
+      for(int x = 0 ; x < p->lenx ; ++x){
+        fade_palette_mark(ncplane_cell_const(p, y, x), used);
+      }
+    }
+    fade_palette_mark(&p->basecell, used);
+  }
+  int idx[NCPALETTESIZE];
+  int found = 0;
+  for(int i = NCPALETTESIZE - 1 ; i >= 0 && found < distinct ; --i){
+    if(!used[i]){
+      idx[found++] = i;
+    }
+  }
+  if(found < distinct){
+    free(colors);
+    return -1;
+  }
+  memset(pp->ours, 0, sizeof(pp->ours));
+  for(int i = 0 ; i < distinct ; ++i){
+    pp->ours[idx[i]] = true;
+    pp->rgb[idx[i]] = colors[i];
+    pp->saved[idx[i]] = nc->palette.chans[idx[i]];
+  }
+  for(int y = 0 ; y < pp->rows ; ++y){
+    for(int x = 0 ; x < pp->cols ; ++x){
+      cell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c){
+        fade_palette_cell(colors, idx, distinct, c);
+      }
+    }
+  }
+  fade_palette_cell(colors, idx, distinct, &n->basecell);
+  free(colors);
+  pp->palette = true;
+  return 0;
+}
+
+static inline unsigned
+fade_rgb(unsigned rgb, int level, int maxsteps){
+  const unsigned r = ((rgb >> 16u) & 0xffu) * level / maxsteps;
+  const unsigned g = ((rgb >> 8u) & 0xffu) * level / maxsteps;
+  const unsigned b = (rgb & 0xffu) * level / maxsteps;
+  return (r << 16u) | (g << 8u) | b;
+}
+
+// reprogram our entries to 'level' of their colors, out of maxsteps
+static void
+fade_palette_level(notcurses* nc, ncfadectx* pp, int level){
+  for(int i = 0 ; i < NCPALETTESIZE ; ++i){
+    if(pp->ours[i]){
+      uint32_t chan = nc->palette.chans[i];
+      channel_set(&chan, fade_rgb(pp->rgb[i], level, pp->maxsteps));
+      if(chan != nc->palette.chans[i]){
+        nc->palette.chans[i] = chan;
+        nc->palette_damage[i] = true;
+      }
+    }
+  }
+  pp->level = level;
+}
+
+// setting RGB doesn't clear the palette bits, so we do so ourselves
+static void
+fade_settle_cell(const ncfadectx* pp, cell* c){
+  if(cell_fg_palindex_p(c) && pp->ours[cell_fg_palindex(c)]){
+    const unsigned idx = cell_fg_palindex(c);
+    c->channels &= ~CELL_FG_PALETTE;
+    c->attrword &= 0xffff00ff;
+    cell_set_fg(c, fade_rgb(pp->rgb[idx], pp->level, pp->maxsteps));
+  }
+  if(cell_bg_palindex_p(c) && pp->ours[cell_bg_palindex(c)]){
+    const unsigned idx = cell_bg_palindex(c);
+    c->channels &= ~CELL_BG_PALETTE;
+    c->attrword &= 0xffffff00;
+    cell_set_bg(c, fade_rgb(pp->rgb[idx], pp->level, pp->maxsteps));
+  }
+}
+
+// return the plane's cells (wherever they might have moved) to RGB, at the
+// last level applied (or the final level, should the fade have completed),
+// and our entries to their prior values
+static void
+fade_palette_settle(ncplane* n, ncfadectx* pp){
+  if(!pp->palette){
+    return;
+  }
+  int dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(int y = 0 ; y < dimy ; ++y){
+    for(int x = 0 ; x < dimx ; ++x){
+      cell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c){
+        fade_settle_cell(pp, c);
+      }
+    }
+  }
+  fade_settle_cell(pp, &n->basecell);
+  notcurses* nc = n->nc;
+  for(int i = 0 ; i < NCPALETTESIZE ; ++i){
+    if(pp->ours[i] && nc->palette.chans[i] != pp->saved[i]){
+      nc->palette.chans[i] = pp->saved[i];
+      nc->palette_damage[i] = true;
+    }
+  }
+  pp->palette = false;
+}
+
+// hand off to the fader, or render and sleep until the next iteration is due
+static int
+fade_wait(ncplane* n, const ncfadectx* nctx, int iter, fadecb fader, void* curry){
+  uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
+  struct timespec sleepspec;
+  sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
+  sleepspec.tv_nsec = nextwake % NANOSECS_IN_SEC;
+  int ret;
+  if(fader){
+    ret = fader(n->nc, n, &sleepspec, curry);
+  }else{
+    ret = notcurses_render(n->nc);
+    // clock_nanosleep() has no love for CLOCK_MONOTONIC_RAW, at least as
+    // of Glibc 2.29 + Linux 5.3 (or FreeBSD 12) :/.
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sleepspec, NULL);
+  }
+  return ret;
+}
+
 int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
                              fadecb fader, void* curry){
   int y, x;
+  if(nctx->palette){
+    fade_palette_level(n->nc, nctx, iter);
+    return fade_wait(n, nctx, iter, fader, curry);
+  }
   // each time through, we need look each cell back up, due to the
   // possibility of a resize event :/
   int dimy, dimx;
@@ -117,7 +345,10 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
       channels_fg_rgb(nctx->channels[nctx->cols * y + x], &r, &g, &b);
       unsigned br, bg, bb;
       channels_bg_rgb(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-      cell* c = &n->fb[dimx * y + x];
+      cell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c == NULL){
+        return -1;
+      }
       if(!cell_fg_default_p(c)){
         r = r * iter / nctx->maxsteps;
         g = g * iter / nctx->maxsteps;
@@ -132,20 +363,7 @@ int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
       }
     }
   }
-  uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
-  struct timespec sleepspec;
-  sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
-  sleepspec.tv_nsec = nextwake % NANOSECS_IN_SEC;
-  int ret = 0;
-  if(fader){
-    ret |= fader(n->nc, n, &sleepspec, curry);
-  }else{
-    ret |= notcurses_render(n->nc);
-    // clock_nanosleep() has no love for CLOCK_MONOTONIC_RAW, at least as
-    // of Glibc 2.29 + Linux 5.3 (or FreeBSD 12) :/.
-    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sleepspec, NULL);
-  }
-  return ret;
+  return fade_wait(n, nctx, iter, fader, curry);
 }
 
 static int
@@ -174,13 +392,20 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
   unsigned br, bg, bb;
   unsigned r, g, b;
   int y, x;
+  if(nctx->palette){
+    fade_palette_level(n->nc, nctx, nctx->maxsteps - iter);
+    return fade_wait(n, nctx, iter, fader, curry);
+  }
   // each time through, we need look each cell back up, due to the
   // possibility of a resize event :/
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
   for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
     for(x = 0 ; x < nctx->cols && x < dimx; ++x){
-      cell* c = &n->fb[dimx * y + x];
+      cell* c = ncplane_cell_ref_yx(n, y, x);
+      if(c == NULL){
+        return -1;
+      }
       if(!cell_fg_default_p(c)){
         channels_fg_rgb(nctx->channels[nctx->cols * y + x], &r, &g, &b);
         r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
@@ -212,30 +437,20 @@ int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
     bb = bb * (nctx->maxsteps - iter) / nctx->maxsteps;
     cell_set_bg_rgb(&n->basecell, br, bg, bb);
   }
-  uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
-  struct timespec sleepspec;
-  sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
-  sleepspec.tv_nsec = nextwake % NANOSECS_IN_SEC;
-  int ret;
-  if(fader){
-    ret = fader(n->nc, n, &sleepspec, curry);
-  }else{
-    ret = notcurses_render(n->nc);
-    // clock_nanosleep() has no love for CLOCK_MONOTONIC_RAW, at least as
-    // of Glibc 2.29 + Linux 5.3 (or FreeBSD 12) :/.
-    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sleepspec, NULL);
-  }
-  return ret;
+  return fade_wait(n, nctx, iter, fader, curry);
 }
 
 static ncfadectx* 
-ncfadectx_setup_internal(ncplane* n, const struct timespec* ts){
+ncfadectx_setup_internal(ncplane* n, const struct timespec* ts, bool palette){
   if(!n->nc->tcache.RGBflag && !n->nc->tcache.CCCflag){ // terminal can't fade
     return NULL;
   }
   ncfadectx* nctx = malloc(sizeof(*nctx));
   if(nctx){
     if(alloc_ncplane_palette(n, nctx, ts) == 0){
+      if(palette){
+        fade_palette_setup(n, nctx);
+      }
       return nctx;
     }
     free(nctx);
@@ -243,8 +458,10 @@ ncfadectx_setup_internal(ncplane* n, const struct timespec* ts){
   return NULL;
 }
 
+// the palette is only used when we drive the fade ourselves, as the cells
+// must be settled while the plane is known to still exist
 ncfadectx* ncfadectx_setup(ncplane* n){
-  return ncfadectx_setup_internal(n, NULL);
+  return ncfadectx_setup_internal(n, NULL, false);
 }
 
 void ncfadectx_free(ncfadectx* nctx){
@@ -254,11 +471,16 @@ void ncfadectx_free(ncfadectx* nctx){
   }
 }
 
-int ncplane_fadeout(ncplane* n, const struct timespec* ts, fadecb fader, void* curry){
-  ncfadectx* pp = ncfadectx_setup_internal(n, ts);
-  if(!pp){
-    return -1;
-  }
+// start the clock anew, for another pass through the same context
+static void
+fade_restart(ncfadectx* pp){
+  struct timespec times;
+  clock_gettime(CLOCK_MONOTONIC, &times);
+  pp->startns = timespec_to_ns(&times);
+}
+
+static int
+ncplane_fadeout_internal(ncplane* n, fadecb fader, ncfadectx* pp, void* curry){
   struct timespec times;
   ns_to_timespec(pp->startns, &times);
   do{
@@ -269,17 +491,29 @@ int ncplane_fadeout(ncplane* n, const struct timespec* ts, fadecb fader, void* c
     }
     int r = ncplane_fadeout_iteration(n, pp, iter, fader, curry);
     if(r){
-      ncfadectx_free(pp);
       return r;
     }
     clock_gettime(CLOCK_MONOTONIC, &times);
   }while(true);
-  ncfadectx_free(pp);
   return 0;
 }
 
+int ncplane_fadeout(ncplane* n, const struct timespec* ts, fadecb fader, void* curry){
+  ncfadectx* pp = ncfadectx_setup_internal(n, ts, true);
+  if(!pp){
+    return -1;
+  }
+  int ret = ncplane_fadeout_internal(n, fader, pp, curry);
+  if(ret == 0){ // the last step might have been skipped
+    pp->level = 0;
+  }
+  fade_palette_settle(n, pp);
+  ncfadectx_free(pp);
+  return ret;
+}
+
 int ncplane_fadein(ncplane* n, const struct timespec* ts, fadecb fader, void* curry){
-  ncfadectx* nctx = ncfadectx_setup_internal(n, ts);
+  ncfadectx* nctx = ncfadectx_setup_internal(n, ts, true);
   if(nctx == NULL){
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
@@ -291,29 +525,33 @@ int ncplane_fadein(ncplane* n, const struct timespec* ts, fadecb fader, void* cu
     return -1;
   }
   int ret = ncplane_fadein_internal(n, fader, nctx, curry);
+  if(ret == 0){ // the last step might have been skipped
+    nctx->level = nctx->maxsteps;
+  }
+  fade_palette_settle(n, nctx);
   ncfadectx_free(nctx);
   return ret;
 }
 
 int ncplane_pulse(ncplane* n, const struct timespec* ts, fadecb fader, void* curry){
-  ncfadectx pp;
   int ret;
-  if(!n->nc->tcache.RGBflag && !n->nc->tcache.CCCflag){ // terminal can't fade
-    return -1;
-  }
-  if(alloc_ncplane_palette(n, &pp, ts)){
+  ncfadectx* pp = ncfadectx_setup_internal(n, ts, true);
+  if(pp == NULL){
     return -1;
   }
   for(;;){
-    ret = ncplane_fadein_internal(n, fader, &pp, curry);
+    ret = ncplane_fadein_internal(n, fader, pp, curry);
     if(ret){
       break;
     }
-    ret = ncplane_fadeout(n, ts, fader, curry);
+    fade_restart(pp);
+    ret = ncplane_fadeout_internal(n, fader, pp, curry);
     if(ret){
       break;
     }
+    fade_restart(pp);
   }
-  free(pp.channels);
+  fade_palette_settle(n, pp);
+  ncfadectx_free(pp);
   return ret;
 }
@@ -1,5 +1,12 @@
 #include "version.h"
 #ifdef USE_FFMPEG
+#include <atomic>
+#include <cerrno>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
 #include "ffmpeg.h"
 #include "internal.h"
 #include "visual-details.h"
@@ -107,48 +114,110 @@ averr2ncerr(int averr){
   return NCERR_DECODE;
 }
 
-nc_err_e ncvisual_decode(ncvisual* nc){
-  if(nc->details.fmtctx == nullptr){ // not a file-backed ncvisual
-    return NCERR_DECODE;
+// add keyframe timestamp 'ts' to the index, unless it's already there. the
+// index is only an aid to seeking, so failure to grow it is ignored.
+static void
+keyframe_note(ncvisual_details* deets, int64_t ts){
+  if(ts == AV_NOPTS_VALUE){
+    return;
   }
+  int i = deets->keyframecount;
+  while(i && deets->keyframes[i - 1] > ts){ // almost always read in order
+    --i;
+  }
+  if(i && deets->keyframes[i - 1] == ts){
+    return;
+  }
+  if(deets->keyframecount == deets->keyframesize){
+    const int nsize = deets->keyframesize ? deets->keyframesize * 2 : 64;
+    auto tmp = static_cast<int64_t*>(realloc(deets->keyframes, sizeof(*deets->keyframes) * nsize));
+    if(tmp == nullptr){
+      return;
+    }
+    deets->keyframes = tmp;
+    deets->keyframesize = nsize;
+  }
+  memmove(deets->keyframes + i + 1, deets->keyframes + i,
+          sizeof(*deets->keyframes) * (deets->keyframecount - i));
+  deets->keyframes[i] = ts;
+  ++deets->keyframecount;
+}
+
+// the latest keyframe known to be no later than 'ts', or AV_NOPTS_VALUE
+static int64_t
+keyframe_before(const ncvisual_details* deets, int64_t ts){
+  int lo = 0;
+  int hi = deets->keyframecount;
+  while(lo < hi){
+    const int mid = lo + (hi - lo) / 2;
+    if(deets->keyframes[mid] <= ts){
+      lo = mid + 1;
+    }else{
+      hi = mid;
+    }
+  }
+  return lo ? deets->keyframes[lo - 1] : AV_NOPTS_VALUE;
+}
+
+// read and decode packets until a frame has been decoded into 'frame'.
+// subtitles found along the way are decoded into 'subtitle', setting
+// 'subtitled'. once the input is exhausted, frames still held by the codec
+// (e.g. when frame threading) are drained.
+static nc_err_e
+decode_frame(ncvisual_details* deets, AVFrame* frame, AVSubtitle* subtitle,
+             bool* subtitled){
   bool have_frame = false;
   bool unref = false;
-  // FIXME what if this was set up with e.g. ncvisual_from_rgba()?
-  if(nc->details.oframe){
-    av_freep(&nc->details.oframe->data[0]);
-  }
   do{
     do{
-      if(nc->details.packet_outstanding){
+      if(deets->packet_outstanding){
         break;
       }
       if(unref){
-        av_packet_unref(nc->details.packet);
+        av_packet_unref(deets->packet);
       }
       int averr;
-      if((averr = av_read_frame(nc->details.fmtctx, nc->details.packet)) < 0){
+      if((averr = av_read_frame(deets->fmtctx, deets->packet)) < 0){
         /*if(averr != AVERROR_EOF){
           fprintf(stderr, "Error reading frame info (%s)\n", av_err2str(*averr));
         }*/
+        if(averr == AVERROR_EOF){
+          if(!deets->draining){
+            avcodec_send_packet(deets->codecctx, nullptr);
+            deets->draining = true;
+          }
+          averr = avcodec_receive_frame(deets->codecctx, frame);
+          if(averr >= 0){
+            return NCERR_SUCCESS;
+          }
+        }
         return averr2ncerr(averr);
       }
       unref = true;
-      if(nc->details.packet->stream_index == nc->details.sub_stream_index){
+      if(deets->packet->stream_index == deets->sub_stream_index){
         int result = 0, ret;
-        ret = avcodec_decode_subtitle2(nc->details.subtcodecctx, &nc->details.subtitle, &result, nc->details.packet);
+        ret = avcodec_decode_subtitle2(deets->subtcodecctx, subtitle, &result, deets->packet);
         if(ret >= 0 && result){
-          // FIXME?
+          *subtitled = true;
         }
       }
-    }while(nc->details.packet->stream_index != nc->details.stream_index);
-    ++nc->details.packet_outstanding;
-    if(avcodec_send_packet(nc->details.codecctx, nc->details.packet) < 0){
+    }while(deets->packet->stream_index != deets->stream_index);
+    const int64_t pts = deets->packet->pts != AV_NOPTS_VALUE ?
+                        deets->packet->pts : deets->packet->dts;
+    if(pts != AV_NOPTS_VALUE && pts > deets->readts){
+      deets->readts = pts;
+    }
+    if(deets->packet->flags & AV_PKT_FLAG_KEY){
+      keyframe_note(deets, pts);
+    }
+    ++deets->packet_outstanding;
+    if(avcodec_send_packet(deets->codecctx, deets->packet) < 0){
       //fprintf(stderr, "Error processing AVPacket (%s)\n", av_err2str(*ncerr));
-      return ncvisual_decode(nc);
+      return decode_frame(deets, frame, subtitle, subtitled);
     }
-    --nc->details.packet_outstanding;
-    av_packet_unref(nc->details.packet);
-    int averr = avcodec_receive_frame(nc->details.codecctx, nc->details.frame);
+    --deets->packet_outstanding;
+    av_packet_unref(deets->packet);
+    int averr = avcodec_receive_frame(deets->codecctx, frame);
     if(averr >= 0){
       have_frame = true;
     }else if(averr == AVERROR(EAGAIN) || averr == AVERROR_EOF){
@@ -158,6 +227,126 @@ nc_err_e ncvisual_decode(ncvisual* nc){
       return averr2ncerr(averr);
     }
   }while(!have_frame);
+  return NCERR_SUCCESS;
+}
+
+// the swscale filter for 'quality'. NCSCALEQ_BOX uses rgba_scale_box() when
+// the source is already RGBA, and swscale's area averaging otherwise.
+static int
+scale_swsflags(ncscalequality_e quality){
+  switch(quality){
+    case NCSCALEQ_FAST: return SWS_FAST_BILINEAR;
+    case NCSCALEQ_AREA: return SWS_AREA;
+    case NCSCALEQ_BICUBIC: return SWS_BICUBIC;
+    case NCSCALEQ_BOX: return SWS_AREA;
+    default: return SWS_LANCZOS;
+  }
+}
+
+// can 'f' be scaled with rgba_scale_box() at 'quality'?
+static inline bool
+scale_boxable(const AVFrame* f, ncscalequality_e quality){
+  return quality == NCSCALEQ_BOX && f->format == AV_PIX_FMT_RGBA;
+}
+
+// a context scaling 'srcw'x'srch' frames of 'srcfmt' to 'dstw'x'dsth' frames
+// of 'dstfmt', reusing the one cached in 'sc' if its parameters match
+static SwsContext*
+swscache_get(framepool* fp, swscache* sc, int srcw, int srch, int srcfmt,
+             int dstw, int dsth, int dstfmt, int flags){
+  const bool hit = sc->ctx && sc->srcw == srcw && sc->srch == srch &&
+                   sc->srcfmt == srcfmt && sc->dstw == dstw && sc->dsth == dsth &&
+                   sc->dstfmt == dstfmt && sc->flags == flags;
+  pthread_mutex_lock(&fp->lock);
+  ++(hit ? fp->swshits : fp->swsmisses);
+  pthread_mutex_unlock(&fp->lock);
+  if(hit){
+    return sc->ctx;
+  }
+  sws_freeContext(sc->ctx);
+  sc->ctx = sws_getContext(srcw, srch, static_cast<AVPixelFormat>(srcfmt),
+                           dstw, dsth, static_cast<AVPixelFormat>(dstfmt),
+                           flags, nullptr, nullptr, nullptr);
+  sc->srcw = srcw;
+  sc->srch = srch;
+  sc->srcfmt = srcfmt;
+  sc->dstw = dstw;
+  sc->dsth = dsth;
+  sc->dstfmt = dstfmt;
+  sc->flags = flags;
+  return sc->ctx;
+}
+
+// a frame of 'rows'x'cols' in 'format', from the pool if one is available. a
+// new geometry or format empties the pool.
+static AVFrame*
+framepool_get(framepool* fp, int rows, int cols, int format){
+  AVFrame* stale[FRAMEPOOL_MAX];
+  int stalecount = 0;
+  AVFrame* f = nullptr;
+  pthread_mutex_lock(&fp->lock);
+  if(fp->rows != rows || fp->cols != cols || fp->format != format){
+    memcpy(stale, fp->frames, sizeof(*stale) * fp->count);
+    stalecount = fp->count;
+    fp->count = 0;
+    fp->rows = rows;
+    fp->cols = cols;
+    fp->format = format;
+  }
+  if(fp->count){
+    f = fp->frames[--fp->count];
+    ++fp->hits;
+  }else{
+    ++fp->misses;
+  }
+  pthread_mutex_unlock(&fp->lock);
+  while(stalecount){
+    av_frame_free(&stale[--stalecount]);
+  }
+  if(f == nullptr && (f = av_frame_alloc())){
+    f->format = format;
+    f->width = cols;
+    f->height = rows;
+    if(av_frame_get_buffer(f, IMGALLOCALIGN) < 0){
+      av_frame_free(&f);
+    }
+  }
+  return f;
+}
+
+// return 'f' to the pool, or free it if it's of a stale geometry or format,
+// or the pool is full. 'f' may be NULL.
+static void
+framepool_put(framepool* fp, AVFrame* f){
+  if(f == nullptr){
+    return;
+  }
+  pthread_mutex_lock(&fp->lock);
+  if(f->width == fp->cols && f->height == fp->rows && f->format == fp->format &&
+     fp->count < FRAMEPOOL_MAX){
+    fp->frames[fp->count++] = f;
+    f = nullptr;
+  }
+  pthread_mutex_unlock(&fp->lock);
+  av_frame_free(&f);
+}
+
+// move the reuse counts accumulated since the last call into 'stats'
+static void
+framepool_fold(framepool* fp, ncstats* stats){
+  pthread_mutex_lock(&fp->lock);
+  stats->scalebuf_hits += fp->hits;
+  stats->scalebuf_misses += fp->misses;
+  stats->swsctx_hits += fp->swshits;
+  stats->swsctx_misses += fp->swsmisses;
+  fp->hits = fp->misses = 0;
+  fp->swshits = fp->swsmisses = 0;
+  pthread_mutex_unlock(&fp->lock);
+}
+
+// point the ncvisual at its newly-decoded details.frame
+static void
+ncvisual_frame_decoded(ncvisual* nc){
 //print_frame_summary(nc->details.codecctx, nc->details.frame);
   const AVFrame* f = nc->details.frame;
   nc->rowstride = f->linesize[0];
@@ -165,29 +354,166 @@ nc_err_e ncvisual_decode(ncvisual* nc){
   nc->rows = nc->details.frame->height;
 //fprintf(stderr, "good decode! %d/%d %d %p\n", nc->details.frame->height, nc->details.frame->width, nc->rowstride, f->data);
   ncvisual_set_data(nc, reinterpret_cast<uint32_t*>(f->data[0]), false);
+  ++nc->details.framenum;
+  // any prescaled frame is of the old one
+  framepool_put(&nc->details.pool, nc->details.sframe);
+  nc->details.sframe = nullptr;
+}
+
+nc_err_e ncvisual_decode(ncvisual* nc){
+  if(nc->details.fmtctx == nullptr){ // not a file-backed ncvisual
+    // ...unless it's a still image from the cache, which has no more frames
+    return nc->cached ? NCERR_EOF : NCERR_DECODE;
+  }
+  // FIXME what if this was set up with e.g. ncvisual_from_rgba()?
+  if(nc->details.oframe){
+    av_freep(&nc->details.oframe->data[0]);
+  }
+  bool subtitled = false;
+  nc_err_e ret = decode_frame(&nc->details, nc->details.frame,
+                              &nc->details.subtitle, &subtitled);
+  if(ret != NCERR_SUCCESS){
+    return ret;
+  }
+  ncvisual_frame_decoded(nc);
+  return NCERR_SUCCESS;
+}
+
+// seek to 'ts' (or, with AVSEEK_FLAG_BACKWARD, the keyframe preceding it),
+// and decode the frame found there. fails for input which can't seek.
+static nc_err_e
+ncvisual_seek_ts(ncvisual* nc, int64_t ts){
+  ncvisual_details* deets = &nc->details;
+  if(av_seek_frame(deets->fmtctx, deets->stream_index, ts, AVSEEK_FLAG_BACKWARD) < 0){
+    return NCERR_DECODE;
+  }
+  avcodec_flush_buffers(deets->codecctx);
+  av_packet_unref(deets->packet);
+  deets->packet_outstanding = 0;
+  deets->draining = false;
+  deets->readts = AV_NOPTS_VALUE;
+  return ncvisual_decode(nc);
+}
+
+// seek back to the beginning, and decode the first frame anew. fails for
+// input which can't seek (i.e. pipes).
+static nc_err_e
+ncvisual_rewind(ncvisual* nc){
+  ncvisual_details* deets = &nc->details;
+  const AVStream* st = deets->fmtctx->streams[deets->stream_index];
+  const int64_t ts = st->start_time == AV_NOPTS_VALUE ? 0 : st->start_time;
+  nc_err_e err = ncvisual_seek_ts(nc, ts);
+  if(err == NCERR_SUCCESS){
+    deets->framenum = 1;
+  }
+  return err;
+}
+
+// does the current frame remain on screen at 'ts'? a frame lacking a duration
+// only covers its own timestamp.
+static inline bool
+frame_covers(const AVFrame* f, int64_t ts){
+  const int64_t pts = f->best_effort_timestamp;
+  return pts <= ts && pts + (f->pkt_duration > 0 ? f->pkt_duration : 1) > ts;
+}
+
+// make the frame shown 'ns' into the media current. we decode forward from the
+// current frame only if the target lies ahead, within what we've already
+// demuxed, and no keyframe lies between. otherwise, we seek to the latest
+// keyframe preceding the target (letting the demuxer find it, if it's beyond
+// what we've read), and decode forward from there. the frames decoded along
+// the way are not shown. if 'resync' is set, the demuxer and codec have run
+// ahead of the current frame (see stream_seek()), and we must always seek.
+static nc_err_e
+ncvisual_seek_now(ncvisual* nc, uint64_t ns, bool resync){
+  ncvisual_details* deets = &nc->details;
+  const AVStream* st = deets->fmtctx->streams[deets->stream_index];
+  const double tbase = av_q2d(st->time_base);
+  if(tbase <= 0 || deets->frame->best_effort_timestamp == AV_NOPTS_VALUE){
+    return NCERR_DECODE; // we can't tell where we are
+  }
+  const int64_t start = st->start_time == AV_NOPTS_VALUE ? 0 : st->start_time;
+  const int64_t target = start + static_cast<int64_t>(ns / (tbase * NANOSECS_IN_SEC));
+  if(!resync && frame_covers(deets->frame, target)){
+    return NCERR_SUCCESS;
+  }
+  const int64_t cur = deets->frame->best_effort_timestamp;
+  const int64_t kf = keyframe_before(deets, target);
+  bool seek = true;
+  bool mustseek = true; // otherwise, we can fall back to decoding forward
+  int64_t seekts = kf;
+  if(resync || target < cur || deets->draining){
+    if(kf == AV_NOPTS_VALUE){
+      seekts = target;
+    }
+  }else if(target > deets->readts){
+    seekts = target; // there might be keyframes we haven't seen
+    mustseek = false; // ...but the input might not be seekable
+  }else if(kf == AV_NOPTS_VALUE || kf <= cur){
+    seek = false;
+  }
+  if(seek){
+    nc_err_e err = ncvisual_seek_ts(nc, seekts);
+    if(err != NCERR_SUCCESS && mustseek){
+      return err;
+    }
+  }
+  while(!frame_covers(deets->frame, target)){
+    // we landed beyond the target (an inexact seek, or a frame lacking a
+    // duration); take what we got, rather than seeking back forever
+    if(deets->frame->best_effort_timestamp > target){
+      break;
+    }
+    nc_err_e err = ncvisual_decode(nc);
+    if(err != NCERR_SUCCESS){
+      return err;
+    }
+  }
   return NCERR_SUCCESS;
 }
 
-// resize frame to oframe, converting to RGBA (if necessary) along the way
-nc_err_e ncvisual_resize(ncvisual* nc, int rows, int cols) {
+nc_err_e ncvisual_seek(ncvisual* nc, uint64_t ns){
+  if(nc->details.fmtctx == nullptr){ // not a file-backed ncvisual
+    // ...unless it's a still image from the cache, shown from the beginning
+    if(nc->cached){
+      return ns ? NCERR_EOF : NCERR_SUCCESS;
+    }
+    return NCERR_DECODE;
+  }
+  // the stream's decoder is running ahead of us; it'll seek once the streamer
+  // returns, and carry on from there
+  if(nc->details.streaming){
+    nc->details.seekpending = true;
+    nc->details.seekns = ns;
+    return NCERR_SUCCESS;
+  }
+  return ncvisual_seek_now(nc, ns, false);
+}
+
+// resize frame to oframe, converting to RGBA (if necessary) along the way,
+// with the filter ncvisual_blit() would use at 'quality'
+nc_err_e ncvisual_resize_quality(ncvisual* nc, int rows, int cols,
+                                 ncscalequality_e quality) {
   if(nc->details.oframe){
     return NCERR_SUCCESS;
   }
   const int targformat = AV_PIX_FMT_RGBA;
 //fprintf(stderr, "got format: %d want format: %d\n", nc->details.frame->format, targformat);
-  auto swsctx = sws_getContext(nc->details.frame->width,
-                               nc->details.frame->height,
-                               static_cast<AVPixelFormat>(nc->details.frame->format),
-                               cols, rows,
-                               static_cast<AVPixelFormat>(targformat),
-                               SWS_LANCZOS, nullptr, nullptr, nullptr);
-  if(swsctx == nullptr){
-    //fprintf(stderr, "Error retrieving swsctx\n");
-    return NCERR_NOMEM;
+  const bool boxed = scale_boxable(nc->details.frame, quality);
+  SwsContext* swsctx = nullptr;
+  if(!boxed){
+    swsctx = swscache_get(&nc->details.pool, &nc->details.sws,
+                          nc->details.frame->width, nc->details.frame->height,
+                          nc->details.frame->format, cols, rows, targformat,
+                          scale_swsflags(quality));
+    if(swsctx == nullptr){
+      //fprintf(stderr, "Error retrieving swsctx\n");
+      return NCERR_NOMEM;
+    }
   }
   if((nc->details.oframe = av_frame_alloc()) == nullptr){
     // fprintf(stderr, "Couldn't allocate frame for %s\n", filename);
-    return NCERR_NOMEM; // no need to free swsctx
+    return NCERR_NOMEM; // swsctx is cached
   }
   memcpy(nc->details.oframe, nc->details.frame, sizeof(*nc->details.oframe));
   nc->details.oframe->format = targformat;
@@ -202,14 +528,22 @@ nc_err_e ncvisual_resize(ncvisual* nc, int rows, int cols) {
 //fprintf(stderr, "Error allocating visual data (%d)\n", size);
     return NCERR_NOMEM;
   }
-  int height = sws_scale(swsctx, nc->details.frame->data,
-                         nc->details.frame->linesize, 0,
-                         nc->details.frame->height, nc->details.oframe->data,
-                         nc->details.oframe->linesize);
-  sws_freeContext(swsctx);
-  if(height < 0){
-    //fprintf(stderr, "Error applying scaling (%s)\n", av_err2str(height));
-    return NCERR_DECODE;
+  if(boxed){
+    if(rgba_scale_box(nc->details.frame->data[0], nc->details.frame->height,
+                      nc->details.frame->linesize[0], nc->details.frame->width,
+                      nc->details.oframe->data[0], rows,
+                      nc->details.oframe->linesize[0], cols, 0, rows)){
+      return NCERR_NOMEM;
+    }
+  }else{
+    int height = sws_scale(swsctx, nc->details.frame->data,
+                           nc->details.frame->linesize, 0,
+                           nc->details.frame->height, nc->details.oframe->data,
+                           nc->details.oframe->linesize);
+    if(height < 0){
+      //fprintf(stderr, "Error applying scaling (%s)\n", av_err2str(height));
+      return NCERR_DECODE;
+    }
   }
   const AVFrame* f = nc->details.oframe;
   int bpp = av_get_bits_per_pixel(av_pix_fmt_desc_get(static_cast<AVPixelFormat>(f->format)));
@@ -225,9 +559,144 @@ nc_err_e ncvisual_resize(ncvisual* nc, int rows, int cols) {
   return NCERR_SUCCESS;
 }
 
-ncvisual* ncvisual_from_file(const char* filename, nc_err_e* ncerr) {
+// intra-only codecs (as used by still image formats) can yet carry a sequence
+// of frames (as motion JPEG does), so demand that the stream claim at most one.
+bool ncvisual_still_p(const ncvisual* ncv) {
+  if(ncv->details.fmtctx == nullptr || ncv->details.stream_index < 0){
+    return false;
+  }
+  const AVStream* st = ncv->details.fmtctx->streams[ncv->details.stream_index];
+  const AVCodecDescriptor* desc = avcodec_descriptor_get(st->codecpar->codec_id);
+  return desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY) && st->nb_frames <= 1;
+}
+
+// all the planes of a frame, in whatever format it's in
+static auto
+frame_bytes(const AVFrame* f) -> size_t {
+  if(f == nullptr || f->data[0] == nullptr){
+    return 0;
+  }
+  const int size = av_image_get_buffer_size(static_cast<AVPixelFormat>(f->format),
+                                            f->width, f->height, 1);
+  return size > 0 ? size : 0;
+}
+
+// the RGBA image ('data', usually that of oframe), and the frames as decoded
+// and as scaled ahead by ncvisual_stream()
+auto ncvisual_bytes(const ncvisual* ncv) -> size_t {
+  size_t bytes = ncv->data ? static_cast<size_t>(ncv->rows) * ncv->rowstride : 0;
+  bytes += frame_bytes(ncv->details.frame);
+  const AVFrame* sf = ncv->details.sframe;
+  if(sf && reinterpret_cast<const uint32_t*>(sf->data[0]) != ncv->data){
+    bytes += frame_bytes(sf);
+  }
+  return bytes;
+}
+
+// the greatest power of two (up to 2^'maxlowres') by which a 'height'x'width'
+// image can be reduced while still covering 'rows'x'cols', as a shift.
+// libavcodec rounds reduced dimensions up.
+static int
+lowres_for(int height, int width, int rows, int cols, int maxlowres){
+  int lowres = 0;
+  while(lowres < maxlowres){
+    const int shift = lowres + 1;
+    if(((height + (1 << shift) - 1) >> shift) < rows ||
+       ((width + (1 << shift) - 1) >> shift) < cols){
+      break;
+    }
+    lowres = shift;
+  }
+  return lowres;
+}
+
+#define CUSTOMIO_BUFSIZE 65536
+
+static int
+customio_read(void* opaque, uint8_t* buf, int size){
+  auto io = static_cast<customio*>(opaque);
+  if(io->data){
+    size_t n = io->len - io->pos;
+    if(n > static_cast<size_t>(size)){
+      n = size;
+    }
+    if(n == 0){
+      return AVERROR_EOF;
+    }
+    memcpy(buf, io->data + io->pos, n);
+    io->pos += n;
+    return n;
+  }
+  ssize_t r;
+  do{
+    r = read(io->fd, buf, size);
+  }while(r < 0 && errno == EINTR);
+  if(r < 0){
+    return AVERROR(errno);
+  }
+  return r ? r : AVERROR_EOF;
+}
+
+static int64_t
+customio_seek(void* opaque, int64_t offset, int whence){
+  auto io = static_cast<customio*>(opaque);
+  whence &= ~AVSEEK_FORCE;
+  if(io->data == nullptr){
+    if(whence == AVSEEK_SIZE){
+      struct stat st;
+      return fstat(io->fd, &st) || !S_ISREG(st.st_mode) ? -1 : st.st_size;
+    }
+    return lseek(io->fd, offset, whence);
+  }
+  int64_t pos;
+  switch(whence){
+    case AVSEEK_SIZE: return io->len;
+    case SEEK_SET: pos = offset; break;
+    case SEEK_CUR: pos = io->pos + offset; break;
+    case SEEK_END: pos = io->len + offset; break;
+    default: return -1;
+  }
+  if(pos < 0 || static_cast<uint64_t>(pos) > io->len){
+    return -1;
+  }
+  io->pos = pos;
+  return pos;
+}
+
+// open 'src', which is in memory or behind a file descriptor, through our
+// own AVIOContext. the caller's buffer is read in place. a descriptor is
+// seekable only if it's a regular file; pipes are read strictly forward.
+static int
+customio_open(ncvisual_details* deets, const ncvsource* src){
+  customio* io = &deets->io;
+  io->data = src->data;
+  io->len = src->len;
+  io->pos = 0;
+  io->fd = src->data ? -1 : src->fd;
+  struct stat st;
+  const bool seekable = io->data || (fstat(io->fd, &st) == 0 && S_ISREG(st.st_mode));
+  auto buf = static_cast<unsigned char*>(av_malloc(CUSTOMIO_BUFSIZE));
+  if(buf == nullptr){
+    return AVERROR(ENOMEM);
+  }
+  if((io->ctx = avio_alloc_context(buf, CUSTOMIO_BUFSIZE, 0, io, customio_read,
+                                   nullptr, seekable ? customio_seek : nullptr)) == nullptr){
+    av_freep(&buf);
+    return AVERROR(ENOMEM);
+  }
+  if((deets->fmtctx = avformat_alloc_context()) == nullptr){
+    return AVERROR(ENOMEM);
+  }
+  deets->fmtctx->pb = io->ctx;
+  // frees the AVFormatContext on failure, but not the AVIOContext
+  return avformat_open_input(&deets->fmtctx, nullptr, nullptr, nullptr);
+}
+
+ncvisual* ncvisual_open(const ncvsource* src, nc_err_e* ncerr, int rows,
+                        int cols, bool* reduced) {
   AVStream* st;
   *ncerr = NCERR_SUCCESS;
+  *reduced = false;
   ncvisual* ncv = ncvisual_create();
   if(ncv == nullptr){
     // fprintf(stderr, "Couldn't create %s (%s)\n", filename, strerror(errno));
@@ -235,9 +704,14 @@ ncvisual* ncvisual_from_file(const char* filename, nc_err_e* ncerr) {
     return nullptr;
   }
 //fprintf(stderr, "FRAME FRAME: %p\n", ncv->details.frame);
-  int averr = avformat_open_input(&ncv->details.fmtctx, filename, nullptr, nullptr);
+  int averr;
+  if(src->path){
+    averr = avformat_open_input(&ncv->details.fmtctx, src->path, nullptr, nullptr);
+  }else{
+    averr = customio_open(&ncv->details, src);
+  }
   if(averr < 0){
-//fprintf(stderr, "Couldn't open %s (%d)\n", filename, averr);
+//fprintf(stderr, "Couldn't open %s (%d)\n", src->path, averr);
     *ncerr = averr2ncerr(averr);
     goto err;
   }
@@ -290,6 +764,18 @@ ncvisual* ncvisual_from_file(const char* filename, nc_err_e* ncerr) {
   if(avcodec_parameters_to_context(ncv->details.codecctx, st->codecpar) < 0){
     goto err;
   }
+  // decoders supporting it (e.g. JPEG, via DCT scaling) can produce a reduced
+  // image directly, far more cheaply than we could scale it afterwards
+  if((rows > 0 || cols > 0) && st->codecpar->width > 0 && st->codecpar->height > 0){
+    ncv->details.codecctx->lowres = lowres_for(st->codecpar->height,
+                                               st->codecpar->width, rows, cols,
+                                               ncv->details.codec->max_lowres);
+    *reduced = ncv->details.codecctx->lowres > 0;
+  }
+  // decode several frames at once, with a thread per processor. the frames
+  // come out in order, after a few frames' delay.
+  ncv->details.codecctx->thread_count = 0;
+  ncv->details.codecctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
   if((averr = avcodec_open2(ncv->details.codecctx, ncv->details.codec, nullptr)) < 0){
     //fprintf(stderr, "Couldn't open codec for %s (%s)\n", filename, av_err2str(*averr));
     *ncerr = averr2ncerr(averr);
@@ -318,124 +804,814 @@ err:
   return nullptr;
 }
 
-// iterate over the decoded frames, calling streamer() with curry for each.
-// frames carry a presentation time relative to the beginning, so we get an
+// ncvisual_stream() is a pipeline of three stages: a thread decoding frames,
+// a thread scaling them to the geometry at which the last frame was blitted,
+// and the caller, which blits, renders, and paces them. the stages are joined
+// by bounded single-producer, single-consumer queues. frames which have been
+// overtaken by their successors are dropped, rather than letting the
+// schedule slip, except while being recorded (see ncvisual_record()).
+#define STREAM_QUEUE_DEPTH 4
+
+// a frame making its way through the pipeline. a null 'frame' marks either a
+// dropped frame or, if 'err' is set, the end of the stream.
+struct streamframe {
+  AVFrame* frame;        // as decoded
+  AVFrame* scaled;       // RGBA at the last blit's geometry, or nullptr
+  AVSubtitle subtitle;   // valid iff 'subtitled'
+  bool subtitled;
+  nc_err_e err;          // NCERR_SUCCESS unless this ends the stream
+  uint64_t schedns;      // CLOCK_MONOTONIC time at which it ought be shown
+  uint64_t offsetns;     // from the beginning of the stream, unscaled
+  uint64_t decodens;     // time spent in each stage
+  uint64_t scalens;
+};
+
+// each index is only advanced by its owner, so no lock is needed. the
+// semaphores only put a stage to sleep when it has nothing to do.
+struct framequeue {
+  streamframe slots[STREAM_QUEUE_DEPTH];
+  std::atomic<unsigned> head; // next slot to be read, owned by the consumer
+  std::atomic<unsigned> tail; // next slot to be written, owned by the producer
+  sem_t items;
+  sem_t spaces;
+};
+
+struct streampipe {
+  ncvisual* ncv;
+  framequeue decoded;     // decoder -> scaler
+  framequeue scaled;      // scaler -> caller
+  std::atomic<bool> stop;
+  std::atomic<int> rows;  // geometry of the last blit, 0 if unknown
+  std::atomic<int> cols;
+  std::atomic<int> fmt;   // AVPixelFormat of the last blit
+  std::atomic<bool> keepall; // show every frame, however late (to record it)
+  ncscalequality_e quality;
+  pthread_t decoder;
+  pthread_t scaler;
+  bool running;           // the threads have been started, and not stopped
+  // the schedule, used only by the decoder once it's running
+  uint64_t nsbegin;       // time we started
+  double tbase;
+  float timescale;
+  bool usets;
+  // each frame has a pkt_duration in milliseconds. keep the aggregate, in case
+  // we don't have PTS available.
+  uint64_t sum_duration;
+};
+
+static inline uint64_t
+stream_nowns(void){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return timespec_to_ns(&now);
+}
+
+// frames carry a presentation time relative to the beginning, so we got an
 // initial timestamp, and check each frame against the elapsed time to sync
-// up playback.
+// up playback. the unscaled time since the beginning goes to 'offsetns'.
+static uint64_t
+stream_schedule(streampipe* p, const AVFrame* f, uint64_t* offsetns){
+  double tbase = p->tbase;
+  uint64_t duration = f->pkt_duration * tbase * NANOSECS_IN_SEC;
+//fprintf(stderr, "use: %u dur: %ju ts: %ju tbase: %f\n", p->usets, duration, f->best_effort_timestamp, tbase);
+  if(p->usets){
+    if(tbase == 0){
+      tbase = duration;
+    }
+    *offsetns = f->best_effort_timestamp * tbase * NANOSECS_IN_SEC;
+  }else{
+    p->sum_duration += duration;
+    *offsetns = p->sum_duration;
+  }
+  return p->nsbegin + *offsetns * static_cast<double>(p->timescale);
+}
+
+static void
+streamframe_free(framepool* fp, streamframe* sf){
+  av_frame_free(&sf->frame);
+  framepool_put(fp, sf->scaled);
+  sf->scaled = nullptr;
+  if(sf->subtitled){
+    avsubtitle_free(&sf->subtitle);
+    sf->subtitled = false;
+  }
+}
+
+static void
+sem_wait_nointr(sem_t* s){
+  while(sem_wait(s) && errno == EINTR){
+    ;
+  }
+}
+
+static int
+framequeue_init(framequeue* q){
+  q->head = 0;
+  q->tail = 0;
+  if(sem_init(&q->items, 0, 0)){
+    return -1;
+  }
+  if(sem_init(&q->spaces, 0, STREAM_QUEUE_DEPTH)){
+    sem_destroy(&q->items);
+    return -1;
+  }
+  return 0;
+}
+
+// free any frames left in the queue, and the queue itself
+static void
+framequeue_destroy(streampipe* p, framequeue* q){
+  const unsigned tail = q->tail.load(std::memory_order_acquire);
+  for(unsigned h = q->head.load(std::memory_order_relaxed) ; h != tail ; ++h){
+    streamframe_free(&p->ncv->details.pool, &q->slots[h % STREAM_QUEUE_DEPTH]);
+  }
+  sem_destroy(&q->spaces);
+  sem_destroy(&q->items);
+}
+
+// returns false, having queued nothing, if the pipeline is being torn down
+static bool
+framequeue_push(streampipe* p, framequeue* q, const streamframe* sf){
+  sem_wait_nointr(&q->spaces);
+  if(p->stop.load()){
+    return false;
+  }
+  const unsigned t = q->tail.load(std::memory_order_relaxed);
+  q->slots[t % STREAM_QUEUE_DEPTH] = *sf;
+  q->tail.store(t + 1, std::memory_order_release);
+  sem_post(&q->items);
+  return true;
+}
+
+// returns false, having taken nothing, if the pipeline is being torn down
+static bool
+framequeue_pop(streampipe* p, framequeue* q, streamframe* sf){
+  sem_wait_nointr(&q->items);
+  if(p->stop.load()){
+    return false;
+  }
+  const unsigned h = q->head.load(std::memory_order_relaxed);
+  *sf = q->slots[h % STREAM_QUEUE_DEPTH];
+  q->head.store(h + 1, std::memory_order_release);
+  sem_post(&q->spaces);
+  return true;
+}
+
+// the frame which would next be popped, if it has arrived. only the consumer
+// may peek, and the frame remains in the queue.
+static const streamframe*
+framequeue_peek(framequeue* q){
+  const unsigned h = q->head.load(std::memory_order_relaxed);
+  if(q->tail.load(std::memory_order_acquire) == h){
+    return nullptr;
+  }
+  return &q->slots[h % STREAM_QUEUE_DEPTH];
+}
+
+// has the frame following 'q's current one already come due? if so, the
+// current one needn't be shown.
+static bool
+stream_overtaken(framequeue* q){
+  const streamframe* next = framequeue_peek(q);
+  return next && next->frame && next->schedns <= stream_nowns();
+}
+
+static void*
+stream_decoder(void* vp){
+  auto p = static_cast<streampipe*>(vp);
+  while(true){
+    streamframe sf{};
+    const uint64_t start = stream_nowns();
+    if((sf.frame = av_frame_alloc()) == nullptr){
+      sf.err = NCERR_NOMEM;
+    }else{
+      sf.err = decode_frame(&p->ncv->details, sf.frame, &sf.subtitle, &sf.subtitled);
+    }
+    sf.decodens = stream_nowns() - start;
+    if(sf.err != NCERR_SUCCESS){
+      streamframe_free(&p->ncv->details.pool, &sf);
+      framequeue_push(p, &p->decoded, &sf);
+      return nullptr;
+    }
+    sf.schedns = stream_schedule(p, sf.frame, &sf.offsetns);
+    if(!framequeue_push(p, &p->decoded, &sf)){
+      streamframe_free(&p->ncv->details.pool, &sf);
+      return nullptr;
+    }
+  }
+}
+
+// scale 'f' to 'fmt' at 'rows'x'cols', unless that's unknown or unnecessary
+static AVFrame*
+stream_scale(framepool* fp, swscache* sc, const AVFrame* f, int rows, int cols,
+             int fmt, ncscalequality_e quality){
+  if(rows <= 0 || cols <= 0){
+    return nullptr;
+  }
+  if(rows == f->height && cols == f->width && f->format == fmt){
+    return nullptr;
+  }
+  if(fmt == AV_PIX_FMT_RGBA && scale_boxable(f, quality)){
+    AVFrame* scaled = framepool_get(fp, rows, cols, fmt);
+    if(scaled && rgba_scale_box(f->data[0], f->height, f->linesize[0], f->width,
+                                scaled->data[0], rows, scaled->linesize[0],
+                                cols, 0, rows)){
+      framepool_put(fp, scaled);
+      scaled = nullptr;
+    }
+    return scaled;
+  }
+  SwsContext* swsctx = swscache_get(fp, sc, f->width, f->height, f->format,
+                                    cols, rows, fmt, scale_swsflags(quality));
+  if(swsctx == nullptr){
+    return nullptr;
+  }
+  AVFrame* scaled = framepool_get(fp, rows, cols, fmt);
+  if(scaled && sws_scale(swsctx, f->data, f->linesize, 0, f->height,
+                         scaled->data, scaled->linesize) < 0){
+    framepool_put(fp, scaled);
+    scaled = nullptr;
+  }
+  return scaled;
+}
+
+static void*
+stream_scaler(void* vp){
+  auto p = static_cast<streampipe*>(vp);
+  framepool* fp = &p->ncv->details.pool;
+  swscache sc{};
+  streamframe sf;
+  while(framequeue_pop(p, &p->decoded, &sf)){
+    const bool last = sf.err != NCERR_SUCCESS;
+    if(sf.frame){
+      // don't bother scaling a frame which won't be shown
+      if(!p->keepall.load() && stream_overtaken(&p->decoded)){
+        av_frame_free(&sf.frame);
+      }else{
+        const uint64_t start = stream_nowns();
+        sf.scaled = stream_scale(fp, &sc, sf.frame, p->rows.load(),
+                                 p->cols.load(), p->fmt.load(), p->quality);
+        sf.scalens = stream_nowns() - start;
+      }
+    }
+    if(!framequeue_push(p, &p->scaled, &sf)){
+      streamframe_free(fp, &sf);
+      break;
+    }
+    if(last){
+      break;
+    }
+  }
+  sws_freeContext(sc.ctx);
+  return nullptr;
+}
+
+static int
+stream_start(streampipe* p){
+  if(framequeue_init(&p->decoded)){
+    return -1;
+  }
+  if(framequeue_init(&p->scaled)){
+    framequeue_destroy(p, &p->decoded);
+    return -1;
+  }
+  // signals (e.g. SIGWINCH) must be delivered to the application's threads
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  int ret = -1;
+  if(pthread_create(&p->decoder, nullptr, stream_decoder, p) == 0){
+    if(pthread_create(&p->scaler, nullptr, stream_scaler, p) == 0){
+      ret = 0;
+    }else{
+      p->stop = true;
+      sem_post(&p->decoded.spaces);
+      pthread_join(p->decoder, nullptr);
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+  if(ret){
+    framequeue_destroy(p, &p->scaled);
+    framequeue_destroy(p, &p->decoded);
+  }else{
+    p->running = true;
+  }
+  return ret;
+}
+
+static void
+stream_stop(streampipe* p){
+  if(!p->running){
+    return;
+  }
+  p->running = false;
+  p->stop = true;
+  // wake each stage, wherever it might be waiting
+  sem_post(&p->decoded.items);
+  sem_post(&p->decoded.spaces);
+  sem_post(&p->scaled.items);
+  sem_post(&p->scaled.spaces);
+  pthread_join(p->scaler, nullptr);
+  pthread_join(p->decoder, nullptr);
+  framequeue_destroy(p, &p->scaled);
+  framequeue_destroy(p, &p->decoded);
+}
+
+// take frames from the pipeline until one ought be shown, and make it the
+// current frame, along with its schedule. returns the error ending the
+// stream, if that's what we got instead.
+static nc_err_e
+stream_next(notcurses* nc, streampipe* p, uint64_t* schedns, uint64_t* offsetns){
+  ncvisual* ncv = p->ncv;
+  while(true){
+    streamframe sf{};
+    // the pipeline is being torn down beneath us; nothing more will come
+    if(!framequeue_pop(p, &p->scaled, &sf)){
+      return NCERR_EOF;
+    }
+    if(sf.err != NCERR_SUCCESS){
+      return sf.err;
+    }
+    ++nc->stats.frames_decoded;
+    nc->stats.decode_ns += sf.decodens;
+    nc->stats.scale_ns += sf.scalens;
+    // subtitles persist across frames, even those we don't show
+    if(sf.subtitled){
+      avsubtitle_free(&ncv->details.subtitle);
+      ncv->details.subtitle = sf.subtitle;
+      sf.subtitled = false;
+    }
+    if(sf.frame == nullptr || (!p->keepall.load() && stream_overtaken(&p->scaled))){
+      ++nc->stats.frames_dropped;
+      streamframe_free(&ncv->details.pool, &sf);
+      continue;
+    }
+    if(ncv->details.oframe){
+      av_freep(&ncv->details.oframe->data[0]);
+    }
+    av_frame_free(&ncv->details.frame);
+    ncv->details.frame = sf.frame;
+    ncvisual_frame_decoded(ncv);
+    ncv->details.sframe = sf.scaled;
+    *schedns = sf.schedns;
+    *offsetns = sf.offsetns;
+    return NCERR_SUCCESS;
+  }
+}
+
+// the streamer called ncvisual_seek(). stop the pipeline, seek, and start it
+// anew from the frame sought, which is due immediately. the decoder has read
+// ahead of the frame shown, so the demuxer is always repositioned.
+static nc_err_e
+stream_seek(streampipe* p, uint64_t* schedns, uint64_t* offsetns){
+  ncvisual* ncv = p->ncv;
+  ncv->details.seekpending = false;
+  stream_stop(p);
+  nc_err_e err = ncvisual_seek_now(ncv, ncv->details.seekns, true);
+  if(err != NCERR_SUCCESS){
+    return err;
+  }
+  const AVFrame* f = ncv->details.frame;
+  if(p->usets){
+    *offsetns = f->best_effort_timestamp * p->tbase * NANOSECS_IN_SEC;
+  }else{
+    p->sum_duration = ncv->details.seekns;
+    *offsetns = p->sum_duration;
+  }
+  *schedns = stream_nowns();
+  p->nsbegin = *schedns - *offsetns * static_cast<double>(p->timescale);
+  p->stop = false;
+  if(stream_start(p)){
+    return NCERR_NOMEM;
+  }
+  return NCERR_SUCCESS;
+}
+
+// a still image from the cache is its own single frame, shown immediately
+static int
+stream_still(notcurses* nc, ncvisual* ncv, streamcb streamer,
+             const struct ncvisual_options* vopts, void* curry) {
+  ncvisual_options activevopts;
+  memcpy(&activevopts, vopts, sizeof(*vopts));
+  if((activevopts.n = ncvisual_render(nc, ncv, vopts)) == nullptr){
+    return -1;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int ret;
+  if(streamer){
+    ret = streamer(ncv, &activevopts, &now, curry);
+  }else{
+    ret = ncvisual_simple_streamer(ncv, &activevopts, &now, curry);
+  }
+  if(activevopts.n != vopts->n){
+    ncplane_destroy(activevopts.n);
+  }
+  return ret;
+}
+
+// iterate over the decoded frames, calling streamer() with curry for each.
 int ncvisual_stream(notcurses* nc, ncvisual* ncv, nc_err_e* ncerr,
                     float timescale, streamcb streamer,
                     const struct ncvisual_options* vopts, void* curry) {
   *ncerr = NCERR_SUCCESS;
-  int frame = 1;
-  struct timespec begin; // time we started
-  clock_gettime(CLOCK_MONOTONIC, &begin);
-  uint64_t nsbegin = timespec_to_ns(&begin);
-  bool usets = false;
-  // each frame has a pkt_duration in milliseconds. keep the aggregate, in case
-  // we don't have PTS available.
-  uint64_t sum_duration = 0;
-  ncplane* newn = NULL;
+  ncv->tier = 0;
+  if(ncv->details.fmtctx == nullptr){ // not a file-backed ncvisual
+    if(ncv->cached){
+      return stream_still(nc, ncv, streamer, vopts, curry);
+    }
+    *ncerr = NCERR_DECODE;
+    return -1;
+  }
+  // a recording is made from the first frame, on a plane of our caller's
+  ncanim* anim = vopts->n ? ncv->anim : nullptr;
+  if(anim){
+    const ncanim_e state = ncanim_lookup(anim, vopts);
+    if(state == NCANIM_COMPLETE){
+      return ncvisual_replay(ncv, ncerr, timescale, streamer, vopts, curry);
+    }
+    if(state == NCANIM_ABANDONED ||
+       (ncv->details.framenum != 1 && ncvisual_rewind(ncv) != NCERR_SUCCESS)){
+      anim = nullptr;
+    }else{
+      ncanim_begin(anim, vopts);
+    }
+  }
+  // adapting requires a plane which stays put, and a recording is of the
+  // options as provided. if we can't adapt, we play as provided.
+  ncadapt* adapt = nullptr;
+  if((vopts->flags & NCVISUAL_OPTION_ADAPTIVE) && vopts->n &&
+     vopts->scaling != NCSCALE_NONE && anim == nullptr){
+    adapt = ncadapt_create(nc, vopts);
+  }
+  streampipe p{};
+  p.ncv = ncv;
+  ncv->details.streaming = true;
+  p.nsbegin = stream_nowns();
+  // codecctx seems to be off by a factor of 2 regularly. instead, go with
+  // the time_base from the avformatctx.
+  p.tbase = av_q2d(ncv->details.fmtctx->streams[ncv->details.stream_index]->time_base);
+  p.timescale = timescale;
+  p.usets = ncv->details.frame->best_effort_timestamp != 0;
+  p.quality = vopts ? vopts->quality : NCSCALEQ_DEFAULT;
+  p.keepall = anim != nullptr;
+  // the first frame was decoded before we got here
+  uint64_t offsetns;
+  uint64_t schedns = stream_schedule(&p, ncv->details.frame, &offsetns);
+  if(stream_start(&p)){
+    if(anim){
+      ncanim_cancel(anim);
+    }
+    ncv->details.streaming = false;
+    ncadapt_destroy(adapt);
+    *ncerr = NCERR_NOMEM;
+    return -1;
+  }
   ncvisual_options activevopts;
   memcpy(&activevopts, vopts, sizeof(*vopts));
+  int ret = 0;
+  uint64_t prevschedns = 0;
+  uint64_t dropped = nc->stats.frames_dropped;
   do{
-    // codecctx seems to be off by a factor of 2 regularly. instead, go with
-    // the time_base from the avformatctx.
-    double tbase = av_q2d(ncv->details.fmtctx->streams[ncv->details.stream_index]->time_base);
-    int64_t ts = ncv->details.frame->best_effort_timestamp;
-    if(frame == 1 && ts){
-      usets = true;
-    }
-    if((newn = ncvisual_render(nc, ncv, &activevopts)) == NULL){
-      if(activevopts.n != vopts->n){
-        ncplane_destroy(activevopts.n);
-      }
-      return -1;
+    const uint64_t blitstart = stream_nowns();
+    ncplane* newn = ncvisual_render(nc, ncv, &activevopts);
+    if(newn == nullptr){
+      ret = -1;
+      break;
     }
-    if(activevopts.n != newn){
-      activevopts.n = newn;
+    const uint64_t blitns = stream_nowns() - blitstart;
+    nc->stats.blit_ns += blitns;
+    activevopts.n = newn;
+    // a recording grown too large is abandoned, and we carry on decoding
+    if(anim && ncanim_record(anim, newn, ncv->placey, ncv->placex,
+                             ncv->disprows, ncv->dispcols, offsetns)){
+      anim = nullptr;
+      p.keepall = false;
     }
-    ++frame;
-    uint64_t duration = ncv->details.frame->pkt_duration * tbase * NANOSECS_IN_SEC;
-//fprintf(stderr, "use: %u dur: %ju ts: %ju cctx: %f fctx: %f\n", usets, duration, ts, av_q2d(ncv->details.codecctx->time_base), av_q2d(ncv->details.fmtctx->streams[ncv->stream_index]->time_base));
-    double schedns = nsbegin;
-    if(usets){
-      if(tbase == 0){
-        tbase = duration;
-      }
-      schedns += ts * (tbase * timescale) * NANOSECS_IN_SEC;
-    }else{
-      sum_duration += (duration * timescale);
-      schedns += sum_duration;
+    // have the scaler prepare subsequent frames at this size
+    p.rows = ncv->details.blitrows;
+    p.cols = ncv->details.blitcols;
+    p.fmt = ncv->details.blitfmt;
+    const bool late = stream_nowns() > schedns;
+    if(late){
+      ++nc->stats.frames_late;
     }
     struct timespec abstime;
     ns_to_timespec(schedns, &abstime);
-    int r;
+    // the render (if the streamer does one) is part of a frame's cost
+    const uint64_t renderns = nc->stats.render_ns;
+    const uint64_t renderbytes = nc->stats.render_bytes;
     if(streamer){
-      r = streamer(ncv, &activevopts, &abstime, curry);
+      ret = streamer(ncv, &activevopts, &abstime, curry);
     }else{
-      r = ncvisual_simple_streamer(ncv, &activevopts, &abstime, curry);
+      ret = ncvisual_simple_streamer(ncv, &activevopts, &abstime, curry);
     }
-    if(r){
-      if(activevopts.n != vopts->n){
-        ncplane_destroy(activevopts.n);
+    if(adapt && ret == 0){
+      const bool dropping = nc->stats.frames_dropped != dropped;
+      dropped = nc->stats.frames_dropped;
+      ncv->tier = ncadapt_frame(adapt, blitns, nc->stats.render_bytes - renderbytes,
+                                nc->stats.render_ns - renderns,
+                                prevschedns && schedns > prevschedns ? schedns - prevschedns : 0,
+                                late || dropping);
+      ncadapt_apply(adapt, &activevopts);
+    }
+    prevschedns = schedns;
+    if(ret == 0 && ncv->details.seekpending){
+      // a recording is of the stream played through from its beginning
+      if(anim){
+        ncanim_cancel(anim);
+        anim = nullptr;
+        p.keepall = false;
       }
-      return r;
+      *ncerr = stream_seek(&p, &schedns, &offsetns);
+      prevschedns = 0; // the schedule has been rebased
+    }else if(ret == 0){
+      *ncerr = stream_next(nc, &p, &schedns, &offsetns);
     }
-  }while((*ncerr = ncvisual_decode(ncv)) == NCERR_SUCCESS);
+  }while(ret == 0 && *ncerr == NCERR_SUCCESS);
+  stream_stop(&p);
+  ncadapt_destroy(adapt);
+  ncv->details.streaming = false;
+  ncv->details.seekpending = false;
+  framepool_put(&ncv->details.pool, ncv->details.sframe);
+  ncv->details.sframe = nullptr;
   if(activevopts.n != vopts->n){
     ncplane_destroy(activevopts.n);
   }
+  // only a stream played through to its end is a complete recording
+  if(anim){
+    if(ret == 0 && *ncerr == NCERR_EOF){
+      ncanim_finish(anim);
+    }else{
+      ncanim_cancel(anim);
+    }
+  }
+  if(ret){
+    return ret;
+  }
   if(*ncerr == NCERR_EOF){
     return 0;
   }
   return -1;
 }
 
+// one band of a parallel blit, which scales only the rows it blits
+struct bandscale {
+  blitbands* bb;
+  ncvisual* ncv;
+  const AVFrame* inframe;
+  uint8_t* data;          // the scaled RGBA frame, 'rows' x 'cols'
+  int linesize;
+  int rows, cols;
+  ncscalequality_e quality;
+};
+
+static auto
+bandscale_job(void* vjob, int band) -> int {
+  auto job = static_cast<bandscale*>(vjob);
+  const AVFrame* in = job->inframe;
+  const auto fmt = static_cast<AVPixelFormat>(in->format);
+  const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(fmt);
+  if(desc == nullptr){
+    return -1;
+  }
+  int by, bl;
+  blitbands_extent(job->bb, band, &by, &bl);
+  if(bl > job->rows - by){
+    bl = job->rows - by;
+  }
+  if(bl <= 0){
+    return -1;
+  }
+  if(scale_boxable(in, job->quality)){
+    if(rgba_scale_box(in->data[0], in->height, in->linesize[0], in->width,
+                      job->data, job->rows, job->linesize, job->cols, by, bl)){
+      return -1;
+    }
+    return blitbands_blit(job->bb, band, job->linesize, job->data);
+  }
+  // the source rows covering our output rows, aligned to the chroma planes.
+  // each band is scaled independently, so there can be faint seams.
+  const int chromay = 1 << desc->log2_chroma_h;
+  int sy = static_cast<int64_t>(by) * in->height / job->rows;
+  int send = (static_cast<int64_t>(by + bl) * in->height + job->rows - 1) / job->rows;
+  sy -= sy % chromay;
+  send = (send + chromay - 1) / chromay * chromay;
+  if(send > in->height){
+    send = in->height;
+  }
+  SwsContext* ctx = swscache_get(&job->ncv->details.pool,
+                                 &job->ncv->details.bandsws[band], in->width,
+                                 send - sy, fmt, job->cols, bl, AV_PIX_FMT_RGBA,
+                                 scale_swsflags(job->quality));
+  if(ctx == nullptr){
+    return -1;
+  }
+  const uint8_t* src[AV_NUM_DATA_POINTERS];
+  for(int p = 0 ; p < AV_NUM_DATA_POINTERS ; ++p){
+    src[p] = in->data[p];
+    // a palette is not a plane of rows
+    if(src[p] && !(p == 1 && (desc->flags & AV_PIX_FMT_FLAG_PAL))){
+      const int shift = (p == 1 || p == 2) ? desc->log2_chroma_h : 0;
+      src[p] += static_cast<ptrdiff_t>(sy >> shift) * in->linesize[p];
+    }
+  }
+  uint8_t* dst[4] = { job->data + static_cast<ptrdiff_t>(by) * job->linesize, };
+  const int dstlinesize[4] = { job->linesize, };
+  if(sws_scale(ctx, src, in->linesize, 0, send - sy, dst, dstlinesize) < 0){
+    return -1;
+  }
+  return blitbands_blit(job->bb, band, job->linesize, job->data);
+}
+
+// scale and blit 'inframe' in bands spread across the workerpool
+static auto
+ncvisual_blit_bands(ncvisual* ncv, const AVFrame* inframe, int rows, int cols,
+                    ncplane* n, const struct blitset* bset, int placey,
+                    int placex, int begy, int begx, int leny, int lenx,
+                    bool blendcolors, ncscalequality_e quality) -> nc_err_e {
+  blitbands bb;
+  // a few bands per thread, so that one slow band doesn't idle the rest
+  if(blitbands_init(&bb, n, bset, placey, placex, begy, begx, leny, lenx,
+                    blendcolors, workerpool_threads(n->nc) * 4)){
+    return NCERR_DECODE;
+  }
+  if(ncv->details.bandswscount < bb.count){
+    auto tmp = static_cast<swscache*>(realloc(ncv->details.bandsws,
+                                              sizeof(swscache) * bb.count));
+    if(tmp == nullptr){
+      blitbands_finish(&bb, true);
+      return NCERR_NOMEM;
+    }
+    memset(tmp + ncv->details.bandswscount, 0,
+           sizeof(*tmp) * (bb.count - ncv->details.bandswscount));
+    ncv->details.bandswscount = bb.count;
+    ncv->details.bandsws = tmp;
+  }
+  AVFrame* scaled = framepool_get(&ncv->details.pool, rows, cols, AV_PIX_FMT_RGBA);
+  if(scaled == nullptr){
+    blitbands_finish(&bb, true);
+    return NCERR_NOMEM;
+  }
+  bandscale job;
+  job.bb = &bb;
+  job.ncv = ncv;
+  job.inframe = inframe;
+  job.data = scaled->data[0];
+  job.linesize = scaled->linesize[0];
+  job.rows = rows;
+  job.cols = cols;
+  job.quality = quality;
+  const bool failed = workerpool_run(n->nc, bb.count, bandscale_job, &job);
+  if(!failed && ncv->cached){
+    vcache_offer(ncv->cached, rows, cols, quality, scaled->data[0], scaled->linesize[0]);
+  }
+  framepool_put(&ncv->details.pool, scaled);
+  if(blitbands_finish(&bb, failed) <= 0){
+    return NCERR_DECODE;
+  }
+  return NCERR_SUCCESS;
+}
+
+// can the cell blitters consume frames of 'f's format directly?
+static bool
+native_format(const AVFrame* f, blitfmt_e* fmt){
+  switch(f->format){
+    case AV_PIX_FMT_YUV420P:
+      *fmt = f->color_range == AVCOL_RANGE_JPEG ? BLITFMT_YUVJ420P : BLITFMT_YUV420P;
+      return true;
+    case AV_PIX_FMT_YUVJ420P: *fmt = BLITFMT_YUVJ420P; return true;
+    case AV_PIX_FMT_RGB24: *fmt = BLITFMT_RGB24; return true;
+    case AV_PIX_FMT_BGR24: *fmt = BLITFMT_BGR24; return true;
+    case AV_PIX_FMT_GRAY8: *fmt = BLITFMT_GRAY8; return true;
+    case AV_PIX_FMT_BGR0: *fmt = BLITFMT_BGRX; return true;
+  }
+  return false;
+}
+
+// blit 'inframe' in its own pixel format, scaling it (but not converting it)
+// first if necessary. this skips the RGBA conversion of every frame.
+static auto
+ncvisual_blit_native(ncvisual* ncv, const AVFrame* inframe,
+                     const AVFrame* prescaled, blitfmt_e fmt, int rows,
+                     int cols, ncplane* n, const struct blitset* bset,
+                     int placey, int placex, int begy, int begx, int leny,
+                     int lenx, bool blendcolors,
+                     ncscalequality_e quality) -> nc_err_e {
+  const AVFrame* src = prescaled ? prescaled : inframe;
+  AVFrame* sframe = nullptr;
+  if(src->width != cols || src->height != rows){
+    SwsContext* swsctx = swscache_get(&ncv->details.pool, &ncv->details.sws,
+                                      inframe->width, inframe->height,
+                                      inframe->format, cols, rows,
+                                      inframe->format, scale_swsflags(quality));
+    if(swsctx == nullptr){
+      return NCERR_NOMEM;
+    }
+    if((sframe = framepool_get(&ncv->details.pool, rows, cols, inframe->format)) == nullptr){
+      return NCERR_NOMEM;
+    }
+    if(sws_scale(swsctx, (const uint8_t* const*)inframe->data, inframe->linesize,
+                 0, inframe->height, sframe->data, sframe->linesize) < 0){
+      framepool_put(&ncv->details.pool, sframe);
+      return NCERR_DECODE;
+    }
+    src = sframe;
+  }
+  blitsource bs;
+  bs.fmt = fmt;
+  for(int p = 0 ; p < 3 ; ++p){
+    bs.planes[p] = src->data[p];
+    bs.linesizes[p] = src->linesize[p];
+  }
+  const int r = native_blit(n, bset, placey, placex, &bs, begy, begx, leny,
+                            lenx, blendcolors);
+  framepool_put(&ncv->details.pool, sframe);
+  if(r < 0){
+    return NCERR_DECODE;
+  }
+  return NCERR_SUCCESS;
+}
+
 nc_err_e ncvisual_blit(ncvisual* ncv, int rows, int cols, ncplane* n,
                        const struct blitset* bset, int placey, int placex,
                        int begy, int begx, int leny, int lenx,
-                       bool blendcolors) {
+                       bool blendcolors, bool parallel,
+                       ncscalequality_e quality, blitdelta* delta) {
   const AVFrame* inframe = ncv->details.oframe ? ncv->details.oframe : ncv->details.frame;
   void* data = nullptr;
   int stride = 0;
   AVFrame* sframe = nullptr;
   const int targformat = AV_PIX_FMT_RGBA;
+  // banded scaling blits each band as it's scaled, and so can't compare
+  // against the previous frame
+  const bool bandable = parallel && !delta && blitset_bandable(bset) &&
+                        workerpool_threads(n->nc) > 1;
+  // the cell blitters can read some decoder formats without our converting
+  // them to RGBA. box filtering and the delta blitter want RGBA.
+  blitfmt_e nfmt = BLITFMT_BGRX;
+  const bool native = !bandable && !delta && blitset_bandable(bset) &&
+                      quality != NCSCALEQ_BOX && inframe &&
+                      native_format(inframe, &nfmt);
+  const int wantfmt = native ? inframe->format : targformat;
+  // ncvisual_stream() prepares frames at the geometry and format we last blitted
+  const AVFrame* prescaled = ncv->details.sframe;
+  if(prescaled && (prescaled->width != cols || prescaled->height != rows ||
+                   prescaled->format != wantfmt)){
+    prescaled = nullptr;
+  }
+  ncv->details.blitrows = rows;
+  ncv->details.blitcols = cols;
+  ncv->details.blitfmt = wantfmt;
+  framepool_fold(&ncv->details.pool, &n->nc->stats);
+  if(native){
+    return ncvisual_blit_native(ncv, inframe, prescaled, nfmt, rows, cols, n,
+                                bset, placey, placex, begy, begx, leny, lenx,
+                                blendcolors, quality);
+  }
+  if(!prescaled && bandable && inframe &&
+     (cols != inframe->width || rows != inframe->height || inframe->format != targformat)){
+    return ncvisual_blit_bands(ncv, inframe, rows, cols, n, bset, placey, placex,
+                               begy, begx, leny, lenx, blendcolors, quality);
+  }
 //fprintf(stderr, "got format: %d want format: %d\n", inframe->format, targformat);
-  if(inframe && (cols != inframe->width || rows != inframe->height || inframe->format != targformat)){
-//fprintf(stderr, "resize+render: %d/%d->%d/%d (%dX%d @ %dX%d, %d/%d)\n", inframe->height, inframe->width, rows, cols, begy, begx, placey, placex, leny, lenx);
-    sframe = av_frame_alloc();
-    if(sframe == nullptr){
-//fprintf(stderr, "Couldn't allocate output frame for scaled frame\n");
+  if(prescaled){
+    stride = prescaled->linesize[0];
+    data = prescaled->data[0];
+  }else if(inframe && scale_boxable(inframe, quality) &&
+           (cols != inframe->width || rows != inframe->height)){
+    if((sframe = framepool_get(&ncv->details.pool, rows, cols, targformat)) == nullptr){
       return NCERR_NOMEM;
     }
-    //fprintf(stderr, "WHN NCV: %d/%d\n", inframe->width, inframe->height);
-    ncv->details.swsctx = sws_getCachedContext(ncv->details.swsctx,
-                                               ncv->cols, ncv->rows,
-                                               static_cast<AVPixelFormat>(inframe->format),
-                                               cols, rows,
-                                               static_cast<AVPixelFormat>(targformat),
-                                               SWS_LANCZOS, nullptr, nullptr, nullptr);
-    if(ncv->details.swsctx == nullptr){
-//fprintf(stderr, "Error retrieving details.swsctx\n");
+    if(rgba_scale_box(inframe->data[0], inframe->height, inframe->linesize[0],
+                      inframe->width, sframe->data[0], rows, sframe->linesize[0],
+                      cols, 0, rows)){
+      framepool_put(&ncv->details.pool, sframe);
+      return NCERR_NOMEM;
+    }
+    stride = sframe->linesize[0];
+    data = sframe->data[0];
+  }else if(inframe && (cols != inframe->width || rows != inframe->height || inframe->format != targformat)){
+//fprintf(stderr, "resize+render: %d/%d->%d/%d (%dX%d @ %dX%d, %d/%d)\n", inframe->height, inframe->width, rows, cols, begy, begx, placey, placex, leny, lenx);
+    SwsContext* swsctx = swscache_get(&ncv->details.pool, &ncv->details.sws,
+                                      inframe->width, inframe->height,
+                                      inframe->format, cols, rows,
+                                      targformat, scale_swsflags(quality));
+    if(swsctx == nullptr){
+//fprintf(stderr, "Error retrieving details.sws\n");
       return NCERR_NOMEM;
     }
-    memcpy(sframe, inframe, sizeof(*inframe));
-    sframe->format = targformat;
-    sframe->width = cols;
-    sframe->height = rows;
-    int size = av_image_alloc(sframe->data, sframe->linesize,
-                              sframe->width, sframe->height,
-                              static_cast<AVPixelFormat>(sframe->format),
-                              IMGALLOCALIGN);
-    if(size < 0){
-//fprintf(stderr, "Error allocating visual data (%d X %d)\n", sframe->height, sframe->width);
+    // the output frames are recycled, being the same size frame after frame
+    if((sframe = framepool_get(&ncv->details.pool, rows, cols, targformat)) == nullptr){
+//fprintf(stderr, "Couldn't allocate output frame for scaled frame\n");
       return NCERR_NOMEM;
     }
-    int height = sws_scale(ncv->details.swsctx, (const uint8_t* const*)inframe->data,
+    int height = sws_scale(swsctx, (const uint8_t* const*)inframe->data,
                            inframe->linesize, 0, inframe->height, sframe->data,
                            sframe->linesize);
     if(height < 0){
 //fprintf(stderr, "Error applying scaling (%d X %d)\n", inframe->height, inframe->width);
+      framepool_put(&ncv->details.pool, sframe);
       return NCERR_DECODE;
     }
     stride = sframe->linesize[0]; // FIXME check for others?
@@ -446,17 +1622,14 @@ nc_err_e ncvisual_blit(ncvisual* ncv, int rows, int cols, ncplane* n,
     data = ncv->data;
   }
 //fprintf(stderr, "place: %d/%d rows/cols: %d/%d %d/%d+%d/%d\n", placey, placex, rows, cols, begy, begx, leny, lenx);
-  if(rgba_blit_dispatch(n, bset, placey, placex, stride, data, begy, begx,
-                        leny, lenx, blendcolors) <= 0){
-    if(sframe){
-      av_freep(sframe->data);
-      av_freep(&sframe);
-    }
-    return NCERR_DECODE;
+  if(sframe && ncv->cached){
+    vcache_offer(ncv->cached, rows, cols, quality, data, stride);
   }
-  if(sframe){
-    av_freep(sframe->data);
-    av_freep(&sframe);
+  const int r = rgba_blit_visual(n, bset, placey, placex, stride, data, begy,
+                                 begx, leny, lenx, blendcolors, parallel, delta);
+  framepool_put(&ncv->details.pool, sframe);
+  if(r < 0){
+    return NCERR_DECODE;
   }
   return NCERR_SUCCESS;
 }
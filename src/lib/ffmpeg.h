@@ -4,6 +4,8 @@
 #include "version.h"
 #ifdef USE_FFMPEG
 
+#include <pthread.h>
+
 extern "C" {
 
 #include "notcurses/ncerrs.h"
@@ -27,21 +29,71 @@ struct AVCodec;
 struct AVCodecParameters;
 struct AVPacket;
 
+// a scaling context, rebuilt only when its parameters change
+typedef struct swscache {
+  struct SwsContext* ctx;
+  int srcw, srch, srcfmt;
+  int dstw, dsth, dstfmt;
+  int flags;
+} swscache;
+
+// enough for ncvisual_stream()'s queues to be kept full
+#define FRAMEPOOL_MAX 10
+
+// scaled frames of a single geometry and format, recycled rather than freed. these
+// are shared with ncvisual_stream()'s scaler, so the lock covers the pool and
+// the reuse counts (which are moved to the ncstats by ncvisual_blit()).
+typedef struct framepool {
+  pthread_mutex_t lock;
+  struct AVFrame* frames[FRAMEPOOL_MAX];
+  int count;
+  int rows, cols;                      // geometry of the pooled frames
+  int format;                          // AVPixelFormat of the pooled frames
+  uint64_t hits, misses;               // frames reused / allocated
+  uint64_t swshits, swsmisses;         // scaling contexts reused / built
+} framepool;
+
+// input read through our own AVIOContext, from memory or a file descriptor
+typedef struct customio {
+  struct AVIOContext* ctx;
+  const unsigned char* data;           // the caller's buffer, or NULL
+  size_t len, pos;
+  int fd;                              // if 'data' is NULL
+} customio;
+
 typedef struct ncvisual_details {
   int packet_outstanding;
   struct AVFormatContext* fmtctx;
+  customio io;                         // if not opened from a file
   struct AVCodecContext* codecctx;     // video codec context
   struct AVCodecContext* subtcodecctx; // subtitle codec context
   struct AVFrame* frame;               // frame as read
   struct AVFrame* oframe;              // RGBA frame
+  struct AVFrame* sframe;              // frame scaled ahead by ncvisual_stream()
+  int blitrows, blitcols;              // geometry of the last ncvisual_blit()
+  int blitfmt;                         // format in which it wanted its frame
   struct AVCodec* codec;
   struct AVCodecParameters* cparams;
   struct AVCodec* subtcodec;
   struct AVPacket* packet;
-  struct SwsContext* swsctx;
+  swscache sws;                        // for ncvisual_blit() and ncvisual_resize()
+  swscache* bandsws;                   // per-band contexts for parallel blits
+  int bandswscount;
+  framepool pool;
   AVSubtitle subtitle;
   int stream_index;        // match against this following av_read_frame()
   int sub_stream_index;    // subtitle stream index, can be < 0 if no subtitles
+  bool draining;           // the input is exhausted; emptying the codec
+  uint64_t framenum;       // frames made current since opening or rewinding
+  // timestamps of the keyframes read so far, ascending, for ncvisual_seek()
+  int64_t* keyframes;
+  int keyframecount, keyframesize;
+  // the latest timestamp demuxed since opening or seeking. keyframes between
+  // the current frame and this point are all in the index.
+  int64_t readts;
+  bool streaming;          // within ncvisual_stream(), which must do any seek
+  bool seekpending;        // ncvisual_seek() was called from its streamer
+  uint64_t seekns;         // ...to this offset
 } ncvisual_details;
 
 static inline auto
@@ -49,7 +101,13 @@ ncvisual_details_init(ncvisual_details* deets) -> nc_err_e {
   memset(deets, 0, sizeof(*deets));
   deets->stream_index = -1;
   deets->sub_stream_index = -1;
+  deets->blitfmt = AV_PIX_FMT_RGBA;
+  deets->readts = AV_NOPTS_VALUE;
+  if(pthread_mutex_init(&deets->pool.lock, nullptr)){
+    return NCERR_NOMEM;
+  }
   if((deets->frame = av_frame_alloc()) == nullptr){
+    pthread_mutex_destroy(&deets->pool.lock);
     return NCERR_NOMEM;
   }
   return NCERR_SUCCESS;
@@ -61,11 +119,26 @@ ncvisual_details_destroy(ncvisual_details* deets) -> void {
   avcodec_free_context(&deets->codecctx);
   av_frame_free(&deets->frame);
   av_freep(&deets->oframe);
+  av_frame_free(&deets->sframe);
   //avcodec_parameters_free(&ncv->cparams);
-  sws_freeContext(deets->swsctx);
+  sws_freeContext(deets->sws.ctx);
+  for(int i = 0 ; i < deets->bandswscount ; ++i){
+    sws_freeContext(deets->bandsws[i].ctx);
+  }
+  free(deets->bandsws);
+  for(int i = 0 ; i < deets->pool.count ; ++i){
+    av_frame_free(&deets->pool.frames[i]);
+  }
+  pthread_mutex_destroy(&deets->pool.lock);
   av_packet_free(&deets->packet);
   avformat_close_input(&deets->fmtctx);
+  // a custom AVIOContext outlives its AVFormatContext, and is ours to free
+  if(deets->io.ctx){
+    av_freep(&deets->io.ctx->buffer);
+    avio_context_free(&deets->io.ctx);
+  }
   avsubtitle_free(&deets->subtitle);
+  free(deets->keyframes);
 }
 
 #endif
@@ -1,16 +1,27 @@
 #include "internal.h"
 
+// the grey of the 24-bit 'rgb', replicated across all three components
+static inline uint64_t
+grey_rgb(uint64_t rgb){
+  const unsigned gy = rgb_greyscale((rgb >> 16u) & 0xffu, (rgb >> 8u) & 0xffu,
+                                    rgb & 0xffu);
+  return gy * 0x010101ull;
+}
+
 void ncplane_greyscale(ncplane *n){
+  // both channels are marked as not using the default color, as per
+  // cell_set_fg_rgb() and cell_set_bg_rgb()
+  const uint64_t keep = ~(CELL_FG_MASK | CELL_BG_MASK);
+  const uint64_t set = CELL_FGDEFAULT_MASK | CELL_BGDEFAULT_MASK;
   for(int y = 0 ; y < n->leny ; ++y){
+    cell* row = ncplane_cell_ref_yx(n, y, 0);
+    if(row == NULL){
+      return;
+    }
     for(int x = 0 ; x < n->lenx ; ++x){
-      cell* c = &n->fb[nfbcellidx(n, y, x)];
-      unsigned r, g, b;
-      cell_fg_rgb(c, &r, &g, &b);
-      int gy = rgb_greyscale(r, g, b);
-      cell_set_fg_rgb(c, gy, gy, gy);
-      cell_bg_rgb(c, &r, &g, &b);
-      gy = rgb_greyscale(r, g, b);
-      cell_set_bg_rgb(c, gy, gy, gy);
+      const uint64_t channels = row[x].channels;
+      row[x].channels = (channels & keep) | set |
+                        (grey_rgb(channels >> 32u) << 32u) | grey_rgb(channels);
     }
   }
 }
@@ -27,10 +38,13 @@ ncplane_polyfill_recurse(ncplane* n, int y, int x, const cell* c){
   if(y < 0 || x < 0){
     return 0; // not fillable
   }
-  cell* cur = &n->fb[nfbcellidx(n, y, x)];
-  if(cur->gcluster){
+  if(ncplane_cell_const(n, y, x)->gcluster){
     return 0; // glyph, not polyfillable
   }
+  cell* cur = ncplane_cell_ref_yx(n, y, x);
+  if(cur == NULL){
+    return -1;
+  }
   if(cell_duplicate(n, cur, c) < 0){
     return -1;
   }
@@ -108,19 +122,160 @@ check_gradient_args(uint64_t ul, uint64_t ur, uint64_t bl, uint64_t br){
   return false;
 }
 
-// calculate both channels of a gradient at a particular point, knowing that
-// we're using double halfblocks, into `c`->channels.
+// Steps one color component of a gradient across a row, yielding at each
+// column exactly what calc_gradient_component() would. Its numerator is linear
+// in the column, so rather than dividing at each cell, we carry the quotient
+// and remainder along. that carry runs from each column into the next, so
+// the rows are stepped serially, in scalar code.
+typedef struct gradstep {
+  int q, r;         // value at the current column, and remainder (< d)
+  int qstep, rstep; // quotient and (nonnegative) remainder of the slope
+  int d;
+} gradstep;
+
+static void
+gradstep_init(gradstep* g, int tl, int tr, int bl, int br,
+              int y, int ylen, int xlen){
+  if(xlen < 2){ // a single column
+    g->q = calc_gradient_component(tl, tr, bl, br, y, 0, ylen, xlen);
+    g->r = g->qstep = g->rstep = 0;
+    g->d = 1;
+    return;
+  }
+  int num, slope;
+  if(ylen < 2){
+    g->d = xlen - 1;
+    num = tl * (xlen - 1);
+    slope = tr - tl;
+  }else{
+    const int avm = (ylen - 1) - y;
+    const int left = avm * tl + y * bl;
+    const int right = avm * tr + y * br;
+    g->d = (ylen - 1) * (xlen - 1);
+    num = left * (xlen - 1) + g->d / 2; // rounded
+    slope = right - left;
+  }
+  g->q = num / g->d;
+  g->r = num % g->d;
+  g->qstep = slope / g->d;
+  g->rstep = slope % g->d;
+  if(g->rstep < 0){
+    g->rstep += g->d;
+    --g->qstep;
+  }
+}
+
 static inline void
-calc_highgradient(cell* c, uint64_t ul, uint64_t ur, uint64_t ll,
-                  uint64_t lr, int y, int x, int ylen, int xlen){
-  if(!channel_default_p(ul)){
-    cell_set_fchannel(c, calc_gradient_channel(ul, ur, ll, lr,
-                                               y * 2, x, ylen, xlen));
-    cell_set_bchannel(c, calc_gradient_channel(ul, ur, ll, lr,
-                                               y * 2 + 1, x, ylen, xlen));
+gradstep_next(gradstep* g){
+  g->q += g->qstep;
+  g->r += g->rstep;
+  if(g->r >= g->d){
+    g->r -= g->d;
+    ++g->q;
+  }
+}
+
+// Steps a 32-bit channel of a gradient across a row, as calc_gradient_channel()
+// would compute it. The components are packed atop the fixed bits.
+typedef struct gradchan {
+  gradstep comp[3];   // red, green, and blue
+  uint32_t base;      // alpha, and the not-default bit
+} gradchan;
+
+static void
+gradchan_init(gradchan* gc, uint32_t ul, uint32_t ur, uint32_t ll, uint32_t lr,
+              int y, int ylen, int xlen){
+  gradstep_init(&gc->comp[0], channel_r(ul), channel_r(ur), channel_r(ll),
+                channel_r(lr), y, ylen, xlen);
+  gradstep_init(&gc->comp[1], channel_g(ul), channel_g(ur), channel_g(ll),
+                channel_g(lr), y, ylen, xlen);
+  gradstep_init(&gc->comp[2], channel_b(ul), channel_b(ur), channel_b(ll),
+                channel_b(lr), y, ylen, xlen);
+  gc->base = 0;
+  channel_set_rgb(&gc->base, 0, 0, 0);
+  channel_set_alpha(&gc->base, channel_alpha(ul)); // precondition: all αs are equal
+}
+
+// the channel at the current column, advancing to the next
+static inline uint32_t
+gradchan_next(gradchan* gc){
+  const uint32_t chan = gc->base | (gc->comp[0].q << 16u) |
+                        (gc->comp[1].q << 8u) | gc->comp[2].q;
+  gradstep_next(&gc->comp[0]);
+  gradstep_next(&gc->comp[1]);
+  gradstep_next(&gc->comp[2]);
+  return chan;
+}
+
+// an EGC to be loaded into many cells, parsed only once
+typedef struct fillegc {
+  const char* egc;
+  int bytes;
+  bool wide;
+} fillegc;
+
+static int
+fillegc_init(fillegc* f, const char* egc){
+  int cols;
+  if((f->bytes = utf8_egc_len(egc, &cols)) < 0){
+    return -1;
+  }
+  f->egc = egc;
+  f->wide = f->bytes > 1 && cols > 1;
+  return 0;
+}
+
+// cell_load() for a parsed EGC, excepting the wide bit, which the callers
+// set along with the channels
+static inline int
+fillegc_load(ncplane* n, cell* c, const fillegc* f){
+  if(f->bytes <= 1){
+    cell_release(n, c);
+    c->gcluster = *f->egc;
+    return 0;
+  }
+  if(!cell_simple_p(c)){
+    if(strcmp(f->egc, cell_extended_gcluster(n, c)) == 0){
+      return 0; // reduce, reuse, recycle
+    }
+    cell_release(n, c);
+  }
+  int eoffset = egcpool_stash(&n->pool, f->egc, f->bytes);
+  if(eoffset < 0){
+    return -1;
+  }
+  c->gcluster = eoffset + 0x80;
+  return 0;
+}
+
+// prepare to step both channels of a gradient across row 'y'. default
+// channels (which must be default at all four corners) are left alone.
+static void
+gradient_row(gradchan* fg, gradchan* bg, uint64_t ul, uint64_t ur,
+             uint64_t bl, uint64_t br, int y, int ylen, int xlen){
+  if(!channels_fg_default_p(ul)){
+    gradchan_init(fg, channels_fchannel(ul), channels_fchannel(ur),
+                  channels_fchannel(bl), channels_fchannel(br), y, ylen, xlen);
+  }
+  if(!channels_bg_default_p(ul)){
+    gradchan_init(bg, channels_bchannel(ul), channels_bchannel(ur),
+                  channels_bchannel(bl), channels_bchannel(br), y, ylen, xlen);
+  }
+}
+
+// set both channels at the current column into 'channels', as per
+// calc_gradient_channels(), advancing to the next
+static inline void
+gradient_next(gradchan* fg, gradchan* bg, uint64_t ul, uint64_t* channels){
+  if(!channels_fg_default_p(ul)){
+    channels_set_fchannel(channels, gradchan_next(fg));
+  }else{
+    channels_set_fg_default(channels);
+  }
+  if(!channels_bg_default_p(ul)){
+    channels_set_bchannel(channels, gradchan_next(bg));
   }else{
-    cell_set_fg_default(c);
-    cell_set_bg_default(c);
+    channels_set_bg_default(channels);
   }
 }
 
@@ -153,17 +308,40 @@ int ncplane_highgradient(ncplane* n, uint32_t ul, uint32_t ur,
       return -1;
     }
   }
+  fillegc upper;
+  if(fillegc_init(&upper, "▀")){
+    return -1;
+  }
+  // we're using double halfblocks: the foreground is the upper row of each
+  // cell, and the background the lower
+  const bool defaults = channel_default_p(ul);
+  uint64_t defchannels = 0;
+  channels_set_fg_default(&defchannels);
+  channels_set_bg_default(&defchannels);
   int total = 0;
   for(int y = yoff ; y <= ystop ; ++y){
-    for(int x = xoff ; x <= xstop ; ++x){
-      cell* targc = ncplane_cell_ref_yx(n, y, x);
-      targc->channels = 0;
-      if(cell_load(n, targc, "▀") < 0){
+    cell* row = ncplane_cell_ref_yx(n, y, xoff);
+    if(row == NULL){
+      return -1;
+    }
+    gradchan top, bot;
+    if(!defaults){
+      gradchan_init(&top, ul, ur, ll, lr, (y - yoff) * 2, ylen, xlen);
+      gradchan_init(&bot, ul, ur, ll, lr, (y - yoff) * 2 + 1, ylen, xlen);
+    }
+    for(int x = 0 ; x < xlen ; ++x){
+      cell* targc = &row[x];
+      if(fillegc_load(n, targc, &upper) < 0){
         return -1;
       }
-      calc_highgradient(targc, ul, ur, ll, lr, y - yoff, x - xoff, ylen, xlen);
-      ++total;
+      if(defaults){
+        targc->channels = defchannels;
+      }else{
+        const uint32_t fchan = gradchan_next(&top);
+        targc->channels = channels_combine(fchan, gradchan_next(&bot));
+      }
     }
+    total += xlen;
   }
   return total;
 }
@@ -208,19 +386,29 @@ int ncplane_gradient(ncplane* n, const char* egc, uint32_t attrword,
       return -1;
     }
   }
+  fillegc f;
+  if(fillegc_init(&f, egc)){
+    return -1;
+  }
+  const uint64_t base = f.wide ? CELL_WIDEASIAN_MASK : 0;
   int total = 0;
   for(int y = yoff ; y <= ystop ; ++y){
-    for(int x = xoff ; x <= xstop ; ++x){
-      cell* targc = ncplane_cell_ref_yx(n, y, x);
-      targc->channels = 0;
-      if(cell_load(n, targc, egc) < 0){
+    cell* row = ncplane_cell_ref_yx(n, y, xoff);
+    if(row == NULL){
+      return -1;
+    }
+    gradchan fg, bg;
+    gradient_row(&fg, &bg, ul, ur, bl, br, y - yoff, ylen, xlen);
+    for(int x = 0 ; x < xlen ; ++x){
+      cell* targc = &row[x];
+      if(fillegc_load(n, targc, &f) < 0){
         return -1;
       }
       targc->attrword = attrword;
-      calc_gradient_channels(&targc->channels, ul, ur, bl, br,
-                             y - yoff, x - xoff, ylen, xlen);
-      ++total;
+      targc->channels = base;
+      gradient_next(&fg, &bg, ul, &targc->channels);
     }
+    total += xlen;
   }
   return total;
 }
@@ -249,12 +437,16 @@ int ncplane_stain(struct ncplane* n, int ystop, int xstop,
   const int ylen = ystop - yoff + 1;
   int total = 0;
   for(int y = yoff ; y <= ystop ; ++y){
-    for(int x = xoff ; x <= xstop ; ++x){
-      cell* targc = ncplane_cell_ref_yx(n, y, x);
-      calc_gradient_channels(&targc->channels, tl, tr, bl, br,
-                             y - yoff, x - xoff, ylen, xlen);
-      ++total;
+    cell* row = ncplane_cell_ref_yx(n, y, xoff);
+    if(row == NULL){
+      return -1;
+    }
+    gradchan fg, bg;
+    gradient_row(&fg, &bg, tl, tr, bl, br, y - yoff, ylen, xlen);
+    for(int x = 0 ; x < xlen ; ++x){
+      gradient_next(&fg, &bg, tl, &row[x].channels);
     }
+    total += xlen;
   }
   return total;
 }
@@ -274,13 +466,17 @@ int ncplane_format(struct ncplane* n, int ystop, int xstop, uint32_t attrword){
   if(xstop >= xmax || ystop >= ymax){
     return -1;
   }
+  const int xlen = xstop - xoff + 1;
   int total = 0;
   for(int y = yoff ; y < ystop + 1 ; ++y){
-    for(int x = xoff ; x < xstop + 1 ; ++x){
-      cell* targc = ncplane_cell_ref_yx(n, y, x);
-      targc->attrword = attrword;
-      ++total;
+    cell* row = ncplane_cell_ref_yx(n, y, xoff);
+    if(row == NULL){
+      return -1;
+    }
+    for(int x = 0 ; x < xlen ; ++x){
+      row[x].attrword = attrword;
     }
+    total += xlen;
   }
   return total;
 }
@@ -288,7 +484,7 @@ int ncplane_format(struct ncplane* n, int ystop, int xstop, uint32_t attrword){
 // if we're a lower block, reverse the channels. if we're a space, set both to
 // the background. if we're a full block, set both to the foreground.
 static void
-rotate_channels(ncplane* src, const cell* c, uint32_t* fchan, uint32_t* bchan){
+rotate_channels(const ncplane* src, const cell* c, uint32_t* fchan, uint32_t* bchan){
   if(cell_simple_p(c)){
     if(!isgraph(c->gcluster)){
       *fchan = *bchan;
@@ -307,18 +503,18 @@ rotate_channels(ncplane* src, const cell* c, uint32_t* fchan, uint32_t* bchan){
   }
 }
 
-static int
-rotate_output(ncplane* dst, uint32_t tchan, uint32_t bchan){
-  dst->channels = channels_combine(tchan, bchan);
+// the EGC of a rotated cell having top half 'tchan' and bottom half 'bchan'
+static const char*
+rotate_egc(uint32_t tchan, uint32_t bchan){
   if(tchan != bchan){
-    return ncplane_putegc(dst, "▀", NULL);
+    return "▀";
   }
   if(channel_default_p(tchan) && channel_default_p(bchan)){
-    return ncplane_putegc(dst, "", NULL);
+    return "";
   }else if(channel_default_p(tchan)){
-    return ncplane_putegc(dst, " ", NULL);
+    return " ";
   }
-  return ncplane_putegc(dst, "█", NULL);
+  return "█";
 }
 
 // rotation works at two levels:
@@ -348,17 +544,14 @@ rotate_output(ncplane* dst, uint32_t tchan, uint32_t bchan){
 //    single full block of that color (what is its background?).
 //  if a "row" is two different channels, they become a upper block (why not
 //   lower?) having the two channels as fore- and background.
-static int
-rotate_2x1_cw(ncplane* src, ncplane* dst, int srcy, int srcx, int dsty, int dstx){
-  cell c1 = CELL_TRIVIAL_INITIALIZER;
-  cell c2 = CELL_TRIVIAL_INITIALIZER;
-  if(ncplane_at_yx_cell(src, srcy, srcx, &c1) < 0){
-    return -1;
-  }
-  if(ncplane_at_yx_cell(src, srcy, srcx + 1, &c2) < 0){
-    cell_release(src, &c1);
-    return -1;
-  }
+//
+// The channels of the two cells into which the 1x2 block at 'srcy', 'srcx'
+// rotates are written to 'left' and 'right'.
+static void
+rotate_2x1(const ncplane* src, int srcy, int srcx, bool cw,
+           uint64_t* left, uint64_t* right){
+  const cell* c1 = ncplane_cell_const(src, srcy, srcx);
+  const cell* c2 = ncplane_cell_const(src, srcy, srcx + 1);
   // there can be at most 4 colors and 4 transparencies:
   //  - c1fg, c1bg, c2fg, c2bg, c1ftrans, c2ftrans, c1btrans, c2btrans
   // but not all are necessarily used:
@@ -370,139 +563,100 @@ rotate_2x1_cw(ncplane* src, ncplane* dst, int srcy, int srcx, int dsty, int dstx
   //     otherwise, c2bg c2btrans
   //  - botright gets topright. if topright is foreground, c2fg c2ftrans.
   //     otherwise, c2bg c2btrans
-  uint32_t c1b = cell_bchannel(&c1);
-  uint32_t c2b = cell_bchannel(&c2);
-  uint32_t c1t = cell_fchannel(&c1);
-  uint32_t c2t = cell_fchannel(&c2);
-  rotate_channels(src, &c1, &c1t, &c1b);
-  rotate_channels(src, &c2, &c2t, &c2b);
-  // right char comes from two tops. left char comes from two bottoms. if
-  // they're the same channel, they become a:
+  uint32_t c1b = cell_bchannel(c1);
+  uint32_t c2b = cell_bchannel(c2);
+  uint32_t c1t = cell_fchannel(c1);
+  uint32_t c2t = cell_fchannel(c2);
+  rotate_channels(src, c1, &c1t, &c1b);
+  rotate_channels(src, c2, &c2t, &c2b);
+  // clockwise, the right char comes from two tops, and the left char from two
+  // bottoms. counterclockwise, the reverse. if they're the same channel, they
+  // become a:
   //
   //  nul if the channel is default
   //  space if the fore is default
   //  full if the back is default
-  ncplane_cursor_move_yx(dst, dsty, dstx);
-  rotate_output(dst, c1b, c2b);
-  rotate_output(dst, c1t, c2t);
-  return 0;
-}
-
-static int
-rotate_2x1_ccw(ncplane* src, ncplane* dst, int srcy, int srcx, int dsty, int dstx){
-  cell c1 = CELL_TRIVIAL_INITIALIZER;
-  cell c2 = CELL_TRIVIAL_INITIALIZER;
-  if(ncplane_at_yx_cell(src, srcy, srcx, &c1) < 0){
-    return -1;
-  }
-  if(ncplane_at_yx_cell(src, srcy, srcx + 1, &c2) < 0){
-    cell_release(src, &c1);
-    return -1;
+  if(cw){
+    *left = channels_combine(c1b, c2b);
+    *right = channels_combine(c1t, c2t);
+  }else{
+    *left = channels_combine(c1t, c2t);
+    *right = channels_combine(c1b, c2b);
   }
-  uint32_t c1b = cell_bchannel(&c1);
-  unsigned c2b = cell_bchannel(&c2);
-  unsigned c1t = cell_fchannel(&c1);
-  unsigned c2t = cell_fchannel(&c2);
-  rotate_channels(src, &c1, &c1t, &c1b);
-  rotate_channels(src, &c2, &c2t, &c2b);
-  ncplane_cursor_move_yx(dst, dsty, dstx);
-  rotate_output(dst, c1t, c2t);
-  rotate_output(dst, c1b, c2b);
-  return 0;
 }
 
-// copy 'newp' into 'n' after resizing 'n' to match 'newp'
-static int
-rotate_merge(ncplane* n, ncplane* newp){
-  int dimy, dimx;
-  ncplane_dim_yx(newp, &dimy, &dimx);
-  int ret = ncplane_resize(n, 0, 0, 0, 0, 0, 0, dimy, dimx);
-  if(ret == 0){
-    for(int y = 0 ; y < dimy ; ++y){
-      for(int x = 0 ; x < dimx ; ++x){
-        const cell* src = &newp->fb[fbcellidx(y, dimx, x)];
-        cell* targ = &n->fb[fbcellidx(y, dimx, x)];
-        if(cell_duplicate_far(&n->pool, targ, newp, src) < 0){
-          return -1;
-        }
-      }
-    }
-  }
-  return ret;
-}
+// tiles are an even number of cells wide, so as not to split a 1x2 block
+#define ROTATE_TILE 32
 
-// generate a temporary plane that can hold the contents of n, rotated 90°
-static ncplane*
-rotate_plane(const ncplane* n){
-  int absy, absx;
-  ncplane_yx(n, &absy, &absx);
+// rotate 'n' through 90 degrees, in place. the rotated channels are first
+// gathered into a flat array, a square tile of the source at a time: a row of
+// the source becomes a column of the result, and working across whole rows
+// would stride through the entire array with each one. 'n' is then resized,
+// and the array written directly into its cells.
+static int
+rotate_plane(ncplane* n, bool cw){
   int dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
   if(dimx % 2 != 0){
-    return NULL;
+    return -1;
   }
   const int newy = dimx / 2;
   const int newx = dimy * 2;
-  ncplane* newp = ncplane_new(n->nc, newy, newx, absy, absx, n->userptr);
-  return newp;
-}
-
-int ncplane_rotate_cw(ncplane* n){
-  ncplane* newp = rotate_plane(n);
-  if(newp == NULL){
-    return -1;
+  uint64_t* chans = malloc(sizeof(*chans) * newy * newx);
+  if(chans == NULL){
+    return -1;
+  }
+  for(int tiley = 0 ; tiley < dimy ; tiley += ROTATE_TILE){
+    const int endy = tiley + ROTATE_TILE < dimy ? tiley + ROTATE_TILE : dimy;
+    for(int tilex = 0 ; tilex < dimx ; tilex += ROTATE_TILE){
+      const int endx = tilex + ROTATE_TILE < dimx ? tilex + ROTATE_TILE : dimx;
+      for(int y = tiley ; y < endy ; ++y){
+        for(int x = tilex ; x < endx ; x += 2){
+          // clockwise, the topmost row consists of the leftmost two columns,
+          // taken from the bottom up. counterclockwise, it consists of the
+          // rightmost two columns, taken from the top down.
+          int targy, targx;
+          if(cw){
+            targy = x / 2;
+            targx = (dimy - 1 - y) * 2;
+          }else{
+            targy = (dimx - 2 - x) / 2;
+            targx = y * 2;
+          }
+          uint64_t* targ = chans + targy * newx + targx;
+          rotate_2x1(n, y, x, cw, targ, targ + 1);
+        }
+      }
+    }
   }
-  int dimy, dimx;
-  ncplane_dim_yx(n, &dimy, &dimx);
-  int centy, centx;
-  ncplane_center_abs(n, &centy, &centx);
-  // the topmost row consists of the leftmost two columns. the rightmost column
-  // of the topmost row consists of the top half of the top two leftmost cells.
-  // the penultimate column of the topmost row consists of the bottom half of
-  // the top two leftmost cells. work from the bottom up on the source, so we
-  // can copy to the top row from the left to the right.
-  int targx, targy = 0;
-  for(int x = 0 ; x < dimx ; x += 2){
-    targx = 0;
-    for(int y = dimy - 1 ; y >= 0 ; --y){
-      if(rotate_2x1_cw(n, newp, y, x, targy, targx)){
-        ncplane_destroy(newp);
-        return -1;
+  int ret = ncplane_resize(n, 0, 0, 0, 0, 0, 0, newy, newx);
+  for(int y = 0 ; ret == 0 && y < newy ; ++y){
+    for(int x = 0 ; x < newx ; ++x){
+      const uint64_t channels = chans[y * newx + x];
+      cell* targ = ncplane_cell_ref_yx(n, y, x);
+      if(targ == NULL){
+        ret = -1;
+        break;
+      }
+      targ->attrword = 0;
+      targ->channels = channels;
+      if(cell_load(n, targ, rotate_egc(channels_fchannel(channels),
+                                       channels_bchannel(channels))) < 0){
+        ret = -1;
+        break;
       }
-      targx += 2;
     }
-    ++targy;
   }
-  int ret = rotate_merge(n, newp);
-  ret |= ncplane_destroy(newp);
+  free(chans);
   return ret;
 }
 
+int ncplane_rotate_cw(ncplane* n){
+  return rotate_plane(n, true);
+}
+
 int ncplane_rotate_ccw(ncplane* n){
-  ncplane* newp = rotate_plane(n);
-  if(newp == NULL){
-    return -1;
-  }
-  int dimy, dimx, targdimy, targdimx;
-  ncplane_dim_yx(n, &dimy, &dimx);
-  ncplane_dim_yx(newp, &targdimy, &targdimx);
-  int x = dimx - 2, y;
-  // Each row of the target plane is taken from a column of the source plane.
-  // As the target row grows (down), the source column shrinks (moves left).
-  for(int targy = 0 ; targy < targdimy ; ++targy){
-    y = 0;
-    for(int targx = 0 ; targx < targdimx ; targx += 2){
-      if(rotate_2x1_ccw(n, newp, y, x, targy, targx)){
-        ncplane_destroy(newp);
-        return -1;
-      }
-      ++y;
-    }
-    x -= 2;
-  }
-  int ret = rotate_merge(n, newp);
-  ret |= ncplane_destroy(newp);
-  return ret;
+  return rotate_plane(n, false);
 }
 
 #ifdef USE_QRCODEGEN
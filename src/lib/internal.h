@@ -20,9 +20,6 @@ const char* oiio_version(void);
 #endif
 #endif
 
-#ifdef USE_SIXEL
-#include <sixel/sixel.h>
-#endif
 
 #include <term.h>
 #include <time.h>
@@ -60,11 +57,73 @@ struct esctrie;
 // screen is resized, for example. Offscreen portions will not be rendered.
 // Accesses beyond the borders of a panel, however, are errors.
 //
-// The framebuffer 'fb' is a set of rows. For scrolling, we interpret it as a
+// The framebuffer is a set of rows. For scrolling, we interpret it as a
 // circular buffer of rows. 'logrow' is the index of the row at the logical top
 // of the plane.
+//
+// The rows are stored as a vector of tiles, each a band of NCTILE_ROWS
+// complete rows (the last tile holds whatever rows remain). Tiles are
+// reference counted, and shared copy-on-write among a plane and its duplicates
+// and snapshots: a write to a shared tile first takes a private copy of that
+// tile alone. The egcpool is shared in the same way. Tiles are allocated on
+// first write; an absent (NULL) tile reads as zeroed cells, i.e. the base
+// cell, so large planes cost only what has actually been drawn.
+#define NCTILE_ROWS 16
+
+typedef struct fbtile {
+  unsigned refcount;     // number of planes and snapshots using this tile
+  cell cells[];          // row-major, lenx cells per row
+} fbtile;
+
+// A bitmap graphic, drawn over a rectangle of some plane's cells using a
+// terminal graphics protocol. The plane's cells hold an approximation of the
+// graphic, which is shown whenever the graphic itself cannot be drawn.
+typedef struct sprixel {
+  char* glyph;           // encoded graphic, written as-is to the terminal
+  size_t glyphlen;       // bytes in glyph
+  struct kittyimg* kitty;// kitty image placed by this sprixel, or NULL (Sixel)
+  uint32_t id;           // unique among this context's sprixels
+  int y, x;              // origin within the plane, in cells
+  int dimy, dimx;        // size in cells
+} sprixel;
+
+// An image of the kitty graphics protocol. It is transmitted to the terminal
+// at most once, and then placed by id as often as necessary, by each of the
+// sprixels sharing it (see ncplane_dup()).
+typedef struct kittyimg {
+  uint32_t id;           // image id known to the terminal
+  int refs;              // sprixels referencing this image
+  char* glyph;           // transmission command, NULL once written
+  size_t glyphlen;
+  char* path;            // shared memory object or file holding the pixels,
+                         //  unlinked by the terminal once read (or NULL)
+  bool shm;              // is path a shared memory object?
+} kittyimg;
+
+// How kitty images are transmitted to the terminal. Shared memory and files
+// are only useful when the terminal runs on the same machine.
+typedef enum {
+  KITTY_DIRECT,          // base64-encoded pixels over the tty (t=d)
+  KITTY_SHM,             // POSIX shared memory object (t=s)
+  KITTY_FILE,            // temporary file (t=t)
+} kittymedium_e;
+
+// Threads used to split work (e.g. blitting a visual) into bands, created on
+// first use (see workers.c).
+typedef struct workerpool workerpool;
+
+// Where a sprixel was drawn on the screen, in absolute cells. Used to detect
+// damage to drawn graphics from one frame to the next.
+typedef struct sprixelplace {
+  uint32_t id;
+  uint32_t imageid;      // kitty image id, or 0 for Sixel
+  int absy, absx;
+  int dimy, dimx;
+} sprixelplace;
+
 typedef struct ncplane {
-  cell* fb;              // "framebuffer" of character cells
+  fbtile** tiles;        // "framebuffer" of character cells, in tiles
+  cell* zrow;            // lenx zeroed cells, read in place of absent tiles
   int logrow;            // logical top row, starts at 0, add one for each scroll
   int x, y;              // current cursor location within this plane
   int absx, absy;        // origin of the plane relative to the screen
@@ -81,9 +140,24 @@ typedef struct ncplane {
   void* userptr;         // slot for the user to stick some opaque pointer
   cell basecell;         // cell written anywhere that fb[i].gcluster == 0
   struct notcurses* nc;  // notcurses object of which we are a part
+  sprixel* sprite;       // bitmap graphic drawn over this plane, or NULL
+  uint64_t epoch;        // changes whenever the cells are wholly replaced
   bool scrolling;        // is scrolling enabled? always disabled by default
 } ncplane;
 
+// A snapshot of a plane's contents, sharing its tiles and egcpool.
+typedef struct ncsnapshot {
+  fbtile** tiles;        // referenced tiles, fbtile_count(leny) of them
+  egcpool pool;          // shared with the snapshotted plane
+  int leny, lenx;        // geometry at the time of the snapshot
+  int logrow;            // so that restoration needn't rotate the rows
+  int y, x;              // cursor
+  uint64_t channels;
+  uint32_t attrword;
+  cell basecell;
+  struct notcurses* nc;  // for tile accounting
+} ncsnapshot;
+
 #include "blitset.h"
 
 // current presentation state of the terminal. it is carried across render
@@ -291,6 +365,7 @@ typedef struct notcurses {
 
   ncstats stats;  // some statistics across the lifetime of the notcurses ctx
   ncstats stashstats; // cumulative stats, unaffected by notcurses_reset_stats()
+  uint64_t epochs; // last plane epoch handed out, see ncplane_invalidate()
 
   int truecols;   // true number of columns in the physical rendering area.
                   // used only to see if output motion takes us to the next
@@ -325,7 +400,17 @@ typedef struct notcurses {
   struct esctrie* inputescapes; // trie of input escapes -> ncspecial_keys
   bool ownttyfp;  // do we own ttyfp (and thus must close it?)
   bool utf8;      // are we using utf-8 encoding, as hoped?
-  bool libsixel;  // do we have Sixel support?
+  bool sixel;     // does the terminal support Sixel graphics?
+  bool kitty;     // does the terminal support the kitty graphics protocol?
+  kittymedium_e kittymedium; // how kitty images are transmitted
+  int cellpixy;   // pixel geometry of a cell, guessed if the terminal
+  int cellpixx;   //  doesn't tell us
+  uint32_t sprixelid;     // last sprixel id handed out
+  sprixelplace* drawnsprites; // sprixels drawn in the last frame
+  int drawnspritecount;
+  uint32_t* kittyfrees;   // kitty images to be deleted from the terminal
+  int kittyfreecount;
+  workerpool* workers;    // for parallel blitting, NULL until first used
 } notcurses;
 
 void sigwinch_handler(int signo);
@@ -388,9 +473,51 @@ logical_to_virtual(const ncplane* n, int y){
   return (y + n->logrow) % n->leny;
 }
 
+// number of tiles necessary for 'rows' rows
 static inline int
-nfbcellidx(const ncplane* n, int row, int col){
-  return fbcellidx(logical_to_virtual(n, row), n->lenx, col);
+fbtile_count(int rows){
+  return (rows + NCTILE_ROWS - 1) / NCTILE_ROWS;
+}
+
+// number of rows held by tile 't' of a framebuffer having 'rows' rows
+static inline int
+fbtile_rows(int rows, int t){
+  int r = rows - t * NCTILE_ROWS;
+  return r > NCTILE_ROWS ? NCTILE_ROWS : r;
+}
+
+// make tile 't' of 'n' private and present, allocating it if it is absent,
+// or taking a copy if it is shared. -1 on allocation failure.
+int fbtile_claim(ncplane* n, int t);
+
+// get the (virtual) row 'vrow' of the framebuffer for reading. the row is
+// contiguous, with n->lenx cells. it is invalidated by any write to 'n'.
+static inline const cell*
+ncplane_fbrow_const(const ncplane* n, int vrow){
+  const fbtile* t = n->tiles[vrow / NCTILE_ROWS];
+  if(t == NULL){
+    return n->zrow;
+  }
+  return t->cells + (vrow % NCTILE_ROWS) * n->lenx;
+}
+
+// get the (virtual) row 'vrow' of the framebuffer for writing, allocating its
+// tile or breaking any sharing of it. returns NULL on allocation failure.
+static inline cell*
+ncplane_fbrow(ncplane* n, int vrow){
+  const int tidx = vrow / NCTILE_ROWS;
+  if(n->tiles[tidx] == NULL || n->tiles[tidx]->refcount > 1){
+    if(fbtile_claim(n, tidx)){
+      return NULL;
+    }
+  }
+  return n->tiles[tidx]->cells + (vrow % NCTILE_ROWS) * n->lenx;
+}
+
+// the cell at logical coordinate 'row'/'col', for reading only.
+static inline const cell*
+ncplane_cell_const(const ncplane* n, int row, int col){
+  return &ncplane_fbrow_const(n, logical_to_virtual(n, row))[col];
 }
 
 // copy the UTF8-encoded EGC out of the cell, whether simple or complex. the
@@ -491,9 +618,9 @@ rgb_greyscale(int r, int g, int b){
   if(b < 0 || b > 255){
     return -1;
   }
-  // Use Rec. 601 scaling plus linear approximation of gamma decompression
-  float fg = (0.299 * (r / 255.0) + 0.587 * (g / 255.0) + 0.114 * (b / 255.0));
-  return fg * 255;
+  // Use Rec. 601 scaling plus linear approximation of gamma decompression,
+  // with the weights in 16.16 fixed point (summing to exactly 1.0)
+  return (r * 19595 + g * 38470 + b * 7471) >> 16;
 }
 
 static inline int
@@ -533,6 +660,8 @@ extended_gcluster(const ncplane* n, const cell* c){
   return egcpool_extended_gcluster(&n->pool, c);
 }
 
+// get a writable reference to the cell at 'y'/'x', breaking any sharing of
+// its tile. returns NULL on allocation failure.
 cell* ncplane_cell_ref_yx(ncplane* n, int y, int x);
 
 static inline void
@@ -573,7 +702,7 @@ plane_debug(const ncplane* n, bool details){
   if(details){
     for(int y = 0 ; y < 1 ; ++y){
       for(int x = 0 ; x < 10 ; ++x){
-        const cell* c = &n->fb[fbcellidx(y, dimx, x)];
+        const cell* c = ncplane_cell_const(n, y, x);
         fprintf(stderr, "[%03d/%03d] ", y, x);
         cell_debug(&n->pool, c);
       }
@@ -622,7 +751,77 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
                             int keepleny, int keeplenx, int yoff, int xoff,
                             int ylen, int xlen);
 
-int update_term_dimensions(int fd, int* rows, int* cols);
+// 'cellpixy' and 'cellpixx' may be NULL. they are set to 0 if the terminal
+// doesn't report its pixel geometry.
+int update_term_dimensions(int fd, int* rows, int* cols,
+                           int* cellpixy, int* cellpixx);
+
+// cell geometry used when the terminal reports none, that of the VT340
+#define NCSIXEL_CELLPIXY 20
+#define NCSIXEL_CELLPIXX 10
+
+// alpha comes to us 0--255, but we have only 3 alpha values to map them to.
+// settled on experimentally.
+static inline bool
+ffmpeg_trans_p(bool bgr, unsigned char alpha){
+  if(!bgr && alpha < 192){
+//fprintf(stderr, "TRANSPARENT!\n");
+    return true;
+  }
+  return false;
+}
+
+// Encode the 'leny'x'lenx' pixels at 'begy'/'begx' of the RGBA (BGRx if
+// 'bgr') 'data' as a Sixel graphic of at most 256 colors. Transparent pixels
+// (see ffmpeg_trans_p()) are not drawn. Returns a heap-allocated DCS string,
+// its length written to 'glyphlen', or NULL on error.
+char* sixel_encode(const void* data, int linesize, int begy, int begx,
+                   int leny, int lenx, bool bgr, size_t* glyphlen);
+
+// Encode the 'leny'x'lenx' pixels at 'begy'/'begx' of the RGBA (BGRx if
+// 'bgr') 'data' as a kitty image, using nc->kittymedium (falling back to
+// KITTY_DIRECT should shared memory or files fail). Transparent pixels (see
+// ffmpeg_trans_p()) are not drawn. Returns an image with one reference, or
+// NULL on error.
+kittyimg* kitty_encode(notcurses* nc, const void* data, int linesize, int begy,
+                       int begx, int leny, int lenx, bool bgr);
+
+// Drop a reference to 'k'. Once the last is gone, the image is queued for
+// deletion from the terminal (see kitty_free_images()).
+void kittyimg_release(notcurses* nc, kittyimg* k);
+
+// Transmit 'k' to the terminal, unless it already has been.
+int kitty_transmit(FILE* out, kittyimg* k);
+
+// Place image 'imageid' at the cursor, as placement 'placeid' (replacing any
+// earlier such placement), without moving the cursor.
+int kitty_place(FILE* out, uint32_t imageid, uint32_t placeid);
+
+// Remove placement 'placeid' of 'imageid' from the screen. The image remains.
+int kitty_unplace(FILE* out, uint32_t imageid, uint32_t placeid);
+
+// Delete the images queued by kittyimg_release() from the terminal.
+int kitty_free_images(notcurses* nc, FILE* out);
+
+// Take ownership of the encoded graphic 'glyph' of 'glyphlen' bytes, covering
+// 'dimy'x'dimx' cells at 'y'/'x' of 'n', replacing any graphic already there.
+int sprixel_attach(ncplane* n, char* glyph, size_t glyphlen,
+                   int y, int x, int dimy, int dimx);
+
+// As sprixel_attach(), but place the kitty image 'k', taking a reference.
+int sprixel_attach_kitty(ncplane* n, kittyimg* k, int y, int x, int dimy, int dimx);
+
+// Drop the graphic from 'n', if there is one. Its cells are unaffected.
+void sprixel_detach(ncplane* n);
+
+// Note that the plane's cells have been erased, resized, scrolled, or
+// otherwise replaced wholesale, so that anything remembered about what was
+// drawn there (see blitdelta) no longer holds. Planes never share an epoch,
+// even across destruction and reallocation.
+static inline void
+ncplane_invalidate(ncplane* n){
+  n->epoch = ++n->nc->epochs;
+}
 
 static inline void*
 memdup(const void* src, size_t len){
@@ -635,10 +834,254 @@ memdup(const void* src, size_t len){
 
 void* bgra_to_rgba(const void* data, int rows, int rowstride, int cols);
 
+// Scale the RGBA image 'data' ('rows' x 'cols', 'rowstride' bytes per row) to
+// 'orows' x 'ocols' with an integer box filter, writing output rows 'obegy'
+// through 'obegy' + 'oleny' - 1 to 'out' ('orowstride' bytes per row).
+int rgba_scale_box(const void* data, int rows, int rowstride, int cols,
+                   void* out, int orows, int orowstride, int ocols,
+                   int obegy, int oleny);
+
 int rgba_blit_dispatch(ncplane* nc, const struct blitset* bset, int placey,
                        int placex, int linesize, const void* data, int begy,
                        int begx, int leny, int lenx, bool blendcolors);
 
+// The number of threads available to workerpool_run(), including the caller,
+// creating the pool if necessary.
+int workerpool_threads(notcurses* nc);
+
+// Call 'fxn' once for each of 'bands' bands, spread across the worker threads
+// and the caller, returning once all are done. Returns -1 if any call failed.
+int workerpool_run(notcurses* nc, int bands, int (*fxn)(void*, int), void* arg);
+
+void workerpool_destroy(workerpool* wp);
+
+// A blit split into bands of whole plane rows, each of which can be blitted
+// concurrently with the others. Bands only read the plane's egcpool; EGCs
+// requiring it be modified are written by blitbands_finish().
+typedef struct blitbands {
+  ncplane* n;
+  const struct blitset* bset;
+  int placey, placex;
+  int begy, begx, leny, lenx; // source pixels of the entire blit
+  bool blendcolors;
+  int pixrows;                // source pixel rows per plane row
+  int rowsper;                // plane rows per band (the last may be short)
+  int count;                  // bands
+  struct blitband* bands;
+} blitbands;
+
+// Can 'bset' be used with blitbands? Pixel blitters can't.
+bool blitset_bandable(const struct blitset* bset);
+
+// Prepare to blit in as many as 'count' bands, claiming the plane rows being
+// written. bb->count holds the actual number of bands.
+int blitbands_init(blitbands* bb, ncplane* n, const struct blitset* bset,
+                   int placey, int placex, int begy, int begx, int leny,
+                   int lenx, bool blendcolors, int count);
+
+// The source pixel rows read by band 'band'.
+void blitbands_extent(const blitbands* bb, int band, int* begy, int* leny);
+
+// Blit band 'band' from 'data' (which must hold its extent). Safe to call
+// concurrently for distinct bands.
+int blitbands_blit(blitbands* bb, int band, int linesize, const void* data);
+
+// Having blitted all bands (or 'failed'), write any deferred EGCs and release
+// resources. Returns the number of cells written, or -1 on error.
+int blitbands_finish(blitbands* bb, bool failed);
+
+// As rgba_blit_dispatch(), but in bands spread across the workerpool.
+int rgba_blit_parallel(ncplane* nc, const struct blitset* bset, int placey,
+                       int placex, int linesize, const void* data, int begy,
+                       int begx, int leny, int lenx, bool blendcolors);
+
+// The source pixels of an ncvisual's last blit with NCVISUAL_OPTION_DELTA, as
+// currently drawn. A following blit of the same geometry to the same place
+// writes only those cells whose pixels have since changed by more than
+// 'threshold' in some channel.
+typedef struct blitdelta {
+  uint32_t* pixels;           // leny x lenx RGBA
+  const ncplane* n;           // NULL if nothing is known to be drawn
+  const struct blitset* bset;
+  int placey, placex;
+  int leny, lenx;
+  uint64_t epoch;             // epoch of 'n' at the time
+  bool blendcolors;
+  unsigned threshold;
+} blitdelta;
+
+void blitdelta_destroy(blitdelta* bd);
+
+// Blit a scaled visual: in bands if 'parallel', and only its changed cells if
+// 'delta' is non-NULL. Returns the number of cells written, or -1 on error.
+int rgba_blit_visual(ncplane* nc, const struct blitset* bset, int placey,
+                     int placex, int linesize, const void* data, int begy,
+                     int begx, int leny, int lenx, bool blendcolors,
+                     bool parallel, blitdelta* delta);
+
+// Pixel formats other than RGBA which the cell blitters read directly, as
+// decoders commonly produce them (see native_blit()).
+typedef enum {
+  BLITFMT_YUV420P,  // planar Y, U, V; U and V subsampled 2x2. BT.601 range.
+  BLITFMT_YUVJ420P, // as BLITFMT_YUV420P, but full (JPEG) range
+  BLITFMT_RGB24,
+  BLITFMT_BGR24,
+  BLITFMT_GRAY8,
+  BLITFMT_BGRX,     // 32 bits per pixel, the last ignored
+} blitfmt_e;
+
+// An image of some blitfmt_e. The packed formats use only the first plane.
+typedef struct blitsource {
+  blitfmt_e fmt;
+  const unsigned char* planes[3];
+  int linesizes[3];
+} blitsource;
+
+// Blit 'src' without first converting it to RGBA. The half-block and ASCII
+// blitters read it directly, converting colors per cell; the others are
+// handed a few converted rows at a time. Not for the pixel blitters. Returns
+// the number of cells written, or -1 on error.
+int native_blit(ncplane* nc, const struct blitset* bset, int placey,
+                int placex, const blitsource* src, int begy, int begx,
+                int leny, int lenx, bool blendcolors);
+
+// The chroma terms of the BT.601 conversion to RGB (16.16 fixed point), which
+// are shared by all pixels having the chroma sample 'u', 'v'.
+static inline void
+yuv_chroma(unsigned u, unsigned v, bool fullrange, int* cr, int* cg, int* cb){
+  const int du = (int)u - 128;
+  const int dv = (int)v - 128;
+  if(fullrange){
+    *cr = 91881 * dv;
+    *cg = -22554 * du - 46802 * dv;
+    *cb = 116130 * du;
+  }else{
+    *cr = 104597 * dv;
+    *cg = -25675 * du - 53279 * dv;
+    *cb = 132201 * du;
+  }
+}
+
+static inline unsigned char
+yuv_clamp(int c){
+  c = (c + 32768) >> 16;
+  return c < 0 ? 0 : c > 255 ? 255 : c;
+}
+
+// Convert luma 'y' to RGB in 'rgb', given its chroma terms from yuv_chroma().
+static inline void
+yuv_rgb(unsigned y, bool fullrange, int cr, int cg, int cb, unsigned char* rgb){
+  const int l = fullrange ? (int)y << 16 : 76309 * ((int)y - 16);
+  rgb[0] = yuv_clamp(l + cr);
+  rgb[1] = yuv_clamp(l + cg);
+  rgb[2] = yuv_clamp(l + cb);
+}
+
+// A decoded still image in the cache behind ncvisual_from_file() (see
+// ncvisual_cache_limit()), and a scaled rendering of one. Each is held by
+// reference; an evicted image lives on until its last ncvisual is destroyed.
+struct vcacheentry;
+struct vcachevariant;
+struct stat;
+
+// Is the cache enabled?
+bool vcache_enabled(void);
+
+// Look up 'path', whose stat(2) is 'st'. On a hit, returns a reference to the
+// entry, and its RGBA pixels (packed 'cols' * 4 bytes to a row) in 'pixels',
+// 'rows', and 'cols'. An entry whose file has since changed is dropped.
+struct vcacheentry* vcache_lookup(const char* path, const struct stat* st,
+                                  const uint32_t** pixels, int* rows, int* cols);
+
+// Cache a copy of the RGBA image 'data' decoded from 'path', returning a
+// reference to the new entry. 'st' must be the stat(2) of 'path' taken before
+// it was decoded, lest a file replaced during decoding be cached as the new
+// one. Returns NULL if it can't be cached.
+struct vcacheentry* vcache_insert(const char* path, const struct stat* st,
+                                  const void* data, int rows, int rowstride,
+                                  int cols);
+
+void vcache_release(struct vcacheentry* e);
+
+// Look up a rendering of 'e' scaled to 'rows' x 'cols' at 'quality'. On a
+// hit, returns a reference, and its pixels (packed) in 'pixels'.
+struct vcachevariant* vcache_variant_get(struct vcacheentry* e, int rows,
+                                         int cols, ncscalequality_e quality,
+                                         const uint32_t** pixels);
+
+void vcache_variant_release(struct vcachevariant* v);
+
+// Offer a copy of 'data', a rendering of 'e' scaled to 'rows' x 'cols' at
+// 'quality', to the cache.
+void vcache_offer(struct vcacheentry* e, int rows, int cols,
+                  ncscalequality_e quality, const void* data, int rowstride);
+
+// The cells drawn by each frame of a streamed ncvisual, as recorded for
+// ncvisual_record(), and replayed in place of decoding once complete. A
+// recording is of one set of ncvisual_options, and is invalidated by the
+// resizing of their plane.
+typedef struct ncanim ncanim;
+
+typedef enum {
+  NCANIM_EMPTY,     // nothing recorded for these options
+  NCANIM_RECORDING,
+  NCANIM_COMPLETE,  // ready to be replayed
+  NCANIM_ABANDONED, // grew past the limit; these options aren't recorded
+} ncanim_e;
+
+ncanim* ncanim_create(size_t maxbytes);
+void ncanim_destroy(ncanim* a);
+
+// Change the limit, abandoning the recording if it's already larger.
+void ncanim_limit(ncanim* a, size_t maxbytes);
+
+// The state of the recording with respect to 'vopts', whose plane is non-NULL.
+ncanim_e ncanim_lookup(const ncanim* a, const struct ncvisual_options* vopts);
+
+// Discard any recording, and begin recording a stream with 'vopts'.
+void ncanim_begin(ncanim* a, const struct ncvisual_options* vopts);
+
+// Record the frame which has just been blitted to the 'rows' x 'cols' cells
+// at 'y'/'x' of 'n', to be shown 'offsetns' after the stream begins. Returns
+// -1 if the recording has been abandoned (or failed, and been discarded).
+int ncanim_record(ncanim* a, const ncplane* n, int y, int x, int rows,
+                  int cols, uint64_t offsetns);
+
+// The stream reached its end; the recording is complete.
+void ncanim_finish(ncanim* a);
+
+// The stream ended early; discard any partial recording.
+void ncanim_cancel(ncanim* a);
+
+size_t ncanim_frames(const ncanim* a);
+uint64_t ncanim_offset(const ncanim* a, size_t frame);
+
+// Write the cells changed by 'frame' of a complete recording to 'n'.
+int ncanim_apply(const ncanim* a, ncplane* n, size_t frame);
+
+// The blitter which ncvisual_render() would use for 'opts', or NULL.
+const struct blitset* rgba_blitter(const struct notcurses* nc,
+                                   const struct ncvisual_options* opts);
+
+// Successively cheaper renderings of a stream with NCVISUAL_OPTION_ADAPTIVE,
+// chosen from the measured cost of each frame. Tier 0 is the options as
+// provided.
+typedef struct ncadapt ncadapt;
+
+ncadapt* ncadapt_create(const struct notcurses* nc,
+                        const struct ncvisual_options* vopts);
+void ncadapt_destroy(ncadapt* a);
+
+// Account for a frame shown at the current tier, which took 'blitns' to blit,
+// and whose render emitted 'bytes' in 'renderns', 'intervalns' after its
+// predecessor was due. 'late' if it was shown late, or frames were dropped
+// before it. Returns the tier at which the next frame ought be shown.
+int ncadapt_frame(ncadapt* a, uint64_t blitns, uint64_t bytes,
+                  uint64_t renderns, uint64_t intervalns, bool late);
+
+// Set the blitter, scaling quality, and flags of the current tier in 'vopts'.
+void ncadapt_apply(const ncadapt* a, struct ncvisual_options* vopts);
+
 // find the "center" cell of two lengths. in the case of even rows/columns, we
 // place the center on the top/left. in such a case there will be one more
 // cell to the bottom/right of the center.
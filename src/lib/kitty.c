@@ -0,0 +1,295 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "internal.h"
+
+// The kitty graphics protocol sends APC strings ("\x1b_G" keys ';' payload
+// "\x1b\\"). An image is transmitted once (a=t) under an id, then placed at
+// the cursor (a=p) by that id as often as we like. Each of our sprixels
+// placing an image does so under its own placement id, so that placing it
+// again moves it, and deleting it (a=d,d=i) removes only that placement. The
+// pixels are 32-bit RGBA (f=32), sent either over the tty as base64, or via a
+// shared memory object or temporary file named by the (base64) payload. The
+// terminal unlinks the latter once it has read them. q=2 suppresses replies,
+// which would otherwise show up as input.
+
+// base64 payloads over the tty are broken into chunks of at most this many
+// bytes, as required by the protocol. it must be a multiple of 4.
+#define KITTY_CHUNK 4096
+
+static const char b64alphabet[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// base64-encode 'len' bytes of 'src' into 'dst', which must have room for
+// 4 * ((len + 2) / 3) bytes. returns the number of bytes written.
+static size_t
+base64(const unsigned char* src, size_t len, char* dst){
+  char* d = dst;
+  while(len >= 3){
+    *d++ = b64alphabet[src[0] >> 2u];
+    *d++ = b64alphabet[((src[0] & 0x3u) << 4u) | (src[1] >> 4u)];
+    *d++ = b64alphabet[((src[1] & 0xfu) << 2u) | (src[2] >> 6u)];
+    *d++ = b64alphabet[src[2] & 0x3fu];
+    src += 3;
+    len -= 3;
+  }
+  if(len){
+    *d++ = b64alphabet[src[0] >> 2u];
+    if(len == 1){
+      *d++ = b64alphabet[(src[0] & 0x3u) << 4u];
+      *d++ = '=';
+    }else{
+      *d++ = b64alphabet[((src[0] & 0x3u) << 4u) | (src[1] >> 4u)];
+      *d++ = b64alphabet[(src[1] & 0xfu) << 2u];
+    }
+    *d++ = '=';
+  }
+  return d - dst;
+}
+
+// copy the pixels out as RGBA. transparent pixels are zeroed.
+static unsigned char*
+kitty_rgba(const void* data, int linesize, int begy, int begx,
+           int leny, int lenx, bool bgr){
+  unsigned char* rgba = malloc((size_t)leny * lenx * 4);
+  if(rgba == NULL){
+    return NULL;
+  }
+  const unsigned char* dat = data;
+  unsigned char* out = rgba;
+  for(int y = 0 ; y < leny ; ++y){
+    const unsigned char* px = dat + (size_t)linesize * (begy + y) + begx * 4;
+    for(int x = 0 ; x < lenx ; ++x, px += 4, out += 4){
+      if(ffmpeg_trans_p(bgr, px[3])){
+        memset(out, 0, 4);
+        continue;
+      }
+      out[0] = px[bgr ? 2 : 0];
+      out[1] = px[1];
+      out[2] = px[bgr ? 0 : 2];
+      out[3] = bgr ? 0xff : px[3];
+    }
+  }
+  return rgba;
+}
+
+// build the transmission command for pixels found at 'path', either a shared
+// memory object or a file
+static char*
+kitty_transmit_path(uint32_t id, int leny, int lenx, char medium,
+                    const char* path, size_t* glyphlen){
+  const size_t pathlen = strlen(path);
+  const size_t cap = 128 + 4 * ((pathlen + 2) / 3);
+  char* glyph = malloc(cap);
+  if(glyph == NULL){
+    return NULL;
+  }
+  int len = snprintf(glyph, cap, "\x1b_Ga=t,t=%c,f=32,s=%d,v=%d,S=%zu,i=%u,q=2;",
+                     medium, lenx, leny, (size_t)leny * lenx * 4, id);
+  len += base64((const unsigned char*)path, pathlen, glyph + len);
+  memcpy(glyph + len, "\x1b\\", 2);
+  *glyphlen = len + 2;
+  return glyph;
+}
+
+// write the pixels to a new shared memory object, returning its name
+static char*
+kitty_shm(uint32_t id, const unsigned char* rgba, size_t size){
+  char name[64];
+  snprintf(name, sizeof(name), "/notcurses-kitty-%d-%u", (int)getpid(), id);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if(fd < 0){
+    return NULL;
+  }
+  void* map = MAP_FAILED;
+  if(ftruncate(fd, size) == 0){
+    map = mmap(NULL, size, PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if(map == MAP_FAILED){
+    shm_unlink(name);
+    return NULL;
+  }
+  memcpy(map, rgba, size);
+  munmap(map, size);
+  return strdup(name);
+}
+
+// write the pixels to a new temporary file, returning its path. kitty will
+// only delete files whose names contain "tty-graphics-protocol".
+static char*
+kitty_file(const unsigned char* rgba, size_t size){
+  const char* tmpdir = getenv("TMPDIR");
+  if(tmpdir == NULL || *tmpdir == '\0'){
+    tmpdir = P_tmpdir;
+  }
+  const char tmpl[] = "/tty-graphics-protocol-notcurses-XXXXXX";
+  char* path = malloc(strlen(tmpdir) + sizeof(tmpl));
+  if(path == NULL){
+    return NULL;
+  }
+  strcpy(path, tmpdir);
+  strcat(path, tmpl);
+  int fd = mkstemp(path);
+  if(fd < 0){
+    free(path);
+    return NULL;
+  }
+  size_t written = 0;
+  while(written < size){
+    ssize_t w = write(fd, rgba + written, size - written);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      break;
+    }
+    written += w;
+  }
+  if(close(fd) || written < size){
+    unlink(path);
+    free(path);
+    return NULL;
+  }
+  return path;
+}
+
+// build the transmission command carrying the pixels themselves
+static char*
+kitty_transmit_direct(uint32_t id, int leny, int lenx,
+                      const unsigned char* rgba, size_t size, size_t* glyphlen){
+  const size_t b64len = 4 * ((size + 2) / 3);
+  const size_t chunks = (b64len + KITTY_CHUNK - 1) / KITTY_CHUNK;
+  const size_t cap = 128 + b64len + chunks * 16;
+  char* glyph = malloc(cap);
+  char* b64 = malloc(b64len);
+  if(glyph == NULL || b64 == NULL){
+    free(glyph);
+    free(b64);
+    return NULL;
+  }
+  base64(rgba, size, b64);
+  size_t len = snprintf(glyph, cap, "\x1b_Ga=t,f=32,s=%d,v=%d,i=%u,q=2,", lenx, leny, id);
+  for(size_t off = 0 ; off < b64len ; off += KITTY_CHUNK){
+    const size_t n = b64len - off < KITTY_CHUNK ? b64len - off : KITTY_CHUNK;
+    if(off){
+      memcpy(glyph + len, "\x1b_G", 3);
+      len += 3;
+    }
+    len += snprintf(glyph + len, cap - len, "m=%d;", off + n < b64len);
+    memcpy(glyph + len, b64 + off, n);
+    len += n;
+    memcpy(glyph + len, "\x1b\\", 2);
+    len += 2;
+  }
+  free(b64);
+  *glyphlen = len;
+  return glyph;
+}
+
+// remove the pixels we wrote for the terminal, which will never read them
+static void
+kittyimg_unlink(kittyimg* k){
+  if(k->path){
+    k->shm ? shm_unlink(k->path) : unlink(k->path);
+    free(k->path);
+    k->path = NULL;
+    k->shm = false;
+  }
+}
+
+kittyimg* kitty_encode(notcurses* nc, const void* data, int linesize, int begy,
+                       int begx, int leny, int lenx, bool bgr){
+  kittyimg* k = malloc(sizeof(*k));
+  unsigned char* rgba = kitty_rgba(data, linesize, begy, begx, leny, lenx, bgr);
+  if(k == NULL || rgba == NULL){
+    free(k);
+    free(rgba);
+    return NULL;
+  }
+  const size_t size = (size_t)leny * lenx * 4;
+  k->id = ++nc->sprixelid;
+  k->refs = 1;
+  k->glyph = NULL;
+  k->path = NULL;
+  k->shm = false;
+  // shared memory falls back to a file, which falls back to the tty
+  if(nc->kittymedium == KITTY_SHM){
+    if( (k->path = kitty_shm(k->id, rgba, size)) ){
+      k->shm = true;
+      k->glyph = kitty_transmit_path(k->id, leny, lenx, 's', k->path, &k->glyphlen);
+      if(k->glyph == NULL){
+        kittyimg_unlink(k);
+      }
+    }
+  }
+  if(k->glyph == NULL && nc->kittymedium != KITTY_DIRECT){
+    if( (k->path = kitty_file(rgba, size)) ){
+      k->glyph = kitty_transmit_path(k->id, leny, lenx, 't', k->path, &k->glyphlen);
+      if(k->glyph == NULL){
+        kittyimg_unlink(k);
+      }
+    }
+  }
+  if(k->glyph == NULL){
+    k->glyph = kitty_transmit_direct(k->id, leny, lenx, rgba, size, &k->glyphlen);
+  }
+  free(rgba);
+  if(k->glyph == NULL){
+    free(k);
+    return NULL;
+  }
+  return k;
+}
+
+void kittyimg_release(notcurses* nc, kittyimg* k){
+  if(--k->refs){
+    return;
+  }
+  if(k->glyph){
+    // never transmitted, so the terminal won't be removing our pixels
+    kittyimg_unlink(k);
+    free(k->glyph);
+  }else{
+    uint32_t* tmp = realloc(nc->kittyfrees, sizeof(*tmp) * (nc->kittyfreecount + 1));
+    if(tmp){
+      nc->kittyfrees = tmp;
+      nc->kittyfrees[nc->kittyfreecount++] = k->id;
+    }
+  }
+  free(k->path);
+  free(k);
+}
+
+int kitty_transmit(FILE* out, kittyimg* k){
+  if(k->glyph == NULL){
+    return 0;
+  }
+  int ret = fwrite(k->glyph, k->glyphlen, 1, out) == 1 ? 0 : -1;
+  free(k->glyph);
+  k->glyph = NULL;
+  // the terminal owns the pixels now
+  free(k->path);
+  k->path = NULL;
+  return ret;
+}
+
+int kitty_place(FILE* out, uint32_t imageid, uint32_t placeid){
+  return fprintf(out, "\x1b_Ga=p,i=%u,p=%u,C=1,q=2\x1b\\", imageid, placeid) < 0 ? -1 : 0;
+}
+
+int kitty_unplace(FILE* out, uint32_t imageid, uint32_t placeid){
+  return fprintf(out, "\x1b_Ga=d,d=i,i=%u,p=%u,q=2\x1b\\", imageid, placeid) < 0 ? -1 : 0;
+}
+
+int kitty_free_images(notcurses* nc, FILE* out){
+  int ret = 0;
+  for(int i = 0 ; i < nc->kittyfreecount ; ++i){
+    if(fprintf(out, "\x1b_Ga=d,d=I,i=%u,q=2\x1b\\", nc->kittyfrees[i]) < 0){
+      ret = -1;
+    }
+  }
+  nc->kittyfreecount = 0;
+  return ret;
+}
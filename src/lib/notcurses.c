@@ -189,14 +189,14 @@ char* ncplane_at_cursor(ncplane* n, uint32_t* attrword, uint64_t* channels){
   if(cursor_invalid_p(n)){
     return NULL;
   }
-  return cell_extract(n, &n->fb[nfbcellidx(n, n->y, n->x)], attrword, channels);
+  return cell_extract(n, ncplane_cell_const(n, n->y, n->x), attrword, channels);
 }
 
 char* ncplane_at_yx(const ncplane* n, int y, int x, uint32_t* attrword, uint64_t* channels){
   char* ret = NULL;
   if(y < n->leny && x < n->lenx){
     if(y >= 0 && x >= 0){
-      ret = cell_extract(n, &n->fb[nfbcellidx(n, y, x)], attrword, channels);
+      ret = cell_extract(n, ncplane_cell_const(n, y, x), attrword, channels);
     }
   }
   return ret;
@@ -205,7 +205,11 @@ char* ncplane_at_yx(const ncplane* n, int y, int x, uint32_t* attrword, uint64_t
 cell* ncplane_cell_ref_yx(ncplane* n, int y, int x){
   assert(y < n->leny);
   assert(x < n->lenx);
-  return &n->fb[nfbcellidx(n, y, x)];
+  cell* row = ncplane_fbrow(n, logical_to_virtual(n, y));
+  if(row == NULL){
+    return NULL;
+  }
+  return &row[x];
 }
 
 void ncplane_dim_yx(const ncplane* n, int* rows, int* cols){
@@ -219,7 +223,8 @@ void ncplane_dim_yx(const ncplane* n, int* rows, int* cols){
 
 // anyone calling this needs ensure the ncplane's framebuffer is updated
 // to reflect changes in geometry.
-int update_term_dimensions(int fd, int* rows, int* cols){
+int update_term_dimensions(int fd, int* rows, int* cols,
+                           int* cellpixy, int* cellpixx){
   struct winsize ws;
   int i = ioctl(fd, TIOCGWINSZ, &ws);
   if(i < 0){
@@ -237,16 +242,110 @@ int update_term_dimensions(int fd, int* rows, int* cols){
   if(cols){
     *cols = ws.ws_col;
   }
+  if(cellpixy){
+    *cellpixy = ws.ws_ypixel / ws.ws_row;
+  }
+  if(cellpixx){
+    *cellpixx = ws.ws_xpixel / ws.ws_col;
+  }
   return 0;
 }
 
+// allocate a tile of 'rows' zeroed rows of 'cols' cells, with a single
+// reference. stats.fbbytes counts each tile once, however widely shared.
+static fbtile*
+fbtile_create(notcurses* nc, int rows, int cols){
+  const size_t cellbytes = sizeof(cell) * rows * cols;
+  fbtile* t = malloc(sizeof(*t) + cellbytes);
+  if(t){
+    t->refcount = 1;
+    memset(t->cells, 0, cellbytes);
+    nc->stats.fbbytes += cellbytes;
+  }
+  return t;
+}
+
+// drop a reference to a tile of 'rows' rows of 'cols' cells, freeing it if
+// that was the last one.
+static void
+fbtile_release(notcurses* nc, fbtile* t, int rows, int cols){
+  if(t && --t->refcount == 0){
+    nc->stats.fbbytes -= sizeof(cell) * rows * cols;
+    free(t);
+  }
+}
+
+int fbtile_claim(ncplane* n, int t){
+  fbtile* shared = n->tiles[t];
+  if(shared == NULL){
+    if((n->tiles[t] = fbtile_create(n->nc, fbtile_rows(n->leny, t), n->lenx)) == NULL){
+      return -1;
+    }
+    return 0;
+  }
+  const size_t cellbytes = sizeof(cell) * fbtile_rows(n->leny, t) * n->lenx;
+  fbtile* priv = malloc(sizeof(*priv) + cellbytes);
+  if(priv == NULL){
+    return -1;
+  }
+  priv->refcount = 1;
+  memcpy(priv->cells, shared->cells, cellbytes);
+  --shared->refcount; // can't have been the last reference
+  n->nc->stats.fbbytes += cellbytes;
+  n->tiles[t] = priv;
+  return 0;
+}
+
+// release all tiles of a framebuffer of 'rows' x 'cols', leaving the vector
+// empty. NULL entries are skipped.
+static void
+fbtiles_clear(notcurses* nc, fbtile** tiles, int rows, int cols){
+  for(int t = 0 ; t < fbtile_count(rows) ; ++t){
+    fbtile_release(nc, tiles[t], fbtile_rows(rows, t), cols);
+    tiles[t] = NULL;
+  }
+}
+
+// release all tiles of a framebuffer of 'rows' x 'cols', and the vector
+// itself.
+static void
+fbtiles_release(notcurses* nc, fbtile** tiles, int rows, int cols){
+  if(tiles){
+    fbtiles_clear(nc, tiles, rows, cols);
+    free(tiles);
+  }
+}
+
+// allocate an empty framebuffer of 'rows' rows, as a vector of absent tiles.
+// tiles are only allocated once written (see fbtile_claim()).
+static fbtile**
+fbtiles_create(int rows){
+  return calloc(fbtile_count(rows), sizeof(fbtile*));
+}
+
+// take a new reference to each of the 'rows' rows' worth of tiles in 'tiles'.
+static fbtile**
+fbtiles_ref(fbtile* const* tiles, int rows){
+  const int tcount = fbtile_count(rows);
+  fbtile** ret = malloc(sizeof(*ret) * tcount);
+  if(ret){
+    for(int t = 0 ; t < tcount ; ++t){
+      if( (ret[t] = tiles[t]) ){
+        ++ret[t]->refcount;
+      }
+    }
+  }
+  return ret;
+}
+
 static void
 free_plane(ncplane* p){
   if(p){
     --p->nc->stats.planes;
-    p->nc->stats.fbbytes -= sizeof(*p->fb) * p->leny * p->lenx;
+    fbtiles_release(p->nc, p->tiles, p->leny, p->lenx);
+    free(p->zrow);
+    sprixel_detach(p);
     egcpool_dump(&p->pool);
-    free(p->fb);
     free(p);
   }
 }
@@ -265,13 +364,20 @@ ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
     return NULL;
   }
   ncplane* p = malloc(sizeof(*p));
-  size_t fbsize = sizeof(*p->fb) * (rows * cols);
-  if((p->fb = malloc(fbsize)) == NULL){
+  if(p == NULL){
+    return NULL;
+  }
+  if((p->tiles = fbtiles_create(rows)) == NULL){
+    free(p);
+    return NULL;
+  }
+  if((p->zrow = calloc(cols, sizeof(*p->zrow))) == NULL){
+    free(p->tiles);
     free(p);
     return NULL;
   }
-  memset(p->fb, 0, fbsize);
   p->scrolling = false;
+  p->sprite = NULL;
   p->userptr = NULL;
   p->leny = rows;
   p->lenx = cols;
@@ -305,7 +411,7 @@ ncplane_create(notcurses* nc, ncplane* n, int rows, int cols,
   }
   nc->top = p;
   p->nc = nc;
-  nc->stats.fbbytes += fbsize;
+  ncplane_invalidate(p);
   ++nc->stats.planes;
   return p;
 }
@@ -372,21 +478,175 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
   uint64_t chan = ncplane_channels(n);
   ncplane* newn = ncplane_create(n->nc, n->boundto, dimy, dimx, n->absy, n->absx, opaque);
   if(newn){
-    if(egcpool_dup(&newn->pool, &n->pool)){
+    // share the tiles and egcpool copy-on-write. this updates reference
+    // counts reachable from 'n', and the sharing state of its egcpool.
+    fbtile** tiles = fbtiles_ref(n->tiles, dimy);
+    if(tiles == NULL || egcpool_share(&newn->pool, (egcpool*)&n->pool)){
+      fbtiles_release(n->nc, tiles, dimy, dimx);
       ncplane_destroy(newn);
       return NULL;
     }else{
+      fbtiles_release(n->nc, newn->tiles, dimy, dimx);
+      newn->tiles = tiles;
+      newn->logrow = n->logrow;
       ncplane_cursor_move_yx(newn, n->y, n->x);
       newn->attrword = attr;
       newn->channels = chan;
-      memmove(newn->fb, n->fb, sizeof(*n->fb) * dimx * dimy);
-      // we dupd the egcpool, so just dup the goffset
+      // we share the egcpool, so just dup the goffset
       newn->basecell = n->basecell;
+      const sprixel* s = n->sprite;
+      if(s && s->kitty){
+        // the duplicate places the same image, rather than transmitting it anew
+        if(sprixel_attach_kitty(newn, s->kitty, s->y, s->x, s->dimy, s->dimx)){
+          ncplane_destroy(newn);
+          return NULL;
+        }
+      }else if(s){
+        char* glyph = memdup(s->glyph, s->glyphlen);
+        if(glyph == NULL || sprixel_attach(newn, glyph, s->glyphlen, s->y, s->x,
+                                           s->dimy, s->dimx)){
+          free(glyph);
+          ncplane_destroy(newn);
+          return NULL;
+        }
+      }
     }
   }
   return newn;
 }
 
+static sprixel*
+sprixel_create(ncplane* n, int y, int x, int dimy, int dimx){
+  sprixel* s = malloc(sizeof(*s));
+  if(s){
+    s->glyph = NULL;
+    s->glyphlen = 0;
+    s->kitty = NULL;
+    s->id = ++n->nc->sprixelid;
+    s->y = y;
+    s->x = x;
+    s->dimy = dimy;
+    s->dimx = dimx;
+  }
+  return s;
+}
+
+int sprixel_attach(ncplane* n, char* glyph, size_t glyphlen,
+                   int y, int x, int dimy, int dimx){
+  sprixel* s = sprixel_create(n, y, x, dimy, dimx);
+  if(s == NULL){
+    return -1;
+  }
+  s->glyph = glyph;
+  s->glyphlen = glyphlen;
+  sprixel_detach(n);
+  n->sprite = s;
+  return 0;
+}
+
+int sprixel_attach_kitty(ncplane* n, kittyimg* k, int y, int x, int dimy, int dimx){
+  sprixel* s = sprixel_create(n, y, x, dimy, dimx);
+  if(s == NULL){
+    return -1;
+  }
+  s->kitty = k;
+  ++k->refs;
+  sprixel_detach(n);
+  n->sprite = s;
+  return 0;
+}
+
+void sprixel_detach(ncplane* n){
+  if(n->sprite){
+    if(n->sprite->kitty){
+      kittyimg_release(n->nc, n->sprite->kitty);
+    }
+    free(n->sprite->glyph);
+    free(n->sprite);
+    n->sprite = NULL;
+  }
+}
+
+ncsnapshot* ncplane_snapshot(const ncplane* n){
+  ncsnapshot* s = malloc(sizeof(*s));
+  if(s == NULL){
+    return NULL;
+  }
+  if((s->tiles = fbtiles_ref(n->tiles, n->leny)) == NULL){
+    free(s);
+    return NULL;
+  }
+  egcpool_init(&s->pool);
+  if(egcpool_share(&s->pool, (egcpool*)&n->pool)){
+    fbtiles_release(n->nc, s->tiles, n->leny, n->lenx);
+    free(s);
+    return NULL;
+  }
+  s->leny = n->leny;
+  s->lenx = n->lenx;
+  s->logrow = n->logrow;
+  s->y = n->y;
+  s->x = n->x;
+  s->channels = n->channels;
+  s->attrword = n->attrword;
+  s->basecell = n->basecell;
+  s->nc = n->nc;
+  return s;
+}
+
+int ncplane_restore(ncplane* n, const ncsnapshot* s){
+  if(n->nc != s->nc){
+    return -1;
+  }
+  // the standard plane must always match the terminal's geometry
+  if(n == n->nc->stdscr && (n->leny != s->leny || n->lenx != s->lenx)){
+    return -1;
+  }
+  cell* zrow = NULL;
+  if(n->lenx != s->lenx){
+    if((zrow = calloc(s->lenx, sizeof(*zrow))) == NULL){
+      return -1;
+    }
+  }
+  fbtile** tiles = fbtiles_ref(s->tiles, s->leny);
+  if(tiles == NULL){
+    free(zrow);
+    return -1;
+  }
+  // a snapshot's pool is already marked shared unless it is empty, so this
+  // doesn't actually modify 's'.
+  if(egcpool_share(&n->pool, (egcpool*)&s->pool)){
+    fbtiles_release(n->nc, tiles, s->leny, s->lenx);
+    free(zrow);
+    return -1;
+  }
+  fbtiles_release(n->nc, n->tiles, n->leny, n->lenx);
+  n->tiles = tiles;
+  if(zrow){
+    free(n->zrow);
+    n->zrow = zrow;
+  }
+  sprixel_detach(n);
+  n->leny = s->leny;
+  n->lenx = s->lenx;
+  n->logrow = s->logrow;
+  n->y = s->y;
+  n->x = s->x;
+  n->channels = s->channels;
+  n->attrword = s->attrword;
+  n->basecell = s->basecell;
+  ncplane_invalidate(n);
+  return 0;
+}
+
+void ncsnapshot_destroy(ncsnapshot* s){
+  if(s){
+    fbtiles_release(s->nc, s->tiles, s->leny, s->lenx);
+    egcpool_dump(&s->pool);
+    free(s);
+  }
+}
+
 // can be used on stdscr, unlike ncplane_resize() which prohibits it.
 int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
                             int keeplenx, int yoff, int xoff, int ylen, int xlen){
@@ -414,12 +674,60 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
   // those elements we're retaining, zeroing out the rest. alternatively, if
   // we've shrunk, we will be filling the new structure.
   int keptarea = keepleny * keeplenx;
-  int newarea = ylen * xlen;
-  size_t fbsize = sizeof(cell) * newarea;
-  cell* fb = malloc(fbsize);
-  if(fb == NULL){
+  fbtile** tiles = fbtiles_create(ylen);
+  if(tiles == NULL){
     return -1;
   }
+  cell* zrow = NULL;
+  if(xlen != cols){
+    if((zrow = calloc(xlen, sizeof(*zrow))) == NULL){
+      free(tiles);
+      return -1;
+    }
+  }
+  if(keptarea){
+    // we currently have maxy rows of maxx cells each. we will be keeping rows
+    // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1.
+    // everything else is zerod out. the new framebuffer starts unrotated, so
+    // its logical and virtual rows coincide. absent source tiles needn't be
+    // copied, and complete tiles which line up with the new framebuffer at
+    // their full width are shared rather than copied.
+    // FIXME in dropping existing text, don't we need cell_release()?
+    int copyoff = xoff < 0 ? -xoff : 0;
+    int copylen = keeplenx;
+    if(copyoff + copylen > xlen){
+      copylen = xlen - copyoff;
+    }
+    const bool wholerows = xlen == cols && keepx == 0 && copyoff == 0 && copylen == cols;
+    const int endy = keepy + keepleny < ylen ? keepy + keepleny : ylen;
+    int itery = keepy;
+    while(itery < endy){
+      const int t = itery / NCTILE_ROWS;
+      const int trows = fbtile_rows(ylen, t);
+      const int vrow = logical_to_virtual(n, itery);
+      const fbtile* src = n->tiles[vrow / NCTILE_ROWS];
+      if(wholerows && itery % NCTILE_ROWS == 0 && itery + trows <= endy &&
+         vrow % NCTILE_ROWS == 0 && fbtile_rows(rows, vrow / NCTILE_ROWS) == trows){
+        if( (tiles[t] = (fbtile*)src) ){
+          ++tiles[t]->refcount;
+        }
+        itery += trows;
+        continue;
+      }
+      if(src){
+        if(tiles[t] == NULL){
+          if((tiles[t] = fbtile_create(n->nc, trows, xlen)) == NULL){
+            fbtiles_release(n->nc, tiles, ylen, xlen);
+            free(zrow);
+            return -1;
+          }
+        }
+        cell* targ = tiles[t]->cells + (itery % NCTILE_ROWS) * xlen + copyoff;
+        memcpy(targ, ncplane_cell_const(n, itery, keepx), sizeof(*targ) * copylen);
+      }
+      ++itery;
+    }
+  }
   // update the cursor, if it would otherwise be off-plane
   if(n->y >= ylen){
     n->y = ylen - 1;
@@ -427,57 +735,25 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx, int keepleny,
   if(n->x >= xlen){
     n->x = xlen - 1;
   }
-  cell* preserved = n->fb;
-  n->nc->stats.fbbytes -= sizeof(*preserved) * (rows * cols);
-  n->nc->stats.fbbytes += fbsize;
-  n->fb = fb;
   n->absy = n->absy + keepy - yoff;
   n->absx = n->absx + keepx - xoff;
   // if we're keeping nothing, dump the old egcspool. otherwise, we go ahead
   // and keep it. perhaps we ought compact it?
   if(keptarea == 0){ // keep nothing, resize/move only
-    memset(fb, 0, sizeof(*fb) * newarea);
     egcpool_dump(&n->pool);
-    n->lenx = xlen;
-    n->leny = ylen;
-    free(preserved);
-    return 0;
   }
-  // we currently have maxy rows of maxx cells each. we will be keeping rows
-  // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1. they
-  // will end up at keepy + yoff..keepy + keepleny - 1 + yoff and
-  // keepx + xoff..keepx + keeplenx - 1 + xoff. everything else is zerod out.
-  int itery;
-  // we'll prepare each cell in our new framebuffer with either zeroes or a copy
-  // from the old one.
-  int sourceline = keepy;
-  for(itery = 0 ; itery < ylen ; ++itery){
-    int copyoff = itery * xlen; // our target at any given time
-    // FIXME in memset()s here of existing text, don't we need cell_release()?
-    // if we have nothing copied to this line, zero it out in one go
-    if(itery < keepy || itery > keepy + keepleny - 1){
-      memset(fb + copyoff, 0, sizeof(*fb) * xlen);
-      continue;
-    }
-    // we do have something to copy, and zero, one, or two regions to zero out
-    int copied = 0;
-    if(xoff < 0){
-      memset(fb + copyoff, 0, sizeof(*fb) * -xoff);
-      copyoff += -xoff;
-      copied += -xoff;
-    }
-    const int sourceidx = nfbcellidx(n, sourceline, keepx);
-    memcpy(fb + copyoff, preserved + sourceidx, sizeof(*fb) * keeplenx);
-    copyoff += keeplenx;
-    copied += keeplenx;
-    if(xlen > copied){
-      memset(fb + copyoff, 0, sizeof(*fb) * (xlen - copied));
-    }
-    ++sourceline;
+  fbtiles_release(n->nc, n->tiles, rows, cols);
+  n->tiles = tiles;
+  if(zrow){
+    free(n->zrow);
+    n->zrow = zrow;
   }
+  // the graphic would need be cropped and moved along with the cells
+  sprixel_detach(n);
+  n->logrow = 0;
   n->lenx = xlen;
   n->leny = ylen;
-  free(preserved);
+  ncplane_invalidate(n);
   return 0;
 }
 
@@ -522,6 +798,40 @@ int ncplane_destroy(ncplane* ncp){
   return 0;
 }
 
+// terminfo has no capability for Sixel, and we can't yet query the terminal,
+// so we recognize those terminal types which always support it.
+static bool
+sixel_term_p(const char* termtype){
+  static const char* const sixelterms[] = {
+    "mlterm", "yaft", "foot", "contour", NULL,
+  };
+  if(termtype == NULL){
+    return false;
+  }
+  for(const char* const* t = sixelterms ; *t ; ++t){
+    if(strncmp(termtype, *t, strlen(*t)) == 0){
+      return true;
+    }
+  }
+  return false;
+}
+
+// likewise, the kitty graphics protocol is assumed only for kitty itself
+static bool
+kitty_term_p(const char* termtype){
+  return termtype && strncmp(termtype, "xterm-kitty", strlen("xterm-kitty")) == 0;
+}
+
+// shared memory and files are only visible to a terminal on this machine. a
+// terminal reached through ssh gets its images over the tty.
+static kittymedium_e
+kitty_medium(void){
+  if(getenv("SSH_CONNECTION") || getenv("SSH_CLIENT") || getenv("SSH_TTY")){
+    return KITTY_DIRECT;
+  }
+  return KITTY_SHM;
+}
+
 static int
 make_nonblocking(FILE* fp){
   int fd = fileno(fp);
@@ -571,6 +881,16 @@ stash_stats(notcurses* nc){
   nc->stashstats.bgemissions += nc->stats.bgemissions;
   nc->stashstats.defaultelisions += nc->stats.defaultelisions;
   nc->stashstats.defaultemissions += nc->stats.defaultemissions;
+  nc->stashstats.frames_decoded += nc->stats.frames_decoded;
+  nc->stashstats.frames_dropped += nc->stats.frames_dropped;
+  nc->stashstats.frames_late += nc->stats.frames_late;
+  nc->stashstats.decode_ns += nc->stats.decode_ns;
+  nc->stashstats.scale_ns += nc->stats.scale_ns;
+  nc->stashstats.blit_ns += nc->stats.blit_ns;
+  nc->stashstats.scalebuf_hits += nc->stats.scalebuf_hits;
+  nc->stashstats.scalebuf_misses += nc->stats.scalebuf_misses;
+  nc->stashstats.swsctx_hits += nc->stats.swsctx_hits;
+  nc->stashstats.swsctx_misses += nc->stats.swsctx_misses;
   // fbbytes aren't stashed
   reset_stats(&nc->stats);
 }
@@ -657,9 +977,6 @@ init_banner(const notcurses* nc){
            bprefix(nc->stats.fbbytes, 1, prefixbuf, 0),
            nc->tcache.colors, nc->tcache.RGBflag ? "direct" : "palette",
            __VERSION__, curses_version());
-#ifdef USE_SIXEL
-    printf("  libsixel " LIBSIXEL_VERSION "\n");
-#endif
 #ifdef USE_FFMPEG
     printf("  avformat %u.%u.%u avutil %u.%u.%u swscale %u.%u.%u\n",
           LIBAVFORMAT_VERSION_MAJOR, LIBAVFORMAT_VERSION_MINOR, LIBAVFORMAT_VERSION_MICRO,
@@ -766,6 +1083,7 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
   ret->stashstats.fbbytes = 0;
   reset_stats(&ret->stats);
   reset_stats(&ret->stashstats);
+  ret->epochs = 0;
   ret->ttyfp = outfp;
   ret->ownttyfp = own_outfp;
   ret->renderfp = opts->renderfp;
@@ -777,7 +1095,15 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
   ret->lastframe = NULL;
   ret->lfdimy = 0;
   ret->lfdimx = 0;
-  ret->libsixel = false;
+  ret->sixel = false;
+  ret->kitty = false;
+  ret->kittymedium = KITTY_DIRECT;
+  ret->sprixelid = 0;
+  ret->drawnsprites = NULL;
+  ret->kittyfrees = NULL;
+  ret->kittyfreecount = 0;
+  ret->drawnspritecount = 0;
+  ret->workers = NULL;
   egcpool_init(&ret->pool);
   if(make_nonblocking(ret->ttyinfp)){
     free(ret);
@@ -823,10 +1149,18 @@ notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
     goto err;
   }
   int dimy, dimx;
-  if(update_term_dimensions(ret->ttyfd, &dimy, &dimx)){
+  if(update_term_dimensions(ret->ttyfd, &dimy, &dimx,
+                            &ret->cellpixy, &ret->cellpixx)){
     goto err;
   }
+  if(ret->cellpixy <= 0 || ret->cellpixx <= 0){
+    ret->cellpixy = NCSIXEL_CELLPIXY;
+    ret->cellpixx = NCSIXEL_CELLPIXX;
+  }
   char* shortname_term = termname();
+  ret->sixel = (opts->flags & NCOPTION_SIXEL) || sixel_term_p(shortname_term);
+  ret->kitty = (opts->flags & NCOPTION_KITTY) || kitty_term_p(shortname_term);
+  ret->kittymedium = kitty_medium();
   char* longname_term = longname();
   if(!opts->suppress_banner){
     fprintf(stderr, "Term: %dx%d %s (%s)\n", dimy, dimx,
@@ -900,6 +1234,12 @@ void notcurses_drop_planes(notcurses* nc){
 int notcurses_stop(notcurses* nc){
   int ret = 0;
   if(nc){
+    // kitty images must be deleted while still on the screen holding them
+    for(ncplane* p = nc->top ; p ; p = p->below){
+      sprixel_detach(p);
+    }
+    ret |= kitty_free_images(nc, nc->ttyfp);
+    ret |= fflush(nc->ttyfp);
     ret |= notcurses_stop_minimal(nc);
     while(nc->top){
       ncplane* p = nc->top->below;
@@ -911,6 +1251,9 @@ int notcurses_stop(notcurses* nc){
     }
     egcpool_dump(&nc->pool);
     free(nc->lastframe);
+    free(nc->drawnsprites);
+    free(nc->kittyfrees);
+    workerpool_destroy(nc->workers);
     free(nc->rstate.mstream);
     input_free_esctrie(&nc->inputescapes);
     stash_stats(nc);
@@ -962,6 +1305,27 @@ int notcurses_stop(notcurses* nc){
                 (nc->stashstats.cellemissions + nc->stashstats.cellelisions) == 0 ? 0 :
                 (nc->stashstats.cellelisions * 100.0) / (nc->stashstats.cellemissions + nc->stashstats.cellelisions));
       }
+      if(nc->stashstats.frames_decoded){
+        char decodebuf[BPREFIXSTRLEN + 1];
+        char scalebuf[BPREFIXSTRLEN + 1];
+        char blitbuf[BPREFIXSTRLEN + 1];
+        const uint64_t frames = nc->stashstats.frames_decoded;
+        qprefix(nc->stashstats.decode_ns / frames, NANOSECS_IN_SEC, decodebuf, 0);
+        qprefix(nc->stashstats.scale_ns / frames, NANOSECS_IN_SEC, scalebuf, 0);
+        qprefix(nc->stashstats.blit_ns / frames, NANOSECS_IN_SEC, blitbuf, 0);
+        fprintf(stderr, "%ju frame%s streamed, %ju dropped, %ju late (%ss decode, %ss scale, %ss blit avg)\n",
+                frames, frames == 1 ? "" : "s", nc->stashstats.frames_dropped,
+                nc->stashstats.frames_late, decodebuf, scalebuf, blitbuf);
+      }
+      const uint64_t bufs = nc->stashstats.scalebuf_hits + nc->stashstats.scalebuf_misses;
+      const uint64_t ctxs = nc->stashstats.swsctx_hits + nc->stashstats.swsctx_misses;
+      if(bufs || ctxs){
+        fprintf(stderr, "Scale buffers reused: %ju/%ju (%.2f%%) contexts reused: %ju/%ju (%.2f%%)\n",
+                nc->stashstats.scalebuf_hits, bufs,
+                bufs == 0 ? 0 : (nc->stashstats.scalebuf_hits * 100.0) / bufs,
+                nc->stashstats.swsctx_hits, ctxs,
+                ctxs == 0 ? 0 : (nc->stashstats.swsctx_hits * 100.0) / ctxs);
+      }
     }
     del_curterm(cur_term);
     free(nc);
@@ -1165,20 +1529,39 @@ cell_obliterate(ncplane* n, cell* c){
   cell_init(c);
 }
 
+// rotate the framebuffer up 'count' lines in a single step, clearing the
+// rows which are recycled. the cursor is not moved.
+static int
+scroll_rows(ncplane* n, int count){
+  for(int y = 0 ; y < count && y < n->leny ; ++y){
+    const int vrow = logical_to_virtual(n, y);
+    // an absent tile is already blank, and needn't be allocated to clear it
+    if(n->tiles[vrow / NCTILE_ROWS]){
+      cell* row = ncplane_fbrow(n, vrow);
+      if(row == NULL){
+        return -1;
+      }
+      for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
+        cell_release(n, &row[clearx]);
+      }
+      memset(row, 0, sizeof(*row) * n->lenx);
+    }
+  }
+  n->logrow = (n->logrow + count) % n->leny;
+  sprixel_detach(n);
+  ncplane_invalidate(n);
+  return 0;
+}
+
 // increment y by 1 and rotate the framebuffer up one line. x moves to 0.
-static inline void
+static inline int
 scroll_down(ncplane* n){
   n->x = 0;
   if(n->y == n->leny - 1){
-    n->logrow = (n->logrow + 1) % n->leny;
-    cell* row = n->fb + nfbcellidx(n, n->y, 0);
-    for(int clearx = 0 ; clearx < n->lenx ; ++clearx){
-      cell_release(n, &row[clearx]);
-    }
-    memset(row, 0, sizeof(*row) * n->lenx);
-  }else{
-    ++n->y;
+    return scroll_rows(n, 1);
   }
+  ++n->y;
+  return 0;
 }
 
 int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
@@ -1189,28 +1572,33 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
     if(!n->scrolling){
       return -1;
     }
-    scroll_down(n);
+    if(scroll_down(n)){
+      return -1;
+    }
   }
   if(ncplane_cursor_move_yx(n, y, x)){
     return -1;
   }
   if(c->gcluster == '\n'){
     if(n->scrolling){
-      scroll_down(n);
-      return 0;
+      return scroll_down(n);
     }
   }
   // A wide character obliterates anything to its immediate right (and marks
   // that cell as wide). Any character placed atop one half of a wide character
   // obliterates the other half. Note that a wide char can thus obliterate two
   // wide chars, totalling four columns.
-  cell* targ = ncplane_cell_ref_yx(n, n->y, n->x);
+  cell* row = ncplane_fbrow(n, logical_to_virtual(n, n->y));
+  if(row == NULL){
+    return -1;
+  }
+  cell* targ = &row[n->x];
   if(n->x > 0){
     if(cell_double_wide_p(targ)){ // replaced cell is half of a wide char
       if(targ->gcluster == 0){ // we're the right half
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x - 1)]);
+        cell_obliterate(n, &row[n->x - 1]);
       }else{
-        cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 1)]);
+        cell_obliterate(n, &row[n->x + 1]);
       }
     }
   }
@@ -1221,10 +1609,10 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const cell* c){
   if(wide){ // must set our right wide, and check for further damage
     ++cols;
     if(n->x < n->lenx - 1){ // check to our right
-      cell* candidate = &n->fb[nfbcellidx(n, n->y, n->x + 1)];
+      cell* candidate = &row[n->x + 1];
       if(n->x < n->lenx - 2){
         if(cell_wide_left_p(candidate)){
-          cell_obliterate(n, &n->fb[nfbcellidx(n, n->y, n->x + 2)]);
+          cell_obliterate(n, &row[n->x + 2]);
         }
       }
       cell_obliterate(n, candidate);
@@ -1250,10 +1638,168 @@ int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, int* sbytes)
   return ret;
 }
 
+// ncplane_putegc_yx() for an EGC at the start of the 'len' bytes at 'gclust',
+// which needn't be NUL-terminated. the EGC is copied out, so that nothing
+// beyond it is ever examined (the buffer might end partway through a
+// character following it). it's copied to the stack unless it's unusually
+// long. if the buffer holds no complete EGC (it ends partway through its
+// first character), nothing is written, and 0 bytes are consumed.
+static int
+ncplane_putnegc_yx(ncplane* n, int y, int x, const char* gclust, size_t len,
+                   int* sbytes){
+  int cols;
+  const int bytes = utf8_egc_nlen(gclust, len, &cols);
+  if(bytes <= 0){
+    *sbytes = bytes;
+    return bytes;
+  }
+  char egcbuf[128];
+  char* egc = egcbuf;
+  if((size_t)bytes >= sizeof(egcbuf)){
+    if((egc = malloc(bytes + 1)) == NULL){
+      *sbytes = -1;
+      return -1;
+    }
+  }
+  memcpy(egc, gclust, bytes);
+  egc[bytes] = '\0';
+  const int ret = ncplane_putegc_yx(n, y, x, egc, sbytes);
+  if(egc != egcbuf){
+    free(egc);
+  }
+  return ret;
+}
+
+// the progress of a dry run of cursor-driven output onto a scrolling plane.
+typedef struct scrollsim {
+  size_t offset;   // bytes consumed
+  int y, x;        // cursor
+  int scrolls;     // times the plane would have been rotated
+  int advances;    // calls to scroll_down(), whether or not they rotated
+} scrollsim;
+
+// advance 's' through the 'len' bytes at 'gclusters' exactly as
+// ncplane_putc_yx() would move the cursor of the scrolling plane 'n', without
+// writing anything. stops early at a NUL, at a character cut off by the end
+// of the buffer (where the real write stops), at invalid UTF-8 (where the
+// real write will fail), or having completed 'stoplines' lines. in the last case,
+// the cursor is at the start of a row, and 'offset' at the next EGC to write.
+static void
+scrollsim_run(const ncplane* n, const char* gclusters, size_t len,
+              scrollsim* s, int stoplines){
+  while(s->offset < len && s->advances < stoplines){
+    int cols;
+    const int bytes = utf8_egc_nlen(gclusters + s->offset, len - s->offset, &cols);
+    if(bytes <= 0){
+      return;
+    }
+    const bool wide = bytes > 1 && cols > 1;
+    if(s->x + wide >= n->lenx){
+      s->x = 0;
+      s->scrolls += s->y == n->leny - 1;
+      s->y += s->y < n->leny - 1;
+      if(++s->advances == stoplines){
+        return; // the EGC is written at the start of the new row
+      }
+    }
+    s->offset += bytes;
+    if(gclusters[s->offset - bytes] == '\n' && bytes == 1){
+      s->x = 0;
+      s->scrolls += s->y == n->leny - 1;
+      s->y += s->y < n->leny - 1;
+      ++s->advances;
+    }else{
+      s->x += wide ? 2 : 1;
+    }
+  }
+}
+
+// when a large chunk of text is about to be written at the cursor of the
+// scrolling plane 'n', most of it might scroll away before the write is
+// complete. determine where the plane will end up, rotate it there in a
+// single step, and return via 'skip' the number of leading bytes whose output
+// would not have survived. the remaining output then never rotates the plane.
+static int
+scroll_bulk(ncplane* n, const char* gclusters, size_t len, size_t* skip){
+  *skip = 0;
+  // don't bother unless at least a screenful might scroll by
+  int newlines = 0;
+  const char* nl = gclusters;
+  while(newlines < n->leny && (nl = memchr(nl, '\n', len - (nl - gclusters)))){
+    ++newlines;
+    ++nl;
+  }
+  if(newlines < n->leny && len < (size_t)n->lenx * n->leny){
+    return 0;
+  }
+  if(n->lenx < 2){ // wide EGCs can't be wrapped, and thus can't be simulated
+    return 0;
+  }
+  scrollsim s = { .offset = 0, .y = n->y, .x = n->x, .scrolls = 0, .advances = 0, };
+  scrollsim_run(n, gclusters, len, &s, INT_MAX);
+  const int scrolls = s.scrolls;
+  if(scrolls == 0){
+    return 0;
+  }
+  // output made while the cursor's absolute line (its row plus the number of
+  // lines completed) was below 'scrolls' is on rows which scroll away.
+  int y = n->y - scrolls;
+  int x = n->x;
+  if(y < 0){
+    s = (scrollsim){ .offset = 0, .y = n->y, .x = n->x, .scrolls = 0, .advances = 0, };
+    scrollsim_run(n, gclusters, len, &s, scrolls - n->y);
+    *skip = s.offset;
+    y = 0;
+    x = 0;
+  }
+  if(scrolls >= n->leny){ // everything is recycled, including the pool
+    ncplane_erase(n);
+  }else if(scroll_rows(n, scrolls)){
+    *skip = 0;
+    return -1;
+  }
+  n->y = y;
+  n->x = x;
+  return 0;
+}
+
+int ncplane_putnstr_yx(ncplane* n, int y, int x, size_t s, const char* gclusters){
+  size_t offset = 0;
+  int wcs;
+  // the first EGC might be explicitly placed; after it, let the cursor code
+  // control where we print, so that scrolling is taken into account
+  if(y != -1 || x != -1){
+    if(s == 0 || *gclusters == '\0'){
+      return 0;
+    }
+    if(ncplane_putnegc_yx(n, y, x, gclusters, s, &wcs) < 0 || wcs == 0){
+      return 0;
+    }
+    offset += wcs;
+  }
+  if(n->scrolling && offset < s){
+    size_t skip;
+    if(scroll_bulk(n, gclusters + offset, s - offset, &skip)){
+      return -(int)offset;
+    }
+    offset += skip;
+  }
+  while(offset < s && gclusters[offset]){
+    if(ncplane_putnegc_yx(n, -1, -1, gclusters + offset, s - offset, &wcs) < 0){
+      return -(int)offset;
+    }
+    if(wcs == 0){ // the buffer ends partway through a character
+      break;
+    }
+    offset += wcs;
+  }
+  return offset;
+}
+
 int ncplane_putsimple_stainable(ncplane* n, char c){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putsimple(n, c);
@@ -1265,7 +1811,7 @@ int ncplane_putsimple_stainable(ncplane* n, char c){
 int ncplane_putwegc_stainable(ncplane* n, const wchar_t* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putwegc(n, gclust, sbytes);
@@ -1277,7 +1823,7 @@ int ncplane_putwegc_stainable(ncplane* n, const wchar_t* gclust, int* sbytes){
 int ncplane_putegc_stainable(ncplane* n, const char* gclust, int* sbytes){
   uint64_t channels = n->channels;
   uint32_t attrword = n->attrword;
-  const cell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* targ = ncplane_cell_const(n, n->y, n->x);
   n->channels = targ->channels;
   n->attrword = targ->attrword;
   int ret = ncplane_putegc(n, gclust, sbytes);
@@ -1290,7 +1836,7 @@ int ncplane_cursor_at(const ncplane* n, cell* c, char** gclust){
   if(n->y == n->leny && n->x == n->lenx){
     return -1;
   }
-  const cell* src = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const cell* src = ncplane_cell_const(n, n->y, n->x);
   memcpy(c, src, sizeof(*src));
   *gclust = NULL;
   if(!cell_simple_p(src)){
@@ -1705,7 +2251,10 @@ void ncplane_erase(ncplane* n){
   // wiped out by the egcpool_dump(). do a duplication (to get the attrword
   // and channels), and then reload.
   char* egc = cell_egc_copy(n, &n->basecell);
-  memset(n->fb, 0, sizeof(*n->fb) * n->lenx * n->leny);
+  fbtiles_clear(n->nc, n->tiles, n->leny, n->lenx);
+  n->logrow = 0;
+  sprixel_detach(n);
+  ncplane_invalidate(n);
   egcpool_dump(&n->pool);
   egcpool_init(&n->pool);
   // we need to zero out the EGC before handing this off to cell_load, but
@@ -1774,7 +2323,11 @@ bool notcurses_canchangecolor(const notcurses* nc){
 }
 
 bool notcurses_cansixel(const notcurses* nc){
-  return nc->libsixel;
+  return nc->sixel;
+}
+
+bool notcurses_cankitty(const notcurses* nc){
+  return nc->kitty;
 }
 
 palette256* palette256_new(notcurses* nc){
@@ -1905,6 +2458,25 @@ int notcurses_lex_scalemode(const char* op, ncscale_e* scalemode){
   return 0;
 }
 
+int notcurses_lex_scalequality(const char* op, ncscalequality_e* quality){
+  if(strcasecmp(op, "default") == 0){
+    *quality = NCSCALEQ_DEFAULT;
+  }else if(strcasecmp(op, "fast") == 0){
+    *quality = NCSCALEQ_FAST;
+  }else if(strcasecmp(op, "area") == 0){
+    *quality = NCSCALEQ_AREA;
+  }else if(strcasecmp(op, "bicubic") == 0){
+    *quality = NCSCALEQ_BICUBIC;
+  }else if(strcasecmp(op, "lanczos") == 0){
+    *quality = NCSCALEQ_LANCZOS;
+  }else if(strcasecmp(op, "box") == 0){
+    *quality = NCSCALEQ_BOX;
+  }else{
+    return -1;
+  }
+  return 0;
+}
+
 int notcurses_lex_margins(const char* op, notcurses_options* opts){
   char* eptr;
   if(lex_long(op, &opts->margin_t, &eptr)){
@@ -1933,114 +2505,175 @@ int notcurses_inputready_fd(notcurses* n){
   return fileno(n->ttyinfp);
 }
 
-uint32_t* ncplane_rgba(const ncplane* nc, int begy, int begx, int leny, int lenx){
+// validate a region specification against the plane 'nc', resolving -1
+// lengths to "through the boundary of the plane". returns -1 if the region
+// does not lie wholly on the plane.
+static int
+plane_region(const ncplane* nc, int begy, int begx, int* leny, int* lenx){
   if(begy < 0 || begx < 0){
-    return NULL;
+    return -1;
   }
   if(begx >= nc->lenx || begy >= nc->leny){
-    return NULL;
+    return -1;
   }
-  if(lenx == -1){ // -1 means "to the end"; use all space available
-    lenx = nc->lenx - begx;
+  if(*lenx == -1){ // -1 means "to the end"; use all space available
+    *lenx = nc->lenx - begx;
   }
-  if(leny == -1){
-    leny = nc->leny - begy;
+  if(*leny == -1){
+    *leny = nc->leny - begy;
   }
-  if(lenx < 0 || leny < 0){ // no need to draw zero-size object, exit
-    return NULL;
+  if(*lenx < 0 || *leny < 0){ // no need to draw zero-size object, exit
+    return -1;
+  }
+  if(begx + *lenx > nc->lenx || begy + *leny > nc->leny){
+    return -1;
+  }
+  return 0;
+}
+
+// the glyphs ncplane_rgba() knows how to decompose into two pixels. we look
+// at the bytes in the pool directly, rather than copying the EGC out and
+// running it through strcmp() against each candidate.
+typedef enum {
+  RGBA_INVALID,
+  RGBA_EMPTY,     // ' ' or the empty EGC: both pixels are background
+  RGBA_LOWERHALF, // "▄": foreground on the bottom
+  RGBA_UPPERHALF, // "▀": foreground on top
+  RGBA_FULL,      // "█": both pixels are foreground
+} rgba_glyph_e;
+
+static inline rgba_glyph_e
+rgba_glyph(const egcpool* pool, const cell* c){
+  if(cell_simple_p(c)){
+    if(c->gcluster == 0 || c->gcluster == ' '){
+      return RGBA_EMPTY;
+    }
+    return RGBA_INVALID;
   }
-  if(begx + lenx > nc->lenx || begy + leny > nc->leny){
+  // all three are U+258x, encoded as e2 96 8x
+  const unsigned char* egc = (const unsigned char*)egcpool_extended_gcluster(pool, c);
+  if(egc[0] != 0xe2 || egc[1] != 0x96 || egc[3]){
+    return RGBA_INVALID;
+  }
+  switch(egc[2]){
+    case 0x84: return RGBA_LOWERHALF;
+    case 0x80: return RGBA_UPPERHALF;
+    case 0x88: return RGBA_FULL;
+  }
+  return RGBA_INVALID;
+}
+
+int ncplane_rgba_buf(const ncplane* nc, int begy, int begx, int leny, int lenx,
+                     uint32_t* rgba){
+  if(plane_region(nc, begy, begx, &leny, &lenx)){
+    return -1;
+  }
+  for(int y = begy, targy = 0 ; y < begy + leny ; ++y, targy += 2){
+    // each row is contiguous in the framebuffer, even when scrolled
+    const cell* c = ncplane_cell_const(nc, y, begx);
+    uint32_t* top = &rgba[targy * lenx];
+    uint32_t* bot = &rgba[(targy + 1) * lenx];
+    for(int targx = 0 ; targx < lenx ; ++targx, ++c){
+      // FIXME what if there's a wide glyph to the left of the selection?
+      unsigned fr, fg, fb, br, bg, bb;
+      channels_fg_rgb(c->channels, &fr, &fb, &fg);
+      channels_bg_rgb(c->channels, &br, &bb, &bg);
+      // FIXME how do we deal with transparency?
+      uint32_t frgba = (fr) + (fg << 8u) + (fb << 16u) + 0xff000000;
+      uint32_t brgba = (br) + (bg << 8u) + (bb << 16u) + 0xff000000;
+      switch(rgba_glyph(&nc->pool, c)){
+        case RGBA_EMPTY:
+          top[targx] = bot[targx] = brgba;
+          break;
+        case RGBA_LOWERHALF:
+          top[targx] = brgba;
+          bot[targx] = frgba;
+          break;
+        case RGBA_UPPERHALF:
+          top[targx] = frgba;
+          bot[targx] = brgba;
+          break;
+        case RGBA_FULL:
+          top[targx] = bot[targx] = frgba;
+          break;
+        default:
+          return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+uint32_t* ncplane_rgba(const ncplane* nc, int begy, int begx, int leny, int lenx){
+  if(plane_region(nc, begy, begx, &leny, &lenx)){
     return NULL;
   }
   uint32_t* ret = malloc(sizeof(*ret) * lenx * leny * 2);
   if(ret){
-    for(int y = begy, targy = 0 ; y < begy + leny ; ++y, targy += 2){
-      for(int x = begx, targx = 0 ; x < begx + lenx ; ++x, ++targx){
-        // FIXME what if there's a wide glyph to the left of the selection?
-        uint32_t attrword;
-        uint64_t channels;
-        char* c = ncplane_at_yx(nc, y, x, &attrword, &channels);
-        if(c == NULL){
-          free(ret);
-          return NULL;
-        }
-        uint32_t* top = &ret[targy * lenx + targx];
-        uint32_t* bot = &ret[(targy + 1) * lenx + targx];
-        unsigned fr, fg, fb, br, bg, bb;
-        channels_fg_rgb(channels, &fr, &fb, &fg);
-        channels_bg_rgb(channels, &br, &bb, &bg);
-        // FIXME how do we deal with transparency?
-        uint32_t frgba = (fr) + (fg << 8u) + (fb << 16u) + 0xff000000;
-        uint32_t brgba = (br) + (bg << 8u) + (bb << 16u) + 0xff000000;
-        if((strcmp(c, " ") == 0) || (strcmp(c, "") == 0)){
-          *top = *bot = brgba;
-        }else if(strcmp(c, "▄") == 0){
-          *top = frgba;
-          *bot = brgba;
-        }else if(strcmp(c, "▀") == 0){
-          *top = brgba;
-          *bot = frgba;
-        }else if(strcmp(c, "█") == 0){
-          *top = *bot = frgba;
-        }else{
-          free(c);
-          free(ret);
-          return NULL;
-        }
-        free(c);
-      }
+    if(ncplane_rgba_buf(nc, begy, begx, leny, lenx, ret)){
+      free(ret);
+      return NULL;
     }
   }
   return ret;
 }
 
-char* ncplane_contents(const ncplane* nc, int begy, int begx, int leny, int lenx){
-  if(begy < 0 || begx < 0){
-    return NULL;
-  }
-  if(begx >= nc->lenx || begy >= nc->leny){
-    return NULL;
+int ncplane_contents_buf(const ncplane* nc, int begy, int begx, int leny,
+                         int lenx, char* buf, size_t buflen){
+  if(plane_region(nc, begy, begx, &leny, &lenx)){
+    return -1;
   }
-  if(lenx == -1){ // -1 means "to the end"; use all space available
-    lenx = nc->lenx - begx;
+  size_t needed = 0;  // bytes required for the entire region
+  size_t written = 0; // bytes actually written to 'buf'
+  for(int y = begy ; y < begy + leny ; ++y){
+    // each row is contiguous in the framebuffer, even when scrolled
+    const cell* c = ncplane_cell_const(nc, y, begx);
+    for(int x = 0 ; x < lenx ; ++x, ++c){
+      const char* egc;
+      size_t clen;
+      char simple;
+      if(cell_simple_p(c)){
+        if(c->gcluster == 0){
+          continue;
+        }
+        simple = c->gcluster;
+        egc = &simple;
+        clen = 1;
+      }else{
+        egc = egcpool_extended_gcluster(&nc->pool, c);
+        clen = strlen(egc);
+      }
+      // only ever write whole EGCs, leaving room for the NUL terminator
+      if(written == needed && needed + clen < buflen){
+        memcpy(buf + written, egc, clen);
+        written += clen;
+      }
+      needed += clen;
+    }
   }
-  if(leny == -1){
-    leny = nc->leny - begy;
+  if(needed > INT_MAX){
+    return -1;
   }
-  if(lenx < 0 || leny < 0){ // no need to draw zero-size object, exit
-    return NULL;
+  if(buflen){
+    buf[written] = '\0';
   }
-  if(begx + lenx > nc->lenx || begy + leny > nc->leny){
+  return needed;
+}
+
+char* ncplane_contents(const ncplane* nc, int begy, int begx, int leny, int lenx){
+  if(plane_region(nc, begy, begx, &leny, &lenx)){
     return NULL;
   }
-  size_t retlen = 1;
+  // simple cells contribute at most one byte apiece, and complex cells no
+  // more than the pool bytes they occupy, so this bound is never exceeded.
+  size_t retlen = (size_t)leny * lenx + nc->pool.poolused + 1;
   char* ret = malloc(retlen);
   if(ret){
-    for(int y = begy, targy = 0 ; y < begy + leny ; ++y, targy += 2){
-      for(int x = begx, targx = 0 ; x < begx + lenx ; ++x, ++targx){
-        uint32_t attrword;
-        uint64_t channels;
-        char* c = ncplane_at_yx(nc, y, x, &attrword, &channels);
-        if(!c){
-          free(ret);
-          return NULL;
-        }
-        size_t clen = strlen(c);
-        if(clen){
-          char* tmp = realloc(ret, retlen + clen);
-          if(!tmp){
-            free(c);
-            free(ret);
-            return NULL;
-          }
-          ret = tmp;
-          memcpy(ret + retlen - 1, c, clen);
-          retlen += clen;
-        }
-        free(c);
-      }
+    int r = ncplane_contents_buf(nc, begy, begx, leny, lenx, ret, retlen);
+    if(r < 0 || (size_t)r >= retlen){
+      free(ret);
+      return NULL;
     }
-    ret[retlen - 1] = '\0';
   }
   return ret;
 }
@@ -1,5 +1,7 @@
 #include "version.h"
 #ifdef USE_OIIO
+#include <cerrno>
+#include <unistd.h>
 #include "oiio.h"
 #include "internal.h"
 #include "visual-details.h"
@@ -12,14 +14,111 @@ bool notcurses_canopen_videos(const notcurses* nc __attribute__ ((unused))) {
   return false; // too slow for reliable use at the moment
 }
 
-ncvisual* ncvisual_from_file(const char* filename, nc_err_e* err) {
+bool ncvisual_still_p(const ncvisual* ncv) {
+  if(!ncv->details.image){
+    return false;
+  }
+  if(!ncv->details.image->supports("multiimage")){
+    return true;
+  }
+  const auto &spec = ncv->details.image->spec();
+  return spec.get_int_attribute("oiio:subimages", 0) == 1 &&
+         !spec.get_int_attribute("oiio:Movie", 0);
+}
+
+// the RGBA image, and the frame as read, if that's since been scaled away
+auto ncvisual_bytes(const ncvisual* ncv) -> size_t {
+  size_t bytes = ncv->data ? static_cast<size_t>(ncv->rows) * ncv->rowstride : 0;
+  if(ncv->details.frame && ncv->details.image &&
+     ncv->data != ncv->details.frame.get()){
+    const auto &spec = ncv->details.image->spec();
+    bytes += static_cast<size_t>(spec.width) * spec.height * 4;
+  }
+  return bytes;
+}
+
+// OIIO selects its reader by extension, which a buffer lacks. recognize the
+// common formats by their magic.
+static const char*
+oiio_extension(const unsigned char* data, size_t len){
+  static const struct {
+    const char* magic;
+    size_t len;
+    const char* ext;
+  } magics[] = {
+    { "\x89PNG\r\n\x1a\n", 8, "png", },
+    { "\xff\xd8\xff", 3, "jpg", },
+    { "GIF8", 4, "gif", },
+    { "BM", 2, "bmp", },
+    { "II*\0", 4, "tif", },
+    { "MM\0*", 4, "tif", },
+  };
+  for(const auto& m : magics){
+    if(len >= m.len && memcmp(data, m.magic, m.len) == 0){
+      return m.ext;
+    }
+  }
+  if(len >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0){
+    return "webp";
+  }
+  return nullptr;
+}
+
+// the entirety of what can be read from 'fd'
+static bool
+oiio_slurp(int fd, std::vector<unsigned char>& buf){
+  unsigned char chunk[65536];
+  ssize_t r;
+  while((r = read(fd, chunk, sizeof(chunk))) != 0){
+    if(r < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return false;
+    }
+    buf.insert(buf.end(), chunk, chunk + r);
+  }
+  return true;
+}
+
+// open 'src', which isn't a file, through an IOProxy. OIIO readers seek
+// freely, so a descriptor (which might be a pipe) is read to its end first.
+static std::unique_ptr<OIIO::ImageInput>
+oiio_open_proxied(ncvisual_details* deets, const ncvsource* src){
+  const unsigned char* data = src->data;
+  size_t len = src->len;
+  if(data == nullptr){
+    if(!oiio_slurp(src->fd, deets->slurped)){
+      return nullptr;
+    }
+    data = deets->slurped.data();
+    len = deets->slurped.size();
+  }
+  const char* ext = oiio_extension(data, len);
+  if(ext == nullptr){
+    return nullptr;
+  }
+  deets->proxy = std::make_unique<OIIO::Filesystem::IOMemReader>(const_cast<unsigned char*>(data), len);
+  OIIO::ImageSpec config;
+  void* proxy = deets->proxy.get();
+  config.attribute("oiio:ioproxy", OIIO::TypeDesc::PTR, &proxy);
+  return OIIO::ImageInput::open(std::string("memory.") + ext, &config);
+}
+
+ncvisual* ncvisual_open(const ncvsource* src, nc_err_e* err, int rows,
+                        int cols, bool* reduced) {
   *err = NCERR_SUCCESS;
+  *reduced = false;
   ncvisual* ncv = ncvisual_create();
   if(ncv == nullptr){
     *err = NCERR_NOMEM;
     return nullptr;
   }
-  ncv->details.image = OIIO::ImageInput::open(filename);
+  if(src->path){
+    ncv->details.image = OIIO::ImageInput::open(src->path);
+  }else{
+    ncv->details.image = oiio_open_proxied(&ncv->details, src);
+  }
   if(!ncv->details.image){
     // fprintf(stderr, "Couldn't create %s (%s)\n", filename, strerror(errno));
     *err = NCERR_DECODE;
@@ -29,6 +128,19 @@ ncvisual* ncvisual_from_file(const char* filename, nc_err_e* err) {
 /*const auto &spec = ncv->details.image->spec_dimensions(0);
 std::cout << "Opened " << filename << ": " << spec.height << "x" <<
 spec.width << "@" << spec.nchannels << " (" << spec.format << ")" << std::endl;*/
+  // use the smallest MIP level still covering the requested geometry. the
+  // subimages of multiimage files are frames, and needn't share MIP levels.
+  if((rows > 0 || cols > 0) && ncvisual_still_p(ncv)){
+    for(int m = 1 ; ; ++m){
+      const auto mspec = ncv->details.image->spec_dimensions(0, m);
+      if(mspec.width <= 0 || mspec.height <= 0 ||
+         mspec.width < cols || mspec.height < rows){
+        break;
+      }
+      ncv->details.miplevel = m;
+    }
+    *reduced = ncv->details.miplevel > 0;
+  }
   if((*err = ncvisual_decode(ncv)) != NCERR_SUCCESS){
     ncvisual_destroy(ncv);
     return nullptr;
@@ -37,12 +149,18 @@ spec.width << "@" << spec.nchannels << " (" << spec.format << ")" << std::endl;*
 }
 
 nc_err_e ncvisual_decode(ncvisual* nc) {
+  if(!nc->details.image){ // not a file-backed ncvisual
+    // ...unless it's a still image from the cache, which has no more frames
+    return nc->cached ? NCERR_EOF : NCERR_DECODE;
+  }
 //fprintf(stderr, "current subimage: %d frame: %p\n", nc->details.image->current_subimage(), nc->details.frame.get());
-  const auto &spec = nc->details.image->spec_dimensions(nc->details.framenum);
+  const auto &spec = nc->details.image->spec_dimensions(nc->details.framenum,
+                                                        nc->details.miplevel);
   if(nc->details.frame){
 //fprintf(stderr, "seeking subimage: %d\n", nc->details.image->current_subimage() + 1);
     OIIO::ImageSpec newspec;
-    if(!nc->details.image->seek_subimage(nc->details.image->current_subimage() + 1, 0, newspec)){
+    if(!nc->details.image->seek_subimage(nc->details.image->current_subimage() + 1,
+                                         nc->details.miplevel, newspec)){
        return NCERR_EOF;
     }
     // FIXME check newspec vis-a-vis image->spec()?
@@ -57,7 +175,7 @@ nc_err_e ncvisual_decode(ncvisual* nc) {
     std::fill(nc->details.frame.get(), nc->details.frame.get() + pixels, 0xfffffffful);
   }
 //fprintf(stderr, "READING: %d %ju\n", nc->details.image->current_subimage(), nc->details.framenum);
-  if(!nc->details.image->read_image(nc->details.framenum++, 0, 0, spec.nchannels, OIIO::TypeDesc(OIIO::TypeDesc::UINT8, 4), nc->details.frame.get(), 4)){
+  if(!nc->details.image->read_image(nc->details.framenum++, nc->details.miplevel, 0, spec.nchannels, OIIO::TypeDesc(OIIO::TypeDesc::UINT8, 4), nc->details.frame.get(), 4)){
     return NCERR_DECODE;
   }
 //fprintf(stderr, "READ: %d %ju\n", nc->details.image->current_subimage(), nc->details.framenum);
@@ -82,24 +200,55 @@ nc_err_e ncvisual_decode(ncvisual* nc) {
   return NCERR_SUCCESS;
 }
 
-// resize, converting to RGBA (if necessary) along the way
-nc_err_e ncvisual_resize(ncvisual* nc, int rows, int cols) {
+// OIIO doesn't tell us when its subimages ought be shown FIXME
+nc_err_e ncvisual_seek(ncvisual* nc, uint64_t ns) {
+  (void)nc;
+  (void)ns;
+  return NCERR_UNIMPLEMENTED;
+}
+
+// OIIO's filter for 'quality'. NCSCALEQ_BOX uses our own rgba_scale_box().
+static auto
+oiio_filter(ncscalequality_e quality) -> const char* {
+  switch(quality){
+    case NCSCALEQ_FAST: return "triangle";
+    case NCSCALEQ_AREA: return "box";
+    case NCSCALEQ_BICUBIC: return "catmull-rom";
+    case NCSCALEQ_LANCZOS: return "lanczos3";
+    default: return ""; // let OIIO choose
+  }
+}
+
+// resize, converting to RGBA (if necessary) along the way, with the filter
+// ncvisual_blit() would use at 'quality'
+nc_err_e ncvisual_resize_quality(ncvisual* nc, int rows, int cols,
+                                 ncscalequality_e quality) {
 //fprintf(stderr, "%d/%d -> %d/%d on the resize\n", ncv->rows, ncv->cols, rows, cols);
-  auto ibuf = std::make_unique<OIIO::ImageBuf>();
   if(nc->details.ibuf && (nc->cols != cols || nc->rows != rows)){ // scale it
-    OIIO::ImageSpec sp{};
-    sp.width = cols;
-    sp.height = rows;
-    ibuf->reset(sp, OIIO::InitializePixels::Yes);
-    OIIO::ROI roi(0, cols, 0, rows, 0, 1, 0, 4);
-    if(!OIIO::ImageBufAlgo::resize(*ibuf, *nc->details.ibuf, "", 0, roi)){
-      return NCERR_DECODE;
+    auto ibuf = std::make_unique<OIIO::ImageBuf>();
+    if(quality == NCSCALEQ_BOX){
+      OIIO::ImageSpec rgbaspec(cols, rows, 4, OIIO::TypeDesc::UINT8);
+      ibuf->reset(rgbaspec, OIIO::InitializePixels::No);
+      if(rgba_scale_box(nc->data, nc->rows, nc->rowstride, nc->cols,
+                        ibuf->localpixels(), rows, cols * 4, cols, 0, rows)){
+        return NCERR_NOMEM;
+      }
+    }else{
+      OIIO::ImageSpec sp{};
+      sp.width = cols;
+      sp.height = rows;
+      ibuf->reset(sp, OIIO::InitializePixels::Yes);
+      OIIO::ROI roi(0, cols, 0, rows, 0, 1, 0, 4);
+      if(!OIIO::ImageBufAlgo::resize(*ibuf, *nc->details.ibuf, oiio_filter(quality), 0, roi)){
+        return NCERR_DECODE;
+      }
     }
     nc->cols = cols;
     nc->rows = rows;
     nc->rowstride = cols * 4;
     ncvisual_set_data(nc, static_cast<uint32_t*>(ibuf->localpixels()), false);
-//fprintf(stderr, "HAVE SOME NEW DATA: %p\n", ibuf->localpixels());
+    nc->details.ibuf = std::move(ibuf); // which now holds our data
+//fprintf(stderr, "HAVE SOME NEW DATA: %p\n", nc->details.ibuf->localpixels());
   }
   return NCERR_SUCCESS;
 }
@@ -107,29 +256,53 @@ nc_err_e ncvisual_resize(ncvisual* nc, int rows, int cols) {
 nc_err_e ncvisual_blit(struct ncvisual* ncv, int rows, int cols,
                        ncplane* n, const struct blitset* bset,
                        int placey, int placex, int begy, int begx,
-                       int leny, int lenx, bool blendcolors) {
+                       int leny, int lenx, bool blendcolors, bool parallel,
+                       ncscalequality_e quality, blitdelta* delta) {
 //fprintf(stderr, "%d/%d -> %d/%d on the resize\n", ncv->rows, ncv->cols, rows, cols);
   void* data = nullptr;
   int stride = 0;
   auto ibuf = std::make_unique<OIIO::ImageBuf>();
-  if(ncv->details.ibuf && (ncv->cols != cols || ncv->rows != rows)){ // scale it
+  std::unique_ptr<uint32_t[]> boxed;
+  if(quality == NCSCALEQ_BOX && (ncv->cols != cols || ncv->rows != rows)){
+    boxed = std::make_unique<uint32_t[]>(static_cast<size_t>(rows) * cols);
+    if(rgba_scale_box(ncv->data, ncv->rows, ncv->rowstride, ncv->cols,
+                      boxed.get(), rows, cols * 4, cols, 0, rows)){
+      return NCERR_NOMEM;
+    }
+    stride = cols * 4;
+    data = boxed.get();
+  }else if((ncv->details.ibuf || ncv->cached) && (ncv->cols != cols || ncv->rows != rows)){ // scale it
+    // cached images were made with ncvisual_from_rgba(), and have no ImageBuf
+    // of their own. wrap their (packed) pixels for the duration.
+    std::unique_ptr<OIIO::ImageBuf> wrapped;
+    const OIIO::ImageBuf* src = ncv->details.ibuf.get();
+    if(src == nullptr){
+      OIIO::ImageSpec rgbaspec(ncv->cols, ncv->rows, 4, OIIO::TypeDesc::UINT8);
+      wrapped = std::make_unique<OIIO::ImageBuf>(rgbaspec, ncv->data);
+      src = wrapped.get();
+    }
     OIIO::ImageSpec sp{};
     sp.width = cols;
     sp.height = rows;
     ibuf->reset(sp, OIIO::InitializePixels::Yes);
     OIIO::ROI roi(0, cols, 0, rows, 0, 1, 0, 4);
-    if(!OIIO::ImageBufAlgo::resize(*ibuf, *ncv->details.ibuf, "", 0, roi)){
+    if(!OIIO::ImageBufAlgo::resize(*ibuf, *src, oiio_filter(quality), 0, roi)){
       return NCERR_DECODE;
     }
     stride = cols * 4;
     data = ibuf->localpixels();
-//fprintf(stderr, "HAVE SOME NEW DATA: %p\n", ibuf->localpixels());
+//fprintf(stderr, "HAVE SOME NEW DATA: %p\n", nc->details.ibuf->localpixels());
   }else{
     data = ncv->data;
     stride = ncv->rowstride;
   }
-  if(rgba_blit_dispatch(n, bset, placey, placex, stride, data, begy, begx,
-                        leny, lenx, blendcolors) <= 0){
+  if(ncv->cached && data != ncv->data){
+    vcache_offer(ncv->cached, rows, cols, quality, data, stride);
+  }
+  // OIIO's resize is already multithreaded; only the blit is banded
+  const int r = rgba_blit_visual(n, bset, placey, placex, stride, data, begy,
+                                 begx, leny, lenx, blendcolors, parallel, delta);
+  if(r < 0){
     return NCERR_DECODE;
   }
   return NCERR_SUCCESS;
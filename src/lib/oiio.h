@@ -5,25 +5,34 @@
 #include "version.h"
 #ifdef USE_OIIO
 #include "notcurses/ncerrs.h"
+#include <vector>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/version.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/filesystem.h>
 
 typedef struct ncvisual_details {
+  // input from memory is read through 'proxy', which must outlive 'image'.
+  // input from a file descriptor is first read into 'slurped'.
+  std::vector<unsigned char> slurped;
+  std::unique_ptr<OIIO::Filesystem::IOProxy> proxy;
   std::unique_ptr<OIIO::ImageInput> image;  // must be close()d
   std::unique_ptr<uint32_t[]> frame;
   std::unique_ptr<OIIO::ImageBuf> ibuf;
   uint64_t framenum;
+  int miplevel;        // MIP level decoded, 0 being full resolution
 } ncvisual_details;
 
 static inline auto
 ncvisual_details_init(ncvisual_details *deets) -> nc_err_e {
+  deets->proxy = nullptr;
   deets->image = nullptr;
   deets->frame = nullptr;
   deets->ibuf = nullptr;
   deets->framenum = 0;
+  deets->miplevel = 0;
   return NCERR_SUCCESS;
 }
 
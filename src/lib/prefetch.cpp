@@ -0,0 +1,293 @@
+#include <vector>
+#include <cstring>
+#include <signal.h>
+#include <pthread.h>
+#include "version.h"
+#include "visual-details.h"
+#include "internal.h"
+
+// An ncprefetch keeps a window of files following the last one taken opened,
+// ready to be shown. Its threads claim the first file in the window which is
+// neither ready nor in progress, so long as the visuals held ready fit within
+// the bound (the file next due is always opened). Everything is covered by a
+// single lock; the opening itself happens outside it.
+
+#define PREFETCH_DEPTH 2
+
+typedef enum {
+  PFSLOT_IDLE,
+  PFSLOT_BUSY,    // being opened
+  PFSLOT_READY,
+} pfslot_e;
+
+typedef struct pfslot {
+  pfslot_e state;
+  ncvisual* ncv;        // if ready (NULL on failure)
+  nc_err_e err;
+  size_t bytes;         // pixels held by 'ncv', see ncvisual_bytes()
+  unsigned gen;         // targeting for which it was opened
+} pfslot;
+
+struct ncprefetch {
+  char** files;
+  int count;
+  pfslot* slots;        // one per file
+  int cursor;           // first file of the window
+  int depth;
+  size_t maxbytes;      // 0 for no bound
+  size_t bytes;         // held by ready slots
+  int rows, cols;       // target geometry
+  ncscale_e scaling;    // how stills are prescaled to it
+  unsigned gen;         // advanced with each retargeting
+  ncscalequality_e quality;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;  // a slot changed state, or we're shutting down
+  bool stop;
+  pthread_t* threads;
+  int threadcount;
+};
+
+// open 'file' for the target geometry 'rows' x 'cols', prescaling a still
+// image as ncvisual_render() would scale it there with 'scaling' and 'quality'
+static auto
+prefetch_open(const char* file, int rows, int cols, ncscale_e scaling,
+              ncscalequality_e quality, nc_err_e* err) -> ncvisual* {
+  ncvisual* ncv = ncvisual_from_file_sized(file, err, rows, cols);
+  if(ncv && scaling != NCSCALE_NONE && rows > 0 && cols > 0 && ncvisual_still_p(ncv)){
+    if(scaling == NCSCALE_SCALE){
+      ncvisual_scale_fit(ncv->rows, ncv->cols, rows, cols, &rows, &cols);
+    }
+    // failure to prescale only means it'll be scaled when rendered
+    ncvisual_resize_quality(ncv, rows, cols, quality);
+  }
+  return ncv;
+}
+
+static inline auto
+prefetch_wanted(const ncprefetch* pf, int idx) -> bool {
+  return idx >= pf->cursor && idx < pf->cursor + pf->depth;
+}
+
+// the next file a thread ought open, or -1. must be called with the lock held.
+static auto
+prefetch_claim(ncprefetch* pf) -> int {
+  for(int i = pf->cursor ; i < pf->count && prefetch_wanted(pf, i) ; ++i){
+    if(pf->slots[i].state != PFSLOT_IDLE){
+      continue;
+    }
+    if(i != pf->cursor && pf->maxbytes && pf->bytes >= pf->maxbytes){
+      return -1;
+    }
+    return i;
+  }
+  return -1;
+}
+
+// release a ready slot's visual to the caller, who destroys it outside the
+// lock. must be called with the lock held.
+static auto
+prefetch_drop(ncprefetch* pf, pfslot* s) -> ncvisual* {
+  ncvisual* ncv = s->ncv;
+  pf->bytes -= s->bytes;
+  s->ncv = nullptr;
+  s->bytes = 0;
+  s->state = PFSLOT_IDLE;
+  return ncv;
+}
+
+static void*
+prefetch_thread(void* vpf){
+  auto pf = static_cast<ncprefetch*>(vpf);
+  pthread_mutex_lock(&pf->lock);
+  while(!pf->stop){
+    int idx = prefetch_claim(pf);
+    if(idx < 0){
+      pthread_cond_wait(&pf->cond, &pf->lock);
+      continue;
+    }
+    pfslot* s = &pf->slots[idx];
+    s->state = PFSLOT_BUSY;
+    s->gen = pf->gen;
+    const int rows = pf->rows;
+    const int cols = pf->cols;
+    pthread_mutex_unlock(&pf->lock);
+    nc_err_e err = NCERR_SUCCESS;
+    ncvisual* ncv = prefetch_open(pf->files[idx], rows, cols, pf->scaling,
+                                  pf->quality, &err);
+    const size_t bytes = ncv ? ncvisual_bytes(ncv) : 0;
+    pthread_mutex_lock(&pf->lock);
+    // we might have been skipped past, or retargeted, in the meantime
+    if(prefetch_wanted(pf, idx) && s->gen == pf->gen){
+      s->ncv = ncv;
+      s->err = err;
+      s->bytes = bytes;
+      s->state = PFSLOT_READY;
+      pf->bytes += bytes;
+      ncv = nullptr;
+    }else{
+      s->state = PFSLOT_IDLE;
+    }
+    pthread_cond_broadcast(&pf->cond);
+    if(ncv){
+      pthread_mutex_unlock(&pf->lock);
+      ncvisual_destroy(ncv);
+      pthread_mutex_lock(&pf->lock);
+    }
+  }
+  pthread_mutex_unlock(&pf->lock);
+  return nullptr;
+}
+
+auto ncprefetch_create(const char* const* files, int count,
+                       const ncprefetch_options* opts) -> ncprefetch* {
+  if(count < 0 || (count && files == nullptr)){
+    return nullptr;
+  }
+  if(opts && (opts->threads < 0 || opts->depth < 0 || opts->rows < 0 || opts->cols < 0 ||
+               opts->scaling < NCSCALE_NONE || opts->scaling > NCSCALE_STRETCH)){
+    return nullptr;
+  }
+  auto pf = static_cast<ncprefetch*>(calloc(1, sizeof(ncprefetch)));
+  if(pf == nullptr){
+    return nullptr;
+  }
+  pf->count = count;
+  pf->depth = opts && opts->depth ? opts->depth : PREFETCH_DEPTH;
+  pf->maxbytes = opts ? opts->maxbytes : 0;
+  pf->rows = opts ? opts->rows : 0;
+  pf->cols = opts ? opts->cols : 0;
+  pf->scaling = opts ? opts->scaling : NCSCALE_NONE;
+  pf->quality = opts ? opts->quality : NCSCALEQ_DEFAULT;
+  const int threads = opts && opts->threads ? opts->threads : 1;
+  pf->files = static_cast<char**>(calloc(count + 1, sizeof(*pf->files)));
+  pf->slots = static_cast<pfslot*>(calloc(count + 1, sizeof(*pf->slots)));
+  pf->threads = static_cast<pthread_t*>(calloc(threads, sizeof(*pf->threads)));
+  if(pf->files == nullptr || pf->slots == nullptr || pf->threads == nullptr){
+    ncprefetch_destroy(pf);
+    return nullptr;
+  }
+  for(int i = 0 ; i < count ; ++i){
+    if((pf->files[i] = strdup(files[i])) == nullptr){
+      ncprefetch_destroy(pf);
+      return nullptr;
+    }
+  }
+  if(pthread_mutex_init(&pf->lock, nullptr)){
+    ncprefetch_destroy(pf);
+    return nullptr;
+  }
+  if(pthread_cond_init(&pf->cond, nullptr)){
+    pthread_mutex_destroy(&pf->lock);
+    ncprefetch_destroy(pf);
+    return nullptr;
+  }
+  // signals (e.g. SIGWINCH) must be delivered to the application's threads
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  while(pf->threadcount < threads){
+    if(pthread_create(&pf->threads[pf->threadcount], nullptr, prefetch_thread, pf)){
+      break;
+    }
+    ++pf->threadcount;
+  }
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+  if(pf->threadcount == 0){
+    pthread_cond_destroy(&pf->cond);
+    pthread_mutex_destroy(&pf->lock);
+    ncprefetch_destroy(pf);
+    return nullptr;
+  }
+  return pf;
+}
+
+auto ncprefetch_take(ncprefetch* pf, int idx, nc_err_e* ncerr) -> ncvisual* {
+  if(idx < 0 || idx >= pf->count){
+    *ncerr = NCERR_DECODE;
+    return nullptr;
+  }
+  std::vector<ncvisual*> dropped;
+  pthread_mutex_lock(&pf->lock);
+  // move the window to 'idx', discarding whatever falls outside it
+  pf->cursor = idx;
+  for(int i = 0 ; i < pf->count ; ++i){
+    if(pf->slots[i].state == PFSLOT_READY && !prefetch_wanted(pf, i)){
+      dropped.push_back(prefetch_drop(pf, &pf->slots[i]));
+    }
+  }
+  pfslot* s = &pf->slots[idx];
+  while(s->state == PFSLOT_BUSY){
+    pthread_cond_wait(&pf->cond, &pf->lock);
+  }
+  ncvisual* ncv = nullptr;
+  bool ready = false;
+  if(s->state == PFSLOT_READY){
+    *ncerr = s->err;
+    ncv = prefetch_drop(pf, s);
+    ready = true;
+  }else{ // open it ourselves, keeping the threads off it
+    s->state = PFSLOT_BUSY;
+  }
+  const int rows = pf->rows;
+  const int cols = pf->cols;
+  // the threads can get on with the files following
+  pf->cursor = idx + 1;
+  pthread_cond_broadcast(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+  for(auto d : dropped){
+    ncvisual_destroy(d);
+  }
+  if(!ready){
+    ncv = prefetch_open(pf->files[idx], rows, cols, pf->scaling, pf->quality,
+                        ncerr);
+    pthread_mutex_lock(&pf->lock);
+    s->state = PFSLOT_IDLE;
+    pthread_cond_broadcast(&pf->cond);
+    pthread_mutex_unlock(&pf->lock);
+  }
+  return ncv;
+}
+
+auto ncprefetch_retarget(ncprefetch* pf, int rows, int cols) -> void {
+  std::vector<ncvisual*> dropped;
+  pthread_mutex_lock(&pf->lock);
+  pf->rows = rows;
+  pf->cols = cols;
+  ++pf->gen; // files being opened are discarded once they have been
+  for(int i = 0 ; i < pf->count ; ++i){
+    if(pf->slots[i].state == PFSLOT_READY){
+      dropped.push_back(prefetch_drop(pf, &pf->slots[i]));
+    }
+  }
+  pthread_cond_broadcast(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+  for(auto d : dropped){
+    ncvisual_destroy(d);
+  }
+}
+
+auto ncprefetch_destroy(ncprefetch* pf) -> void {
+  if(pf){
+    if(pf->threadcount){
+      pthread_mutex_lock(&pf->lock);
+      pf->stop = true;
+      pthread_cond_broadcast(&pf->cond);
+      pthread_mutex_unlock(&pf->lock);
+      for(int i = 0 ; i < pf->threadcount ; ++i){
+        pthread_join(pf->threads[i], nullptr);
+      }
+      pthread_cond_destroy(&pf->cond);
+      pthread_mutex_destroy(&pf->lock);
+    }
+    for(int i = 0 ; i < pf->count && pf->slots ; ++i){
+      ncvisual_destroy(pf->slots[i].ncv);
+    }
+    for(int i = 0 ; i < pf->count && pf->files ; ++i){
+      free(pf->files[i]);
+    }
+    free(pf->threads);
+    free(pf->slots);
+    free(pf->files);
+    free(pf);
+  }
+}
@@ -17,9 +17,14 @@ int notcurses_resize(notcurses* n, int* restrict rows, int* restrict cols){
   }
   int oldrows = n->stdscr->leny;
   int oldcols = n->stdscr->lenx;
-  if(update_term_dimensions(n->ttyfd, rows, cols)){
+  int cellpixy, cellpixx;
+  if(update_term_dimensions(n->ttyfd, rows, cols, &cellpixy, &cellpixx)){
     return -1;
   }
+  if(cellpixy > 0 && cellpixx > 0){
+    n->cellpixy = cellpixy;
+    n->cellpixx = cellpixx;
+  }
   n->truecols = *cols;
   *rows -= n->margin_t + n->margin_b;
   if(*rows <= 0){
@@ -265,6 +270,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
     if(absy >= dstleny){
       break;
     }
+    const cell* prow = ncplane_fbrow_const(p, logical_to_virtual(p, y));
     for(x = startx ; x < dimx ; ++x){
       const int absx = x + offx;
       if(absx >= dstlenx){
@@ -275,7 +281,7 @@ paint(ncplane* p, cell* lastframe, struct crender* rvec,
         continue;
       }
       struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
-      const cell* vis = &p->fb[nfbcellidx(p, y, x)];
+      const cell* vis = &prow[x];
       // if we never loaded any content into the cell (or obliterated it by
       // writing in a zero), use the plane's base cell.
       if(vis->gcluster == 0 && !cell_wide_right_p(vis)){
@@ -440,8 +446,18 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst){
     return -1;
   }
   postpaint(tmpfb, rendfb, dimy, dimx, rvec, &dst->pool);
-  free(dst->fb);
-  dst->fb = rendfb;
+  for(int y = 0 ; y < dimy ; ++y){
+    cell* row = ncplane_fbrow(dst, logical_to_virtual(dst, y));
+    if(row == NULL){
+      free(rvec);
+      free(rendfb);
+      free(tmpfb);
+      return -1;
+    }
+    memcpy(row, rendfb + fbcellidx(y, dimx, 0), sizeof(*row) * dimx);
+  }
+  ncplane_invalidate(dst);
+  free(rendfb);
   free(tmpfb);
   free(rvec);
   return 0;
@@ -833,6 +849,188 @@ stage_cursor(notcurses* nc, FILE* out, int y, int x){
   return ret;
 }
 
+// a sprixel chosen for drawing in this frame
+typedef struct sprixeldraw {
+  sprixelplace place;    // relative to the rendering area
+  const sprixel* s;
+  bool redraw;           // must it be written to the terminal?
+} sprixeldraw;
+
+static inline bool
+sprixelplace_eq(const sprixelplace* a, const sprixelplace* b){
+  return a->id == b->id && a->absy == b->absy && a->absx == b->absx &&
+         a->dimy == b->dimy && a->dimx == b->dimx;
+}
+
+// damage each cell of 'place' within the rendering area
+static void
+sprixelplace_damage(const notcurses* nc, struct crender* rvec,
+                    const sprixelplace* place){
+  for(int y = place->absy ; y < place->absy + place->dimy && y < nc->lfdimy ; ++y){
+    for(int x = place->absx ; x < place->absx + place->dimx && x < nc->lfdimx ; ++x){
+      rvec[y * nc->lfdimx + x].damaged = true;
+    }
+  }
+}
+
+// Choose the sprixels to draw in this frame. A sprixel is drawn only if it
+// lies entirely within the rendering area, stops short of the terminal's last
+// row (drawing Sixel there could scroll the screen), and supplied the glyph
+// for each of its cells (i.e. no plane above obscures any part of it).
+// Otherwise, its cells show the approximation beneath it. Cells under a Sixel
+// graphic which was drawn in the last frame, but won't be drawn in the same
+// place in this one, are damaged so that text overwrites it. A graphic is
+// (re)drawn if it wasn't drawn in the same place last frame, or (Sixel only)
+// if any of its cells are to be rewritten. Kitty images float above the text,
+// and are instead removed by emit_sprixels(). On a refresh, each graphic drawn
+// last frame is redrawn; kitty images are placed anew, but can't be
+// retransmitted, their pixels having been handed over to the terminal.
+static sprixeldraw*
+prep_sprixels(notcurses* nc, struct crender* rvec, bool refresh, int* count){
+  int cap = 0;
+  for(const ncplane* p = nc->top ; p ; p = p->below){
+    cap += !!p->sprite;
+  }
+  *count = 0;
+  if(cap == 0 && nc->drawnspritecount == 0){
+    return NULL;
+  }
+  sprixeldraw* draws = malloc(sizeof(*draws) * (cap ? cap : 1));
+  if(draws == NULL){
+    return NULL;
+  }
+  const int lasty = nc->stdscr->leny + nc->margin_b - 1;
+  for(ncplane* p = nc->top ; p ; p = p->below){
+    const sprixel* s = p->sprite;
+    if(s == NULL){
+      continue;
+    }
+    sprixeldraw* d = &draws[*count];
+    d->s = s;
+    d->place.id = s->id;
+    d->place.imageid = s->kitty ? s->kitty->id : 0;
+    d->place.absy = p->absy + s->y - nc->stdscr->absy;
+    d->place.absx = p->absx + s->x - nc->stdscr->absx;
+    d->place.dimy = s->dimy;
+    d->place.dimx = s->dimx;
+    if(d->place.absy < 0 || d->place.absx < 0 ||
+       d->place.absy + s->dimy > nc->lfdimy || d->place.absx + s->dimx > nc->lfdimx ||
+       (!s->kitty && d->place.absy + s->dimy > lasty)){
+      continue;
+    }
+    bool drawn = false;
+    for(int i = 0 ; i < nc->drawnspritecount ; ++i){
+      if(sprixelplace_eq(&nc->drawnsprites[i], &d->place)){
+        drawn = true;
+        break;
+      }
+    }
+    if(refresh){
+      // planes might have changed since the last render; only redraw what
+      // was already there
+      if(!drawn){
+        continue;
+      }
+    }else{
+      bool visible = true;
+      for(int y = d->place.absy ; visible && y < d->place.absy + s->dimy ; ++y){
+        for(int x = d->place.absx ; x < d->place.absx + s->dimx ; ++x){
+          if(rvec[y * nc->lfdimx + x].p != p){
+            visible = false;
+            break;
+          }
+        }
+      }
+      if(!visible){
+        continue;
+      }
+    }
+    d->redraw = !drawn || refresh;
+    ++*count;
+  }
+  for(int i = 0 ; i < nc->drawnspritecount ; ++i){
+    int d;
+    for(d = 0 ; d < *count ; ++d){
+      if(sprixelplace_eq(&nc->drawnsprites[i], &draws[d].place)){
+        break;
+      }
+    }
+    if(d == *count && !nc->drawnsprites[i].imageid){
+      sprixelplace_damage(nc, rvec, &nc->drawnsprites[i]);
+    }
+  }
+  for(int d = 0 ; d < *count ; ++d){
+    const sprixelplace* place = &draws[d].place;
+    if(place->imageid){
+      continue;
+    }
+    for(int y = place->absy ; !draws[d].redraw && y < place->absy + place->dimy ; ++y){
+      for(int x = place->absx ; x < place->absx + place->dimx ; ++x){
+        if(rvec[y * nc->lfdimx + x].damaged){
+          draws[d].redraw = true;
+          break;
+        }
+      }
+    }
+  }
+  return draws;
+}
+
+// write out the graphics chosen by prep_sprixels() which need be redrawn, and
+// remember where they all are. Sixel graphics leave the cursor in some
+// terminal-dependent location, so it is invalidated. kitty images which are
+// no longer drawn where they were are removed, and those no longer referenced
+// by any plane are deleted. kitty images are transmitted only once, and
+// thereafter merely placed.
+static int
+emit_sprixels(notcurses* nc, FILE* out, const sprixeldraw* draws, int count){
+  int ret = kitty_free_images(nc, out);
+  for(int i = 0 ; i < nc->drawnspritecount ; ++i){
+    const sprixelplace* place = &nc->drawnsprites[i];
+    if(!place->imageid){
+      continue;
+    }
+    int d;
+    for(d = 0 ; d < count ; ++d){
+      if(sprixelplace_eq(place, &draws[d].place)){
+        break;
+      }
+    }
+    if(d == count){
+      ret |= kitty_unplace(out, place->imageid, place->id);
+    }
+  }
+  for(int d = 0 ; d < count ; ++d){
+    if(draws[d].redraw){
+      ret |= stage_cursor(nc, out, draws[d].place.absy + nc->stdscr->absy,
+                          draws[d].place.absx + nc->stdscr->absx);
+      if(draws[d].s->kitty){
+        ret |= kitty_transmit(out, draws[d].s->kitty);
+        ret |= kitty_place(out, draws[d].place.imageid, draws[d].place.id);
+        continue;
+      }
+      if(fwrite(draws[d].s->glyph, draws[d].s->glyphlen, 1, out) != 1){
+        ret = -1;
+      }
+      nc->rstate.y = -1;
+      nc->rstate.x = -1;
+    }
+  }
+  if(count > nc->drawnspritecount){
+    sprixelplace* tmp = realloc(nc->drawnsprites, sizeof(*tmp) * count);
+    if(tmp == NULL){
+      nc->drawnspritecount = 0;
+      return -1;
+    }
+    nc->drawnsprites = tmp;
+  }
+  for(int d = 0 ; d < count ; ++d){
+    nc->drawnsprites[d] = draws[d].place;
+  }
+  nc->drawnspritecount = count;
+  return ret;
+}
+
 // Producing the frame requires three steps:
 //  * render -- build up a flat framebuffer from a set of ncplanes
 //  * rasterize -- build up a UTF-8/ASCII stream of escapes and EGCs
@@ -841,15 +1039,19 @@ stage_cursor(notcurses* nc, FILE* out, int y, int x){
 // Takes a rendered frame (a flat framebuffer, where each cell has the desired
 // EGC, attribute, and channels), which has been written to nc->lastframe, and
 // spits out an optimal sequence of terminal-appropriate escapes and EGCs. There
-// should be an rvec entry for each cell, but only the 'damaged' field is used.
+// should be an rvec entry for each cell. The 'damaged' field drives output,
+// and cells under graphics (see prep_sprixels()) might be damaged here. Unless
+// 'refresh' is set, the 'p' field determines which graphics are visible.
 // lastframe has *not yet been written to the screen*, i.e. it's only about to
 // *become* the last frame rasterized.
 static int
-notcurses_rasterize(notcurses* nc, const struct crender* rvec){
+notcurses_rasterize(notcurses* nc, struct crender* rvec, bool refresh){
   FILE* out = nc->rstate.mstreamfp;
   int ret = 0;
   int y, x;
   fseeko(out, 0, SEEK_SET);
+  int sprixelcount;
+  sprixeldraw* sprixels = prep_sprixels(nc, rvec, refresh, &sprixelcount);
   // we only need to emit a coordinate if it was damaged. the damagemap is a
   // bit per coordinate, rows by rows, column by column within a row, with the
   // MSB being the first coordinate.
@@ -1003,6 +1205,8 @@ fprintf(stderr, "RAST %u [%s] to %d/%d\n", srccell->gcluster, egcpool_extended_g
 //fprintf(stderr, "damageidx: %ld\n", damageidx);
     }
   }
+  ret |= emit_sprixels(nc, out, sprixels, sprixelcount);
+  free(sprixels);
   ret |= fflush(out);
   //fflush(nc->ttyfp);
   if(blocking_write(nc->ttyfd, nc->rstate.mstream, nc->rstate.mstrsize)){
@@ -1010,7 +1214,8 @@ fprintf(stderr, "RAST %u [%s] to %d/%d\n", srccell->gcluster, egcpool_extended_g
   }
 //fprintf(stderr, "%lu/%lu %lu/%lu %lu/%lu %d\n", nc->stats.defaultelisions, nc->stats.defaultemissions, nc->stats.fgelisions, nc->stats.fgemissions, nc->stats.bgelisions, nc->stats.bgemissions, ret);
   if(nc->renderfp){
-    fprintf(nc->renderfp, "%s\n", nc->rstate.mstream);
+    // the memstream isn't necessarily NUL-terminated at mstrsize
+    fprintf(nc->renderfp, "%.*s\n", (int)nc->rstate.mstrsize, nc->rstate.mstream);
   }
   if(ret < 0){
     return ret;
@@ -1057,7 +1262,7 @@ int notcurses_refresh(notcurses* nc, int* restrict dimy, int* restrict dimx){
   for(int i = 0 ; i < count ; ++i){
     rvec[i].damaged = true;
   }
-  int ret = notcurses_rasterize(nc, rvec);
+  int ret = notcurses_rasterize(nc, rvec, true);
   free(rvec);
   if(ret < 0){
     return -1;
@@ -1102,7 +1307,7 @@ int notcurses_render(notcurses* nc){
   struct crender* crender = malloc(crenderlen);
   memset(crender, 0, crenderlen);
   if(notcurses_render_internal(nc, crender) == 0){
-    bytes = notcurses_rasterize(nc, crender);
+    bytes = notcurses_rasterize(nc, crender, false);
   }
   free(crender);
   clock_gettime(CLOCK_MONOTONIC, &done);
@@ -0,0 +1,100 @@
+#include "internal.h"
+
+// A box filter: each output pixel is the mean of the whole source pixels it
+// covers, weighted by their alpha so that transparent pixels don't tint their
+// neighbors. When enlarging, an output pixel takes the one source pixel it
+// falls within. Each source row is read once per output row covering it, and
+// summed down into per-column totals; only then is each footprint summed
+// across, so the work is dominated by a sequential pass over the source.
+
+// column sums are 32 bits, holding up to this many rows of 255 * 255
+#define BOX_MAXROWS (UINT32_MAX / (255u * 255u))
+
+// the source pixels [*beg, *end) covering output pixel 'o' of 'olen'
+static inline void
+box_footprint(int o, int len, int olen, int* beg, int* end){
+  *beg = (int64_t)o * len / olen;
+  *end = (int64_t)(o + 1) * len / olen;
+  if(*end <= *beg){
+    *end = *beg + 1;
+  }
+}
+
+int rgba_scale_box(const void* data, int rows, int rowstride, int cols,
+                   void* out, int orows, int orowstride, int ocols,
+                   int obegy, int oleny){
+  if(rows <= 0 || cols <= 0 || orows <= 0 || ocols <= 0){
+    return -1;
+  }
+  if(obegy < 0 || oleny < 0 || obegy + oleny > orows){
+    return -1;
+  }
+  if((rows + orows - 1) / orows > (int64_t)BOX_MAXROWS){
+    return -1;
+  }
+  // r*a, g*a, b*a, and a, summed down each source column
+  uint32_t* colsums = malloc(sizeof(*colsums) * 4 * cols);
+  // the source columns spanned by each output column, computed once
+  int* xbounds = malloc(sizeof(*xbounds) * 2 * ocols);
+  if(colsums == NULL || xbounds == NULL){
+    free(xbounds);
+    free(colsums);
+    return -1;
+  }
+  for(int ox = 0 ; ox < ocols ; ++ox){
+    box_footprint(ox, cols, ocols, &xbounds[ox * 2], &xbounds[ox * 2 + 1]);
+  }
+  // with power-of-two factors in both dimensions, alpha is averaged by
+  // shifting. color must be divided by the alpha sum regardless.
+  int shift = -1;
+  if(rows % orows == 0 && cols % ocols == 0){
+    const unsigned fy = rows / orows;
+    const unsigned fx = cols / ocols;
+    if(!(fy & (fy - 1)) && !(fx & (fx - 1))){
+      shift = __builtin_ctz(fy) + __builtin_ctz(fx);
+    }
+  }
+  for(int oy = obegy ; oy < obegy + oleny ; ++oy){
+    int sy, syend;
+    box_footprint(oy, rows, orows, &sy, &syend);
+    memset(colsums, 0, sizeof(*colsums) * 4 * cols);
+    for(int y = sy ; y < syend ; ++y){
+      const unsigned char* px = (const unsigned char*)data + (size_t)y * rowstride;
+      uint32_t* cs = colsums;
+      for(int x = 0 ; x < cols ; ++x){
+        const unsigned a = px[3];
+        cs[0] += px[0] * a;
+        cs[1] += px[1] * a;
+        cs[2] += px[2] * a;
+        cs[3] += a;
+        px += 4;
+        cs += 4;
+      }
+    }
+    unsigned char* o = (unsigned char*)out + (size_t)oy * orowstride;
+    for(int ox = 0 ; ox < ocols ; ++ox){
+      const int sx = xbounds[ox * 2];
+      const int sxend = xbounds[ox * 2 + 1];
+      uint64_t r = 0, g = 0, b = 0, a = 0;
+      for(const uint32_t* cs = colsums + sx * 4 ; cs < colsums + sxend * 4 ; cs += 4){
+        r += cs[0];
+        g += cs[1];
+        b += cs[2];
+        a += cs[3];
+      }
+      if(a){
+        o[0] = (r + a / 2) / a;
+        o[1] = (g + a / 2) / a;
+        o[2] = (b + a / 2) / a;
+      }else{
+        o[0] = o[1] = o[2] = 0;
+      }
+      const uint64_t n = (uint64_t)(syend - sy) * (sxend - sx);
+      o[3] = shift >= 0 ? (a + n / 2) >> shift : (a + n / 2) / n;
+      o += 4;
+    }
+  }
+  free(xbounds);
+  free(colsums);
+  return 0;
+}
@@ -0,0 +1,352 @@
+#include <stdarg.h>
+#include "internal.h"
+
+// A Sixel graphic is a DCS string. Each band of six pixel rows is written as
+// one row of characters per color present in the band, each character a
+// column of the band's pixels of that color (bits 0..5, top to bottom, offset
+// by 63). '$' returns to the start of the band for the next color, and '-'
+// advances to the next band. "!n" repeats the next character n times.
+//
+// Colors are first bucketed by the high 5 bits of each channel. If more than
+// 256 buckets are occupied, they're reduced to 256 colors by median cut:
+// the box (range of buckets) holding the most pixels is repeatedly split at
+// its median along its widest channel. Each box's color is the mean of its
+// pixels.
+
+#define SIXEL_MAXCOLORS 256
+#define QBITS 5
+#define QBUCKETS (1u << (QBITS * 3))
+#define SIXEL_TRANSPARENT 0xffffu
+
+typedef struct qbucket {
+  uint64_t count;       // pixels in this bucket
+  uint64_t r, g, b;     // sums of their channels
+} qbucket;
+
+// a box of the median cut, a run of the occupied bucket keys
+typedef struct qbox {
+  int start, len;
+  uint64_t count;       // pixels in the box's buckets
+} qbox;
+
+typedef struct sixelbuf {
+  char* buf;
+  size_t used;
+  size_t size;
+} sixelbuf;
+
+static int
+sbuf_reserve(sixelbuf* s, size_t n){
+  if(s->size - s->used >= n){
+    return 0;
+  }
+  size_t size = s->size ? s->size : BUFSIZ;
+  while(size - s->used < n){
+    size *= 2;
+  }
+  char* tmp = realloc(s->buf, size);
+  if(tmp == NULL){
+    return -1;
+  }
+  s->buf = tmp;
+  s->size = size;
+  return 0;
+}
+
+static int
+sbuf_printf(sixelbuf* s, const char* fmt, ...){
+  char tmp[64];
+  va_list va;
+  va_start(va, fmt);
+  int len = vsnprintf(tmp, sizeof(tmp), fmt, va);
+  va_end(va);
+  if(len < 0 || (size_t)len >= sizeof(tmp) || sbuf_reserve(s, len)){
+    return -1;
+  }
+  memcpy(s->buf + s->used, tmp, len);
+  s->used += len;
+  return 0;
+}
+
+// write 'count' of the sixel character 'bits'. space must already be reserved.
+static inline void
+sbuf_run(sixelbuf* s, unsigned bits, int count){
+  const char c = 63 + bits;
+  if(count > 3){
+    s->used += sprintf(s->buf + s->used, "!%d%c", count, c);
+  }else{
+    while(count--){
+      s->buf[s->used++] = c;
+    }
+  }
+}
+
+static inline unsigned
+qkey(unsigned r, unsigned g, unsigned b){
+  return ((r >> (8 - QBITS)) << (QBITS * 2)) | ((g >> (8 - QBITS)) << QBITS) |
+         (b >> (8 - QBITS));
+}
+
+// the channel of the bucket key 'k': 0 for red, 1 for green, 2 for blue
+static inline unsigned
+qkey_channel(unsigned k, int channel){
+  return (k >> (QBITS * (2 - channel))) & ((1u << QBITS) - 1);
+}
+
+static int
+qcmp_r(const void* a, const void* b){
+  return (int)qkey_channel(*(const unsigned*)a, 0) - (int)qkey_channel(*(const unsigned*)b, 0);
+}
+
+static int
+qcmp_g(const void* a, const void* b){
+  return (int)qkey_channel(*(const unsigned*)a, 1) - (int)qkey_channel(*(const unsigned*)b, 1);
+}
+
+static int
+qcmp_b(const void* a, const void* b){
+  return (int)qkey_channel(*(const unsigned*)a, 2) - (int)qkey_channel(*(const unsigned*)b, 2);
+}
+
+// split boxes until we have 'maxcolors' of them, or none can be split.
+// returns the number of boxes.
+static int
+median_cut(const qbucket* hist, unsigned* keys, int keycount,
+           qbox* boxes, int maxcolors){
+  int (* const cmps[3])(const void*, const void*) = { qcmp_r, qcmp_g, qcmp_b, };
+  int boxcount = 1;
+  boxes[0].start = 0;
+  boxes[0].len = keycount;
+  boxes[0].count = 0;
+  for(int k = 0 ; k < keycount ; ++k){
+    boxes[0].count += hist[keys[k]].count;
+  }
+  while(boxcount < maxcolors){
+    int target = -1;
+    for(int b = 0 ; b < boxcount ; ++b){
+      if(boxes[b].len > 1 && (target < 0 || boxes[b].count > boxes[target].count)){
+        target = b;
+      }
+    }
+    if(target < 0){
+      break;
+    }
+    qbox* box = &boxes[target];
+    unsigned* bkeys = keys + box->start;
+    unsigned lo[3] = { ~0u, ~0u, ~0u }, hi[3] = { 0, 0, 0 };
+    for(int k = 0 ; k < box->len ; ++k){
+      for(int c = 0 ; c < 3 ; ++c){
+        const unsigned v = qkey_channel(bkeys[k], c);
+        lo[c] = v < lo[c] ? v : lo[c];
+        hi[c] = v > hi[c] ? v : hi[c];
+      }
+    }
+    int channel = 0;
+    for(int c = 1 ; c < 3 ; ++c){
+      if(hi[c] - lo[c] > hi[channel] - lo[channel]){
+        channel = c;
+      }
+    }
+    qsort(bkeys, box->len, sizeof(*bkeys), cmps[channel]);
+    // split after the bucket which takes us to half of the box's pixels,
+    // leaving at least one bucket on either side
+    uint64_t seen = 0;
+    int split = 1;
+    for(int k = 0 ; k < box->len - 1 ; ++k){
+      seen += hist[bkeys[k]].count;
+      split = k + 1;
+      if(seen * 2 >= box->count){
+        break;
+      }
+    }
+    qbox* nbox = &boxes[boxcount++];
+    nbox->start = box->start + split;
+    nbox->len = box->len - split;
+    nbox->count = box->count - seen;
+    box->len = split;
+    box->count = seen;
+  }
+  return boxcount;
+}
+
+// write the palette and build the bucket->color map. returns the number of
+// colors, or -1 on error.
+static int
+sixel_palette(sixelbuf* s, const qbucket* hist, unsigned char* map){
+  unsigned* keys = malloc(sizeof(*keys) * QBUCKETS);
+  qbox* boxes = malloc(sizeof(*boxes) * SIXEL_MAXCOLORS);
+  if(keys == NULL || boxes == NULL){
+    free(keys);
+    free(boxes);
+    return -1;
+  }
+  int keycount = 0;
+  for(unsigned k = 0 ; k < QBUCKETS ; ++k){
+    if(hist[k].count){
+      keys[keycount++] = k;
+    }
+  }
+  int colors;
+  if(keycount <= SIXEL_MAXCOLORS){
+    for(int k = 0 ; k < keycount ; ++k){
+      boxes[k].start = k;
+      boxes[k].len = 1;
+    }
+    colors = keycount;
+  }else{
+    colors = median_cut(hist, keys, keycount, boxes, SIXEL_MAXCOLORS);
+  }
+  int ret = colors;
+  for(int c = 0 ; c < colors ; ++c){
+    uint64_t r = 0, g = 0, b = 0, count = 0;
+    for(int k = boxes[c].start ; k < boxes[c].start + boxes[c].len ; ++k){
+      const qbucket* q = &hist[keys[k]];
+      r += q->r;
+      g += q->g;
+      b += q->b;
+      count += q->count;
+      map[keys[k]] = c;
+    }
+    // registers are specified in percent of each channel
+    if(sbuf_printf(s, "#%d;2;%d;%d;%d", c,
+                   (int)((r * 100 + count * 255 / 2) / (count * 255)),
+                   (int)((g * 100 + count * 255 / 2) / (count * 255)),
+                   (int)((b * 100 + count * 255 / 2) / (count * 255)))){
+      ret = -1;
+      break;
+    }
+  }
+  free(keys);
+  free(boxes);
+  return ret;
+}
+
+// write the bands of the 'leny'x'lenx' color indices 'pix'
+static int
+sixel_bands(sixelbuf* s, const uint16_t* pix, int leny, int lenx, int colors){
+  int slot[SIXEL_MAXCOLORS];
+  uint16_t slotcolor[SIXEL_MAXCOLORS];
+  unsigned char* bits = malloc((size_t)colors * lenx);
+  if(bits == NULL){
+    return -1;
+  }
+  for(int c = 0 ; c < colors ; ++c){
+    slot[c] = -1;
+  }
+  for(int band = 0 ; band < leny ; band += 6){
+    int slots = 0;
+    for(int y = band ; y < band + 6 && y < leny ; ++y){
+      const uint16_t* row = pix + (size_t)y * lenx;
+      for(int x = 0 ; x < lenx ; ++x){
+        const uint16_t c = row[x];
+        if(c == SIXEL_TRANSPARENT){
+          continue;
+        }
+        if(slot[c] < 0){
+          slot[c] = slots;
+          slotcolor[slots] = c;
+          memset(bits + (size_t)slots * lenx, 0, lenx);
+          ++slots;
+        }
+        bits[(size_t)slot[c] * lenx + x] |= 1u << (y - band);
+      }
+    }
+    for(int sl = 0 ; sl < slots ; ++sl){
+      const unsigned char* sbits = bits + (size_t)sl * lenx;
+      // trailing empty columns needn't be written
+      int len = lenx;
+      while(len && !sbits[len - 1]){
+        --len;
+      }
+      // worst case is one byte per column, plus the color and separator
+      if(sbuf_reserve(s, len + 9)){
+        free(bits);
+        return -1;
+      }
+      if(sl){
+        s->buf[s->used++] = '$';
+      }
+      s->used += sprintf(s->buf + s->used, "#%d", slotcolor[sl]);
+      int x = 0;
+      while(x < len){
+        int run = 1;
+        while(x + run < len && sbits[x + run] == sbits[x]){
+          ++run;
+        }
+        // a run of n > 3 becomes "!n" plus the character, never longer
+        sbuf_run(s, sbits[x], run);
+        x += run;
+      }
+      slot[slotcolor[sl]] = -1;
+    }
+    if(band + 6 < leny){
+      if(sbuf_reserve(s, 1)){
+        free(bits);
+        return -1;
+      }
+      s->buf[s->used++] = '-';
+    }
+  }
+  free(bits);
+  return 0;
+}
+
+char* sixel_encode(const void* data, int linesize, int begy, int begx,
+                   int leny, int lenx, bool bgr, size_t* glyphlen){
+  qbucket* hist = calloc(QBUCKETS, sizeof(*hist));
+  unsigned char* map = malloc(QBUCKETS);
+  uint16_t* pix = malloc(sizeof(*pix) * leny * lenx);
+  sixelbuf s = { .buf = NULL, .used = 0, .size = 0, };
+  if(hist == NULL || map == NULL || pix == NULL){
+    goto err;
+  }
+  // first pass: bucket each opaque pixel, stashing its key
+  const unsigned char* dat = data;
+  for(int y = 0 ; y < leny ; ++y){
+    const unsigned char* row = dat + (size_t)linesize * (begy + y) + begx * 4;
+    for(int x = 0 ; x < lenx ; ++x){
+      const unsigned char* px = row + x * 4;
+      if(ffmpeg_trans_p(bgr, px[3])){
+        pix[y * lenx + x] = SIXEL_TRANSPARENT;
+        continue;
+      }
+      const unsigned r = px[bgr ? 2 : 0], g = px[1], b = px[bgr ? 0 : 2];
+      const unsigned k = qkey(r, g, b);
+      ++hist[k].count;
+      hist[k].r += r;
+      hist[k].g += g;
+      hist[k].b += b;
+      pix[y * lenx + x] = k;
+    }
+  }
+  // P2 == 1: pixels which aren't drawn remain as they were. the raster
+  // attributes specify square pixels, and the size of the graphic.
+  if(sbuf_printf(&s, "\x1bP0;1;0q\"1;1;%d;%d", lenx, leny)){
+    goto err;
+  }
+  int colors = sixel_palette(&s, hist, map);
+  if(colors < 0){
+    goto err;
+  }
+  // second pass: map each bucket key to its color
+  for(int i = 0 ; i < leny * lenx ; ++i){
+    if(pix[i] != SIXEL_TRANSPARENT){
+      pix[i] = map[pix[i]];
+    }
+  }
+  if(sixel_bands(&s, pix, leny, lenx, colors) || sbuf_printf(&s, "\x1b\\")){
+    goto err;
+  }
+  free(hist);
+  free(map);
+  free(pix);
+  *glyphlen = s.used;
+  return s.buf;
+
+err:
+  free(hist);
+  free(map);
+  free(pix);
+  free(s.buf);
+  return NULL;
+}
@@ -0,0 +1,333 @@
+#include <pthread.h>
+#include <sys/stat.h>
+#include "internal.h"
+
+// An LRU cache of decoded still images, bounded in bytes, together with the
+// scaled renderings made of each. An image is keyed on its path, modification
+// time, and size; a stale entry is dropped when next looked up. ncvisuals made
+// from an entry hold a reference to it, and each rendering is likewise held
+// while it's being blitted, so eviction only unlinks them from the cache.
+
+// scaled renderings kept per image
+#define VCACHE_VARIANTS 4
+
+typedef struct vcachevariant {
+  uint32_t* pixels;           // rows x cols RGBA, packed
+  int rows, cols;
+  ncscalequality_e quality;
+  unsigned refs;              // blits in progress, plus one for the entry
+} vcachevariant;
+
+typedef struct vcacheentry {
+  struct vcacheentry* prev;   // toward the most recently used
+  struct vcacheentry* next;   // toward the least recently used
+  char* path;
+  struct timespec mtime;
+  off_t size;
+  uint32_t* pixels;           // rows x cols RGBA, packed
+  int rows, cols;
+  vcachevariant* variants[VCACHE_VARIANTS]; // most recently used first
+  size_t bytes;               // pixels and variants
+  unsigned refs;              // ncvisuals, plus one while cached
+  bool cached;                // false once evicted
+} vcacheentry;
+
+static pthread_mutex_t vcache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+  vcacheentry* head;          // most recently used
+  vcacheentry* tail;          // least recently used
+  size_t limit;               // 0 when disabled
+  ncvisual_cachestats stats;
+} vcache;
+
+static void
+vcache_variant_free(vcachevariant* v){
+  free(v->pixels);
+  free(v);
+}
+
+// must be called with the lock held
+static void
+vcache_variant_unref(vcachevariant* v){
+  if(--v->refs == 0){
+    vcache_variant_free(v);
+  }
+}
+
+// must be called with the lock held
+static void
+vcache_entry_unref(vcacheentry* e){
+  if(--e->refs == 0){
+    for(int i = 0 ; i < VCACHE_VARIANTS ; ++i){
+      if(e->variants[i]){
+        vcache_variant_unref(e->variants[i]);
+      }
+    }
+    free(e->pixels);
+    free(e->path);
+    free(e);
+  }
+}
+
+// drop 'e' from the cache. must be called with the lock held.
+static void
+vcache_unlink(vcacheentry* e){
+  if(e->prev){
+    e->prev->next = e->next;
+  }else{
+    vcache.head = e->next;
+  }
+  if(e->next){
+    e->next->prev = e->prev;
+  }else{
+    vcache.tail = e->prev;
+  }
+  e->prev = e->next = NULL;
+  e->cached = false;
+  vcache.stats.bytes -= e->bytes;
+  --vcache.stats.entries;
+  vcache_entry_unref(e);
+}
+
+static void
+vcache_push(vcacheentry* e){
+  e->prev = NULL;
+  e->next = vcache.head;
+  if(vcache.head){
+    vcache.head->prev = e;
+  }else{
+    vcache.tail = e;
+  }
+  vcache.head = e;
+}
+
+// evict least-recently-used images other than 'keep' until we're under the
+// limit. must be called with the lock held.
+static void
+vcache_trim(const vcacheentry* keep){
+  vcacheentry* e = vcache.tail;
+  while(e && vcache.stats.bytes > vcache.limit){
+    vcacheentry* prev = e->prev;
+    if(e != keep){
+      vcache_unlink(e);
+      ++vcache.stats.evictions;
+    }
+    e = prev;
+  }
+}
+
+void ncvisual_cache_limit(size_t bytes){
+  pthread_mutex_lock(&vcache_lock);
+  vcache.limit = bytes;
+  vcache.stats.limit = bytes;
+  vcache_trim(NULL);
+  pthread_mutex_unlock(&vcache_lock);
+}
+
+void ncvisual_cache_stats(ncvisual_cachestats* stats){
+  pthread_mutex_lock(&vcache_lock);
+  memcpy(stats, &vcache.stats, sizeof(*stats));
+  pthread_mutex_unlock(&vcache_lock);
+}
+
+bool vcache_enabled(void){
+  pthread_mutex_lock(&vcache_lock);
+  const bool ret = vcache.limit != 0;
+  pthread_mutex_unlock(&vcache_lock);
+  return ret;
+}
+
+// packed copy of 'rows' lines of 'cols' pixels, 'rowstride' bytes apart
+static uint32_t*
+vcache_copy(const void* data, int rows, int rowstride, int cols){
+  uint32_t* ret = malloc((size_t)rows * cols * 4);
+  if(ret){
+    for(int y = 0 ; y < rows ; ++y){
+      memcpy(ret + (size_t)y * cols, (const char*)data + (size_t)y * rowstride,
+             (size_t)cols * 4);
+    }
+  }
+  return ret;
+}
+
+vcacheentry* vcache_lookup(const char* path, const struct stat* st,
+                           const uint32_t** pixels, int* rows, int* cols){
+  if(!vcache_enabled()){
+    return NULL;
+  }
+  pthread_mutex_lock(&vcache_lock);
+  vcacheentry* e;
+  for(e = vcache.head ; e ; e = e->next){
+    if(strcmp(e->path, path) == 0){
+      break;
+    }
+  }
+  if(e){
+    if(e->size != st->st_size || e->mtime.tv_sec != st->st_mtim.tv_sec ||
+       e->mtime.tv_nsec != st->st_mtim.tv_nsec){
+      vcache_unlink(e); // the file has changed beneath us
+      e = NULL;
+    }else{
+      if(e != vcache.head){
+        vcacheentry* next = e->next;
+        e->prev->next = next;
+        if(next){
+          next->prev = e->prev;
+        }else{
+          vcache.tail = e->prev;
+        }
+        vcache_push(e);
+      }
+      ++e->refs;
+      *pixels = e->pixels;
+      *rows = e->rows;
+      *cols = e->cols;
+    }
+  }
+  if(e){
+    ++vcache.stats.hits;
+  }else{
+    ++vcache.stats.misses;
+  }
+  pthread_mutex_unlock(&vcache_lock);
+  return e;
+}
+
+vcacheentry* vcache_insert(const char* path, const struct stat* st,
+                           const void* data, int rows, int rowstride, int cols){
+  if(!vcache_enabled()){
+    return NULL;
+  }
+  vcacheentry* e = malloc(sizeof(*e));
+  if(e == NULL){
+    return NULL;
+  }
+  memset(e, 0, sizeof(*e));
+  e->bytes = (size_t)rows * cols * 4;
+  if((e->path = strdup(path)) == NULL){
+    free(e);
+    return NULL;
+  }
+  if((e->pixels = vcache_copy(data, rows, rowstride, cols)) == NULL){
+    free(e->path);
+    free(e);
+    return NULL;
+  }
+  e->mtime = st->st_mtim;
+  e->size = st->st_size;
+  e->rows = rows;
+  e->cols = cols;
+  e->refs = 2; // the cache, and the caller
+  e->cached = true;
+  pthread_mutex_lock(&vcache_lock);
+  if(e->bytes > vcache.limit){ // too large for the cache
+    e->refs = 1;
+    vcache_entry_unref(e);
+    pthread_mutex_unlock(&vcache_lock);
+    return NULL;
+  }
+  // another thread might have beaten us to it
+  for(vcacheentry* old = vcache.head ; old ; old = old->next){
+    if(strcmp(old->path, path) == 0){
+      vcache_unlink(old);
+      break;
+    }
+  }
+  vcache_push(e);
+  vcache.stats.bytes += e->bytes;
+  ++vcache.stats.entries;
+  vcache_trim(e);
+  pthread_mutex_unlock(&vcache_lock);
+  return e;
+}
+
+void vcache_release(vcacheentry* e){
+  if(e){
+    pthread_mutex_lock(&vcache_lock);
+    vcache_entry_unref(e);
+    pthread_mutex_unlock(&vcache_lock);
+  }
+}
+
+vcachevariant* vcache_variant_get(vcacheentry* e, int rows, int cols,
+                                  ncscalequality_e quality,
+                                  const uint32_t** pixels){
+  vcachevariant* ret = NULL;
+  pthread_mutex_lock(&vcache_lock);
+  for(int i = 0 ; i < VCACHE_VARIANTS && e->variants[i] ; ++i){
+    vcachevariant* v = e->variants[i];
+    if(v->rows == rows && v->cols == cols && v->quality == quality){
+      memmove(e->variants + 1, e->variants, sizeof(*e->variants) * i);
+      e->variants[0] = v;
+      ++v->refs;
+      *pixels = v->pixels;
+      ret = v;
+      break;
+    }
+  }
+  if(ret){
+    ++vcache.stats.scaled_hits;
+  }else{
+    ++vcache.stats.scaled_misses;
+  }
+  pthread_mutex_unlock(&vcache_lock);
+  return ret;
+}
+
+void vcache_variant_release(vcachevariant* v){
+  pthread_mutex_lock(&vcache_lock);
+  vcache_variant_unref(v);
+  pthread_mutex_unlock(&vcache_lock);
+}
+
+void vcache_offer(vcacheentry* e, int rows, int cols, ncscalequality_e quality,
+                  const void* data, int rowstride){
+  const size_t bytes = (size_t)rows * cols * 4;
+  pthread_mutex_lock(&vcache_lock);
+  const bool wanted = e->cached && e->bytes + bytes <= vcache.limit;
+  pthread_mutex_unlock(&vcache_lock);
+  if(!wanted){
+    return;
+  }
+  vcachevariant* v = malloc(sizeof(*v));
+  if(v == NULL){
+    return;
+  }
+  if((v->pixels = vcache_copy(data, rows, rowstride, cols)) == NULL){
+    free(v);
+    return;
+  }
+  v->rows = rows;
+  v->cols = cols;
+  v->quality = quality;
+  v->refs = 1;
+  pthread_mutex_lock(&vcache_lock);
+  bool dup = false;
+  for(int i = 0 ; i < VCACHE_VARIANTS && e->variants[i] ; ++i){
+    const vcachevariant* ev = e->variants[i];
+    if(ev->rows == rows && ev->cols == cols && ev->quality == quality){
+      dup = true;
+      break;
+    }
+  }
+  if(dup || !e->cached){ // raced with another thread, or evicted meanwhile
+    vcache_variant_unref(v);
+    pthread_mutex_unlock(&vcache_lock);
+    return;
+  }
+  vcachevariant* dropped = e->variants[VCACHE_VARIANTS - 1];
+  if(dropped){
+    const size_t dbytes = (size_t)dropped->rows * dropped->cols * 4;
+    e->bytes -= dbytes;
+    vcache.stats.bytes -= dbytes;
+    vcache_variant_unref(dropped);
+  }
+  memmove(e->variants + 1, e->variants,
+          sizeof(*e->variants) * (VCACHE_VARIANTS - 1));
+  e->variants[0] = v;
+  e->bytes += bytes;
+  vcache.stats.bytes += bytes;
+  vcache_trim(e);
+  pthread_mutex_unlock(&vcache_lock);
+}
@@ -1,8 +1,10 @@
 #ifndef NOTCURSES_VISUAL_DETAILS
 #define NOTCURSES_VISUAL_DETAILS
 
+#include <algorithm>
 #include "version.h"
 #include "notcurses/notcurses.h"
+#include "internal.h"
 
 #ifdef USE_FFMPEG
 #include "ffmpeg.h"
@@ -30,6 +32,15 @@ ncvisual_details_destroy(ncvisual_details* deets) -> void {
 
 struct ncplane;
 
+// where an encoded visual is read from: a file, a caller's buffer (which is
+// not copied), or a file descriptor (which might be a pipe)
+typedef struct ncvsource {
+  const char* path;            // if non-NULL, a file
+  const unsigned char* data;   // otherwise, if non-NULL, 'len' bytes
+  size_t len;
+  int fd;                      // otherwise, read until EOF
+} ncvsource;
+
 typedef struct ncvisual {
   int cols, rows;
   // lines are sometimes padded. this many true bytes per row in data.
@@ -37,6 +48,12 @@ typedef struct ncvisual {
   ncvisual_details details;// implementation-specific details
   uint32_t* data; // (scaled) RGBA image data, rowstride bytes per row
   bool owndata; // we own data iff owndata == true
+  struct blitdelta* delta; // last blit with NCVISUAL_OPTION_DELTA, if any
+  struct vcacheentry* cached; // cached image of which 'data' is a copy, if any
+  struct ncanim* anim; // recording of streamed frames, if ncvisual_record()ed
+  // the cells covered by the last ncvisual_render(), possibly off the plane
+  int placey, placex, disprows, dispcols;
+  int tier; // of the frame being streamed with NCVISUAL_OPTION_ADAPTIVE
 } ncvisual;
 
 static inline auto
@@ -51,6 +68,9 @@ ncvisual_create(void) -> ncvisual* {
 
 static inline auto
 ncvisual_set_data(ncvisual* ncv, uint32_t* data, bool owned) -> void {
+  // our renderings are no longer those of the cached image
+  vcache_release(ncv->cached);
+  ncv->cached = nullptr;
   if(ncv->owndata){
     free(ncv->data);
   }
@@ -58,4 +78,40 @@ ncvisual_set_data(ncvisual* ncv, uint32_t* data, bool owned) -> void {
   ncv->owndata = owned;
 }
 
+// ncvisual_resize() with the filter ncvisual_blit() uses at 'quality', so that
+// blitting at that quality and geometry needn't scale it again.
+auto ncvisual_resize_quality(ncvisual* ncv, int rows, int cols,
+                             ncscalequality_e quality) -> nc_err_e;
+
+// Is this a single still image, as opposed to video or an animation? Only
+// these are cached by ncvisual_from_file(), and prescaled by ncprefetch.
+auto ncvisual_still_p(const ncvisual* ncv) -> bool;
+
+// The bytes of pixels held by 'ncv': its RGBA image, and any frames the
+// backend retains alongside it (e.g. the frame as decoded, which is often
+// planar YUV at full resolution).
+auto ncvisual_bytes(const ncvisual* ncv) -> size_t;
+
+// The largest geometry within 'maxrows' x 'maxcols' having the aspect ratio
+// of a 'rows' x 'cols' image, as NCSCALE_SCALE draws it. A geometry so
+// fitted is its own fit, so prescaling to it spares ncvisual_render() any
+// further scaling.
+static inline auto
+ncvisual_scale_fit(int rows, int cols, int maxrows, int maxcols,
+                   int* fitrows, int* fitcols) -> void {
+  if(static_cast<int64_t>(cols) * maxrows > static_cast<int64_t>(maxcols) * rows){
+    *fitrows = std::max<int64_t>(1, static_cast<int64_t>(rows) * maxcols / cols);
+    *fitcols = maxcols;
+  }else{
+    *fitrows = maxrows;
+    *fitcols = std::max<int64_t>(1, static_cast<int64_t>(cols) * maxrows / rows);
+  }
+}
+
+// Play back the complete recording of 'ncv' for 'vopts', as ncvisual_stream()
+// would have played the stream, without decoding.
+auto ncvisual_replay(ncvisual* ncv, nc_err_e* ncerr, float timescale,
+                     streamcb streamer, const struct ncvisual_options* vopts,
+                     void* curry) -> int;
+
 #endif
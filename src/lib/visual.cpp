@@ -1,30 +1,48 @@
 #include <cmath>
 #include <cstring>
+#include <algorithm>
+#include <sys/stat.h>
 #include "version.h"
 #include "visual-details.h"
 #include "internal.h"
 
 // Resize the provided ncviusal to the specified 'rows' x 'cols', but do not
-// change the internals of the ncvisual. Uses oframe.
+// change the internals of the ncvisual. Uses oframe. If 'parallel' is set,
+// the work may be split into bands across the workerpool. 'quality' selects
+// the scaling filter. If 'delta' is non-NULL, only changed cells are written.
 nc_err_e ncvisual_blit(struct ncvisual* ncv, int rows, int cols,
                        ncplane* n, const struct blitset* bset,
                        int placey, int placex, int begy, int begx,
-                       int leny, int lenx, bool blendcolors);
+                       int leny, int lenx, bool blendcolors, bool parallel,
+                       ncscalequality_e quality, blitdelta* delta);
+
+// Open and decode the first frame of 'src', for ncvisual_from_file() and
+// friends. If 'rows' or 'cols' is positive, the decoder may reduce the
+// resolution to no less than that geometry, in which case 'reduced' is set.
+auto ncvisual_open(const ncvsource* src, nc_err_e* err, int rows, int cols,
+                   bool* reduced) -> ncvisual*;
 
 // ncv constructors other than ncvisual_from_file() need to set up the
 // AVFrame* 'frame' according to their own data, which is assumed to
 // have been prepared already in 'ncv'.
 auto ncvisual_details_seed(struct ncvisual* ncv) -> void;
 
-// number of pixels that map to a single cell, height-wise
+// number of pixels that map to a single cell, height-wise. The pixel blitters
+// use the terminal's own pixel geometry.
 static inline auto
-encoding_y_scale(const struct blitset* bset) -> int {
+encoding_y_scale(const notcurses* nc, const struct blitset* bset) -> int {
+  if(bset->geom == NCBLIT_SIXEL || bset->geom == NCBLIT_KITTY){
+    return nc->cellpixy;
+  }
   return bset->height;
 }
 
 // number of pixels that map to a single cell, width-wise
 static inline auto
-encoding_x_scale(const struct blitset* bset) -> int {
+encoding_x_scale(const notcurses* nc, const struct blitset* bset) -> int {
+  if(bset->geom == NCBLIT_SIXEL || bset->geom == NCBLIT_KITTY){
+    return nc->cellpixx;
+  }
   return bset->width;
 }
 
@@ -46,23 +64,23 @@ auto ncvisual_geom(const notcurses* nc, const ncvisual* n, ncblitter_e blitter,
     return -1;
   }
   if(y){
-    *y = n->rows;
+    *y = n ? n->rows : 0;
   }
   if(x){
-    *x = n->cols;
+    *x = n ? n->cols : 0;
   }
   if(toy){
-    *toy = encoding_y_scale(bset);
+    *toy = encoding_y_scale(nc, bset);
   }
   if(tox){
-    *tox = encoding_x_scale(bset);
+    *tox = encoding_x_scale(nc, bset);
   }
   return 0;
 }
 
 // RGBA visuals all use NCBLIT_2x1 by default (or NCBLIT_1x1 if not in
 // UTF-8 mode), but an alternative can be specified.
-static const struct blitset*
+const struct blitset*
 rgba_blitter(const notcurses* nc, const struct ncvisual_options* opts){
   const struct blitset* bset;
   const bool maydegrade = !opts || (opts->flags & NCVISUAL_OPTION_MAYDEGRADE);
@@ -271,6 +289,137 @@ rotate_bounding_box(double stheta, double ctheta, int* leny, int* lenx,
   return *leny * *lenx;
 }
 
+// rotations through multiples of pi/2 move each pixel to an exact location.
+// if 'stheta' and 'ctheta' describe such a rotation, snap them to their exact
+// values (-1, 0, or 1), and return true.
+static auto
+rotate_quarter(double* stheta, double* ctheta) -> bool {
+  const double s = round(*stheta);
+  const double c = round(*ctheta);
+  if(fabs(*stheta - s) > 1e-9 || fabs(*ctheta - c) > 1e-9){
+    return false;
+  }
+  *stheta = s;
+  *ctheta = c;
+  return true;
+}
+
+#define ROTATE_TILE 64
+
+// narrow [*lo, *hi) to those 'x' for which 0 <= 'e0' + 'k' * 'x' < 'lim',
+// 'k' being -1, 0, or 1.
+static inline auto
+rotate_clip(int e0, int k, int lim, int* lo, int* hi) -> void {
+  int a = *lo, b = *hi;
+  if(k == 0){
+    if(e0 < 0 || e0 >= lim){
+      b = a;
+    }
+  }else if(k > 0){
+    a = -e0;
+    b = lim - e0;
+  }else{
+    a = e0 - lim + 1;
+    b = e0 + 1;
+  }
+  *lo = std::max(*lo, a);
+  *hi = std::min(*hi, b);
+}
+
+// rotate through a multiple of pi/2, 's' and 'c' being its (exact) sine and
+// cosine. each pixel lands just where rotate_point() would put it, but is
+// moved with integer arithmetic, a tile at a time, so that the writes down
+// the columns of 'data' (for quarter turns) stay within the cache.
+static auto
+rotate_exact(const ncvisual* ncv, uint32_t* data, int s, int c, int centy,
+             int centx, int bby, int bbx, int bboffy, int bboffx) -> void {
+  const int stride = ncv->rowstride / 4;
+  const ptrdiff_t step = static_cast<ptrdiff_t>(s) * bbx + c; // per source column
+  for(int tiley = 0 ; tiley < ncv->rows ; tiley += ROTATE_TILE){
+    const int endy = std::min(tiley + ROTATE_TILE, ncv->rows);
+    for(int tilex = 0 ; tilex < ncv->cols ; tilex += ROTATE_TILE){
+      const int endx = std::min(tilex + ROTATE_TILE, ncv->cols);
+      for(int y = tiley ; y < endy ; ++y){
+        const int convy = y - centy;
+        // where the pixel in the center column lands
+        const int targx = -convy * s - bboffx;
+        const int targy = convy * c - bboffy;
+        int lo = tilex - centx; // in terms of the centered column
+        int hi = endx - centx;
+        rotate_clip(targx, c, bbx, &lo, &hi);
+        rotate_clip(targy, s, bby, &lo, &hi);
+        const uint32_t* src = ncv->data + y * stride + centx;
+        const ptrdiff_t base = static_cast<ptrdiff_t>(targy) * bbx + targx;
+        for(int convx = lo ; convx < hi ; ++convx){
+          data[base + convx * step] = src[convx];
+        }
+      }
+    }
+  }
+}
+
+static inline auto
+floordiv(int64_t a, int64_t b) -> int64_t { // 'b' > 0
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// narrow [*lo, *hi) to those 'x' for which 0 <= 'f0' + 'k' * 'x' < 'lim', in
+// 16.16 fixed point, i.e. those which sample within 'lim' pixels.
+static inline auto
+rotate_clip_fixed(int64_t f0, int64_t k, int lim, int* lo, int* hi) -> void {
+  const int64_t b = static_cast<int64_t>(lim) << 16;
+  int64_t l, h;
+  if(k == 0){
+    if(f0 < 0 || f0 >= b){
+      *hi = *lo;
+    }
+    return;
+  }else if(k > 0){
+    l = -floordiv(f0, k);      // ceil(-f0 / k)
+    h = -floordiv(f0 - b, k);  // ceil((b - f0) / k)
+  }else{
+    l = floordiv(f0 - b, -k) + 1;
+    h = floordiv(f0, -k) + 1;
+  }
+  *lo = std::max<int64_t>(*lo, l);
+  *hi = std::min<int64_t>(*hi, h);
+}
+
+// rotate through any other angle by sampling: each pixel of the result takes
+// the nearest source pixel, found by walking the inverse rotation in 16.16
+// fixed point (mapping source pixels forward would leave holes). the pixels
+// of each row which sample from within the visual form a single run, which
+// is found up front, leaving a branch-free inner loop. its loads are a
+// gather, which leaves nothing for vector arithmetic to win; it's scalar.
+static auto
+rotate_sampled(const ncvisual* ncv, uint32_t* data, double stheta, double ctheta,
+               int centy, int centx, int bby, int bbx, int bboffy, int bboffx) -> void {
+  const int stride = ncv->rowstride / 4;
+  const int64_t one = 1 << 16;
+  const int64_t fc = llround(ctheta * one);
+  const int64_t fs = llround(stheta * one);
+  for(int y = 0 ; y < bby ; ++y){
+    const int64_t ty = y + bboffy;
+    // source coordinates of the row's first pixel, plus a half for rounding
+    const int64_t fx = bboffx * fc + ty * fs + centx * one + one / 2;
+    const int64_t fy = -bboffx * fs + ty * fc + centy * one + one / 2;
+    int lo = 0;
+    int hi = bbx;
+    rotate_clip_fixed(fx, fc, ncv->cols, &lo, &hi);
+    rotate_clip_fixed(fy, -fs, ncv->rows, &lo, &hi);
+    uint32_t* dst = data + static_cast<ptrdiff_t>(y) * bbx;
+    for(int x = lo ; x < hi ; ++x){
+      const int sx = (fx + x * fc) >> 16;
+      const int sy = (fy - x * fs) >> 16;
+      dst[x] = ncv->data[sy * stride + sx];
+    }
+  }
+}
+
+auto ncvisual_resize(ncvisual* ncv, int rows, int cols) -> nc_err_e {
+  return ncvisual_resize_quality(ncv, rows, cols, NCSCALEQ_DEFAULT);
+}
+
 auto ncvisual_rotate(ncvisual* ncv, double rads) -> nc_err_e {
   nc_err_e err = ncvisual_resize(ncv, ncv->rows, ncv->cols);
   if(err != NCERR_SUCCESS){
@@ -286,6 +435,7 @@ auto ncvisual_rotate(ncvisual* ncv, double rads) -> nc_err_e {
   double stheta, ctheta; // sine, cosine
   stheta = sin(rads);
   ctheta = cos(rads);
+  const bool quarter = rotate_quarter(&stheta, &ctheta);
   // bounding box for real data within the ncvisual. we must only resize to
   // accommodate real data, lest we grow without band as we rotate.
   // see https://github.com/dankamongmen/notcurses/issues/599.
@@ -311,19 +461,10 @@ auto ncvisual_rotate(ncvisual* ncv, double rads) -> nc_err_e {
   }
   memset(data, 0, bbarea * 4);
 //fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d bbcenty: %d bbcentx: %d\n", bbarea, bby, bbx, centy, centx, bbcenty, bbcentx);
-  for(int y = 0 ; y < ncv->rows ; ++y){
-      for(int x = 0 ; x < ncv->cols ; ++x){
-      int targx = x, targy = y;
-      rotate_point(&targy, &targx, stheta, ctheta, centy, centx);
-      const int deconvx = targx - bboffx;
-      const int deconvy = targy - bboffy;
-      if(deconvy >= 0 && deconvx >= 0 && deconvy < bby && deconvx < bbx){
-        data[deconvy * bbx + deconvx] = ncv->data[y * (ncv->rowstride / 4) + x];
-      }
- //     data[deconvy * (ncv->cols) + deconvx] = ncv->data[y * (ncv->rowstride / 4) + x];
-//fprintf(stderr, "CW: %d/%d (%08x) -> %d/%d (stride: %d)\n", y, x, ncv->data[y * (ncv->rowstride / 4) + x], targy, targx, ncv->rowstride);
-//fprintf(stderr, "wrote %08x to %d (%d)\n", data[targy * ncv->rows + targx], targy * ncv->rows + targx, (targy * ncv->rows + targx) * 4);
-    }
+  if(quarter){
+    rotate_exact(ncv, data, static_cast<int>(stheta), static_cast<int>(ctheta), centy, centx, bby, bbx, bboffy, bboffx);
+  }else{
+    rotate_sampled(ncv, data, stheta, ctheta, centy, centx, bby, bbx, bboffy, bboffx);
   }
   ncvisual_set_data(ncv, data, true);
   ncv->cols = bbx;
@@ -377,9 +518,35 @@ auto ncvisual_from_bgra(const void* bgra, int rows, int rowstride,
   return ncv;
 }
 
+// blit the rendering of a cached image at this geometry, if one is cached.
+// returns 0 on success, -1 on error, and 1 if it must be scaled anew.
+static auto
+ncvisual_blit_cached(ncvisual* ncv, int rows, int cols, ncplane* n,
+                     const struct blitset* bset, int placey, int placex,
+                     int begy, int begx, int leny, int lenx, bool blendcolors,
+                     bool parallel, ncscalequality_e quality,
+                     blitdelta* delta) -> int {
+  if(ncv->cached == nullptr || (rows == ncv->rows && cols == ncv->cols)){
+    return 1;
+  }
+  const uint32_t* pixels;
+  vcachevariant* v = vcache_variant_get(ncv->cached, rows, cols, quality, &pixels);
+  if(v == nullptr){
+    return 1;
+  }
+  const int r = rgba_blit_visual(n, bset, placey, placex, cols * 4, pixels,
+                                 begy, begx, leny, lenx, blendcolors, parallel,
+                                 delta);
+  vcache_variant_release(v);
+  return r < 0 ? -1 : 0;
+}
+
 auto ncvisual_render(notcurses* nc, ncvisual* ncv,
                      const struct ncvisual_options* vopts) -> ncplane* {
-  if(vopts && vopts->flags > NCVISUAL_OPTION_BLEND){
+  if(vopts && vopts->flags >= (NCVISUAL_OPTION_ADAPTIVE << 1u)){
+    return nullptr;
+  }
+  if(vopts && (vopts->quality < NCSCALEQ_DEFAULT || vopts->quality > NCSCALEQ_BOX)){
     return nullptr;
   }
   int lenx = vopts ? vopts->lenx : 0;
@@ -415,7 +582,7 @@ auto ncvisual_render(notcurses* nc, ncvisual* ncv,
   if(!bset){
     return nullptr;
   }
-//fprintf(stderr, "beg/len: %d %d %d %d scale: %d/%d\n", begy, leny, begx, lenx, encoding_y_scale(bset), encoding_x_scale(bset));
+//fprintf(stderr, "beg/len: %d %d %d %d scale: %d/%d\n", begy, leny, begx, lenx, encoding_y_scale(nc, bset), encoding_x_scale(nc, bset));
   int placey = vopts ? vopts->y : 0;
   int placex = vopts ? vopts->x : 0;
   int disprows, dispcols;
@@ -423,14 +590,14 @@ auto ncvisual_render(notcurses* nc, ncvisual* ncv,
 //fprintf(stderr, "INPUT N: %p\n", vopts ? vopts->n : nullptr);
   if((n = (vopts ? vopts->n : nullptr)) == nullptr){ // create plane
     if(!vopts || vopts->scaling == NCSCALE_NONE){
-      dispcols = ncv->cols / encoding_x_scale(bset) + ncv->cols % encoding_x_scale(bset);
-      disprows = ncv->rows / encoding_y_scale(bset) + ncv->rows % encoding_y_scale(bset);
+      dispcols = (ncv->cols + encoding_x_scale(nc, bset) - 1) / encoding_x_scale(nc, bset);
+      disprows = (ncv->rows + encoding_y_scale(nc, bset) - 1) / encoding_y_scale(nc, bset);
     }else if(vopts->scaling == NCSCALE_SCALE){
       notcurses_term_dim_yx(nc, &disprows, &dispcols);
       // FIXME kill FP?
-      double tmpratio = dispcols * encoding_x_scale(bset) / (double)ncv->cols;
-      if(tmpratio * ncv->rows > disprows * encoding_y_scale(bset)){
-        tmpratio = disprows * encoding_y_scale(bset) / (double)ncv->rows;
+      double tmpratio = dispcols * encoding_x_scale(nc, bset) / (double)ncv->cols;
+      if(tmpratio * ncv->rows > disprows * encoding_y_scale(nc, bset)){
+        tmpratio = disprows * encoding_y_scale(nc, bset) / (double)ncv->rows;
         assert(tmpratio <= 1);
         dispcols *= tmpratio;
       }else{
@@ -450,27 +617,133 @@ auto ncvisual_render(notcurses* nc, ncvisual* ncv,
     placex = 0;
   }else{
     if(!vopts || vopts->scaling == NCSCALE_NONE){
-      dispcols = ncv->cols / encoding_x_scale(bset) + ncv->cols % encoding_x_scale(bset);
-      disprows = ncv->rows / encoding_y_scale(bset) + ncv->rows % encoding_y_scale(bset);
-    }else{ // FIXME handle SCALE
+      dispcols = (ncv->cols + encoding_x_scale(nc, bset) - 1) / encoding_x_scale(nc, bset);
+      disprows = (ncv->rows + encoding_y_scale(nc, bset) - 1) / encoding_y_scale(nc, bset);
+    }else{ // NCSCALE_SCALE is fit within this area below
       ncplane_dim_yx(n, &disprows, &dispcols);
       disprows -= placey;
       dispcols -= placex;
     }
   }
-  leny = (leny / (double)ncv->rows) * ((double)disprows * encoding_y_scale(bset));
-  lenx = (lenx / (double)ncv->cols) * ((double)dispcols * encoding_x_scale(bset));
+  blitdelta* delta = nullptr;
+  if(vopts && (vopts->flags & NCVISUAL_OPTION_DELTA)){
+    if(ncv->delta == nullptr){
+      if((ncv->delta = static_cast<blitdelta*>(calloc(1, sizeof(*ncv->delta)))) == nullptr){
+        if(n != vopts->n){
+          ncplane_destroy(n);
+        }
+        return nullptr;
+      }
+    }
+    delta = ncv->delta;
+    delta->threshold = vopts->delta_threshold;
+  }
+  // the geometry to which the visual is scaled. unscaled visuals are blitted
+  // as they are, the blitters padding out any partial cells; rounding them up
+  // to whole cells would read past the end of the image.
+  int rows = ncv->rows;
+  int cols = ncv->cols;
+  if(vopts && vopts->scaling != NCSCALE_NONE){
+    rows = disprows * encoding_y_scale(nc, bset);
+    cols = dispcols * encoding_x_scale(nc, bset);
+    // a plane we created was already sized to the visual's aspect ratio. on
+    // our caller's plane, the visual is drawn at its origin, the blitter
+    // padding out any partial cells, and the remainder is left untouched.
+    if(vopts->scaling == NCSCALE_SCALE && n == vopts->n && rows > 0 && cols > 0){
+      ncvisual_scale_fit(ncv->rows, ncv->cols, rows, cols, &rows, &cols);
+      disprows = (rows + encoding_y_scale(nc, bset) - 1) / encoding_y_scale(nc, bset);
+      dispcols = (cols + encoding_x_scale(nc, bset) - 1) / encoding_x_scale(nc, bset);
+    }
+    leny = (leny / (double)ncv->rows) * rows;
+    lenx = (lenx / (double)ncv->cols) * cols;
+  }
 //fprintf(stderr, "render: %dx%d:%d+%d of %d/%d stride %u %p\n", begy, begx, leny, lenx, ncv->rows, ncv->cols, ncv->rowstride, ncv->data);
-  if(ncvisual_blit(ncv, disprows * encoding_y_scale(bset),
-                   dispcols * encoding_x_scale(bset), n, bset,
-                   placey, placex, begy, begx, leny, lenx,
-                   vopts && (vopts->flags & NCVISUAL_OPTION_BLEND))){
+  const bool blendcolors = vopts && (vopts->flags & NCVISUAL_OPTION_BLEND);
+  const bool parallel = vopts && (vopts->flags & NCVISUAL_OPTION_PARALLEL);
+  const ncscalequality_e quality = vopts ? vopts->quality : NCSCALEQ_DEFAULT;
+  int r = ncvisual_blit_cached(ncv, rows, cols, n, bset, placey, placex, begy,
+                               begx, leny, lenx, blendcolors, parallel,
+                               quality, delta);
+  if(r > 0){
+    r = ncvisual_blit(ncv, rows, cols, n, bset, placey, placex, begy, begx,
+                      leny, lenx, blendcolors, parallel, quality, delta);
+  }
+  if(r){
     ncplane_destroy(n);
     return nullptr;
   }
+  ncv->placey = placey;
+  ncv->placex = placex;
+  ncv->disprows = disprows;
+  ncv->dispcols = dispcols;
   return n;
 }
 
+auto ncvisual_from_file_sized(const char* filename, nc_err_e* err,
+                              int rows, int cols) -> ncvisual* {
+  // the file is examined once, before it's decoded; should it change while
+  // being decoded, the cached image is then stale, and is dropped next time.
+  struct stat st;
+  const bool cacheable = vcache_enabled() && stat(filename, &st) == 0;
+  const uint32_t* pixels;
+  int crows, ccols;
+  vcacheentry* e = nullptr;
+  if(cacheable){
+    e = vcache_lookup(filename, &st, &pixels, &crows, &ccols);
+  }
+  if(e){
+    ncvisual* ncv = ncvisual_from_rgba(pixels, crows, ccols * 4, ccols);
+    if(ncv){
+      ncv->cached = e;
+      *err = NCERR_SUCCESS;
+      return ncv;
+    }
+    vcache_release(e);
+  }
+  // a cached image of any resolution will do, but only full-resolution
+  // decodes are cached, lest they be served to those wanting more
+  bool reduced = false;
+  ncvsource src{};
+  src.path = filename;
+  ncvisual* ncv = ncvisual_open(&src, err, rows, cols, &reduced);
+  // the cache holds RGBA, to which the image must first be converted
+  if(ncv && cacheable && !reduced && ncvisual_still_p(ncv) &&
+     ncvisual_resize(ncv, ncv->rows, ncv->cols) == NCERR_SUCCESS){
+    ncv->cached = vcache_insert(filename, &st, ncv->data, ncv->rows,
+                                ncv->rowstride, ncv->cols);
+  }
+  return ncv;
+}
+
+auto ncvisual_from_file(const char* filename, nc_err_e* err) -> ncvisual* {
+  return ncvisual_from_file_sized(filename, err, 0, 0);
+}
+
+// these aren't cached, lacking a path by which to know them
+auto ncvisual_from_memory(const void* data, size_t len, nc_err_e* err) -> ncvisual* {
+  ncvsource src{};
+  src.data = static_cast<const unsigned char*>(data);
+  src.len = len;
+  src.fd = -1;
+  if(data == nullptr || len == 0){
+    *err = NCERR_DECODE;
+    return nullptr;
+  }
+  bool reduced;
+  return ncvisual_open(&src, err, 0, 0, &reduced);
+}
+
+auto ncvisual_from_fd(int fd, nc_err_e* err) -> ncvisual* {
+  ncvsource src{};
+  src.fd = fd;
+  if(fd < 0){
+    *err = NCERR_DECODE;
+    return nullptr;
+  }
+  bool reduced;
+  return ncvisual_open(&src, err, 0, 0, &reduced);
+}
+
 auto ncvisual_from_plane(const ncplane* n, int begy, int begx,
                          int leny, int lenx) -> ncvisual* {
   uint32_t* rgba = ncplane_rgba(n, begx, begy, leny, lenx);
@@ -496,6 +769,9 @@ auto ncvisual_from_plane(const ncplane* n, int begy, int begx,
 auto ncvisual_destroy(ncvisual* ncv) -> void {
   if(ncv){
     ncvisual_details_destroy(&ncv->details);
+    blitdelta_destroy(ncv->delta);
+    vcache_release(ncv->cached);
+    ncanim_destroy(ncv->anim);
     if(ncv->owndata){
       free(ncv->data);
     }
@@ -524,14 +800,73 @@ auto ncvisual_simple_streamer(ncvisual* ncv, struct ncvisual_options* vopts,
   return ret;
 }
 
+auto ncvisual_tier(const ncvisual* ncv) -> int {
+  return ncv->tier;
+}
+
+auto ncvisual_record(ncvisual* ncv, size_t maxbytes) -> int {
+  if(maxbytes == 0){
+    ncanim_destroy(ncv->anim);
+    ncv->anim = nullptr;
+  }else if(ncv->anim){
+    ncanim_limit(ncv->anim, maxbytes);
+  }else if((ncv->anim = ncanim_create(maxbytes)) == nullptr){
+    return -1;
+  }
+  return 0;
+}
+
+auto ncvisual_replay(ncvisual* ncv, nc_err_e* ncerr, float timescale,
+                     streamcb streamer, const struct ncvisual_options* vopts,
+                     void* curry) -> int {
+  ncvisual_options activevopts;
+  memcpy(&activevopts, vopts, sizeof(*vopts));
+  struct timespec begin;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  const uint64_t nsbegin = timespec_to_ns(&begin);
+  *ncerr = NCERR_SUCCESS;
+  for(size_t f = 0 ; f < ncanim_frames(ncv->anim) ; ++f){
+    if(ncanim_apply(ncv->anim, vopts->n, f)){
+      *ncerr = NCERR_NOMEM;
+      return -1;
+    }
+    struct timespec abstime;
+    ns_to_timespec(nsbegin + ncanim_offset(ncv->anim, f) * timescale, &abstime);
+    int ret;
+    if(streamer){
+      ret = streamer(ncv, &activevopts, &abstime, curry);
+    }else{
+      ret = ncvisual_simple_streamer(ncv, &activevopts, &abstime, curry);
+    }
+    if(ret){
+      return ret;
+    }
+  }
+  *ncerr = NCERR_EOF;
+  return 0;
+}
+
 #ifndef USE_OIIO // built without ffmpeg or oiio
 #ifndef USE_FFMPEG
-auto ncvisual_from_file(const char* filename, nc_err_e* err) -> ncvisual* {
-  (void)filename;
+auto ncvisual_open(const ncvsource* src, nc_err_e* err, int rows, int cols,
+                   bool* reduced) -> ncvisual* {
+  (void)src;
+  (void)rows;
+  (void)cols;
+  (void)reduced;
   *err = NCERR_UNIMPLEMENTED;
   return nullptr;
 }
 
+auto ncvisual_still_p(const ncvisual* ncv) -> bool {
+  (void)ncv;
+  return false;
+}
+
+auto ncvisual_bytes(const ncvisual* ncv) -> size_t {
+  return ncv->data ? static_cast<size_t>(ncv->rows) * ncv->rowstride : 0;
+}
+
 auto notcurses_canopen_images(const notcurses* nc __attribute__ ((unused))) -> bool {
   return false;
 }
@@ -545,6 +880,12 @@ auto ncvisual_decode(ncvisual* nc) -> nc_err_e {
   return NCERR_UNIMPLEMENTED;
 }
 
+auto ncvisual_seek(ncvisual* nc, uint64_t ns) -> nc_err_e {
+  (void)nc;
+  (void)ns;
+  return NCERR_UNIMPLEMENTED;
+}
+
 auto ncvisual_stream(notcurses* nc, ncvisual* ncv, nc_err_e* ncerr,
                     float timescale, streamcb streamer,
                     const ncvisual_options* vopts, void* curry) -> int {
@@ -571,11 +912,29 @@ auto ncvisual_init(int loglevel) -> int {
 auto ncvisual_blit(ncvisual* ncv, int rows, int cols, ncplane* n,
                    const struct blitset* bset, int placey, int placex,
                    int begy, int begx, int leny, int lenx,
-                   bool blendcolors) -> nc_err_e {
-  (void)rows;
-  (void)cols;
-  if(rgba_blit_dispatch(n, bset, placey, placex, ncv->rowstride, ncv->data,
-                        begy, begx, leny, lenx, blendcolors) <= 0){
+                   bool blendcolors, bool parallel,
+                   ncscalequality_e quality, blitdelta* delta) -> nc_err_e {
+  const void* data = ncv->data;
+  int stride = ncv->rowstride;
+  // without a multimedia engine, we only scale when a quality is requested,
+  // and always with the box filter
+  void* scaled = nullptr;
+  if(quality != NCSCALEQ_DEFAULT && (rows != ncv->rows || cols != ncv->cols)){
+    stride = cols * 4;
+    if((scaled = malloc(static_cast<size_t>(stride) * rows)) == nullptr){
+      return NCERR_NOMEM;
+    }
+    if(rgba_scale_box(ncv->data, ncv->rows, ncv->rowstride, ncv->cols,
+                      scaled, rows, stride, cols, 0, rows)){
+      free(scaled);
+      return NCERR_NOMEM;
+    }
+    data = scaled;
+  }
+  const int r = rgba_blit_visual(n, bset, placey, placex, stride, data, begy,
+                                 begx, leny, lenx, blendcolors, parallel, delta);
+  free(scaled);
+  if(r < 0){
     return NCERR_DECODE;
   }
   return NCERR_SUCCESS;
@@ -585,14 +944,33 @@ auto ncvisual_details_seed(struct ncvisual* ncv) -> void {
   (void)ncv;
 }
 
-auto ncvisual_resize(ncvisual* nc, int rows, int cols) -> nc_err_e {
+auto ncvisual_resize_quality(ncvisual* nc, int rows, int cols,
+                             ncscalequality_e quality) -> nc_err_e {
   // we'd need to verify that it's RGBA as well, except that if we've got no
   // multimedia engine, we've only got memory-assembled ncvisuals, which are
   // RGBA-native. so we ought be good, but this is undeniably sloppy...
   if(nc->rows == rows && nc->cols == cols){
     return NCERR_SUCCESS;
   }
-  return NCERR_UNIMPLEMENTED;
+  // as in ncvisual_blit(), only a requested quality is available, as the box
+  // filter
+  if(quality == NCSCALEQ_DEFAULT){
+    return NCERR_UNIMPLEMENTED;
+  }
+  auto scaled = static_cast<uint32_t*>(malloc(static_cast<size_t>(rows) * cols * 4));
+  if(scaled == nullptr){
+    return NCERR_NOMEM;
+  }
+  if(rgba_scale_box(nc->data, nc->rows, nc->rowstride, nc->cols,
+                    scaled, rows, cols * 4, cols, 0, rows)){
+    free(scaled);
+    return NCERR_NOMEM;
+  }
+  ncvisual_set_data(nc, scaled, true);
+  nc->rows = rows;
+  nc->cols = cols;
+  nc->rowstride = cols * 4;
+  return NCERR_SUCCESS;
 }
 
 #endif
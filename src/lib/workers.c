@@ -0,0 +1,159 @@
+#include <signal.h>
+#include <pthread.h>
+#include "internal.h"
+
+// A pool of threads which, along with the caller, work through the bands of
+// a job. Bands are handed out in order from a shared counter, so a band which
+// runs long doesn't hold up the others. Only one job runs at a time.
+
+// more workers than this see diminishing returns on the memory bus
+#define WORKERS_MAX 16
+
+struct workerpool {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;        // a job was posted, or we're shutting down
+  pthread_cond_t done;        // the last outstanding band has finished
+  pthread_t* tids;
+  int count;                  // worker threads (not including the caller)
+  int (*fxn)(void*, int);     // the current job
+  void* arg;
+  int bands;                  // bands in the current job
+  int next;                   // next band to be handed out
+  int outstanding;            // bands not yet finished
+  int ret;                    // ORed results of the current job
+  unsigned generation;        // incremented for each job
+  bool stop;
+};
+
+// run bands of the current job until none remain. call with the lock held.
+static void
+workerpool_drain(workerpool* wp){
+  while(wp->next < wp->bands){
+    const int band = wp->next++;
+    pthread_mutex_unlock(&wp->lock);
+    const int r = wp->fxn(wp->arg, band);
+    pthread_mutex_lock(&wp->lock);
+    if(r){
+      wp->ret = -1;
+    }
+    if(--wp->outstanding == 0){
+      pthread_cond_signal(&wp->done);
+    }
+  }
+}
+
+static void*
+workerpool_thread(void* vwp){
+  workerpool* wp = vwp;
+  unsigned seen = 0;
+  pthread_mutex_lock(&wp->lock);
+  while(true){
+    while(!wp->stop && seen == wp->generation){
+      pthread_cond_wait(&wp->cond, &wp->lock);
+    }
+    if(wp->stop){
+      break;
+    }
+    seen = wp->generation;
+    workerpool_drain(wp);
+  }
+  pthread_mutex_unlock(&wp->lock);
+  return NULL;
+}
+
+static workerpool*
+workerpool_create(void){
+  workerpool* wp = malloc(sizeof(*wp));
+  if(wp == NULL){
+    return NULL;
+  }
+  memset(wp, 0, sizeof(*wp));
+  if(pthread_mutex_init(&wp->lock, NULL)){
+    free(wp);
+    return NULL;
+  }
+  if(pthread_cond_init(&wp->cond, NULL)){
+    pthread_mutex_destroy(&wp->lock);
+    free(wp);
+    return NULL;
+  }
+  if(pthread_cond_init(&wp->done, NULL)){
+    pthread_cond_destroy(&wp->cond);
+    pthread_mutex_destroy(&wp->lock);
+    free(wp);
+    return NULL;
+  }
+  // the caller works too, so one fewer thread than processors
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int want = cpus > 1 ? cpus - 1 : 0;
+  if(want > WORKERS_MAX){
+    want = WORKERS_MAX;
+  }
+  if(want && (wp->tids = malloc(sizeof(*wp->tids) * want))){
+    // signals (e.g. SIGWINCH) must be delivered to the application's threads
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    while(wp->count < want){
+      if(pthread_create(&wp->tids[wp->count], NULL, workerpool_thread, wp)){
+        break; // make do with what we've got
+      }
+      ++wp->count;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+  }
+  return wp;
+}
+
+void workerpool_destroy(workerpool* wp){
+  if(wp){
+    pthread_mutex_lock(&wp->lock);
+    wp->stop = true;
+    pthread_cond_broadcast(&wp->cond);
+    pthread_mutex_unlock(&wp->lock);
+    for(int i = 0 ; i < wp->count ; ++i){
+      pthread_join(wp->tids[i], NULL);
+    }
+    free(wp->tids);
+    pthread_cond_destroy(&wp->done);
+    pthread_cond_destroy(&wp->cond);
+    pthread_mutex_destroy(&wp->lock);
+    free(wp);
+  }
+}
+
+int workerpool_threads(notcurses* nc){
+  if(nc->workers == NULL){
+    if((nc->workers = workerpool_create()) == NULL){
+      return 1;
+    }
+  }
+  return nc->workers->count + 1;
+}
+
+int workerpool_run(notcurses* nc, int bands, int (*fxn)(void*, int), void* arg){
+  if(workerpool_threads(nc) <= 1 || bands <= 1){
+    int ret = 0;
+    for(int b = 0 ; b < bands ; ++b){
+      ret |= fxn(arg, b);
+    }
+    return ret ? -1 : 0;
+  }
+  workerpool* wp = nc->workers;
+  pthread_mutex_lock(&wp->lock);
+  wp->fxn = fxn;
+  wp->arg = arg;
+  wp->bands = bands;
+  wp->next = 0;
+  wp->outstanding = bands;
+  wp->ret = 0;
+  ++wp->generation;
+  pthread_cond_broadcast(&wp->cond);
+  workerpool_drain(wp);
+  while(wp->outstanding){
+    pthread_cond_wait(&wp->done, &wp->lock);
+  }
+  const int ret = wp->ret;
+  pthread_mutex_unlock(&wp->lock);
+  return ret;
+}
@@ -0,0 +1,136 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <stdint.h>
+#include <notcurses/notcurses.h>
+
+// measure the throughput of each blitter, in cells per second, by repeatedly
+// blitting a synthetic image to an offscreen plane. nothing is rendered.
+
+#define IMGROWS 480
+#define IMGCOLS 640
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// a gradient with some noise and a transparent band, so that the blitters
+// take all of their paths
+static uint32_t*
+synth_image(void){
+  uint32_t* rgba = malloc(sizeof(*rgba) * IMGROWS * IMGCOLS);
+  if(rgba){
+    unsigned seed = 1;
+    for(int y = 0 ; y < IMGROWS ; ++y){
+      for(int x = 0 ; x < IMGCOLS ; ++x){
+        seed = seed * 1103515245 + 12345;
+        const unsigned noise = (seed >> 16) % 32;
+        const unsigned r = (x * 255 / IMGCOLS + noise) % 256;
+        const unsigned g = (y * 255 / IMGROWS) % 256;
+        const unsigned b = ((x + y) % 64) * 4;
+        const unsigned a = (y / 16) % 8 == 7 ? 0 : 255;
+        // RGBA in memory order
+        unsigned char* px = (unsigned char*)&rgba[y * IMGCOLS + x];
+        px[0] = r; px[1] = g; px[2] = b; px[3] = a;
+      }
+    }
+  }
+  return rgba;
+}
+
+int main(int argc, char** argv){
+  if(setlocale(LC_ALL, "") == NULL){
+    fprintf(stderr, "Couldn't set locale based off LANG\n");
+    return EXIT_FAILURE;
+  }
+  int iterations = 100;
+  if(argc > 1){
+    iterations = atoi(argv[1]);
+    if(iterations <= 0){
+      fprintf(stderr, "usage: blitbench [iterations]\n");
+      return EXIT_FAILURE;
+    }
+  }
+  const struct {
+    ncblitter_e blitter;
+    const char* name;
+    uint64_t flags;
+  } blitters[] = {
+    { NCBLIT_1x1, "1x1", 0, },
+    { NCBLIT_2x1, "2x1", 0, },
+    { NCBLIT_2x2, "2x2", 0, },
+    { NCBLIT_BRAILLE, "braille", 0, },
+    // only faster given several processors
+    { NCBLIT_2x2, "2x2 par", NCVISUAL_OPTION_PARALLEL, },
+    // the image never changes, so only the first iteration draws anything
+    { NCBLIT_2x2, "2x2 delta", NCVISUAL_OPTION_DELTA, },
+  };
+  const int bcount = sizeof(blitters) / sizeof(*blitters);
+  double cellrate[sizeof(blitters) / sizeof(*blitters)];
+  uint32_t* rgba = synth_image();
+  if(rgba == NULL){
+    return EXIT_FAILURE;
+  }
+  struct notcurses_options nopts = {
+    .flags = NCOPTION_INHIBIT_SETLOCALE,
+    .inhibit_alternate_screen = true,
+    .suppress_banner = true,
+  };
+  struct notcurses* nc = notcurses_init(&nopts, NULL);
+  if(nc == NULL){
+    free(rgba);
+    return EXIT_FAILURE;
+  }
+  struct ncvisual* ncv = ncvisual_from_rgba(rgba, IMGROWS, IMGCOLS * 4, IMGCOLS);
+  free(rgba);
+  if(ncv == NULL){
+    notcurses_stop(nc);
+    return EXIT_FAILURE;
+  }
+  int ret = EXIT_SUCCESS;
+  for(int b = 0 ; b < bcount ; ++b){
+    // the plane is placed offscreen; it is never rendered
+    struct ncplane* n = ncplane_new(nc, IMGROWS, IMGCOLS, 10000, 0, NULL);
+    if(n == NULL){
+      ret = EXIT_FAILURE;
+      break;
+    }
+    struct ncvisual_options vopts = {
+      .n = n,
+      .scaling = NCSCALE_NONE,
+      .blitter = blitters[b].blitter,
+      .flags = blitters[b].flags,
+    };
+    uint64_t cells = 0;
+    const uint64_t start = nowns();
+    for(int i = 0 ; i < iterations ; ++i){
+      if(ncvisual_render(nc, ncv, &vopts) == NULL){
+        ret = EXIT_FAILURE;
+        break;
+      }
+      int geomy, geomx;
+      if(ncvisual_geom(nc, ncv, blitters[b].blitter, &geomy, &geomx, NULL, NULL)){
+        ret = EXIT_FAILURE;
+        break;
+      }
+      cells += (uint64_t)geomy * geomx;
+    }
+    const uint64_t elapsed = nowns() - start;
+    cellrate[b] = elapsed ? cells * 1000000000.0 / elapsed : 0;
+    ncplane_destroy(n);
+  }
+  ncvisual_destroy(ncv);
+  if(notcurses_stop(nc)){
+    return EXIT_FAILURE;
+  }
+  if(ret == EXIT_SUCCESS){
+    for(int b = 0 ; b < bcount ; ++b){
+      printf("%9s: %12.0f cells/s\n", blitters[b].name, cellrate[b]);
+    }
+  }
+  return ret;
+}
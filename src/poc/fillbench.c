@@ -0,0 +1,142 @@
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <stdint.h>
+#include <notcurses/notcurses.h>
+
+// measure the throughput of the whole-plane color kernels, in cells per
+// second, by repeatedly applying each to an offscreen plane. nothing is
+// rendered.
+
+#define PLANEROWS 200
+#define PLANECOLS 400
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+typedef enum {
+  KERNEL_GRADIENT,
+  KERNEL_GRADIENT_UTF8,
+  KERNEL_HIGHGRADIENT,
+  KERNEL_STAIN,
+  KERNEL_FORMAT,
+  KERNEL_GREYSCALE,
+} kernel_e;
+
+// apply the kernel to the entire plane, returning the number of cells hit
+static int
+run_kernel(struct ncplane* n, kernel_e k, int i){
+  uint64_t ul = 0, ur = 0, bl = 0, br = 0;
+  // vary the corners, lest any work be skipped
+  channels_set_fg_rgb(&ul, i % 256, 0x40, 0xc0);
+  channels_set_bg_rgb(&ul, 0x10, i % 256, 0x20);
+  channels_set_fg_rgb(&ur, 0xff, 0xff, i % 256);
+  channels_set_bg_rgb(&ur, 0x80, 0x00, 0xff);
+  channels_set_fg_rgb(&bl, 0x00, i % 256, 0x00);
+  channels_set_bg_rgb(&bl, 0xff, 0xc0, 0x00);
+  channels_set_fg_rgb(&br, 0x20, 0x20, 0x20);
+  channels_set_bg_rgb(&br, i % 256, i % 256, i % 256);
+  if(ncplane_cursor_move_yx(n, 0, 0)){
+    return -1;
+  }
+  switch(k){
+    case KERNEL_GRADIENT:
+      return ncplane_gradient(n, " ", 0, ul, ur, bl, br,
+                              PLANEROWS - 1, PLANECOLS - 1);
+    case KERNEL_GRADIENT_UTF8: // an EGC which must be stashed in the pool
+      return ncplane_gradient(n, "▄", 0, ul, ur, bl, br,
+                              PLANEROWS - 1, PLANECOLS - 1);
+    case KERNEL_HIGHGRADIENT:
+      return ncplane_highgradient(n, channels_fchannel(ul), channels_fchannel(ur),
+                                  channels_fchannel(bl), channels_fchannel(br),
+                                  PLANEROWS - 1, PLANECOLS - 1);
+    case KERNEL_STAIN:
+      return ncplane_stain(n, PLANEROWS - 1, PLANECOLS - 1, ul, ur, bl, br);
+    case KERNEL_FORMAT:
+      return ncplane_format(n, PLANEROWS - 1, PLANECOLS - 1,
+                            i % 2 ? NCSTYLE_BOLD : NCSTYLE_ITALIC);
+    case KERNEL_GREYSCALE:
+      ncplane_greyscale(n);
+      return PLANEROWS * PLANECOLS;
+  }
+  return -1;
+}
+
+int main(int argc, char** argv){
+  if(setlocale(LC_ALL, "") == NULL){
+    fprintf(stderr, "Couldn't set locale based off LANG\n");
+    return EXIT_FAILURE;
+  }
+  int iterations = 100;
+  if(argc > 1){
+    iterations = atoi(argv[1]);
+    if(iterations <= 0){
+      fprintf(stderr, "usage: fillbench [iterations]\n");
+      return EXIT_FAILURE;
+    }
+  }
+  const struct {
+    kernel_e kernel;
+    const char* name;
+  } kernels[] = {
+    { KERNEL_GRADIENT, "gradient", },
+    { KERNEL_GRADIENT_UTF8, "utf8grad", },
+    { KERNEL_HIGHGRADIENT, "highgrad", },
+    { KERNEL_STAIN, "stain", },
+    { KERNEL_FORMAT, "format", },
+    { KERNEL_GREYSCALE, "greyscale", },
+  };
+  const int kcount = sizeof(kernels) / sizeof(*kernels);
+  double cellrate[sizeof(kernels) / sizeof(*kernels)];
+  struct notcurses_options nopts = {
+    .flags = NCOPTION_INHIBIT_SETLOCALE,
+    .inhibit_alternate_screen = true,
+    .suppress_banner = true,
+  };
+  struct notcurses* nc = notcurses_init(&nopts, NULL);
+  if(nc == NULL){
+    return EXIT_FAILURE;
+  }
+  int ret = EXIT_SUCCESS;
+  for(int k = 0 ; k < kcount ; ++k){
+    // the plane is placed offscreen; it is never rendered
+    struct ncplane* n = ncplane_new(nc, PLANEROWS, PLANECOLS, 10000, 0, NULL);
+    if(n == NULL){
+      ret = EXIT_FAILURE;
+      break;
+    }
+    // start from a colored plane, so that stain, format, and greyscale have
+    // something to work with
+    if(run_kernel(n, KERNEL_GRADIENT, 0) < 0){
+      ret = EXIT_FAILURE;
+    }
+    uint64_t cells = 0;
+    const uint64_t start = nowns();
+    for(int i = 0 ; i < iterations && ret == EXIT_SUCCESS ; ++i){
+      const int r = run_kernel(n, kernels[k].kernel, i);
+      if(r < 0){
+        fprintf(stderr, "error running %s\n", kernels[k].name);
+        ret = EXIT_FAILURE;
+        break;
+      }
+      cells += r;
+    }
+    const uint64_t elapsed = nowns() - start;
+    cellrate[k] = elapsed ? cells * 1000000000.0 / elapsed : 0;
+    ncplane_destroy(n);
+  }
+  if(notcurses_stop(nc)){
+    return EXIT_FAILURE;
+  }
+  if(ret == EXIT_SUCCESS){
+    for(int k = 0 ; k < kcount ; ++k){
+      printf("%10s: %12.0f cells/s\n", kernels[k].name, cellrate[k]);
+    }
+  }
+  return ret;
+}
@@ -1,6 +1,8 @@
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <locale.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
@@ -10,15 +12,33 @@ static bool fddone;
 static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 
+// the start of a character split across reads, written with the next one
+static char carry[MB_LEN_MAX];
+static size_t carried;
+
 static int
 cb(struct ncfdplane* ncfd, const void* data, size_t len, void* curry){
   int ret = -1;
-  if(ncplane_putstr(ncfdplane_plane(ncfd), data) >= 0){
+  char* buf = NULL;
+  if(carried){
+    if((buf = malloc(carried + len)) == NULL){
+      return -1;
+    }
+    memcpy(buf, carry, carried);
+    memcpy(buf + carried, data, len);
+    data = buf;
+    len += carried;
+  }
+  const int w = ncplane_putnstr(ncfdplane_plane(ncfd), len, data);
+  if(w >= 0){
+    // anything else unwritten followed a NUL, and is dropped
+    carried = len - w < sizeof(carry) ? len - w : 0;
+    memcpy(carry, (const char*)data + w, carried);
     if(!notcurses_render(ncplane_notcurses(ncfdplane_plane(ncfd)))){
       ret = 0;
     }
   }
-  (void)len;
+  free(buf);
   (void)curry;
   return ret;
 }
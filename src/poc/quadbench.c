@@ -0,0 +1,214 @@
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <stdint.h>
+#include <notcurses/notcurses.h>
+
+// measure the quadrant blitter (NCBLIT_2x2) on a strip of independent 2x2
+// blocks: its throughput in blocks per second, and the mean squared error of
+// its output against that of the best possible choice of quadrants. nothing
+// is rendered.
+
+#define BLOCKS 4096
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// the quadrant glyphs, indexed by the mask of quadrants drawn in the
+// foreground: 1 is the top left, 2 top right, 4 bottom left, 8 bottom right.
+static const char* const quadrants[16] = {
+  " ", "▘", "▝", "▀", "▖", "▌", "▞", "▛",
+  "▗", "▚", "▐", "▜", "▄", "▙", "▟", "█",
+};
+
+static int
+quadrant_mask(const char* egc){
+  for(int m = 0 ; m < 16 ; ++m){
+    if(strcmp(egc, quadrants[m]) == 0){
+      return m;
+    }
+  }
+  // older releases drew the left half with U+258B LEFT FIVE EIGHTHS BLOCK
+  if(strcmp(egc, "▋") == 0){
+    return 5;
+  }
+  return -1;
+}
+
+// the squared error of drawing the pixels 'px' (top left, top right, bottom
+// left, bottom right) with 'fg' where 'mask' is set, and 'bg' elsewhere.
+static unsigned
+block_sse(const unsigned char* px[4], unsigned mask, uint32_t fg, uint32_t bg){
+  unsigned sse = 0;
+  for(int i = 0 ; i < 4 ; ++i){
+    const uint32_t c = (mask >> i) & 1u ? fg : bg;
+    const int dr = px[i][0] - (int)((c >> 16u) & 0xff);
+    const int dg = px[i][1] - (int)((c >> 8u) & 0xff);
+    const int db = px[i][2] - (int)(c & 0xff);
+    sse += dr * dr + dg * dg + db * db;
+  }
+  return sse;
+}
+
+// the least squared error of any two-color quadrant drawing, each color the
+// rounded mean of its pixels. masks and their complements are equivalent.
+static unsigned
+block_optimum(const unsigned char* px[4]){
+  unsigned best = ~0u;
+  for(unsigned m = 0 ; m < 8 ; ++m){
+    const int nf = __builtin_popcount(m);
+    uint32_t fg = 0, bg = 0;
+    for(int k = 0 ; k < 3 ; ++k){
+      int sf = 0, sb = 0;
+      for(int i = 0 ; i < 4 ; ++i){
+        if((m >> i) & 1u){
+          sf += px[i][k];
+        }else{
+          sb += px[i][k];
+        }
+      }
+      const unsigned shift = 16 - 8 * k;
+      fg |= (uint32_t)(nf ? (sf + nf / 2) / nf : 0) << shift;
+      bg |= (uint32_t)((sb + (4 - nf) / 2) / (4 - nf)) << shift;
+    }
+    const unsigned sse = block_sse(px, m, fg, bg);
+    if(sse < best){
+      best = sse;
+    }
+  }
+  return best;
+}
+
+// a strip two pixels high of BLOCKS 2x2 blocks. "noise" blocks are a random
+// color with each channel of each pixel perturbed by up to 32; "random"
+// blocks are four unrelated colors.
+static uint32_t*
+synth_blocks(bool random){
+  uint32_t* rgba = malloc(sizeof(*rgba) * 2 * BLOCKS * 2);
+  if(rgba){
+    unsigned seed = 1;
+    for(int b = 0 ; b < BLOCKS ; ++b){
+      int base[3];
+      for(int k = 0 ; k < 3 ; ++k){
+        seed = seed * 1103515245 + 12345;
+        base[k] = (seed >> 16) & 0xff;
+      }
+      for(int i = 0 ; i < 4 ; ++i){
+        // RGBA in memory order
+        unsigned char* px = (unsigned char*)&rgba[(i / 2) * BLOCKS * 2 + b * 2 + i % 2];
+        for(int k = 0 ; k < 3 ; ++k){
+          seed = seed * 1103515245 + 12345;
+          int v = random ? (int)((seed >> 16) & 0xff) : base[k] + (int)((seed >> 16) % 64) - 32;
+          px[k] = v < 0 ? 0 : v > 255 ? 255 : v;
+        }
+        px[3] = 255;
+      }
+    }
+  }
+  return rgba;
+}
+
+// blit the blocks 'iterations' times, returning the rate in blocks per
+// second, and the mean squared errors of the blitter and of the optimum.
+static int
+run_blocks(struct notcurses* nc, bool random, int iterations,
+           double* rate, double* sse, double* optsse){
+  uint32_t* rgba = synth_blocks(random);
+  if(rgba == NULL){
+    return -1;
+  }
+  struct ncvisual* ncv = ncvisual_from_rgba(rgba, 2, BLOCKS * 2 * 4, BLOCKS * 2);
+  // the plane is placed offscreen; it is never rendered
+  struct ncplane* n = ncplane_new(nc, 1, BLOCKS, 10000, 0, NULL);
+  int ret = -1;
+  if(ncv && n){
+    struct ncvisual_options vopts = {
+      .n = n,
+      .scaling = NCSCALE_NONE,
+      .blitter = NCBLIT_2x2,
+    };
+    ret = 0;
+    const uint64_t start = nowns();
+    for(int i = 0 ; i < iterations ; ++i){
+      if(ncvisual_render(nc, ncv, &vopts) == NULL){
+        ret = -1;
+        break;
+      }
+    }
+    const uint64_t elapsed = nowns() - start;
+    *rate = elapsed ? (double)BLOCKS * iterations * 1000000000.0 / elapsed : 0;
+    uint64_t total = 0, opttotal = 0;
+    for(int b = 0 ; b < BLOCKS && ret == 0 ; ++b){
+      const unsigned char* px[4];
+      for(int i = 0 ; i < 4 ; ++i){
+        px[i] = (const unsigned char*)&rgba[(i / 2) * BLOCKS * 2 + b * 2 + i % 2];
+      }
+      uint64_t channels;
+      char* egc = ncplane_at_yx(n, 0, b, NULL, &channels);
+      const int mask = egc ? quadrant_mask(egc) : -1;
+      free(egc);
+      if(mask < 0){
+        ret = -1;
+        break;
+      }
+      total += block_sse(px, mask, channels_fg(channels), channels_bg(channels));
+      opttotal += block_optimum(px);
+    }
+    *sse = (double)total / BLOCKS;
+    *optsse = (double)opttotal / BLOCKS;
+  }
+  ncplane_destroy(n);
+  ncvisual_destroy(ncv);
+  free(rgba);
+  return ret;
+}
+
+int main(int argc, char** argv){
+  if(setlocale(LC_ALL, "") == NULL){
+    fprintf(stderr, "Couldn't set locale based off LANG\n");
+    return EXIT_FAILURE;
+  }
+  int iterations = 1000;
+  if(argc > 1){
+    iterations = atoi(argv[1]);
+    if(iterations <= 0){
+      fprintf(stderr, "usage: quadbench [iterations]\n");
+      return EXIT_FAILURE;
+    }
+  }
+  struct notcurses_options nopts = {
+    .flags = NCOPTION_INHIBIT_SETLOCALE,
+    .inhibit_alternate_screen = true,
+    .suppress_banner = true,
+  };
+  struct notcurses* nc = notcurses_init(&nopts, NULL);
+  if(nc == NULL){
+    return EXIT_FAILURE;
+  }
+  const char* names[] = { "noise", "random", };
+  double rate[2], sse[2], optsse[2];
+  int ret = EXIT_SUCCESS;
+  for(int r = 0 ; r < 2 ; ++r){
+    if(run_blocks(nc, r, iterations, &rate[r], &sse[r], &optsse[r])){
+      fprintf(stderr, "error blitting %s blocks\n", names[r]);
+      ret = EXIT_FAILURE;
+      break;
+    }
+  }
+  if(notcurses_stop(nc)){
+    return EXIT_FAILURE;
+  }
+  if(ret == EXIT_SUCCESS){
+    for(int r = 0 ; r < 2 ; ++r){
+      printf("%6s: %12.0f blocks/s mean SSE %8.1f (optimum %8.1f)\n",
+             names[r], rate[r], sse[r], optsse[r]);
+    }
+  }
+  return ret;
+}
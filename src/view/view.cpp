@@ -17,10 +17,13 @@ static void usage(std::ostream& os, const char* name, int exitcode)
   __attribute__ ((noreturn));
 
 void usage(std::ostream& o, const char* name, int exitcode){
-  o << "usage: " << name << " [ -h ] [ -m margins ] [ -l loglevel ] [ -d mult ] [ -s scaletype ] [ -k ] files" << '\n';
+  o << "usage: " << name << " [ -h ] [ -m margins ] [ -l loglevel ] [ -d mult ] [ -s scaletype ] [ -q quality ] [ -k ] [ -t ] [ -a ] files" << '\n';
   o << " -k: don't use the alternate screen\n";
+  o << " -t: scale and blit frames using multiple threads\n";
+  o << " -a: use cheaper blitters when video can't keep up\n";
   o << " -l loglevel: integer between 0 and 9, goes to stderr'\n";
   o << " -s scaletype: one of 'none', 'scale', or 'stretch'\n";
+  o << " -q quality: one of 'default', 'fast', 'area', 'bicubic', 'lanczos', or 'box'\n";
   o << " -m margins: margin, or 4 comma-separated margins\n";
   o << " -d mult: non-negative floating point scale for frame time" << std::endl;
   exit(exitcode);
@@ -28,6 +31,9 @@ void usage(std::ostream& o, const char* name, int exitcode){
 
 constexpr auto NANOSECS_IN_SEC = 1000000000ll;
 
+// bound on the visuals held ready by the prefetcher
+constexpr size_t PREFETCH_BYTES = 256 * 1024 * 1024;
+
 static inline auto
 timespec_to_ns(const struct timespec* ts) -> uint64_t {
   return ts->tv_sec * NANOSECS_IN_SEC + ts->tv_nsec;
@@ -61,7 +67,12 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
   clock_gettime(CLOCK_MONOTONIC, &now);
   intmax_t ns = timespec_to_ns(&now) - timespec_to_ns(start);
   // clear top line only
-  stdn->printf(0, NCAlign::Left, "frame %06d\u2026", *framecount);
+  const int tier = ncvisual_tier(ncv);
+  if(tier){
+    stdn->printf(0, NCAlign::Left, "frame %06d (tier %d)\u2026", *framecount, tier);
+  }else{
+    stdn->printf(0, NCAlign::Left, "frame %06d\u2026", *framecount);
+  }
   char* subtitle = ncvisual_subtitle(ncv);
   if(subtitle){
     if(!subtitle_plane){
@@ -116,13 +127,33 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
   return 0;
 }
 
+// the geometry in pixels of the standard plane, to which visuals are scaled
+// according to 'scalemode' (stretched to it, or fit within it). nothing
+// larger needs be decoded.
+static auto
+prefetch_target(NotCurses& nc, ncscale_e scalemode, ncblitter_e blitter,
+                int dimy, int dimx, int* rows, int* cols) -> void {
+  int toy, tox;
+  *rows = *cols = 0;
+  if(scalemode != NCSCALE_NONE &&
+     ncvisual_geom(nc, nullptr, blitter, nullptr, nullptr, &toy, &tox) == 0){
+    *rows = dimy * toy;
+    *cols = dimx * tox;
+  }
+}
+
 // can exit() directly. returns index in argv of first non-option param.
 auto handle_opts(int argc, char** argv, notcurses_options& opts,
-                 float* timescale, ncscale_e* scalemode) -> int {
+                 float* timescale, ncscale_e* scalemode,
+                 ncscalequality_e* quality, bool* parallel,
+                 bool* adaptive) -> int {
   *timescale = 1.0;
   *scalemode = NCSCALE_STRETCH;
+  *quality = NCSCALEQ_DEFAULT;
+  *parallel = false;
+  *adaptive = false;
   int c;
-  while((c = getopt(argc, argv, "hl:d:s:m:k")) != -1){
+  while((c = getopt(argc, argv, "hl:d:s:q:m:kta")) != -1){
     switch(c){
       case 'h':
         usage(std::cout, argv[0], EXIT_SUCCESS);
@@ -133,9 +164,21 @@ auto handle_opts(int argc, char** argv, notcurses_options& opts,
           usage(std::cerr, argv[0], EXIT_FAILURE);
         }
         break;
+      case 'q':
+        if(notcurses_lex_scalequality(optarg, quality)){
+          std::cerr <<  "Quality should be one of default, fast, area, bicubic, lanczos, box" << std::endl;
+          usage(std::cerr, argv[0], EXIT_FAILURE);
+        }
+        break;
       case 'k':{
         opts.inhibit_alternate_screen = true;
         break;
+      }case 't':{
+        *parallel = true;
+        break;
+      }case 'a':{
+        *adaptive = true;
+        break;
       }case 'm':{
         if(opts.margin_t || opts.margin_r || opts.margin_b || opts.margin_l){
           std::cerr <<  "Provided margins twice!" << std::endl;
@@ -190,8 +233,12 @@ auto main(int argc, char** argv) -> int {
   }
   float timescale;
   ncscale_e scalemode;
+  ncscalequality_e quality;
+  bool parallel;
+  bool adaptive;
   notcurses_options nopts{};
-  auto nonopt = handle_opts(argc, argv, nopts, &timescale, &scalemode);
+  auto nonopt = handle_opts(argc, argv, nopts, &timescale, &scalemode,
+                            &quality, &parallel, &adaptive);
   nopts.flags |= NCOPTION_INHIBIT_SETLOCALE;
   NotCurses nc;
   if(!nc.can_open_images()){
@@ -204,23 +251,45 @@ auto main(int argc, char** argv) -> int {
   bool failed = false;
   {
     std::unique_ptr<Plane> stdn(nc.get_stdplane(&dimy, &dimx));
+    // the files following are opened (and stills prescaled) while each is shown
+    ncprefetch_options popts{};
+    popts.maxbytes = PREFETCH_BYTES;
+    popts.scaling = scalemode;
+    popts.quality = quality;
+    prefetch_target(nc, scalemode, blitter, dimy, dimx, &popts.rows, &popts.cols);
+    std::unique_ptr<ncprefetch, decltype(&ncprefetch_destroy)>
+      pf(ncprefetch_create(argv + nonopt, argc - nonopt, &popts), ncprefetch_destroy);
+    if(!pf){
+      nc.stop();
+      std::cerr << "Couldn't start prefetching\n";
+      return EXIT_FAILURE;
+    }
     for(auto i = nonopt ; i < argc ; ++i){
       int frames = 0;
       nc_err_e err;
       std::unique_ptr<Visual> ncv;
       try{
-        ncv = std::make_unique<Visual>(argv[i], &err);
+        ncv = std::make_unique<Visual>(pf.get(), i - nonopt, &err);
       }catch(std::exception& e){
         // FIXME want to stop nc first :/ can't due to stdn, ugh
         std::cerr << argv[i] << ": " << e.what() << "\n";
         failed = true;
         break;
       }
+      // a visual fit within the plane doesn't cover its predecessor
+      stdn->erase();
       struct ncvisual_options vopts{};
       vopts.n = *stdn;
       vopts.scaling = scalemode;
+      vopts.quality = quality;
       vopts.blitter = blitter;
       vopts.flags = NCVISUAL_OPTION_MAYDEGRADE;
+      if(parallel){
+        vopts.flags |= NCVISUAL_OPTION_PARALLEL;
+      }
+      if(adaptive){
+        vopts.flags |= NCVISUAL_OPTION_ADAPTIVE;
+      }
       int r = ncv->stream(&vopts, &err, timescale, perframe, &frames);
       if(r < 0){ // positive is intentional abort
         std::cerr << "Error decoding " << argv[i] << ": " << nc_strerror(err) << std::endl;
@@ -238,12 +307,16 @@ auto main(int argc, char** argv) -> int {
         }else if(ie >= '0' && ie <= '8'){
           --i; // rerun same input with the new blitter
           blitter = static_cast<ncblitter_e>(ie - '0');
+          prefetch_target(nc, scalemode, blitter, dimy, dimx, &popts.rows, &popts.cols);
+          ncprefetch_retarget(pf.get(), popts.rows, popts.cols);
         }else if(ie == NCKey::Resize){
           --i; // rerun with the new size
           if(!nc.refresh(&dimy, &dimx)){
             failed = true;
             break;
           }
+          prefetch_target(nc, scalemode, blitter, dimy, dimx, &popts.rows, &popts.cols);
+          ncprefetch_retarget(pf.get(), popts.rows, popts.cols);
         }
       }
     }
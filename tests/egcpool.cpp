@@ -204,6 +204,28 @@ TEST_CASE("EGCpool") {
     CHECK(candidates.size() / 13 > no);
   }
 
+  // shared storage is copied upon the first modification of either pool
+  SUBCASE("ShareCopyOnWrite") {
+    const char* wstr = "\u8840";
+    int c;
+    auto ulen = utf8_egc_len(wstr, &c);
+    int off = egcpool_stash(&pool_, wstr, ulen);
+    REQUIRE(0 <= off);
+    egcpool shared{};
+    REQUIRE(0 == egcpool_share(&shared, &pool_));
+    CHECK(shared.pool == pool_.pool);
+    REQUIRE(pool_.sharers);
+    CHECK(2 == *pool_.sharers);
+    egcpool_release(&shared, off);
+    CHECK(shared.pool != pool_.pool);
+    CHECK(!shared.sharers);
+    CHECK(0 == shared.poolused);
+    CHECK(!strcmp(pool_.pool + off, wstr));
+    CHECK(ulen + 1 == pool_.poolused);
+    CHECK(1 == *pool_.sharers);
+    egcpool_dump(&shared);
+  }
+
   // common cleanup
   egcpool_dump(&pool_);
 
@@ -27,6 +27,40 @@ auto fadeaborter(struct notcurses* nc, struct ncplane* ncp,
   return 1;
 }
 
+// checks each step of a palette-driven fade: the plane is drawn through the
+// palette, and once its cells have been drawn so, none need be emitted again
+struct palettefade {
+  struct ncplane* n;
+  int steps;
+  uint64_t emissions; // cells emitted after the first step
+  unsigned avoid;     // a palette entry which mustn't be taken, if nonzero
+};
+
+auto palettefader(struct notcurses* nc, struct ncplane* ncp,
+                  const struct timespec* ts, void* curry) -> int {
+  (void)ts;
+  auto pf = static_cast<palettefade*>(curry);
+  CHECK(pf->n == ncp);
+  const cell* c = ncplane_cell_const(ncp, 0, 0);
+  CHECK(cell_fg_palindex_p(c));
+  CHECK(cell_bg_palindex_p(c));
+  if(pf->avoid){
+    CHECK(pf->avoid != cell_fg_palindex(c));
+    CHECK(pf->avoid != cell_bg_palindex(c));
+  }
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  const uint64_t before = stats.cellemissions;
+  if(notcurses_render(nc)){
+    return -1;
+  }
+  notcurses_stats(nc, &stats);
+  if(pf->steps++){
+    pf->emissions += stats.cellemissions - before;
+  }
+  return 0;
+}
+
 TEST_CASE("Fade") {
   notcurses_options nopts{};
   nopts.suppress_banner = true;
@@ -148,6 +182,77 @@ TEST_CASE("Fade") {
     ncfadectx_free(nctx);
   }
 
+  // with few enough colors, the plane is faded through palette entries
+  SUBCASE("FadePalette") {
+    nc_->tcache.RGBflag = true;
+    if(notcurses_canchangecolor(nc_)){
+      struct ncplane* n = ncplane_new(nc_, 4, 8, 0, 0, nullptr);
+      REQUIRE(n);
+      ncplane_set_fg(n, 0x80c040);
+      ncplane_set_bg(n, 0x204060);
+      for(int y = 0 ; y < 4 ; ++y){
+        CHECK(0 < ncplane_putstr_yx(n, y, 0, "abcdefgh"));
+      }
+      CHECK(0 == notcurses_render(nc_));
+      palette256 saved = nc_->palette;
+      struct timespec ts;
+      ts.tv_sec = 0;
+      ts.tv_nsec = 100000000;
+      palettefade pf{n, 0, 0, 0};
+      CHECK(0 == ncplane_fadein(n, &ts, palettefader, &pf));
+      CHECK(0 < pf.steps);
+      CHECK(0 == pf.emissions);
+      const cell* cl = ncplane_cell_const(n, 3, 7);
+      CHECK(!cell_fg_palindex_p(cl));
+      CHECK(0x80c040 == cell_fg(cl));
+      CHECK(0x204060 == cell_bg(cl));
+      CHECK(0 == memcmp(&saved, &nc_->palette, sizeof(saved)));
+      pf = palettefade{n, 0, 0, 0};
+      CHECK(0 == ncplane_fadeout(n, &ts, palettefader, &pf));
+      CHECK(0 < pf.steps);
+      CHECK(0 == pf.emissions);
+      // the cells are back on RGB, faded out, and the palette is as it was
+      for(int y = 0 ; y < 4 ; ++y){
+        for(int x = 0 ; x < 8 ; ++x){
+          cl = ncplane_cell_const(n, y, x);
+          CHECK(!cell_fg_palindex_p(cl));
+          CHECK(!cell_bg_palindex_p(cl));
+          CHECK(0 == cell_fg(cl));
+          CHECK(0 == cell_bg(cl));
+        }
+      }
+      CHECK(0 == memcmp(&saved, &nc_->palette, sizeof(saved)));
+      CHECK(0 == ncplane_destroy(n));
+    }
+  }
+
+  // entries used by other planes are avoided, even if they've not yet been
+  // rendered
+  SUBCASE("FadePaletteAvoidsPlanes") {
+    nc_->tcache.RGBflag = true;
+    if(notcurses_canchangecolor(nc_)){
+      struct ncplane* n = ncplane_new(nc_, 1, 8, 0, 0, nullptr);
+      REQUIRE(n);
+      ncplane_set_fg(n, 0x80c040);
+      ncplane_set_bg(n, 0x204060);
+      CHECK(0 < ncplane_putstr_yx(n, 0, 0, "abcdefgh"));
+      CHECK(0 == notcurses_render(nc_));
+      const unsigned top = NCPALETTESIZE - 1;
+      struct ncplane* other = ncplane_new(nc_, 1, 8, 2, 0, nullptr);
+      REQUIRE(other);
+      CHECK(0 == ncplane_set_fg_palindex(other, top));
+      CHECK(0 < ncplane_putstr_yx(other, 0, 0, "ijklmnop"));
+      struct timespec ts;
+      ts.tv_sec = 0;
+      ts.tv_nsec = 50000000;
+      palettefade pf{n, 0, 0, top};
+      CHECK(0 == ncplane_fadeout(n, &ts, palettefader, &pf));
+      CHECK(0 < pf.steps);
+      CHECK(0 == ncplane_destroy(other));
+      CHECK(0 == ncplane_destroy(n));
+    }
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -1,6 +1,7 @@
 #include <array>
 #include <cstdlib>
 #include "main.h"
+#include "internal.h"
 
 TEST_CASE("Fills") {
   if(!enforce_utf8()){
@@ -434,6 +435,70 @@ TEST_CASE("Fills") {
     ncplane_destroy(p2);
   }
 
+  // the row kernels must produce exactly what the per-cell computations do
+  SUBCASE("GradientsMatchReference") {
+    const int dims[][2] = { {1, 1}, {1, 9}, {7, 1}, {5, 13}, {17, 4}, };
+    struct ncplane* n = ncplane_new(nc_, 17, 13, 0, 0, nullptr);
+    REQUIRE(n);
+    for(auto& dim : dims){
+      const int ylen = dim[0];
+      const int xlen = dim[1];
+      uint64_t ul = 0, ur = 0, bl = 0, br = 0;
+      channels_set_fg(&ul, 0x10f0e0);
+      channels_set_bg(&ul, 0x000000);
+      channels_set_fg(&ur, 0xff0001);
+      channels_set_bg(&ur, 0x7f7f7f);
+      channels_set_fg(&bl, 0x0000ff);
+      channels_set_bg(&bl, 0xffffff);
+      channels_set_fg(&br, 0x808080);
+      channels_set_bg(&br, 0x01fe33);
+      if(ylen == 1){
+        bl = ul;
+        br = ur;
+      }
+      if(xlen == 1){
+        ur = ul;
+        br = bl;
+      }
+      CHECK(0 == ncplane_cursor_move_yx(n, 0, 0));
+      CHECK(ylen * xlen == ncplane_gradient(n, "x", 0, ul, ur, bl, br, ylen - 1, xlen - 1));
+      for(int y = 0 ; y < ylen ; ++y){
+        for(int x = 0 ; x < xlen ; ++x){
+          uint64_t expected = 0;
+          calc_gradient_channels(&expected, ul, ur, bl, br, y, x, ylen, xlen);
+          CHECK(expected == ncplane_cell_const(n, y, x)->channels);
+        }
+      }
+      // stain in the opposite direction atop it
+      CHECK(0 == ncplane_cursor_move_yx(n, 0, 0));
+      CHECK(ylen * xlen == ncplane_stain(n, ylen - 1, xlen - 1, br, bl, ur, ul));
+      for(int y = 0 ; y < ylen ; ++y){
+        for(int x = 0 ; x < xlen ; ++x){
+          uint64_t expected = 0;
+          calc_gradient_channels(&expected, br, bl, ur, ul, y, x, ylen, xlen);
+          CHECK(expected == ncplane_cell_const(n, y, x)->channels);
+        }
+      }
+      const uint32_t ful = channels_fchannel(ul);
+      const uint32_t fur = channels_fchannel(ur);
+      const uint32_t fbl = channels_fchannel(bl);
+      const uint32_t fbr = channels_fchannel(br);
+      if(xlen > 1 || (ful == fur && fbl == fbr)){
+        CHECK(0 == ncplane_cursor_move_yx(n, 0, 0));
+        CHECK(ylen * xlen == ncplane_highgradient(n, ful, fur, fbl, fbr, ylen - 1, xlen - 1));
+        for(int y = 0 ; y < ylen ; ++y){
+          for(int x = 0 ; x < xlen ; ++x){
+            const uint64_t expected = channels_combine(
+                calc_gradient_channel(ful, fur, fbl, fbr, y * 2, x, ylen * 2, xlen),
+                calc_gradient_channel(ful, fur, fbl, fbr, y * 2 + 1, x, ylen * 2, xlen));
+            CHECK(expected == ncplane_cell_const(n, y, x)->channels);
+          }
+        }
+      }
+    }
+    CHECK(0 == ncplane_destroy(n));
+  }
+
 #ifdef USE_QRCODEGEN
   SUBCASE("QRCodes") {
     const char* qr = "a very simple qr code";
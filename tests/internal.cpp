@@ -75,4 +75,48 @@ TEST_CASE("Internals") {
     }
   }
 
+  // BT.601 endpoints and primaries, within rounding
+  SUBCASE("YUVtoRGB") {
+    auto conv = [](unsigned y, unsigned u, unsigned v, bool full, unsigned char* rgb) {
+      int cr, cg, cb;
+      yuv_chroma(u, v, full, &cr, &cg, &cb);
+      yuv_rgb(y, full, cr, cg, cb, rgb);
+    };
+    unsigned char rgb[3];
+    conv(16, 128, 128, false, rgb);
+    CHECK(0 == rgb[0]);
+    CHECK(0 == rgb[1]);
+    CHECK(0 == rgb[2]);
+    conv(235, 128, 128, false, rgb);
+    CHECK(255 == rgb[0]);
+    CHECK(255 == rgb[1]);
+    CHECK(255 == rgb[2]);
+    conv(0, 128, 128, true, rgb);
+    CHECK(0 == rgb[0]);
+    CHECK(0 == rgb[1]);
+    CHECK(0 == rgb[2]);
+    conv(255, 128, 128, true, rgb);
+    CHECK(255 == rgb[0]);
+    CHECK(255 == rgb[1]);
+    CHECK(255 == rgb[2]);
+    // limited-range red, green, and blue
+    conv(81, 90, 240, false, rgb);
+    CHECK(abs(255 - rgb[0]) <= 1);
+    CHECK(rgb[1] <= 1);
+    CHECK(rgb[2] <= 1);
+    conv(145, 54, 34, false, rgb);
+    CHECK(rgb[0] <= 1);
+    CHECK(abs(255 - rgb[1]) <= 1);
+    CHECK(rgb[2] <= 1);
+    conv(41, 240, 110, false, rgb);
+    CHECK(rgb[0] <= 1);
+    CHECK(rgb[1] <= 1);
+    CHECK(abs(255 - rgb[2]) <= 1);
+    // out-of-range results are clamped
+    conv(255, 255, 255, false, rgb);
+    CHECK(255 == rgb[0]);
+    conv(0, 0, 0, false, rgb);
+    CHECK(0 == rgb[0]);
+  }
+
 }
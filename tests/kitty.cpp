@@ -0,0 +1,318 @@
+#include "main.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+// a kitty graphics command, as a terminal would parse it
+struct KittyCommand {
+  std::map<std::string, std::string> keys;
+  std::string payload;
+};
+
+// everything written to the renderfp since 'pos', which is then updated
+static auto
+rendered_since(FILE* fp, long* pos) -> std::string {
+  std::string ret;
+  fflush(fp);
+  fseek(fp, *pos, SEEK_SET);
+  int c;
+  while((c = fgetc(fp)) != EOF){
+    ret += static_cast<char>(c);
+  }
+  *pos = ftell(fp);
+  return ret;
+}
+
+// extract the graphics commands (APC strings beginning with 'G')
+static auto
+kitty_commands(const std::string& frame) -> std::vector<KittyCommand> {
+  std::vector<KittyCommand> cmds;
+  size_t pos = 0;
+  while((pos = frame.find("\x1b_G", pos)) != std::string::npos){
+    const size_t end = frame.find("\x1b\\", pos);
+    REQUIRE(std::string::npos != end);
+    std::string body = frame.substr(pos + 3, end - pos - 3);
+    KittyCommand cmd;
+    const size_t semi = body.find(';');
+    if(semi != std::string::npos){
+      cmd.payload = body.substr(semi + 1);
+      body.resize(semi);
+    }
+    size_t k = 0;
+    while(k < body.size()){
+      size_t comma = body.find(',', k);
+      if(comma == std::string::npos){
+        comma = body.size();
+      }
+      const std::string kv = body.substr(k, comma - k);
+      const size_t eq = kv.find('=');
+      REQUIRE(std::string::npos != eq);
+      cmd.keys[kv.substr(0, eq)] = kv.substr(eq + 1);
+      k = comma + 1;
+    }
+    cmds.push_back(cmd);
+    pos = end + 2;
+  }
+  return cmds;
+}
+
+static auto
+unbase64(const std::string& s) -> std::string {
+  static const std::string alphabet =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string ret;
+  unsigned acc = 0;
+  int bits = 0;
+  for(char c : s){
+    if(c == '='){
+      break;
+    }
+    const size_t v = alphabet.find(c);
+    REQUIRE(std::string::npos != v);
+    acc = (acc << 6u) | v;
+    bits += 6;
+    if(bits >= 8){
+      bits -= 8;
+      ret += static_cast<char>((acc >> bits) & 0xffu);
+    }
+  }
+  return ret;
+}
+
+// count the commands having 'key' set to 'val'
+static auto
+count_with(const std::vector<KittyCommand>& cmds, const char* key,
+           const char* val) -> int {
+  int count = 0;
+  for(const auto& cmd : cmds){
+    auto it = cmd.keys.find(key);
+    if(it != cmd.keys.end() && it->second == val){
+      ++count;
+    }
+  }
+  return count;
+}
+
+// reassemble the pixels of the single image transmitted in 'cmds', reading
+// them from wherever the terminal would, and returning the image id
+static auto
+kitty_pixels(const std::vector<KittyCommand>& cmds, std::string& pixels,
+             char* medium) -> std::string {
+  std::string id;
+  pixels.clear();
+  for(size_t i = 0 ; i < cmds.size() ; ++i){
+    const auto& cmd = cmds[i];
+    auto a = cmd.keys.find("a");
+    if(a == cmd.keys.end() || a->second != "t"){
+      continue;
+    }
+    REQUIRE(id.empty());
+    id = cmd.keys.at("i");
+    CHECK("32" == cmd.keys.at("f"));
+    CHECK("2" == cmd.keys.at("q"));
+    auto t = cmd.keys.find("t");
+    *medium = t == cmd.keys.end() ? 'd' : t->second[0];
+    if(*medium == 'd'){
+      // chunks continue so long as m=1
+      std::string b64 = cmd.payload;
+      size_t c = i;
+      while(cmds[c].keys.at("m") == "1"){
+        ++c;
+        REQUIRE(c < cmds.size());
+        CHECK(1 == cmds[c].keys.size());
+        b64 += cmds[c].payload;
+      }
+      pixels = unbase64(b64);
+      continue;
+    }
+    const std::string path = unbase64(cmd.payload);
+    const size_t size = std::stoul(cmd.keys.at("S"));
+    if(*medium == 's'){
+      int fd = shm_open(path.c_str(), O_RDONLY, 0);
+      REQUIRE(0 <= fd);
+      void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      REQUIRE(MAP_FAILED != map);
+      pixels.assign(static_cast<const char*>(map), size);
+      munmap(map, size);
+      close(fd);
+      // the terminal unlinks the object once it has been read
+      CHECK(0 == shm_unlink(path.c_str()));
+    }else{
+      CHECK(std::string::npos != path.find("tty-graphics-protocol"));
+      FILE* fp = fopen(path.c_str(), "rb");
+      REQUIRE(fp);
+      std::vector<char> buf(size + 1);
+      CHECK(size == fread(buf.data(), 1, buf.size(), fp));
+      fclose(fp);
+      pixels.assign(buf.data(), size);
+      CHECK(0 == unlink(path.c_str()));
+    }
+  }
+  return id;
+}
+
+TEST_CASE("Kitty") {
+  FILE* renderfp = tmpfile();
+  REQUIRE(renderfp);
+  notcurses_options nopts{};
+  nopts.suppress_banner = true;
+  nopts.flags = NCOPTION_KITTY;
+  nopts.renderfp = renderfp;
+  struct notcurses* nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    fclose(renderfp);
+    return;
+  }
+  REQUIRE(notcurses_cankitty(nc_));
+  long pos = 0;
+  CHECK(0 == notcurses_render(nc_));
+  rendered_since(renderfp, &pos);
+  const uint32_t px = 0;
+  auto probe = ncvisual_from_rgba(&px, 1, 4, 1);
+  REQUIRE(probe);
+  int toy, tox;
+  CHECK(0 == ncvisual_geom(nc_, probe, NCBLIT_KITTY, nullptr, nullptr, &toy, &tox));
+  ncvisual_destroy(probe);
+  REQUIRE(0 < toy);
+  REQUIRE(0 < tox);
+  // a column of two cells: the top red, the bottom blue, with a transparent
+  // pixel in its upper left
+  const int rows = toy * 2;
+  const int cols = tox;
+  std::vector<uint32_t> rgba(rows * cols);
+  for(int y = 0 ; y < rows ; ++y){
+    for(int x = 0 ; x < cols ; ++x){
+      rgba[y * cols + x] = y < toy ? 0xff0000ff : 0xffff0000;
+    }
+  }
+  rgba[0] = 0;
+  const std::string expected(reinterpret_cast<const char*>(rgba.data()),
+                             rgba.size() * sizeof(rgba[0]));
+  auto ncv = ncvisual_from_rgba(rgba.data(), rows, cols * 4, cols);
+  REQUIRE(ncv);
+  struct ncvisual_options vopts{};
+  vopts.blitter = NCBLIT_KITTY;
+  vopts.y = 1;
+  vopts.x = 1;
+
+  // each medium must deliver exactly the pixels we blitted
+  SUBCASE("KittyMedia") {
+    for(char want : { 'd', 's', 't' }){
+      nc_->kittymedium = want == 'd' ? KITTY_DIRECT : want == 's' ? KITTY_SHM : KITTY_FILE;
+      auto n = ncvisual_render(nc_, ncv, &vopts);
+      REQUIRE(n);
+      CHECK(0 == notcurses_render(nc_));
+      auto cmds = kitty_commands(rendered_since(renderfp, &pos));
+      std::string pixels;
+      char medium;
+      auto id = kitty_pixels(cmds, pixels, &medium);
+      REQUIRE(!id.empty());
+      CHECK(want == medium);
+      CHECK(expected == pixels);
+      CHECK(std::to_string(cols) == cmds[0].keys.at("s"));
+      CHECK(std::to_string(rows) == cmds[0].keys.at("v"));
+      CHECK(1 == count_with(cmds, "a", "p"));
+      CHECK(0 == ncplane_destroy(n));
+      CHECK(0 == notcurses_render(nc_));
+      cmds = kitty_commands(rendered_since(renderfp, &pos));
+      CHECK(1 == count_with(cmds, "d", "I"));
+      for(const auto& cmd : cmds){
+        if(cmd.keys.count("d") && cmd.keys.at("d") == "I"){
+          CHECK(id == cmd.keys.at("i"));
+        }
+      }
+    }
+  }
+
+  // an image is transmitted once, and then only placed and removed
+  SUBCASE("KittyPlacement") {
+    nc_->kittymedium = KITTY_DIRECT;
+    auto n = ncvisual_render(nc_, ncv, &vopts);
+    REQUIRE(n);
+    CHECK(0 == notcurses_render(nc_));
+    auto cmds = kitty_commands(rendered_since(renderfp, &pos));
+    std::string pixels;
+    char medium;
+    const auto id = kitty_pixels(cmds, pixels, &medium);
+    REQUIRE(!id.empty());
+    REQUIRE(1 == count_with(cmds, "a", "p"));
+    std::string placement;
+    for(const auto& cmd : cmds){
+      if(cmd.keys.count("a") && cmd.keys.at("a") == "p"){
+        CHECK(id == cmd.keys.at("i"));
+        CHECK("1" == cmd.keys.at("C"));
+        placement = cmd.keys.at("p");
+      }
+    }
+    // nothing changed, so nothing is written
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == kitty_commands(rendered_since(renderfp, &pos)).size());
+    // a refresh places the image again, under the same placement
+    CHECK(0 == notcurses_refresh(nc_, nullptr, nullptr));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "a", "t"));
+    CHECK(1 == count_with(cmds, "a", "p"));
+    CHECK(1 == count_with(cmds, "p", placement.c_str()));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == kitty_commands(rendered_since(renderfp, &pos)).size());
+    // a move removes the old placement, and places the image anew
+    CHECK(0 == ncplane_move_yx(n, 3, 4));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "a", "t"));
+    CHECK(1 == count_with(cmds, "a", "p"));
+    CHECK(1 == count_with(cmds, "d", "i"));
+    CHECK(2 == count_with(cmds, "p", placement.c_str()));
+    // an obscured image is removed, and placed again once uncovered
+    auto top = ncplane_new(nc_, 1, 1, 4, 4, nullptr);
+    REQUIRE(top);
+    CHECK(0 < ncplane_putsimple_yx(top, 0, 0, 'x'));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "a", "p"));
+    CHECK(1 == count_with(cmds, "d", "i"));
+    CHECK(0 == ncplane_destroy(top));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "a", "t"));
+    CHECK(1 == count_with(cmds, "a", "p"));
+    // a duplicate places the same image under its own placement
+    auto dup = ncplane_dup(n, nullptr);
+    REQUIRE(dup);
+    CHECK(0 == ncplane_move_yx(dup, 3, 8));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "a", "t"));
+    REQUIRE(1 == count_with(cmds, "a", "p"));
+    CHECK(1 == count_with(cmds, "i", id.c_str()));
+    CHECK(0 == count_with(cmds, "p", placement.c_str()));
+    // the image is only deleted along with its last plane
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(0 == count_with(cmds, "d", "I"));
+    CHECK(1 == count_with(cmds, "d", "i"));
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(0 == notcurses_render(nc_));
+    cmds = kitty_commands(rendered_since(renderfp, &pos));
+    CHECK(1 == count_with(cmds, "d", "I"));
+  }
+
+  // without the kitty protocol, NCBLIT_KITTY degrades only if permitted
+  SUBCASE("KittyDegrade") {
+    nc_->kitty = false;
+    nc_->sixel = false;
+    CHECK(!ncvisual_render(nc_, ncv, &vopts));
+    vopts.flags = NCVISUAL_OPTION_MAYDEGRADE;
+    auto n = ncvisual_render(nc_, ncv, &vopts);
+    REQUIRE(n);
+    CHECK(!n->sprite);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  ncvisual_destroy(ncv);
+  CHECK(0 == notcurses_stop(nc_));
+  fclose(renderfp);
+}
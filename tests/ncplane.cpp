@@ -821,6 +821,161 @@ TEST_CASE("NCPlane") {
     CHECK(ncplane_reparent(ndom, n_)); // *can* reparent *to* standard plane
   }
 
+  SUBCASE("PlaneContents") {
+    struct ncplane* n = ncplane_new(nc_, 2, 4, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "aé"));
+    CHECK(0 < ncplane_putstr_yx(n, 1, 1, "▀z"));
+    char* contents = ncplane_contents(n, 0, 0, -1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "aé▀z"));
+    free(contents);
+    contents = ncplane_contents(n, 1, 1, 1, 2);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "▀z"));
+    free(contents);
+    char buf[8];
+    CHECK(7 == ncplane_contents_buf(n, 0, 0, -1, -1, buf, sizeof(buf)));
+    CHECK(0 == strcmp(buf, "aé▀z"));
+    // truncation must never split an EGC
+    CHECK(7 == ncplane_contents_buf(n, 0, 0, -1, -1, buf, 5));
+    CHECK(0 == strcmp(buf, "aé"));
+    CHECK(7 == ncplane_contents_buf(n, 0, 0, -1, -1, nullptr, 0));
+    CHECK(0 > ncplane_contents_buf(n, 2, 0, -1, -1, buf, sizeof(buf)));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("DupIsCopyOnWrite") {
+    struct ncplane* n = ncplane_new(nc_, 40, 10, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "héllo"));
+    CHECK(0 < ncplane_putstr_yx(n, 39, 0, "wörld"));
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    const uint64_t fbbytes = stats.fbbytes;
+    struct ncplane* dup = ncplane_dup(n, nullptr);
+    REQUIRE(dup);
+    notcurses_stats(nc_, &stats);
+    CHECK(fbbytes == stats.fbbytes); // no framebuffer was copied
+    CHECK(0 < ncplane_putstr_yx(dup, 0, 0, "jé"));
+    notcurses_stats(nc_, &stats);
+    CHECK(fbbytes < stats.fbbytes); // one tile was copied...
+    CHECK(fbbytes + sizeof(cell) * 40 * 10 > stats.fbbytes); // ...but only one
+    char* contents = ncplane_contents(n, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "héllo"));
+    free(contents);
+    contents = ncplane_contents(dup, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "jéllo"));
+    free(contents);
+    contents = ncplane_contents(dup, 39, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "wörld"));
+    free(contents);
+    CHECK(0 == ncplane_destroy(n));
+    contents = ncplane_contents(dup, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "jéllo"));
+    free(contents);
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  SUBCASE("SnapshotRestore") {
+    struct ncplane* n = ncplane_new(nc_, 4, 10, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 < ncplane_putstr_yx(n, 1, 0, "before✓"));
+    struct ncsnapshot* snap = ncplane_snapshot(n);
+    REQUIRE(snap);
+    ncplane_erase(n);
+    CHECK(0 < ncplane_putstr_yx(n, 2, 0, "after"));
+    CHECK(0 == ncplane_resize_simple(n, 6, 12));
+    CHECK(0 == ncplane_restore(n, snap));
+    int dimy, dimx;
+    ncplane_dim_yx(n, &dimy, &dimx);
+    CHECK(4 == dimy);
+    CHECK(10 == dimx);
+    char* contents = ncplane_contents(n, 0, 0, -1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "before✓"));
+    free(contents);
+    // the snapshot survives modification of the restored plane
+    CHECK(0 < ncplane_putstr_yx(n, 1, 0, "x"));
+    CHECK(0 == ncplane_restore(n, snap));
+    contents = ncplane_contents(n, 0, 0, -1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "before✓"));
+    free(contents);
+    ncsnapshot_destroy(snap);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("SparseFramebuffer") {
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    const uint64_t fbbytes = stats.fbbytes;
+    // a large virtual plane costs nothing until it is written
+    struct ncplane* n = ncplane_new(nc_, 100000, 200, 0, 0, nullptr);
+    REQUIRE(n);
+    notcurses_stats(nc_, &stats);
+    CHECK(fbbytes == stats.fbbytes);
+    CHECK(0 < ncplane_putstr_yx(n, 50000, 10, "sparse"));
+    notcurses_stats(nc_, &stats);
+    CHECK(fbbytes < stats.fbbytes);
+    CHECK(fbbytes + 200 * 16 * sizeof(cell) >= stats.fbbytes);
+    char* egc = ncplane_at_yx(n, 50000, 10, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "s"));
+    free(egc);
+    egc = ncplane_at_yx(n, 99999, 199, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, ""));
+    free(egc);
+    // growing the plane vertically shares the written tile
+    const uint64_t written = stats.fbbytes;
+    CHECK(0 == ncplane_resize_simple(n, 100016, 200));
+    notcurses_stats(nc_, &stats);
+    CHECK(written == stats.fbbytes);
+    char* contents = ncplane_contents(n, 50000, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "sparse"));
+    free(contents);
+    CHECK(0 == notcurses_render(nc_));
+    ncplane_erase(n);
+    notcurses_stats(nc_, &stats);
+    CHECK(fbbytes == stats.fbbytes);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("PlaneRGBA") {
+    struct ncplane* n = ncplane_new(nc_, 1, 3, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 == ncplane_set_fg_rgb(n, 0x10, 0x20, 0x30));
+    CHECK(0 == ncplane_set_bg_rgb(n, 0x40, 0x50, 0x60));
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, " ▄█"));
+    uint32_t* rgba = ncplane_rgba(n, 0, 0, -1, -1);
+    REQUIRE(rgba);
+    uint32_t buf[6];
+    CHECK(0 == ncplane_rgba_buf(n, 0, 0, -1, -1, buf));
+    CHECK(0 == memcmp(rgba, buf, sizeof(buf)));
+    CHECK(buf[0] == buf[3]); // space is all background
+    CHECK(buf[1] != buf[4]); // lower half block splits the cell
+    CHECK(buf[0] == buf[1]); // ...with background on top
+    CHECK(buf[2] == buf[5]); // full block is all foreground
+    CHECK(buf[4] == buf[5]); // ...as is the lower half block's bottom
+    free(rgba);
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "▀"));
+    CHECK(0 == ncplane_rgba_buf(n, 0, 0, -1, -1, buf));
+    CHECK(buf[0] == buf[2]); // upper half block has foreground on top
+    CHECK(buf[3] == buf[1]); // ...and background on the bottom
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "x"));
+    CHECK(!ncplane_rgba(n, 0, 0, -1, -1));
+    CHECK(0 > ncplane_rgba_buf(n, 0, 0, -1, -1, buf));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -213,6 +213,139 @@ TEST_CASE("Rotate") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // quarter turns move every pixel exactly
+  SUBCASE("RotateRGBAQuarters") {
+    auto pixel = [](uint32_t rgb) -> uint32_t {
+      return 0xff000000ul | ((rgb & 0xff) << 16u) | (rgb & 0xff00) | (rgb >> 16u);
+    };
+    const uint32_t rgb[] = {
+      0x100000, 0x200000, 0x300000,
+      0x001000, 0x002000, 0x003000,
+    };
+    std::vector<uint32_t> rgba;
+    for(auto p : rgb){
+      rgba.push_back(pixel(p));
+    }
+    auto ncv = ncvisual_from_rgba(rgba.data(), 2, 12, 3);
+    REQUIRE(ncv);
+    auto check = [&](int rows, int cols, const uint32_t* expected) {
+      struct ncplane* n = ncplane_new(nc_, rows, cols, 0, 0, nullptr);
+      REQUIRE(n);
+      struct ncvisual_options opts{};
+      opts.n = n;
+      opts.scaling = NCSCALE_NONE;
+      opts.blitter = NCBLIT_1x1;
+      CHECK(n == ncvisual_render(nc_, ncv, &opts));
+      for(int y = 0 ; y < rows ; ++y){
+        for(int x = 0 ; x < cols ; ++x){
+          uint64_t channels;
+          char* egc = ncplane_at_yx(n, y, x, nullptr, &channels);
+          REQUIRE(egc);
+          free(egc);
+          CHECK(expected[y * cols + x] == channels_bg(channels));
+        }
+      }
+      CHECK(0 == ncplane_destroy(n));
+    };
+    const uint32_t quarter[] = {
+      0x300000, 0x003000,
+      0x200000, 0x002000,
+      0x100000, 0x001000,
+    };
+    const uint32_t flipped[] = {
+      0x003000, 0x002000, 0x001000,
+      0x300000, 0x200000, 0x100000,
+    };
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, M_PI / 2));
+    check(3, 2, quarter);
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, M_PI / 2));
+    check(2, 3, flipped);
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, -M_PI / 2));
+    check(3, 2, quarter);
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, -M_PI / 2));
+    check(2, 3, rgb);
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, M_PI));
+    check(2, 3, flipped);
+    ncvisual_destroy(ncv);
+  }
+
+  // other angles sample the source, leaving no holes within the image
+  SUBCASE("RotateRGBASampled") {
+    const int dim = 32;
+    std::vector<uint32_t> rgba(dim * dim, 0xffbbccff);
+    auto ncv = ncvisual_from_rgba(rgba.data(), dim, dim * 4, dim);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, M_PI / 4));
+    int rows, cols;
+    CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_1x1, &rows, &cols, nullptr, nullptr));
+    CHECK(rows > dim);
+    CHECK(cols > dim);
+    struct ncplane* n = ncplane_new(nc_, rows, cols, 0, 0, nullptr);
+    REQUIRE(n);
+    struct ncvisual_options opts{};
+    opts.n = n;
+    opts.scaling = NCSCALE_NONE;
+    opts.blitter = NCBLIT_1x1;
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    // the inscribed square of the rotated image is entirely covered
+    for(int y = rows / 2 - dim / 3 ; y < rows / 2 + dim / 3 ; ++y){
+      for(int x = cols / 2 - dim / 3 ; x < cols / 2 + dim / 3 ; ++x){
+        uint64_t channels;
+        char* egc = ncplane_at_yx(n, y, x, nullptr, &channels);
+        REQUIRE(egc);
+        free(egc);
+        CHECK(0xffccbb == channels_bg(channels));
+      }
+    }
+    CHECK(0 == ncplane_destroy(n));
+    ncvisual_destroy(ncv);
+  }
+
+  // four clockwise rotations ought restore the plane's halves exactly
+  SUBCASE("RotatePlaneRoundTrip") {
+    struct ncplane* testn = ncplane_new(nc_, 40, 70, 0, 0, nullptr);
+    REQUIRE(testn);
+    for(int y = 0 ; y < 40 ; ++y){
+      for(int x = 0 ; x < 70 ; ++x){
+        uint64_t channels = 0;
+        channels_set_fg(&channels, (y << 8u) | x);
+        channels_set_bg(&channels, (y << 8u) | x | 0x800000);
+        ncplane_set_channels(testn, channels);
+        CHECK(0 < ncplane_putegc_yx(testn, y, x, "▀", nullptr));
+      }
+    }
+    CHECK(0 == ncplane_rotate_cw(testn));
+    int rows, cols;
+    ncplane_dim_yx(testn, &rows, &cols);
+    CHECK(35 == rows);
+    CHECK(80 == cols);
+    // the top left cell holds the bottom halves of the bottom left pair
+    uint64_t channels;
+    char* egc = ncplane_at_yx(testn, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "▀"));
+    free(egc);
+    CHECK(((39u << 8u) | 0x800000) == channels_fg(channels));
+    CHECK(((39u << 8u) | 1 | 0x800000) == channels_bg(channels));
+    for(int i = 0 ; i < 3 ; ++i){
+      CHECK(0 == ncplane_rotate_cw(testn));
+    }
+    ncplane_dim_yx(testn, &rows, &cols);
+    CHECK(40 == rows);
+    CHECK(70 == cols);
+    for(unsigned y = 0 ; y < 40 ; ++y){
+      for(unsigned x = 0 ; x < 70 ; ++x){
+        egc = ncplane_at_yx(testn, y, x, nullptr, &channels);
+        REQUIRE(egc);
+        CHECK(0 == strcmp(egc, "▀"));
+        free(egc);
+        CHECK(((y << 8u) | x) == channels_fg(channels));
+        CHECK(((y << 8u) | x | 0x800000) == channels_bg(channels));
+      }
+    }
+    CHECK(0 == ncplane_destroy(testn));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
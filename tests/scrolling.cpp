@@ -1,5 +1,6 @@
 #include "main.h"
 #include <array>
+#include <string>
 #include <cstdlib>
 #include "internal.h"
 
@@ -171,6 +172,109 @@ TEST_CASE("Scrolling") {
     CHECK(10 == x);
   }
 
+  // a large chunk written in one go to a scrolling plane must leave it just
+  // as writing it one EGC at a time would (the latter never scrolls in bulk)
+  SUBCASE("BulkScrollingMatchesIncremental") {
+    std::string text;
+    for(int i = 0 ; i < 200 ; ++i){
+      text += std::to_string(i);
+      text += std::string(i % 23, i % 3 ? 'x' : ' ');
+      if(i % 5 == 0){
+        text += "全角";
+      }
+      if(i % 7){
+        text += '\n';
+      }
+    }
+    struct ncplane* bulk = ncplane_new(nc_, 5, 12, 1, 1, nullptr);
+    REQUIRE(bulk);
+    struct ncplane* ref = ncplane_new(nc_, 5, 12, 1, 20, nullptr);
+    REQUIRE(ref);
+    CHECK(!ncplane_set_scrolling(bulk, true));
+    CHECK(!ncplane_set_scrolling(ref, true));
+    CHECK(0 < ncplane_putstr(bulk, "pre\nexisting"));
+    CHECK(0 < ncplane_putstr(ref, "pre\nexisting"));
+    CHECK((int)text.size() == ncplane_putstr(bulk, text.c_str()));
+    const char* egcs = text.c_str();
+    while(*egcs){
+      int sbytes;
+      REQUIRE(0 <= ncplane_putegc(ref, egcs, &sbytes));
+      egcs += sbytes;
+    }
+    int by, bx, ry, rx;
+    ncplane_cursor_yx(bulk, &by, &bx);
+    ncplane_cursor_yx(ref, &ry, &rx);
+    CHECK(ry == by);
+    CHECK(rx == bx);
+    for(int y = 0 ; y < 5 ; ++y){
+      char* b = ncplane_contents(bulk, y, 0, 1, -1);
+      char* r = ncplane_contents(ref, y, 0, 1, -1);
+      REQUIRE(b);
+      REQUIRE(r);
+      CHECK(0 == strcmp(b, r));
+      free(b);
+      free(r);
+    }
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(bulk));
+    CHECK(0 == ncplane_destroy(ref));
+  }
+
+  // ncplane_putnstr() mustn't look beyond the bytes it was given
+  SUBCASE("PutnstrUnterminated") {
+    struct ncplane* n = ncplane_new(nc_, 2, 20, 1, 1, nullptr);
+    REQUIRE(n);
+    const char buf[] = { 'a', 'b', '\xc3', '\xa9', '\xcc', '\x81' };
+    CHECK(4 == ncplane_putnstr(n, 4, buf));
+    char* contents = ncplane_contents(n, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abé"));
+    free(contents);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // a character split across two calls is written by the second, the first
+  // stopping short of it
+  SUBCASE("PutnstrSplitCharacter") {
+    struct ncplane* n = ncplane_new(nc_, 2, 20, 1, 1, nullptr);
+    REQUIRE(n);
+    const char buf[] = "ab\xc3\xa9" "cd";
+    CHECK(2 == ncplane_putnstr(n, 3, buf));
+    CHECK(4 == ncplane_putnstr(n, 4, buf + 2));
+    char* contents = ncplane_contents(n, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abécd"));
+    free(contents);
+    // likewise when the first call scrolls in bulk
+    CHECK(!ncplane_set_scrolling(n, true));
+    CHECK(0 == ncplane_cursor_move_yx(n, 0, 0));
+    std::string text(50, 'x');
+    text += "\xe2\x82\xac"; // U+20AC EURO SIGN
+    CHECK(50 == ncplane_putnstr(n, 52, text.data()));
+    CHECK(3 == ncplane_putnstr(n, 3, text.data() + 50));
+    contents = ncplane_contents(n, 1, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "xxxxxxxxxx€"));
+    free(contents);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // an EGC ending the buffer can be arbitrarily long
+  SUBCASE("PutnstrLongEGC") {
+    struct ncplane* n = ncplane_new(nc_, 2, 20, 1, 1, nullptr);
+    REQUIRE(n);
+    std::string egc = "e";
+    for(int i = 0 ; i < 100 ; ++i){
+      egc += "\xcc\x81"; // U+0301 COMBINING ACUTE ACCENT
+    }
+    CHECK((int)egc.size() == ncplane_putnstr(n, egc.size(), egc.data()));
+    char* contents = ncplane_contents(n, 0, 0, 1, -1);
+    REQUIRE(contents);
+    CHECK(egc == contents);
+    free(contents);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   // make sure that, after scrolling a line up, our y specifications are
   // correctly adjusted for scrolling.
   SUBCASE("XYPostScroll") {
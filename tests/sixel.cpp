@@ -0,0 +1,183 @@
+#include "main.h"
+#include <string>
+#include <vector>
+
+// everything written to the renderfp since 'pos', which is then updated
+static auto
+rendered_since(FILE* fp, long* pos) -> std::string {
+  std::string ret;
+  fflush(fp);
+  fseek(fp, *pos, SEEK_SET);
+  int c;
+  while((c = fgetc(fp)) != EOF){
+    ret += static_cast<char>(c);
+  }
+  *pos = ftell(fp);
+  return ret;
+}
+
+// 'count' of the sixel having 'bits', run-length encoded as we expect
+static auto
+sixel_run(unsigned bits, int count) -> std::string {
+  const char c = static_cast<char>(63 + bits);
+  if(count > 3){
+    return "!" + std::to_string(count) + c;
+  }
+  return std::string(count, c);
+}
+
+TEST_CASE("Sixel") {
+  FILE* renderfp = tmpfile();
+  REQUIRE(renderfp);
+  notcurses_options nopts{};
+  nopts.suppress_banner = true;
+  nopts.flags = NCOPTION_SIXEL;
+  nopts.renderfp = renderfp;
+  struct notcurses* nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    fclose(renderfp);
+    return;
+  }
+  REQUIRE(notcurses_cansixel(nc_));
+  long pos = 0;
+  CHECK(0 == notcurses_render(nc_));
+  rendered_since(renderfp, &pos);
+  // the pixel geometry of a cell depends on the terminal
+  const uint32_t px = 0;
+  auto probe = ncvisual_from_rgba(&px, 1, 4, 1);
+  REQUIRE(probe);
+  int toy, tox;
+  CHECK(0 == ncvisual_geom(nc_, probe, NCBLIT_SIXEL, nullptr, nullptr, &toy, &tox));
+  ncvisual_destroy(probe);
+  REQUIRE(0 < toy);
+  REQUIRE(0 < tox);
+
+  // a column of two cells, the top red and the bottom blue, ought be drawn
+  // byte-for-byte as we expect, only when it changes or moves.
+  SUBCASE("SixelDamage") {
+    const int rows = toy * 2;
+    const int cols = tox;
+    std::vector<uint32_t> rgba(rows * cols);
+    for(int y = 0 ; y < rows ; ++y){
+      for(int x = 0 ; x < cols ; ++x){
+        // RGBA in memory order
+        rgba[y * cols + x] = y < toy ? 0xff0000ff : 0xffff0000;
+      }
+    }
+    // blue has the lower bucket, and thus gets the first color register
+    std::string expected = "\x1bP0;1;0q\"1;1;" + std::to_string(cols) + ";" +
+                           std::to_string(rows) + "#0;2;0;0;100#1;2;100;0;0";
+    for(int band = 0 ; band < rows ; band += 6){
+      unsigned red = 0, blue = 0;
+      for(int y = band ; y < band + 6 && y < rows ; ++y){
+        if(y < toy){
+          red |= 1u << (y - band);
+        }else{
+          blue |= 1u << (y - band);
+        }
+      }
+      if(red){
+        expected += "#1" + sixel_run(red, cols);
+      }
+      if(blue){
+        expected += std::string(red ? "$" : "") + "#0" + sixel_run(blue, cols);
+      }
+      if(band + 6 < rows){
+        expected += "-";
+      }
+    }
+    expected += "\x1b\\";
+    auto ncv = ncvisual_from_rgba(rgba.data(), rows, cols * 4, cols);
+    REQUIRE(ncv);
+    struct ncvisual_options vopts{};
+    vopts.blitter = NCBLIT_SIXEL;
+    vopts.y = 1;
+    vopts.x = 1;
+    auto n = ncvisual_render(nc_, ncv, &vopts);
+    ncvisual_destroy(ncv);
+    REQUIRE(n);
+    int dimy, dimx;
+    ncplane_dim_yx(n, &dimy, &dimx);
+    CHECK(2 == dimy);
+    CHECK(1 == dimx);
+    // the cells approximate the graphic
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    free(egc);
+    CHECK(0xff0000 == channels_bg(channels));
+    CHECK(0 == notcurses_render(nc_));
+    auto frame = rendered_since(renderfp, &pos);
+    auto at = frame.find(expected);
+    CHECK(std::string::npos != at);
+    CHECK(std::string::npos == frame.find("\x1bP", at + 1));
+    // nothing has changed; the graphic needn't be written again
+    CHECK(0 == notcurses_render(nc_));
+    frame = rendered_since(renderfp, &pos);
+    CHECK(std::string::npos == frame.find("\x1bP"));
+    // moving it requires it be redrawn
+    CHECK(0 == ncplane_move_yx(n, 2, 2));
+    CHECK(0 == notcurses_render(nc_));
+    frame = rendered_since(renderfp, &pos);
+    CHECK(std::string::npos != frame.find(expected));
+    // obscuring it with a plane above it leaves only the text
+    auto top = ncplane_new(nc_, 1, 1, 3, 2, nullptr);
+    REQUIRE(top);
+    CHECK(0 < ncplane_putsimple_yx(top, 0, 0, 'x'));
+    CHECK(0 == notcurses_render(nc_));
+    frame = rendered_since(renderfp, &pos);
+    CHECK(std::string::npos == frame.find("\x1bP"));
+    CHECK(0 == ncplane_destroy(top));
+    CHECK(0 == notcurses_render(nc_));
+    frame = rendered_since(renderfp, &pos);
+    CHECK(std::string::npos != frame.find(expected));
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(0 == notcurses_render(nc_));
+    frame = rendered_since(renderfp, &pos);
+    CHECK(std::string::npos == frame.find("\x1bP"));
+  }
+
+  // thousands of colors are reduced to a palette of 256
+  SUBCASE("SixelQuantization") {
+    const int dim = 64;
+    std::vector<uint32_t> rgba(dim * dim);
+    for(int y = 0 ; y < dim ; ++y){
+      for(int x = 0 ; x < dim ; ++x){
+        const uint32_t r = (x % 32) * 8;
+        const uint32_t g = (y % 32) * 8;
+        const uint32_t b = ((x / 32) * 2 + y / 32) * 64;
+        rgba[y * dim + x] = 0xff000000u | (b << 16u) | (g << 8u) | r;
+      }
+    }
+    auto ncv = ncvisual_from_rgba(rgba.data(), dim, dim * 4, dim);
+    REQUIRE(ncv);
+    struct ncvisual_options vopts{};
+    vopts.blitter = NCBLIT_SIXEL;
+    auto n = ncvisual_render(nc_, ncv, &vopts);
+    ncvisual_destroy(ncv);
+    REQUIRE(n);
+    CHECK(0 == notcurses_render(nc_));
+    auto frame = rendered_since(renderfp, &pos);
+    auto start = frame.find("\x1bP");
+    REQUIRE(std::string::npos != start);
+    auto end = frame.find("\x1b\\", start);
+    REQUIRE(std::string::npos != end);
+    const std::string glyph = frame.substr(start, end - start);
+    // color introducers defining a register are followed by ';', while
+    // those selecting one are followed by sixel data
+    int registers = 0;
+    for(auto p = glyph.find('#') ; p != std::string::npos ; p = glyph.find('#', p + 1)){
+      auto q = glyph.find_first_not_of("0123456789", p + 1);
+      if(q != std::string::npos && glyph[q] == ';'){
+        ++registers;
+      }
+    }
+    CHECK(256 == registers);
+    CHECK(std::string::npos != glyph.find("#255"));
+    CHECK(std::string::npos == glyph.find("#256"));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+  fclose(renderfp);
+}
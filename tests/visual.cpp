@@ -1,5 +1,13 @@
 #include "main.h"
+#include <cmath>
+#include <algorithm>
 #include <vector>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
 
 TEST_CASE("Visual") {
   notcurses_options nopts{};
@@ -60,6 +68,95 @@ TEST_CASE("Visual") {
     ncvisual_destroy(ncv);
   }
 
+  SUBCASE("LoadImageSized") {
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto full = ncvisual_from_file(find_data("changes.jpg"), &ncerr);
+    REQUIRE(full);
+    int fully, fullx;
+    CHECK(0 == ncvisual_geom(nc_, full, NCBLIT_DEFAULT, &fully, &fullx, nullptr, nullptr));
+    ncvisual_destroy(full);
+    const int rows = fully / 5, cols = fullx / 5;
+    auto ncv = ncvisual_from_file_sized(find_data("changes.jpg"), &ncerr, rows, cols);
+    REQUIRE(ncv);
+    REQUIRE(NCERR_SUCCESS == ncerr);
+    int y, x;
+    CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_DEFAULT, &y, &x, nullptr, nullptr));
+    // possibly reduced, but never below what we asked for
+    CHECK(rows <= y);
+    CHECK(y <= fully);
+    CHECK(cols <= x);
+    CHECK(x <= fullx);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    CHECK(0 == notcurses_render(nc_));
+    ncvisual_destroy(ncv);
+  }
+
+  // the encoded image, wherever it comes from, decodes identically
+  SUBCASE("LoadImageFromMemory") {
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto full = ncvisual_from_file(find_data("changes.jpg"), &ncerr);
+    REQUIRE(full);
+    std::ifstream in(find_data("changes.jpg"), std::ios::binary);
+    std::vector<char> jpeg((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    REQUIRE(jpeg.size());
+    auto ncv = ncvisual_from_memory(jpeg.data(), jpeg.size(), &ncerr);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncerr);
+    int y, x, fully, fullx;
+    CHECK(0 == ncvisual_geom(nc_, full, NCBLIT_DEFAULT, &fully, &fullx, nullptr, nullptr));
+    CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_DEFAULT, &y, &x, nullptr, nullptr));
+    CHECK(fully == y);
+    CHECK(fullx == x);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(NCERR_EOF == ncvisual_decode(ncv));
+    ncvisual_destroy(ncv);
+    // garbage is refused
+    std::vector<char> junk(jpeg.size(), 'x');
+    CHECK(!ncvisual_from_memory(junk.data(), junk.size(), &ncerr));
+    CHECK(NCERR_SUCCESS != ncerr);
+    ncvisual_destroy(full);
+  }
+
+  SUBCASE("LoadImageFromPipe") {
+    std::ifstream in(find_data("changes.jpg"), std::ios::binary);
+    std::vector<char> jpeg((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    REQUIRE(jpeg.size());
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+    std::thread writer([&jpeg, &fds]{
+      size_t off = 0;
+      while(off < jpeg.size()){
+        auto w = write(fds[1], jpeg.data() + off, jpeg.size() - off);
+        if(w <= 0){
+          break;
+        }
+        off += w;
+      }
+      close(fds[1]);
+    });
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto ncv = ncvisual_from_fd(fds[0], &ncerr);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncerr);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    CHECK(0 == notcurses_render(nc_));
+    ncvisual_destroy(ncv);
+    writer.join();
+    close(fds[0]);
+  }
+
   SUBCASE("PlaneDuplicate") {
     nc_err_e ncerr = NCERR_SUCCESS;
     int dimy, dimx;
@@ -113,6 +210,40 @@ TEST_CASE("Visual") {
     }
   }
 
+  SUBCASE("StreamVideoFromPipe") {
+    if(notcurses_canopen_videos(nc_)){
+      int fds[2];
+      REQUIRE(0 == pipe(fds));
+      std::thread writer([&fds]{
+        int fd = open(find_data("fm6.mkv"), O_RDONLY | O_CLOEXEC);
+        if(fd >= 0){
+          char buf[BUFSIZ];
+          ssize_t r;
+          while((r = read(fd, buf, sizeof(buf))) > 0){
+            if(write(fds[1], buf, r) != r){
+              break;
+            }
+          }
+          close(fd);
+        }
+        close(fds[1]);
+      });
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncvisual_from_fd(fds[0], &ncerr);
+      REQUIRE(ncv);
+      CHECK(NCERR_SUCCESS == ncerr);
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0, nullptr, &opts, nullptr));
+      CHECK(NCERR_EOF == ncerr);
+      ncvisual_destroy(ncv);
+      // the writer might have been left blocked, had we stopped early
+      close(fds[0]);
+      writer.join();
+    }
+  }
+
   SUBCASE("LoadVideoCreatePlane") {
     if(notcurses_canopen_videos(nc_)){
       nc_err_e ncerr = NCERR_SUCCESS;
@@ -134,6 +265,350 @@ TEST_CASE("Visual") {
       ncvisual_destroy(ncv);
     }
   }
+
+  // at a hundredth of its natural duration, frames will be dropped. every
+  // frame decoded must be either shown or dropped.
+  SUBCASE("StreamVideo") {
+    if(notcurses_canopen_videos(nc_)){
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncvisual_from_file(find_data("notcursesI.avi"), &ncerr);
+      REQUIRE(ncv);
+      CHECK(NCERR_SUCCESS == ncerr);
+      ncstats stats;
+      notcurses_reset_stats(nc_, &stats);
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      uint64_t shown = 0;
+      auto streamer = [](ncvisual*, ncvisual_options* vopts,
+                         const struct timespec*, void* curry) -> int {
+        ++*static_cast<uint64_t*>(curry);
+        return notcurses_render(ncplane_notcurses(vopts->n));
+      };
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.01, streamer, &opts, &shown));
+      CHECK(NCERR_EOF == ncerr);
+      notcurses_stats(nc_, &stats);
+      // the first frame was decoded by ncvisual_from_file()
+      CHECK(shown + stats.frames_dropped == stats.frames_decoded + 1);
+      CHECK(stats.frames_late <= shown);
+      ncvisual_destroy(ncv);
+    }
+  }
+
+  // a recorded stream is replayed without decoding, frame for frame, leaving
+  // the plane as decoding did
+  SUBCASE("RecordedStream") {
+    if(notcurses_canopen_videos(nc_)){
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncvisual_from_file(find_data("notcursesI.avi"), &ncerr);
+      REQUIRE(ncv);
+      CHECK(0 == ncvisual_record(ncv, 64 * 1024 * 1024));
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      auto streamer = [](ncvisual*, ncvisual_options*,
+                         const struct timespec*, void* curry) -> int {
+        ++*static_cast<uint64_t*>(curry);
+        return 0;
+      };
+      auto contents = [ncp_]{
+        std::vector<std::string> cells;
+        int dimy, dimx;
+        ncplane_dim_yx(ncp_, &dimy, &dimx);
+        for(int y = 0 ; y < dimy ; ++y){
+          for(int x = 0 ; x < dimx ; ++x){
+            uint32_t attr;
+            uint64_t channels;
+            char* egc = ncplane_at_yx(ncp_, y, x, &attr, &channels);
+            REQUIRE(egc);
+            cells.emplace_back(std::string(egc) + std::to_string(channels));
+            free(egc);
+          }
+        }
+        return cells;
+      };
+      uint64_t recorded = 0;
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.01, streamer, &opts, &recorded));
+      CHECK(NCERR_EOF == ncerr);
+      auto decoded = contents();
+      ncplane_erase(ncp_);
+      ncstats stats;
+      notcurses_reset_stats(nc_, &stats);
+      uint64_t replayed = 0;
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.01, streamer, &opts, &replayed));
+      CHECK(NCERR_EOF == ncerr);
+      notcurses_stats(nc_, &stats);
+      CHECK(0 == stats.frames_decoded);
+      CHECK(recorded == replayed);
+      CHECK(decoded == contents());
+      ncvisual_destroy(ncv);
+      // without room for the recording, we decode, and ought get the same
+      ncv = ncvisual_from_file(find_data("notcursesI.avi"), &ncerr);
+      REQUIRE(ncv);
+      CHECK(0 == ncvisual_record(ncv, 1));
+      ncplane_erase(ncp_);
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.01, streamer, &opts, &replayed));
+      CHECK(NCERR_EOF == ncerr);
+      notcurses_stats(nc_, &stats);
+      CHECK(0 < stats.frames_decoded);
+      CHECK(decoded == contents());
+      ncvisual_destroy(ncv);
+    }
+  }
+
+  // reopening a cached image ought skip the decode, and rendering it at the
+  // same geometry ought skip the scaling, with the same result
+  SUBCASE("ImageCache") {
+    ncvisual_cachestats before, after;
+    ncvisual_cache_limit(64 * 1024 * 1024);
+    ncvisual_cache_stats(&before);
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto ncv = ncvisual_from_file(find_data("changes.jpg"), &ncerr);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncerr);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    int dimy, dimx;
+    ncplane_dim_yx(ncp_, &dimy, &dimx);
+    std::vector<uint64_t> decoded;
+    for(int y = 0 ; y < dimy ; ++y){
+      for(int x = 0 ; x < dimx ; ++x){
+        uint32_t attr;
+        uint64_t channels;
+        free(ncplane_at_yx(ncp_, y, x, &attr, &channels));
+        decoded.push_back(channels);
+      }
+    }
+    ncvisual_destroy(ncv);
+    ncplane_erase(ncp_);
+    ncv = ncvisual_from_file(find_data("changes.jpg"), &ncerr);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncerr);
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    for(int y = 0 ; y < dimy ; ++y){
+      for(int x = 0 ; x < dimx ; ++x){
+        uint32_t attr;
+        uint64_t channels;
+        free(ncplane_at_yx(ncp_, y, x, &attr, &channels));
+        CHECK(decoded[y * dimx + x] == channels);
+      }
+    }
+    CHECK(NCERR_EOF == ncvisual_decode(ncv));
+    ncvisual_destroy(ncv);
+    ncvisual_cache_stats(&after);
+    CHECK(before.misses + 1 == after.misses);
+    CHECK(before.hits + 1 == after.hits);
+    CHECK(before.scaled_hits + 1 == after.scaled_hits);
+    CHECK(1 == after.entries);
+    CHECK(0 < after.bytes);
+    ncvisual_cache_limit(0);
+    ncvisual_cache_stats(&after);
+    CHECK(0 == after.entries);
+    CHECK(0 == after.bytes);
+  }
+
+  // prefetched images are prescaled to the target, in whatever order they're
+  // taken, and render as they would have unprefetched
+  SUBCASE("Prefetch") {
+    const char* files[] = {
+      find_data("changes.jpg"), find_data("warmech.bmp"),
+      find_data("megaman2.bmp"), find_data("PurpleDrank.jpg"),
+      find_data("aidsrobots.jpeg"),
+    };
+    ncprefetch_options popts{};
+    popts.threads = 2;
+    popts.rows = 60;
+    popts.cols = 80;
+    popts.scaling = NCSCALE_STRETCH;
+    auto pf = ncprefetch_create(files, 5, &popts);
+    REQUIRE(pf);
+    for(int idx : { 0, 1, 3, 4, 2, 2 }){ // skipping ahead, then back
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncprefetch_take(pf, idx, &ncerr);
+      REQUIRE(ncv);
+      CHECK(NCERR_SUCCESS == ncerr);
+      int y, x;
+      CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_DEFAULT, &y, &x, nullptr, nullptr));
+      CHECK(60 == y);
+      CHECK(80 == x);
+      ncvisual_destroy(ncv);
+    }
+    ncprefetch_retarget(pf, 30, 40);
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto ncv = ncprefetch_take(pf, 0, &ncerr);
+    REQUIRE(ncv);
+    int y, x;
+    CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_DEFAULT, &y, &x, nullptr, nullptr));
+    CHECK(30 == y);
+    CHECK(40 == x);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    ncvisual_destroy(ncv);
+    ncprefetch_destroy(pf);
+  }
+
+  // with NCSCALE_SCALE, images are prescaled to fit within the target
+  SUBCASE("PrefetchScaled") {
+    const char* files[] = { find_data("changes.jpg"), };
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto full = ncvisual_from_file(files[0], &ncerr);
+    REQUIRE(full);
+    int fully, fullx;
+    CHECK(0 == ncvisual_geom(nc_, full, NCBLIT_DEFAULT, &fully, &fullx, nullptr, nullptr));
+    ncvisual_destroy(full);
+    // whatever the filter, which the prescaling uses as rendering would
+    for(auto quality : { NCSCALEQ_DEFAULT, NCSCALEQ_BOX }){
+      ncprefetch_options popts{};
+      popts.rows = 60;
+      popts.cols = 60;
+      popts.scaling = NCSCALE_SCALE;
+      popts.quality = quality;
+      auto pf = ncprefetch_create(files, 1, &popts);
+      REQUIRE(pf);
+      auto ncv = ncprefetch_take(pf, 0, &ncerr);
+      REQUIRE(ncv);
+      int y, x;
+      CHECK(0 == ncvisual_geom(nc_, ncv, NCBLIT_DEFAULT, &y, &x, nullptr, nullptr));
+      CHECK(((y == 60 && x <= 60) || (x == 60 && y <= 60)));
+      // the aspect ratio is kept, to within the rounding of the shorter side
+      CHECK(std::abs(y * fullx - x * fully) < std::max(fully, fullx));
+      ncvisual_destroy(ncv);
+      ncprefetch_destroy(pf);
+    }
+  }
+
+#ifdef USE_FFMPEG
+  // blitting the same frame repeatedly at one size ought build a single
+  // scaling context, and allocate a single scaled frame
+  SUBCASE("ScalePoolReuse") {
+    nc_err_e ncerr = NCERR_SUCCESS;
+    auto ncv = ncvisual_from_file(find_data("changes.jpg"), &ncerr);
+    REQUIRE(ncv);
+    CHECK(NCERR_SUCCESS == ncerr);
+    ncstats stats;
+    notcurses_reset_stats(nc_, &stats);
+    struct ncvisual_options opts{};
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    for(int i = 0 ; i < 5 ; ++i){
+      CHECK(ncvisual_render(nc_, ncv, &opts));
+    }
+    CHECK(ncvisual_render(nc_, ncv, &opts)); // gathers the previous blit's counts
+    notcurses_stats(nc_, &stats);
+    CHECK(1 == stats.swsctx_misses);
+    CHECK(4 == stats.swsctx_hits);
+    CHECK(1 == stats.scalebuf_misses);
+    CHECK(4 == stats.scalebuf_hits);
+    ncvisual_destroy(ncv);
+  }
+
+  // seeking back to the beginning ought get us the first frame again, whether
+  // called directly or from a streamer, while seeking past the end fails
+  SUBCASE("Seek") {
+    if(notcurses_canopen_videos(nc_)){
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncvisual_from_file(find_data("notcursesI.avi"), &ncerr);
+      REQUIRE(ncv);
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      auto contents = [ncp_]{
+        std::vector<std::string> cells;
+        int dimy, dimx;
+        ncplane_dim_yx(ncp_, &dimy, &dimx);
+        for(int y = 0 ; y < dimy ; ++y){
+          for(int x = 0 ; x < dimx ; ++x){
+            uint32_t attr;
+            uint64_t channels;
+            char* egc = ncplane_at_yx(ncp_, y, x, &attr, &channels);
+            REQUIRE(egc);
+            cells.emplace_back(std::string(egc) + std::to_string(channels));
+            free(egc);
+          }
+        }
+        return cells;
+      };
+      CHECK(ncvisual_render(nc_, ncv, &opts));
+      auto first = contents();
+      for(int i = 0 ; i < 10 ; ++i){
+        CHECK(NCERR_SUCCESS == ncvisual_decode(ncv));
+      }
+      CHECK(NCERR_SUCCESS == ncvisual_seek(ncv, 0));
+      CHECK(ncvisual_render(nc_, ncv, &opts));
+      CHECK(first == contents());
+      // the streamer rewinds once, five frames in
+      struct seekstate {
+        int calls;
+        int seekedat;
+        bool matched;
+        decltype(contents)* snapshot;
+        decltype(first)* expected;
+      } st{0, 0, false, &contents, &first};
+      auto streamer = [](ncvisual* v, ncvisual_options*,
+                         const struct timespec*, void* curry) -> int {
+        auto s = static_cast<seekstate*>(curry);
+        if(++s->calls == 5){
+          s->seekedat = s->calls;
+          return ncvisual_seek(v, 0) == NCERR_SUCCESS ? 0 : -1;
+        }
+        if(s->seekedat && s->calls == s->seekedat + 1){
+          s->matched = (*s->snapshot)() == *s->expected;
+        }
+        return 0;
+      };
+      ncplane_erase(ncp_);
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.01, streamer, &opts, &st));
+      CHECK(NCERR_EOF == ncerr);
+      CHECK(5 == st.seekedat);
+      CHECK(st.matched);
+      CHECK(NCERR_EOF == ncvisual_seek(ncv, 3600ull * 1000000000ull));
+      ncvisual_destroy(ncv);
+    }
+  }
+
+  // frames costing far more than the interval between them ought step the
+  // stream down from the options provided, which the streamer sees
+  SUBCASE("AdaptiveStream") {
+    if(notcurses_canopen_videos(nc_)){
+      nc_err_e ncerr = NCERR_SUCCESS;
+      auto ncv = ncvisual_from_file(find_data("notcursesI.avi"), &ncerr);
+      REQUIRE(ncv);
+      CHECK(0 == ncvisual_tier(ncv));
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      opts.blitter = NCBLIT_2x2;
+      opts.flags = NCVISUAL_OPTION_ADAPTIVE | NCVISUAL_OPTION_MAYDEGRADE;
+      struct tierstate {
+        int maxtier;
+        bool consistent;
+      } st{0, true};
+      auto streamer = [](ncvisual* v, ncvisual_options* vo,
+                         const struct timespec*, void* curry) -> int {
+        auto s = static_cast<tierstate*>(curry);
+        const int tier = ncvisual_tier(v);
+        if(tier > s->maxtier){
+          s->maxtier = tier;
+        }
+        const bool asprovided = vo->blitter == NCBLIT_2x2 &&
+                                !(vo->flags & NCVISUAL_OPTION_DELTA);
+        if((tier == 0) != asprovided){
+          s->consistent = false;
+        }
+        return notcurses_render(ncplane_notcurses(vo->n));
+      };
+      CHECK(0 == ncvisual_stream(nc_, ncv, &ncerr, 0.001, streamer, &opts, &st));
+      CHECK(NCERR_EOF == ncerr);
+      CHECK(0 < st.maxtier);
+      CHECK(st.consistent);
+      ncvisual_destroy(ncv);
+    }
+  }
+#endif
 #endif
 
   SUBCASE("LoadRGBAFromMemory") {
@@ -164,5 +639,544 @@ TEST_CASE("Visual") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  SUBCASE("HalfBlockCells") {
+    // top row: red, transparent. bottom row: blue, green.
+    const uint32_t rgba[] = { 0xff0000ff, 0x00000000, 0xffff0000, 0xff00ff00, };
+    auto ncv = ncvisual_from_rgba(rgba, 2, 8, 2);
+    REQUIRE(ncv);
+    for(auto flags : { 0ull, (unsigned long long)NCVISUAL_OPTION_BLEND }){
+      struct ncvisual_options opts{};
+      opts.n = ncp_;
+      opts.blitter = NCBLIT_2x1;
+      opts.flags = flags;
+      CHECK(ncvisual_render(nc_, ncv, &opts));
+      const unsigned alpha = flags ? CELL_ALPHA_BLEND : CELL_ALPHA_OPAQUE;
+      uint64_t channels;
+      char* egc = ncplane_at_yx(ncp_, 0, 0, nullptr, &channels);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, "▀"));
+      free(egc);
+      CHECK(0xff0000 == channels_fg(channels));
+      CHECK(0x0000ff == channels_bg(channels));
+      CHECK(alpha == channels_fg_alpha(channels));
+      CHECK(alpha == channels_bg_alpha(channels));
+      egc = ncplane_at_yx(ncp_, 0, 1, nullptr, &channels);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, "▄"));
+      free(egc);
+      CHECK(0x00ff00 == channels_fg(channels));
+      CHECK(alpha == channels_fg_alpha(channels));
+      CHECK(CELL_ALPHA_TRANSPARENT == channels_bg_alpha(channels));
+    }
+    ncvisual_destroy(ncv);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // an unscaled visual with an odd number of rows ends in a half-filled cell
+  SUBCASE("UnscaledPartialCell") {
+    const uint32_t rgba[] = { 0xff0000ff, 0xff0000ff, 0xff0000ff, };
+    auto ncv = ncvisual_from_rgba(rgba, 3, 4, 1);
+    REQUIRE(ncv);
+    struct ncvisual_options opts{};
+    opts.blitter = NCBLIT_2x1;
+    auto n = ncvisual_render(nc_, ncv, &opts);
+    REQUIRE(n);
+    int dimy, dimx;
+    ncplane_dim_yx(n, &dimy, &dimx);
+    CHECK(2 == dimy);
+    CHECK(1 == dimx);
+    uint64_t channels;
+    char* egc = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, " "));
+    free(egc);
+    CHECK(0xff0000 == channels_bg(channels));
+    egc = ncplane_at_yx(n, 1, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "▀"));
+    free(egc);
+    CHECK(0xff0000 == channels_fg(channels));
+    CHECK(CELL_ALPHA_TRANSPARENT == channels_bg_alpha(channels));
+    CHECK(0 == ncplane_destroy(n));
+    ncvisual_destroy(ncv);
+  }
+
+  SUBCASE("BrailleCells") {
+    // two 4x2 blocks. the first is black save white pixels at its top left and
+    // bottom right. the second is uniform red, save a transparent top row.
+    const uint32_t black = 0xff000000;
+    const uint32_t white = 0xffffffff;
+    const uint32_t red = 0xff0000ff;
+    const uint32_t rgba[] = {
+      white, black, 0, 0,
+      black, black, red, red,
+      black, black, red, red,
+      black, white, red, red,
+    };
+    auto ncv = ncvisual_from_rgba(rgba, 4, 16, 4);
+    REQUIRE(ncv);
+    struct ncvisual_options opts{};
+    opts.n = ncp_;
+    opts.blitter = NCBLIT_BRAILLE;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    uint64_t channels;
+    char* egc = ncplane_at_yx(ncp_, 0, 0, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "⢁"));
+    free(egc);
+    CHECK(0xffffff == channels_fg(channels));
+    CHECK(CELL_ALPHA_TRANSPARENT == channels_bg_alpha(channels));
+    egc = ncplane_at_yx(ncp_, 0, 1, nullptr, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "⣶"));
+    free(egc);
+    CHECK(0xff0000 == channels_fg(channels));
+    ncvisual_destroy(ncv);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  SUBCASE("QuadrantError") {
+    // the quadrant solver ought come within a few percent of the least
+    // possible squared error over noisy blocks, and reproduce exactly any
+    // block of only two colors.
+    const char* quads[] = {
+      " ", "▘", "▝", "▀", "▖", "▌", "▞", "▛",
+      "▗", "▚", "▐", "▜", "▄", "▙", "▟", "█",
+    };
+    const int dimy = 32, dimx = 32;
+    std::vector<uint32_t> noisy(dimy * dimx), twotone(dimy * dimx);
+    unsigned seed = 1;
+    auto rand8 = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0xffu; };
+    for(int y = 0 ; y < dimy ; y += 2){
+      for(int x = 0 ; x < dimx ; x += 2){
+        const uint32_t c0 = 0xff000000u | (rand8() << 16) | (rand8() << 8) | rand8();
+        const uint32_t c1 = 0xff000000u | (rand8() << 16) | (rand8() << 8) | rand8();
+        const unsigned pattern = (y / 2 * dimx / 2 + x / 2) % 16;
+        for(int q = 0 ; q < 4 ; ++q){
+          const int idx = (y + q / 2) * dimx + x + q % 2;
+          noisy[idx] = 0xff000000u | (rand8() << 16) | (rand8() << 8) | rand8();
+          twotone[idx] = (pattern & (1u << q)) ? c1 : c0;
+        }
+      }
+    }
+    // the squared error of each 2x2 block of 'rgba' as rendered
+    auto sse = [&](const std::vector<uint32_t>& rgba, std::vector<long>& errs) {
+      auto ncv = ncvisual_from_rgba(rgba.data(), dimy, dimx * 4, dimx);
+      REQUIRE(ncv);
+      struct ncvisual_options opts{};
+      opts.n = ncp_;
+      opts.blitter = NCBLIT_2x2;
+      CHECK(ncvisual_render(nc_, ncv, &opts));
+      ncvisual_destroy(ncv);
+      for(int y = 0 ; y < dimy / 2 ; ++y){
+        for(int x = 0 ; x < dimx / 2 ; ++x){
+          uint64_t channels;
+          char* egc = ncplane_at_yx(ncp_, y, x, nullptr, &channels);
+          REQUIRE(egc);
+          unsigned mask = 16;
+          for(unsigned m = 0 ; m < 16 ; ++m){
+            if(strcmp(egc, quads[m]) == 0){
+              mask = m;
+            }
+          }
+          free(egc);
+          REQUIRE(16 > mask);
+          long err = 0;
+          for(int q = 0 ; q < 4 ; ++q){
+            // RGBA in memory order
+            const uint32_t px = rgba[(y * 2 + q / 2) * dimx + x * 2 + q % 2];
+            const uint32_t c = (mask & (1u << q)) ? channels_fg(channels) : channels_bg(channels);
+            const long dr = (long)(px & 0xffu) - (long)((c >> 16) & 0xffu);
+            const long dg = (long)((px >> 8) & 0xffu) - (long)((c >> 8) & 0xffu);
+            const long db = (long)((px >> 16) & 0xffu) - (long)(c & 0xffu);
+            err += dr * dr + dg * dg + db * db;
+          }
+          errs.push_back(err);
+        }
+      }
+    };
+    std::vector<long> errs;
+    sse(twotone, errs);
+    for(auto err : errs){
+      CHECK(0 == err);
+    }
+    errs.clear();
+    sse(noisy, errs);
+    // find the best partition of each block by brute force
+    long best = 0, actual = 0;
+    for(int y = 0 ; y < dimy ; y += 2){
+      for(int x = 0 ; x < dimx ; x += 2){
+        long bestblock = -1;
+        for(unsigned m = 1 ; m < 16 ; ++m){
+          long err = 0;
+          for(int shift = 0 ; shift < 24 ; shift += 8){
+            long sums[2] = { 0, 0 }, counts[2] = { 0, 0 }, vals[4];
+            for(int q = 0 ; q < 4 ; ++q){
+              vals[q] = (noisy[(y + q / 2) * dimx + x + q % 2] >> shift) & 0xffu;
+              sums[(m >> q) & 1] += vals[q];
+              ++counts[(m >> q) & 1];
+            }
+            for(int q = 0 ; q < 4 ; ++q){
+              const int side = (m >> q) & 1;
+              const long mean = (sums[side] + counts[side] / 2) / counts[side];
+              err += (vals[q] - mean) * (vals[q] - mean);
+            }
+          }
+          if(bestblock < 0 || err < bestblock){
+            bestblock = err;
+          }
+        }
+        best += bestblock;
+      }
+    }
+    for(auto err : errs){
+      actual += err;
+    }
+    CHECK(actual >= best);
+    CHECK(actual * 100 <= best * 105);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // each 2x2 block is averaged to a single cell, weighted by alpha
+  SUBCASE("BoxScaling") {
+    const uint32_t R = 0xff0000ff;
+    const uint32_t B = 0xffff0000;
+    const uint32_t G = 0xff00ff00;
+    const uint32_t W = 0xffffffff;
+    const uint32_t r = 0x800000ff; // half-transparent red
+    const uint32_t rgba[] = {
+      R, R, R, B,
+      R, R, B, R,
+      G, G, W, W,
+      G, r, W, W,
+    };
+    auto ncv = ncvisual_from_rgba(rgba, 4, 16, 4);
+    REQUIRE(ncv);
+    auto n = ncplane_new(nc_, 2, 2, 0, 0, nullptr);
+    REQUIRE(n);
+    struct ncvisual_options opts{};
+    opts.n = n;
+    opts.scaling = NCSCALE_STRETCH;
+    opts.quality = NCSCALEQ_BOX;
+    opts.blitter = NCBLIT_1x1;
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    const uint32_t expected[] = { 0xff0000, 0x800080, 0x25da00, 0xffffff, };
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 2 ; ++x){
+        uint64_t channels;
+        char* egc = ncplane_at_yx(n, y, x, nullptr, &channels);
+        REQUIRE(egc);
+        free(egc);
+        CHECK(expected[y * 2 + x] == channels_bg(channels));
+        CHECK(CELL_ALPHA_OPAQUE == channels_bg_alpha(channels));
+      }
+    }
+    opts.quality = static_cast<ncscalequality_e>(NCSCALEQ_BOX + 1);
+    CHECK(!ncvisual_render(nc_, ncv, &opts));
+    ncplane_destroy(n);
+    ncvisual_destroy(ncv);
+  }
+
+  // NCSCALE_SCALE fits a visual within the plane, keeping its aspect ratio,
+  // and leaves the rest of the plane alone
+  SUBCASE("ScaleWithinPlane") {
+    const uint32_t R = 0xff0000ff;
+    const uint32_t rgba[] = {
+      R, R, R, R, R, R, R, R,
+      R, R, R, R, R, R, R, R,
+    };
+    auto ncv = ncvisual_from_rgba(rgba, 2, 32, 8);
+    REQUIRE(ncv);
+    auto n = ncplane_new(nc_, 4, 4, 0, 0, nullptr);
+    REQUIRE(n);
+    struct ncvisual_options opts{};
+    opts.n = n;
+    opts.scaling = NCSCALE_SCALE;
+    opts.quality = NCSCALEQ_BOX;
+    opts.blitter = NCBLIT_1x1;
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int y = 0 ; y < 4 ; ++y){
+      for(int x = 0 ; x < 4 ; ++x){
+        uint64_t channels;
+        char* egc = ncplane_at_yx(n, y, x, nullptr, &channels);
+        REQUIRE(egc);
+        if(y == 0){
+          CHECK(0 == strcmp(egc, " "));
+          CHECK(0xff0000 == channels_bg(channels));
+        }else{
+          CHECK(0 == strcmp(egc, ""));
+        }
+        free(egc);
+      }
+    }
+    ncplane_destroy(n);
+    ncvisual_destroy(ncv);
+  }
+
+  // with NCVISUAL_OPTION_DELTA, only cells whose pixels changed are redrawn.
+  // rotating this image by pi changes only its top left and bottom right.
+  SUBCASE("DeltaBlit") {
+    const uint32_t R = 0xff0000ff;
+    const uint32_t W = 0xffffffff;
+    const uint32_t rgba[] = {
+      R, W, W, W,
+      R, W, W, W,
+      W, W, W, W,
+      W, W, W, W,
+    };
+    auto ncv = ncvisual_from_rgba(rgba, 4, 16, 4);
+    REQUIRE(ncv);
+    auto n = ncplane_new(nc_, 2, 4, 0, 0, nullptr);
+    REQUIRE(n);
+    struct ncvisual_options opts{};
+    opts.n = n;
+    opts.blitter = NCBLIT_2x1;
+    opts.flags = NCVISUAL_OPTION_DELTA;
+    auto scribble = [n](){
+      for(int y = 0 ; y < 2 ; ++y){
+        for(int x = 0 ; x < 4 ; ++x){
+          CHECK(1 == ncplane_putsimple_yx(n, y, x, 'x'));
+        }
+      }
+    };
+    auto drawn = [n](int y, int x){
+      char* egc = ncplane_at_yx(n, y, x, nullptr, nullptr);
+      REQUIRE(egc);
+      const bool ret = strcmp(egc, "x");
+      free(egc);
+      return ret;
+    };
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    scribble();
+    // nothing has changed, so nothing ought be drawn
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 4 ; ++x){
+        CHECK(!drawn(y, x));
+      }
+    }
+    CHECK(NCERR_SUCCESS == ncvisual_rotate(ncv, M_PI));
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int y = 0 ; y < 2 ; ++y){
+      for(int x = 0 ; x < 4 ; ++x){
+        CHECK(drawn(y, x) == ((y == 0 && x == 0) || (y == 1 && x == 3)));
+      }
+    }
+    // elsewhere, it's all drawn anew
+    scribble();
+    opts.x = 0;
+    opts.y = 1;
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int x = 0 ; x < 4 ; ++x){
+      CHECK(drawn(1, x));
+    }
+    // erasing or resizing the plane forgets what was drawn
+    ncplane_erase(n);
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int x = 0 ; x < 4 ; ++x){
+      CHECK(drawn(1, x));
+    }
+    scribble();
+    CHECK(0 == ncplane_resize_simple(n, 2, 4));
+    CHECK(n == ncvisual_render(nc_, ncv, &opts));
+    for(int x = 0 ; x < 4 ; ++x){
+      CHECK(drawn(1, x));
+    }
+    ncplane_destroy(n);
+    ncvisual_destroy(ncv);
+  }
+
+  // a blit split into bands must be indistinguishable from one done all at
+  // once, even over a plane holding other EGCs (which bands can't release).
+  // with a single processor, the bands are all blitted by the caller.
+  SUBCASE("ParallelBands") {
+    const int dimy = 37, dimx = 23;
+    std::vector<uint32_t> rgba(dimy * dimx);
+    unsigned seed = 1;
+    for(auto& px : rgba){
+      seed = seed * 1103515245 + 12345;
+      // a random color, transparent about one time in eight
+      px = ((seed >> 16) % 8 ? 0xff000000u : 0) | ((seed >> 8) & 0xffffffu);
+    }
+    auto ncv = ncvisual_from_rgba(rgba.data(), dimy, dimx * 4, dimx);
+    REQUIRE(ncv);
+    for(auto blitter : { NCBLIT_1x1, NCBLIT_2x1, NCBLIT_1x1x4, NCBLIT_2x2,
+                         NCBLIT_4x1, NCBLIT_BRAILLE, NCBLIT_8x1 }){
+      auto serial = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+      REQUIRE(serial);
+      auto banded = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+      REQUIRE(banded);
+      for(int y = 0 ; y < dimy ; ++y){
+        for(int x = 0 ; x < dimx ; ++x){
+          CHECK(0 < ncplane_putstr_yx(banded, y, x, (x + y) % 2 ? "▓" : "x"));
+        }
+      }
+      struct ncvisual_options opts{};
+      opts.blitter = blitter;
+      opts.y = 1;
+      opts.x = 1;
+      opts.n = serial;
+      CHECK(serial == ncvisual_render(nc_, ncv, &opts));
+      opts.n = banded;
+      opts.flags = NCVISUAL_OPTION_PARALLEL;
+      CHECK(banded == ncvisual_render(nc_, ncv, &opts));
+      int compared = 0;
+      for(int y = 0 ; y < dimy ; ++y){
+        for(int x = 0 ; x < dimx ; ++x){
+          uint64_t schan, bchan;
+          char* segc = ncplane_at_yx(serial, y, x, nullptr, &schan);
+          REQUIRE(segc);
+          char* begc = ncplane_at_yx(banded, y, x, nullptr, &bchan);
+          REQUIRE(begc);
+          // only the cells written by the blit are comparable
+          if(strcmp(segc, "")){
+            CHECK(0 == strcmp(segc, begc));
+            CHECK(schan == bchan);
+            ++compared;
+          }
+          free(segc);
+          free(begc);
+        }
+      }
+      CHECK(0 < compared);
+      int sy, sx, by, bx;
+      ncplane_cursor_yx(serial, &sy, &sx);
+      ncplane_cursor_yx(banded, &by, &bx);
+      CHECK(sy == by);
+      CHECK(sx == bx);
+      CHECK(0 == ncplane_destroy(banded));
+      CHECK(0 == ncplane_destroy(serial));
+    }
+    ncvisual_destroy(ncv);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // the blitter's ratios are available without a visual
+  // ncvisual_tier() is 0 for anything not streamed adaptively, and flags
+  // beyond NCVISUAL_OPTION_ADAPTIVE are rejected
+  SUBCASE("TierWithoutStream") {
+    std::vector<uint32_t> rgba(16 * 16, 0xff808080u);
+    auto ncv = ncvisual_from_rgba(rgba.data(), 16, 16 * 4, 16);
+    REQUIRE(ncv);
+    CHECK(0 == ncvisual_tier(ncv));
+    struct ncvisual_options opts{};
+    opts.n = ncp_;
+    opts.scaling = NCSCALE_STRETCH;
+    opts.flags = NCVISUAL_OPTION_ADAPTIVE;
+    CHECK(ncvisual_render(nc_, ncv, &opts));
+    CHECK(0 == ncvisual_tier(ncv));
+    opts.flags = NCVISUAL_OPTION_ADAPTIVE << 1u;
+    CHECK(!ncvisual_render(nc_, ncv, &opts));
+    ncvisual_destroy(ncv);
+  }
+
+  SUBCASE("GeomWithoutVisual") {
+    int y = -1, x = -1, toy, tox;
+    CHECK(0 == ncvisual_geom(nc_, nullptr, NCBLIT_2x2, &y, &x, &toy, &tox));
+    CHECK(0 == y);
+    CHECK(0 == x);
+    CHECK(2 == toy);
+    CHECK(2 == tox);
+    CHECK(0 == ncvisual_geom(nc_, nullptr, NCBLIT_BRAILLE, nullptr, nullptr, &toy, &tox));
+    CHECK(4 == toy);
+    CHECK(2 == tox);
+  }
+
+  // failures are reported for the file taken, wherever it was opened
+  SUBCASE("PrefetchFailures") {
+    const char* files[] = { "/nonexistent/a.png", "/nonexistent/b.png", "/nonexistent/c.png", };
+    auto pf = ncprefetch_create(files, 3, nullptr);
+    REQUIRE(pf);
+    nc_err_e ncerr = NCERR_SUCCESS;
+    CHECK(!ncprefetch_take(pf, 0, &ncerr));
+    CHECK(NCERR_SUCCESS != ncerr);
+    ncerr = NCERR_SUCCESS;
+    CHECK(!ncprefetch_take(pf, 2, &ncerr));
+    CHECK(NCERR_SUCCESS != ncerr);
+    ncerr = NCERR_SUCCESS;
+    CHECK(!ncprefetch_take(pf, 3, &ncerr));
+    CHECK(NCERR_SUCCESS != ncerr);
+    ncprefetch_destroy(pf);
+    ncprefetch_options popts{};
+    popts.depth = -1;
+    CHECK(!ncprefetch_create(files, 3, &popts));
+  }
+
+  // the native formats must draw just as their RGBA equivalents do
+  SUBCASE("NativeFormats") {
+    const int dimy = 5, dimx = 7; // an odd final row, and odd chroma columns
+    std::vector<uint32_t> rgba(dimy * dimx);
+    auto compare = [&](ncplane* native) {
+      auto expected = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+      REQUIRE(expected);
+      CHECK(0 < ncblit_rgba(expected, 0, 0, dimx * 4, rgba.data(), 0, 0, dimy, dimx));
+      for(int y = 0 ; y < (dimy + 1) / 2 ; ++y){
+        for(int x = 0 ; x < dimx ; ++x){
+          uint64_t echan, nchan;
+          char* eegc = ncplane_at_yx(expected, y, x, nullptr, &echan);
+          REQUIRE(eegc);
+          char* negc = ncplane_at_yx(native, y, x, nullptr, &nchan);
+          REQUIRE(negc);
+          CHECK(0 == strcmp(eegc, negc));
+          CHECK(echan == nchan);
+          free(eegc);
+          free(negc);
+        }
+      }
+      CHECK(0 == ncplane_destroy(expected));
+      CHECK(0 == ncplane_destroy(native));
+    };
+    unsigned seed = 7;
+    auto rnd = [&seed]() {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 16) & 0xffu;
+    };
+    std::vector<unsigned char> packed(dimy * dimx * 3);
+    for(int i = 0 ; i < dimy * dimx ; ++i){
+      // force some vertically identical pairs, which draw as spaces
+      const unsigned char g = (i / dimx) % 2 && i % 3 == 0 ? packed[i - dimx] : rnd();
+      packed[i] = g;
+      rgba[i] = 0xff000000u | (g << 16u) | (g << 8u) | g;
+    }
+    auto n = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 < ncblit_gray8(n, 0, 0, dimx, packed.data(), 0, 0, dimy, dimx));
+    compare(n);
+    for(int i = 0 ; i < dimy * dimx ; ++i){
+      unsigned char* bgr = &packed[i * 3];
+      bgr[0] = rnd();
+      bgr[1] = rnd();
+      bgr[2] = rnd();
+      rgba[i] = 0xff000000u | (bgr[0] << 16u) | (bgr[1] << 8u) | bgr[2];
+    }
+    n = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+    REQUIRE(n);
+    CHECK(0 < ncblit_bgr24(n, 0, 0, dimx * 3, packed.data(), 0, 0, dimy, dimx));
+    compare(n);
+    const int cdimy = (dimy + 1) / 2, cdimx = (dimx + 1) / 2;
+    std::vector<unsigned char> luma(dimy * dimx), u(cdimy * cdimx), v(cdimy * cdimx);
+    for(auto& l : luma){ l = rnd(); }
+    for(auto& c : u){ c = rnd(); }
+    for(auto& c : v){ c = rnd(); }
+    const void* const planes[3] = { luma.data(), u.data(), v.data(), };
+    const int linesizes[3] = { dimx, cdimx, cdimx, };
+    for(bool fullrange : { false, true }){
+      for(int y = 0 ; y < dimy ; ++y){
+        for(int x = 0 ; x < dimx ; ++x){
+          const int ci = (y / 2) * cdimx + x / 2;
+          int cr, cg, cb;
+          yuv_chroma(u[ci], v[ci], fullrange, &cr, &cg, &cb);
+          unsigned char rgb[3];
+          yuv_rgb(luma[y * dimx + x], fullrange, cr, cg, cb, rgb);
+          rgba[y * dimx + x] = 0xff000000u | (rgb[2] << 16u) | (rgb[1] << 8u) | rgb[0];
+        }
+      }
+      n = ncplane_new(nc_, dimy, dimx, 0, 0, nullptr);
+      REQUIRE(n);
+      CHECK(0 < ncblit_yuv420p(n, 0, 0, linesizes, planes, 0, 0, dimy, dimx, fullrange));
+      compare(n);
+    }
+  }
+
   CHECK(!notcurses_stop(nc_));
 }